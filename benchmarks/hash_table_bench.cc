@@ -0,0 +1,85 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/ps_map.h"
+#include "../src/ps_unordered_map.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+template <typename F>
+double measure_ms(F &&body) {
+  auto start = bench_clock::now();
+  body();
+  std::chrono::duration<double, std::milli> elapsed =
+      bench_clock::now() - start;
+  return elapsed.count();
+}
+
+template <typename Map, typename Key>
+long long lookup_all(const Map &m, const std::vector<Key> &probes) {
+  long long found = 0;
+  for (const Key &key : probes) {
+    found += m.contains(key) ? 1 : 0;
+  }
+  return found;
+}
+
+/** Point lookups, half of them for keys that are not there. */
+template <typename Key, typename MakeKey>
+void bench_lookup(const char *name, int n, int rounds, MakeKey make_key) {
+  std::mt19937 gen(5);
+  std::uniform_int_distribution<int> dist(0, 2 * n);
+
+  ps::map<Key, int> tree;
+  ps::unordered_map<Key, int> hash;
+  std::unordered_map<Key, int> std_hash;
+  for (int i = 0; i < n; i++) {
+    Key key = make_key(dist(gen));
+    tree[key] = i;
+    hash[key] = i;
+    std_hash[key] = i;
+  }
+  std::vector<Key> probes;
+  for (int i = 0; i < n; i++) {
+    probes.push_back(make_key(dist(gen)));
+  }
+
+  long long check = 0;
+  double tree_ms = measure_ms([&] {
+    for (int r = 0; r < rounds; r++) check += lookup_all(tree, probes);
+  });
+  double hash_ms = measure_ms([&] {
+    for (int r = 0; r < rounds; r++) check += lookup_all(hash, probes);
+  });
+  double std_ms = measure_ms([&] {
+    for (int r = 0; r < rounds; r++) {
+      for (const Key &key : probes) check += std_hash.count(key);
+    }
+  });
+  double lookups = static_cast<double>(n) * rounds / 1e6;
+  std::printf(
+      "lookup %-6s n=%-8d ps::map %7.1f Mops/s  ps::unordered_map %7.1f "
+      "Mops/s  std::unordered_map %7.1f Mops/s  (check %lld)\n",
+      name, n, lookups / tree_ms * 1e3, lookups / hash_ms * 1e3,
+      lookups / std_ms * 1e3, check);
+}
+
+}  // namespace
+
+int main() {
+  auto int_key = [](int x) { return x; };
+  auto string_key = [](int x) { return "key:" + std::to_string(x) + "/x"; };
+  bench_lookup<int>("int", 1000, 1000, int_key);
+  bench_lookup<int>("int", 100000, 10, int_key);
+  bench_lookup<int>("int", 1000000, 2, int_key);
+  bench_lookup<std::string>("string", 1000, 1000, string_key);
+  bench_lookup<std::string>("string", 100000, 10, string_key);
+  bench_lookup<std::string>("string", 1000000, 2, string_key);
+  return 0;
+}
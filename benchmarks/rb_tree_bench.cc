@@ -0,0 +1,444 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../src/ps_flat_map.h"
+#include "../src/ps_map.h"
+#include "../src/ps_multiset.h"
+#include "../src/ps_set.h"
+#include "../src/ps_set_algebra.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+template <typename F>
+double measure_ms(F &&body) {
+  auto start = bench_clock::now();
+  body();
+  std::chrono::duration<double, std::milli> elapsed = bench_clock::now() - start;
+  return elapsed.count();
+}
+
+template <typename Container>
+long long full_scan_map(const Container &c) {
+  long long sum = 0;
+  for (auto it = c.begin(); it != c.end(); ++it) {
+    sum += it->second;
+  }
+  return sum;
+}
+
+template <typename Container>
+long long full_scan_set(const Container &c) {
+  long long sum = 0;
+  for (auto it = c.begin(); it != c.end(); ++it) {
+    sum += *it;
+  }
+  return sum;
+}
+
+void bench_full_scan(int n, int rounds) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(0, n * 4);
+
+  ps::map<int, int> my_map;
+  std::map<int, int> std_map;
+  ps::set<int> my_set;
+  ps::multiset<int> my_multiset;
+  for (int i = 0; i < n; i++) {
+    int key = dist(gen);
+    my_map.insert(key, i);
+    std_map.emplace(key, i);
+    my_set.insert(key);
+    my_multiset.insert(key % (n / 4 + 1));
+  }
+
+  long long check = 0;
+  double ps_map_ms = measure_ms([&] {
+    for (int r = 0; r < rounds; r++) check += full_scan_map(my_map);
+  });
+  double std_map_ms = measure_ms([&] {
+    for (int r = 0; r < rounds; r++) check -= full_scan_map(std_map);
+  });
+  double ps_set_ms = measure_ms([&] {
+    for (int r = 0; r < rounds; r++) check += full_scan_set(my_set);
+  });
+  double ps_multiset_ms = measure_ms([&] {
+    for (int r = 0; r < rounds; r++) check += full_scan_set(my_multiset);
+  });
+
+  std::printf(
+      "full scan n=%-8d rounds=%d  ps::map %9.2f ms  std::map %9.2f ms  "
+      "ps::set %9.2f ms  ps::multiset %9.2f ms  (check %lld)\n",
+      n, rounds, ps_map_ms, std_map_ms, ps_set_ms, ps_multiset_ms, check);
+}
+
+void bench_insert_erase_churn(int n, int rounds) {
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<int> dist(0, n * 4);
+
+  ps::map<int, int> my_map;
+  std::map<int, int> std_map;
+  for (int i = 0; i < n; i++) {
+    int key = dist(gen);
+    my_map.insert(key, i);
+    std_map.emplace(key, i);
+  }
+
+  std::vector<int> keys;
+  for (int i = 0; i < n * rounds; i++) {
+    keys.push_back(dist(gen));
+  }
+
+  double ps_map_ms = measure_ms([&] {
+    for (size_t i = 0; i + 1 < keys.size(); i += 2) {
+      my_map.erase(keys[i]);
+      my_map.insert(keys[i + 1], 0);
+    }
+  });
+  double std_map_ms = measure_ms([&] {
+    for (size_t i = 0; i + 1 < keys.size(); i += 2) {
+      std_map.erase(keys[i]);
+      std_map.emplace(keys[i + 1], 0);
+    }
+  });
+
+  std::printf(
+      "churn     n=%-8d rounds=%d  ps::map %9.2f ms  std::map %9.2f ms  "
+      "(size %zu/%zu)\n",
+      n, rounds, ps_map_ms, std_map_ms, my_map.size(), std_map.size());
+}
+
+void bench_sorted_load(int n) {
+  std::vector<std::pair<int, int>> items;
+  for (int i = 0; i < n; i++) {
+    items.emplace_back(i * 2, i);
+  }
+
+  size_t check = 0;
+  double insert_ms = measure_ms([&] {
+    ps::map<int, int> my_map;
+    for (const auto &item : items) {
+      my_map.insert(item);
+    }
+    check += my_map.size();
+  });
+  double hint_ms = measure_ms([&] {
+    ps::map<int, int> my_map;
+    auto hint = my_map.end();
+    for (const auto &item : items) {
+      hint = my_map.insert(hint, item);
+    }
+    check += my_map.size();
+  });
+  double from_sorted_ms = measure_ms([&] {
+    auto my_map = ps::map<int, int>::from_sorted(items.begin(), items.end());
+    check += my_map.size();
+  });
+  double std_map_ms = measure_ms([&] {
+    std::map<int, int> std_map(items.begin(), items.end());
+    check += std_map.size();
+  });
+
+  std::printf(
+      "load      n=%-8d insert %9.2f ms  hinted insert %9.2f ms  "
+      "from_sorted %9.2f ms  std::map(first, last) %9.2f ms  (check %zu)\n",
+      n, insert_ms, hint_ms, from_sorted_ms, std_map_ms, check);
+}
+
+void bench_merge(int n, int parts) {
+  std::mt19937 gen(5);
+  std::uniform_int_distribution<int> dist(0, n * parts * 2);
+  std::vector<std::vector<int>> keys(static_cast<size_t>(parts));
+  for (auto &part : keys) {
+    for (int i = 0; i < n; i++) {
+      part.push_back(dist(gen));
+    }
+  }
+
+  double ps_map_ms = 0;
+  double std_map_ms = 0;
+  size_t check = 0;
+  {
+    ps::map<int, std::vector<int>> global;
+    for (const auto &part : keys) {
+      ps::map<int, std::vector<int>> local;
+      for (int key : part) {
+        local.try_emplace(key, 16, key);
+      }
+      ps_map_ms += measure_ms([&] { global.merge(local); });
+    }
+    check += global.size();
+  }
+  {
+    std::map<int, std::vector<int>> global;
+    for (const auto &part : keys) {
+      std::map<int, std::vector<int>> local;
+      for (int key : part) {
+        local.try_emplace(key, 16, key);
+      }
+      std_map_ms += measure_ms([&] { global.merge(local); });
+    }
+    check -= global.size();
+  }
+
+  std::printf(
+      "merge     n=%-8d parts=%d  ps::map %9.2f ms  std::map %9.2f ms  "
+      "(check %zu)\n",
+      n, parts, ps_map_ms, std_map_ms, check);
+}
+
+void bench_teardown(int n) {
+  auto fill = [n](auto &m) {
+    auto hint = m.end();
+    for (int i = 0; i < n; i++) {
+      hint = m.emplace_hint(hint, i, std::to_string(i));
+    }
+  };
+
+  ps::map<int, std::string> my_map;
+  fill(my_map);
+  double clear_ms = measure_ms([&] { my_map.clear(); });
+  fill(my_map);
+  double async_ms = measure_ms([&] { my_map.clear_async(); });
+  double reclaim_ms =
+      measure_ms([] { ps::reclaimer::instance().wait_idle(); });
+
+  std::map<int, std::string> std_map;
+  fill(std_map);
+  double std_map_ms = measure_ms([&] { std_map.clear(); });
+
+  std::printf(
+      "teardown  n=%-8d clear %9.2f ms  clear_async %9.2f ms (+%.2f ms in "
+      "background)  std::map %9.2f ms\n",
+      n, clear_ms, async_ms, reclaim_ms, std_map_ms);
+}
+
+// Orders strings like std::less<> but also exposes the three-way compare the
+// tree can use to decide each level with one call.
+struct string_three_way {
+  using is_transparent = void;
+  bool operator()(const std::string &a, const std::string &b) const {
+    return a < b;
+  }
+  int compare(const std::string &a, const std::string &b) const {
+    return a.compare(b);
+  }
+};
+
+template <typename Map>
+double lookup_ms(const Map &m, const std::vector<std::string> &keys,
+                 size_t &check) {
+  return measure_ms([&] {
+    for (const auto &key : keys) {
+      check += m.contains(key) ? 1 : 0;
+    }
+  });
+}
+
+void bench_string_lookup(int n, int rounds) {
+  // Long shared prefixes make every key comparison expensive.
+  const std::string prefix(48, 'k');
+  std::mt19937 gen(11);
+  std::uniform_int_distribution<int> dist(0, n * 2);
+
+  ps::map<std::string, int> less_map;
+  ps::map<std::string, int, string_three_way> three_way_map;
+  std::map<std::string, int> std_map;
+  for (int i = 0; i < n; i++) {
+    std::string key = prefix + std::to_string(dist(gen));
+    less_map.insert(key, i);
+    three_way_map.insert(key, i);
+    std_map.emplace(key, i);
+  }
+  std::vector<std::string> keys;
+  for (int i = 0; i < n * rounds; i++) {
+    keys.push_back(prefix + std::to_string(dist(gen)));
+  }
+
+  size_t check = 0;
+  double less_ms = lookup_ms(less_map, keys, check);
+  double three_way_ms = lookup_ms(three_way_map, keys, check);
+  double std_map_ms = measure_ms([&] {
+    for (const auto &key : keys) {
+      check += std_map.count(key);
+    }
+  });
+
+  std::printf(
+      "strings   n=%-8d rounds=%d  ps::map %9.2f ms  three-way %9.2f ms  "
+      "std::map %9.2f ms  (check %zu)\n",
+      n, rounds, less_ms, three_way_ms, std_map_ms, check);
+}
+
+// Percentile queries on a multiset with many repeated keys: nth() uses the
+// subtree weights, std::multiset has to walk k elements.
+void bench_percentile(int n, int queries) {
+  std::mt19937 gen(11);
+  std::uniform_int_distribution<int> dist(0, n / 8);
+
+  ps::ranked_multiset<int> my_multiset;
+  std::multiset<int> std_multiset;
+  for (int i = 0; i < n; i++) {
+    int key = dist(gen);
+    my_multiset.insert(key);
+    std_multiset.insert(key);
+  }
+
+  long long check = 0;
+  double ps_ms = measure_ms([&] {
+    for (int q = 0; q < queries; q++) {
+      size_t k = static_cast<size_t>(n) * static_cast<size_t>(q) /
+                 static_cast<size_t>(queries);
+      check += *my_multiset.nth(k);
+    }
+  });
+  double std_ms = measure_ms([&] {
+    for (int q = 0; q < queries; q++) {
+      size_t k = static_cast<size_t>(n) * static_cast<size_t>(q) /
+                 static_cast<size_t>(queries);
+      check -= *std::next(std_multiset.begin(), static_cast<long>(k));
+    }
+  });
+
+  std::printf(
+      "percentile n=%-7d queries=%d  ps::multiset nth %9.3f ms  "
+      "std::multiset next %9.2f ms  (check %lld)\n",
+      n, queries, ps_ms, std_ms, check);
+}
+
+void bench_intersection(int n, int ratio) {
+  std::mt19937 gen(13);
+  std::uniform_int_distribution<int> dist(0, 4 * n);
+
+  ps::set<int> large;
+  ps::set<int> small;
+  std::set<int> std_large;
+  std::set<int> std_small;
+  for (int i = 0; i < n; i++) {
+    int key = dist(gen);
+    large.insert(key);
+    std_large.insert(key);
+  }
+  for (int i = 0; i < n / ratio; i++) {
+    int key = dist(gen);
+    small.insert(key);
+    std_small.insert(key);
+  }
+
+  size_t check = 0;
+  double merge_ms = measure_ms([&] {
+    check += ps::set_algebra::combine(small, large, [](size_t x, size_t y) {
+               return std::min(x, y);
+             }).size();
+  });
+  double gallop_ms = measure_ms(
+      [&] { check += ps::set_intersection_galloping(small, large).size(); });
+  double probe_ms = measure_ms([&] {
+    ps::set<int> result;
+    for (auto it = small.begin(); it != small.end(); ++it) {
+      if (large.contains(*it)) {
+        result.insert(*it);
+      }
+    }
+    check += result.size();
+  });
+  double std_ms = measure_ms([&] {
+    std::set<int> result;
+    std::set_intersection(std_small.begin(), std_small.end(),
+                          std_large.begin(), std_large.end(),
+                          std::inserter(result, result.end()));
+    check += result.size();
+  });
+
+  std::printf(
+      "intersect n=%-7d ratio=%-4d merge %7.2f ms  gallop %7.2f ms  "
+      "contains+insert %7.2f ms  std::set_intersection %7.2f ms  "
+      "(check %zu)\n",
+      n, ratio, merge_ms, gallop_ms, probe_ms, std_ms, check);
+}
+
+template <typename Map>
+double probe_ms(const Map &m, const std::vector<int> &keys, long long &check) {
+  return measure_ms([&] {
+    for (int key : keys) {
+      auto it = m.find(key);
+      if (it != m.end()) {
+        check += it->second;
+      }
+    }
+  });
+}
+
+// Read-mostly table: flat_map against the node-based map for loading,
+// lookups, full scans and memory per element.
+void bench_flat_lookup(int n, int rounds) {
+  std::mt19937 gen(17);
+  std::uniform_int_distribution<int> dist(0, n * 2);
+  std::vector<std::pair<int, int>> items;
+  for (int i = 0; i < n; i++) {
+    items.emplace_back(dist(gen), i);
+  }
+  std::vector<int> keys;
+  for (int i = 0; i < n * rounds; i++) {
+    keys.push_back(dist(gen));
+  }
+
+  ps::map<int, int> my_map;
+  ps::flat_map<int, int> flat;
+  ps::eytzinger_flat_map<int, int> eytzinger;
+  double map_load_ms = measure_ms([&] {
+    for (const auto &item : items) {
+      my_map.insert(item);
+    }
+  });
+  double flat_load_ms =
+      measure_ms([&] { flat.insert(items.begin(), items.end()); });
+  double eytzinger_load_ms =
+      measure_ms([&] { eytzinger.insert(items.begin(), items.end()); });
+
+  long long check = 0;
+  double map_find_ms = probe_ms(my_map, keys, check);
+  double flat_find_ms = probe_ms(flat, keys, check);
+  double eytzinger_find_ms = probe_ms(eytzinger, keys, check);
+  double map_scan_ms = measure_ms([&] { check += full_scan_map(my_map); });
+  double flat_scan_ms = measure_ms([&] { check -= full_scan_map(flat); });
+
+  size_t flat_bytes = sizeof(int) + sizeof(int);
+  size_t eytzinger_bytes = flat_bytes + sizeof(int) + sizeof(size_t);
+  std::printf(
+      "flat      n=%-8d rounds=%d  load: map %7.2f  flat %7.2f  "
+      "eytzinger %7.2f ms  find: map %7.2f  flat %7.2f  eytzinger %7.2f ms  "
+      "scan: map %6.2f  flat %6.2f ms  bytes/elem: map %zu  flat %zu  "
+      "eytzinger %zu  (check %lld)\n",
+      n, rounds, map_load_ms, flat_load_ms, eytzinger_load_ms, map_find_ms,
+      flat_find_ms, eytzinger_find_ms, map_scan_ms, flat_scan_ms,
+      sizeof(ps::rbnode<int, int>), flat_bytes, eytzinger_bytes, check);
+}
+
+}  // namespace
+
+int main() {
+  bench_full_scan(1000, 1000);
+  bench_full_scan(100000, 10);
+  bench_full_scan(1000000, 2);
+  bench_insert_erase_churn(100000, 10);
+  bench_sorted_load(1000000);
+  bench_string_lookup(100000, 5);
+  bench_merge(100000, 8);
+  bench_teardown(2000000);
+  bench_percentile(100000, 100);
+  for (int ratio : {1, 4, 16, 64, 256}) {
+    bench_intersection(1000000, ratio);
+  }
+  bench_flat_lookup(10000, 100);
+  bench_flat_lookup(1000000, 2);
+  return 0;
+}
@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <queue>
+#include <stack>
+#include <string>
+#include <vector>
+
+#include "../src/ps_deque.h"
+#include "../src/ps_huge_page_allocator.h"
+#include "../src/ps_list.h"
+#include "../src/ps_mapped_vector.h"
+#include "../src/ps_pool_allocator.h"
+#include "../src/ps_queue.h"
+#include "../src/ps_stack.h"
+#include "../src/ps_vector.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+template <typename F>
+double measure_ms(F &&body) {
+  auto start = bench_clock::now();
+  body();
+  std::chrono::duration<double, std::milli> elapsed =
+      bench_clock::now() - start;
+  return elapsed.count();
+}
+
+/** A queue that holds about window elements while ops pass through it. */
+template <typename Queue>
+double queue_churn_ms(int window, int ops, long long &check) {
+  return measure_ms([&] {
+    Queue q;
+    for (int i = 0; i < window; i++) {
+      q.push(i);
+    }
+    for (int i = 0; i < ops; i++) {
+      check += q.front();
+      q.pop();
+      q.push(i);
+    }
+  });
+}
+
+/** A stack that is filled to depth and emptied again, rounds times. */
+template <typename Stack>
+double stack_fill_ms(int depth, int rounds, long long &check) {
+  return measure_ms([&] {
+    Stack s;
+    for (int r = 0; r < rounds; r++) {
+      for (int i = 0; i < depth; i++) {
+        s.push(i);
+      }
+      while (!s.empty()) {
+        check += s.top();
+        s.pop();
+      }
+    }
+  });
+}
+
+void bench_queue(int window, int ops) {
+  long long check = 0;
+  double ps_ms = queue_churn_ms<ps::queue<int>>(window, ops, check);
+  double std_ms = queue_churn_ms<std::queue<int>>(window, ops, check);
+  std::printf(
+      "queue     window=%-8d ops=%d  ps::queue %8.2f ms  "
+      "std::queue %8.2f ms  (check %lld)\n",
+      window, ops, ps_ms, std_ms, check);
+}
+
+void bench_stack(int depth, int rounds) {
+  long long check = 0;
+  double ps_ms = stack_fill_ms<ps::stack<int>>(depth, rounds, check);
+  double std_ms = stack_fill_ms<std::stack<int>>(depth, rounds, check);
+  std::printf(
+      "stack     depth=%-9d rounds=%d  ps::stack %8.2f ms  "
+      "std::stack %8.2f ms  (check %lld)\n",
+      depth, rounds, ps_ms, std_ms, check);
+}
+
+void bench_deque_index(int n, int rounds) {
+  ps::deque<int> my_deque;
+  std::deque<int> std_deque;
+  for (int i = 0; i < n; i++) {
+    my_deque.push_front(i);
+    std_deque.push_front(i);
+  }
+  long long check = 0;
+  double ps_ms = measure_ms([&] {
+    for (int r = 0; r < rounds; r++) {
+      for (int i = 0; i < n; i++) check += my_deque[static_cast<size_t>(i)];
+    }
+  });
+  double std_ms = measure_ms([&] {
+    for (int r = 0; r < rounds; r++) {
+      for (int i = 0; i < n; i++) check -= std_deque[static_cast<size_t>(i)];
+    }
+  });
+  std::printf(
+      "index     n=%-12d rounds=%d  ps::deque %8.2f ms  "
+      "std::deque %8.2f ms  (check %lld)\n",
+      n, rounds, ps_ms, std_ms, check);
+}
+
+/** push_back of n heap-allocated strings, growing from empty. */
+template <typename Vector>
+double string_growth_ms(int n, size_t &check) {
+  const std::string value(64, 'v');
+  return measure_ms([&] {
+    Vector v;
+    for (int i = 0; i < n; i++) {
+      v.push_back(value);
+    }
+    check += v.size();
+  });
+}
+
+/** push_back of n ints, growing from empty, rounds times. */
+template <typename Vector>
+double int_growth_ms(int n, int rounds, size_t &check) {
+  return measure_ms([&] {
+    for (int r = 0; r < rounds; r++) {
+      Vector v;
+      for (int i = 0; i < n; i++) {
+        v.push_back(i);
+      }
+      check += v.size();
+    }
+  });
+}
+
+void bench_vector_growth(int n, int rounds) {
+  // The state malloc is left in by one loop skews the next one, the more
+  // so after the strings are freed; interleave a few runs of each and keep
+  // the best.
+  size_t check = 0;
+  double ps_string_ms = 1e9, std_string_ms = 1e9;
+  double ps_int_ms = 1e9, std_int_ms = 1e9;
+  for (int k = 0; k < 3; k++) {
+    ps_int_ms =
+        std::min(ps_int_ms, int_growth_ms<ps::vector<int>>(n, rounds, check));
+    std_int_ms = std::min(std_int_ms,
+                          int_growth_ms<std::vector<int>>(n, rounds, check));
+  }
+  for (int k = 0; k < 3; k++) {
+    ps_string_ms = std::min(
+        ps_string_ms, string_growth_ms<ps::vector<std::string>>(n, check));
+    std_string_ms = std::min(
+        std_string_ms, string_growth_ms<std::vector<std::string>>(n, check));
+  }
+  std::printf(
+      "vector    n=%-12d strings: ps::vector %8.2f ms  std::vector %8.2f ms  "
+      "ints x%d: ps::vector %8.2f ms  std::vector %8.2f ms  (check %zu)\n",
+      n, ps_string_ms, std_string_ms, rounds, ps_int_ms, std_int_ms, check);
+}
+
+/**
+ * push_back of n ints into one vector that ends up n * 4 bytes large. With
+ * huge_page_allocator every growth past 2 MiB is an mremap, not a copy.
+ */
+void bench_huge_growth(size_t n) {
+  size_t check = 0;
+  double std_ms = measure_ms([&] {
+    ps::vector<int> v;
+    for (size_t i = 0; i < n; i++) {
+      v.push_back(int(i));
+    }
+    check += v.size();
+  });
+  double huge_ms = measure_ms([&] {
+    ps::vector<int, ps::huge_page_allocator<int>> v;
+    for (size_t i = 0; i < n; i++) {
+      v.push_back(int(i));
+    }
+    check += v.size();
+  });
+  std::printf(
+      "growth    n=%-12zu std::allocator %8.2f ms  "
+      "ps::huge_page_allocator %8.2f ms  (check %zu)\n",
+      n, std_ms, huge_ms, check);
+}
+
+/**
+ * Restart of a service that holds n longs: mapping the saved vector again
+ * against reading the same bytes back into a ps::vector.
+ */
+void bench_mapped_reopen(size_t n) {
+  std::string path =
+      (std::filesystem::temp_directory_path() / "sequence_bench.vec").string();
+  std::filesystem::remove(path);
+  {
+    ps::mapped_vector<long> saved(path);
+    saved.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+      saved.push_back(long(i));
+    }
+  }
+  long check = 0;
+  double mapped_ms = measure_ms([&] {
+    ps::mapped_vector<long> v(path);
+    check += v[0] + v[v.size() / 2] + v.back();
+  });
+  double reload_ms = measure_ms([&] {
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    std::fseek(file, 64, SEEK_SET);
+    ps::vector<long> v;
+    v.reserve(n);
+    long buffer[4096];
+    size_t got;
+    while ((got = std::fread(buffer, sizeof(long), 4096, file)) > 0) {
+      for (size_t i = 0; i < got; i++) {
+        v.push_back(buffer[i]);
+      }
+    }
+    std::fclose(file);
+    check += v[0] + v[v.size() / 2] + v.back();
+  });
+  std::filesystem::remove(path);
+  std::printf(
+      "reopen    n=%-12zu ps::mapped_vector %8.2f ms  "
+      "read into ps::vector %8.2f ms  (check %ld)\n",
+      n, mapped_ms, reload_ms, check);
+}
+
+/**
+ * A list that holds about window elements while ops pass through it: every
+ * op frees one node and allocates another.
+ */
+template <typename List>
+double list_churn_ms(int window, int ops, size_t &check) {
+  return measure_ms([&] {
+    List lst;
+    for (int i = 0; i < window; i++) {
+      lst.push_back(i);
+    }
+    for (int i = 0; i < ops; i++) {
+      check += static_cast<size_t>(lst.front());
+      lst.pop_front();
+      lst.push_back(i);
+    }
+  });
+}
+
+void bench_list_churn(int window, int ops) {
+  size_t check = 0;
+  double std_ms = 1e9, pool_ms = 1e9;
+  for (int k = 0; k < 3; k++) {
+    std_ms = std::min(std_ms, list_churn_ms<ps::list<int>>(window, ops, check));
+    pool_ms = std::min(
+        pool_ms, list_churn_ms<ps::list<int, ps::pool_allocator<int>>>(
+                     window, ops, check));
+  }
+  std::printf(
+      "list      window=%-8d ops=%d  std::allocator %8.2f ms  "
+      "ps::pool_allocator %8.2f ms  (check %zu)\n",
+      window, ops, std_ms, pool_ms, check);
+}
+
+}  // namespace
+
+int main() {
+  bench_queue(16, 10000000);
+  bench_queue(100000, 10000000);
+  bench_stack(1000000, 10);
+  bench_deque_index(1000000, 10);
+  bench_vector_growth(1000000, 10);
+  bench_list_churn(16, 10000000);
+  bench_list_churn(100000, 10000000);
+  bench_huge_growth(size_t{1} << 28);
+  bench_mapped_reopen(size_t{1} << 27);
+  return 0;
+}
@@ -2,6 +2,15 @@
 #define CPP2_S21_CONTAINERS_S21_CONTAINERSPLUS_H_
 
 #include "ps_array.h"
+#include "ps_flat_map.h"
+#include "ps_flat_set.h"
+#include "ps_huge_page_allocator.h"
+#include "ps_mapped_vector.h"
 #include "ps_multiset.h"
+#include "ps_pool_allocator.h"
+#include "ps_set_algebra.h"
+#include "ps_small_vector.h"
+#include "ps_unordered_map.h"
+#include "ps_unordered_set.h"
 
 #endif  // CPP2_S21_CONTAINERS_S21_CONTAINERSPLUS_H_
\ No newline at end of file
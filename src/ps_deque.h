@@ -1,212 +1,600 @@
 #ifndef CONTAINERS_SRC_PS_DEQUE_H_
 #define CONTAINERS_SRC_PS_DEQUE_H_
 
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
 namespace ps {
-template <class T>
+/**
+ * deque - a ring buffer cut into fixed-size blocks. map_ holds
+ * map_blocks_ block pointers, a power of two, so the ring has room for
+ * map_blocks_ * kBlockSize elements and element i lives at ring position
+ * (head_ + i) & mask_. Blocks are allocated the first time the ring reaches
+ * them and are kept when emptied, so a queue that stays within its
+ * high-water mark does not allocate at all; shrink_to_fit hands the unused
+ * ones back. Growing doubles the map and moves block pointers, not
+ * elements, except for the part of the head block that has wrapped around.
+ *
+ * Blocks, the map and the elements all go through Allocator, as in vector.
+ */
+template <class T, class Allocator = std::allocator<T>>
 class deque {
+  template <bool Const>
+  class DequeIterator;
+
+  using alloc_traits = std::allocator_traits<Allocator>;
+  using map_allocator = typename alloc_traits::template rebind_alloc<T*>;
+  using map_traits = std::allocator_traits<map_allocator>;
+  static constexpr bool kMoveTakesStorage =
+      alloc_traits::propagate_on_container_move_assignment::value ||
+      alloc_traits::is_always_equal::value;
+
  public:
   using value_type = T;
   using reference = T&;
   using const_reference = const T&;
+  using iterator = DequeIterator<false>;
+  using const_iterator = DequeIterator<true>;
   using size_type = size_t;
+  using allocator_type = Allocator;
 
   deque();
-  explicit deque(std::initializer_list<value_type> const& items);
+  explicit deque(const Allocator& allocator) noexcept;
+  explicit deque(std::initializer_list<value_type> const& items,
+                 const Allocator& allocator = Allocator());
   deque(const deque& s);
-  deque(deque&& s);
-  ~deque() { clear(); }
+  deque(deque&& s) noexcept;
+  ~deque();
 
   deque& operator=(const deque& other);
-  deque& operator=(deque&& other);
+  deque& operator=(deque&& other) noexcept(kMoveTakesStorage);
 
+  allocator_type get_allocator() const noexcept;
+
+  reference at(size_type pos);
+  const_reference at(size_type pos) const;
+  reference operator[](size_type pos);
+  const_reference operator[](size_type pos) const;
   reference front();
   const_reference front() const;
   reference back();
   const_reference back() const;
+
+  iterator begin() noexcept;
+  const_iterator begin() const noexcept;
+  const_iterator cbegin() const noexcept;
+  iterator end() noexcept;
+  const_iterator end() const noexcept;
+  const_iterator cend() const noexcept;
+
   bool empty() const;
   size_type size() const;
+  size_type capacity() const noexcept;
+  void shrink_to_fit();
   void push_back(const T& value);
+  void push_back(T&& value);
   void push_front(const T& value);
+  void push_front(T&& value);
+  template <class... Args>
+  reference emplace_back(Args&&... args);
+  template <class... Args>
+  reference emplace_front(Args&&... args);
   void pop_back();
   void pop_front();
   void clear() noexcept;
-  void swap(deque& other);
+  void swap(deque& other) noexcept;
 
  private:
-  struct Node {
-    T data_;
-    Node* next_;
-    Node* prev_;
-
-    Node(T data) : data_(data), next_(nullptr), prev_(nullptr) {}
-    ~Node() {}
-  };
-
-  struct LinkedList {
-    size_type size_ = 0;
-    Node* head_ = nullptr;
-    Node* tail_ = nullptr;
-  };
-
-  LinkedList list_;
+  // About 512 bytes per block, rounded down to a power of two elements so
+  // that a ring position splits into block and offset with a shift and a
+  // mask, and never fewer than 16 elements.
+  static constexpr size_type blockSizeFor(size_type bytes) {
+    size_type size = 16;
+    while (size * 2 * sizeof(T) <= bytes) {
+      size *= 2;
+    }
+    return size;
+  }
+  static constexpr size_type kBlockSize = blockSizeFor(512);
+  static constexpr size_type kBlockMask = kBlockSize - 1;
+
+  T* slot(size_type pos) const;
+  T* claim(size_type ring_pos);
+  // The rare paths stay out of line so that pushes inline as a few
+  // instructions.
+  [[gnu::noinline]] void grow();
+  [[gnu::noinline]] T* allocateBlock();
+  void deallocateBlock(T* block);
+  void release() noexcept;
+  void swapStorage(deque& other) noexcept;
+
+  [[no_unique_address]] Allocator allocator_;
+  T** map_ = nullptr;
+  size_type map_blocks_ = 0;
+  size_type mask_ = 0;
+  size_type head_ = 0;
+  size_type size_ = 0;
 };
-}  // namespace ps
 
-template <class T>
-ps::deque<T>::deque() {}
+/**
+ * A deque iterator is the deque and an index into it: a random access
+ * iterator whose dereference is operator[].
+ */
+template <class T, class Allocator>
+template <bool Const>
+class deque<T, Allocator>::DequeIterator {
+  friend deque;
+  friend DequeIterator<!Const>;
+  using owner_type = std::conditional_t<Const, const deque, deque>;
+
+ public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = std::conditional_t<Const, const T*, T*>;
+  using reference = std::conditional_t<Const, const T&, T&>;
+
+  DequeIterator() {}
+  DequeIterator(owner_type* owner, size_type index)
+      : owner_(owner), index_(index) {}
+  template <bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+  DequeIterator(const DequeIterator<OtherConst>& other)
+      : owner_(other.owner_), index_(other.index_) {}
+
+  reference operator*() const { return (*owner_)[index_]; }
+  pointer operator->() const { return &(*owner_)[index_]; }
+  reference operator[](difference_type n) const { return *(*this + n); }
+
+  DequeIterator& operator++() {
+    ++index_;
+    return *this;
+  }
+  DequeIterator operator++(int) {
+    DequeIterator tmp(*this);
+    ++index_;
+    return tmp;
+  }
+  DequeIterator& operator--() {
+    --index_;
+    return *this;
+  }
+  DequeIterator operator--(int) {
+    DequeIterator tmp(*this);
+    --index_;
+    return tmp;
+  }
+  DequeIterator& operator+=(difference_type n) {
+    index_ = static_cast<size_type>(static_cast<difference_type>(index_) + n);
+    return *this;
+  }
+  DequeIterator& operator-=(difference_type n) { return *this += -n; }
+  DequeIterator operator+(difference_type n) const {
+    DequeIterator tmp(*this);
+    return tmp += n;
+  }
+  DequeIterator operator-(difference_type n) const {
+    DequeIterator tmp(*this);
+    return tmp -= n;
+  }
+  difference_type operator-(const DequeIterator& other) const {
+    return static_cast<difference_type>(index_) -
+           static_cast<difference_type>(other.index_);
+  }
+
+  bool operator==(const DequeIterator& other) const noexcept {
+    return index_ == other.index_;
+  }
+  bool operator!=(const DequeIterator& other) const noexcept {
+    return index_ != other.index_;
+  }
+  bool operator<(const DequeIterator& other) const noexcept {
+    return index_ < other.index_;
+  }
+  bool operator>(const DequeIterator& other) const noexcept {
+    return index_ > other.index_;
+  }
+  bool operator<=(const DequeIterator& other) const noexcept {
+    return index_ <= other.index_;
+  }
+  bool operator>=(const DequeIterator& other) const noexcept {
+    return index_ >= other.index_;
+  }
+
+ private:
+  owner_type* owner_ = nullptr;
+  size_type index_ = 0;
+};
 
+namespace pmr {
 template <class T>
-ps::deque<T>::deque(std::initializer_list<value_type> const& items) {
+using deque = ps::deque<T, std::pmr::polymorphic_allocator<T>>;
+}  // namespace pmr
+}  // namespace ps
+
+template <class T, class Allocator>
+ps::deque<T, Allocator>::deque() : allocator_() {}
+
+template <class T, class Allocator>
+ps::deque<T, Allocator>::deque(const Allocator& allocator) noexcept
+    : allocator_(allocator) {}
+
+template <class T, class Allocator>
+ps::deque<T, Allocator>::deque(std::initializer_list<value_type> const& items,
+                               const Allocator& allocator)
+    : deque(allocator) {
   for (auto it = items.begin(); it != items.end(); ++it) {
     push_back(*it);
   }
 }
 
-template <class T>
-ps::deque<T>::deque(const deque& s) : deque() {
-  Node* cur = s.list_.head_;
-  while (cur) {
-    push_back(cur->data_);
-    cur = cur->next_;
+template <class T, class Allocator>
+ps::deque<T, Allocator>::deque(const deque& s)
+    : deque(alloc_traits::select_on_container_copy_construction(
+          s.allocator_)) {
+  for (size_type i = 0; i < s.size_; ++i) {
+    push_back(s[i]);
   }
 }
 
-template <class T>
-ps::deque<T>::deque(deque&& s) {
-  list_.size_ = s.list_.size_;
-  list_.head_ = s.list_.head_;
-  list_.tail_ = s.list_.tail_;
-  s.list_.size_ = 0;
-  s.list_.head_ = nullptr;
-  s.list_.tail_ = nullptr;
+template <class T, class Allocator>
+ps::deque<T, Allocator>::deque(deque&& s) noexcept : allocator_(s.allocator_) {
+  swapStorage(s);
 }
 
-template <class T>
-ps::deque<T>& ps::deque<T>::operator=(const deque& other) {
+template <class T, class Allocator>
+ps::deque<T, Allocator>::~deque() {
+  release();
+}
+
+template <class T, class Allocator>
+ps::deque<T, Allocator>& ps::deque<T, Allocator>::operator=(
+    const deque& other) {
   if (this != &other) {
-    while (!empty()) {
-      pop_front();
+    if constexpr (alloc_traits::propagate_on_container_copy_assignment::
+                      value) {
+      if (allocator_ != other.allocator_) {
+        release();
+      }
+      allocator_ = other.allocator_;
     }
-    Node* cur = other.list_.head_;
-    while (cur) {
-      push_back(cur->data_);
-      cur = cur->next_;
+    clear();
+    for (size_type i = 0; i < other.size_; ++i) {
+      push_back(other[i]);
     }
   }
   return *this;
 }
 
-template <class T>
-ps::deque<T>& ps::deque<T>::operator=(deque&& other) {
-  if (this != &other) {
-    while (!empty()) {
-      pop_front();
+/** Takes other's blocks when the allocators allow it, as vector does. */
+template <class T, class Allocator>
+ps::deque<T, Allocator>& ps::deque<T, Allocator>::operator=(
+    deque&& other) noexcept(kMoveTakesStorage) {
+  if (this == &other) {
+    return *this;
+  }
+  if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+    release();
+    allocator_ = std::move(other.allocator_);
+    swapStorage(other);
+  } else if (kMoveTakesStorage || allocator_ == other.allocator_) {
+    release();
+    swapStorage(other);
+  } else {
+    clear();
+    for (size_type i = 0; i < other.size_; ++i) {
+      push_back(std::move(other[i]));
     }
-    list_.size_ = other.list_.size_;
-    list_.head_ = other.list_.head_;
-    list_.tail_ = other.list_.tail_;
-    other.list_.size_ = 0;
-    other.list_.head_ = nullptr;
-    other.list_.tail_ = nullptr;
+    other.clear();
   }
   return *this;
 }
 
-template <class T>
-typename ps::deque<T>::reference ps::deque<T>::front() {
-  return list_.head_->data_;
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::allocator_type
+ps::deque<T, Allocator>::get_allocator() const noexcept {
+  return allocator_;
 }
 
-template <class T>
-typename ps::deque<T>::const_reference ps::deque<T>::front() const {
-  return list_.head_->data_;
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::reference ps::deque<T, Allocator>::at(
+    size_type pos) {
+  if (pos >= size_) {
+    throw std::out_of_range("Out of range");
+  }
+  return *slot(pos);
 }
 
-template <class T>
-typename ps::deque<T>::reference ps::deque<T>::back() {
-  return list_.tail_->data_;
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::const_reference
+ps::deque<T, Allocator>::at(size_type pos) const {
+  if (pos >= size_) {
+    throw std::out_of_range("Out of range");
+  }
+  return *slot(pos);
 }
 
-template <class T>
-typename ps::deque<T>::const_reference ps::deque<T>::back() const {
-  return list_.tail_->data_;
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::reference
+ps::deque<T, Allocator>::operator[](size_type pos) {
+  return *slot(pos);
 }
 
-template <class T>
-bool ps::deque<T>::empty() const {
-  return list_.size_ == 0;
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::const_reference
+ps::deque<T, Allocator>::operator[](size_type pos) const {
+  return *slot(pos);
 }
 
-template <class T>
-typename ps::deque<T>::size_type ps::deque<T>::size() const {
-  return list_.size_;
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::reference ps::deque<T, Allocator>::front() {
+  return *slot(0);
 }
 
-template <class T>
-void ps::deque<T>::push_back(const T& value) {
-  Node* tmp = new Node(value);
-  tmp->prev_ = list_.tail_;
-  tmp->next_ = nullptr;
-  if (list_.tail_) list_.tail_->next_ = tmp;
-  list_.tail_ = tmp;
-  if (!list_.head_) list_.head_ = tmp;
-  ++list_.size_;
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::const_reference
+ps::deque<T, Allocator>::front() const {
+  return *slot(0);
 }
 
-template <class T>
-void ps::deque<T>::push_front(const T& value) {
-  Node* tmp = new Node(value);
-  tmp->prev_ = nullptr;
-  tmp->next_ = list_.head_;
-  if (list_.head_) list_.head_->prev_ = tmp;
-  list_.head_ = tmp;
-  if (!list_.tail_) list_.tail_ = tmp;
-  ++list_.size_;
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::reference ps::deque<T, Allocator>::back() {
+  return *slot(size_ - 1);
 }
 
-template <class T>
-void ps::deque<T>::pop_back() {
-  if (list_.tail_) {
-    Node* tmp = list_.tail_;
-    list_.tail_ = list_.tail_->prev_;
-    delete tmp;
-    if (list_.tail_)
-      list_.tail_->next_ = nullptr;
-    else
-      list_.head_ = nullptr;
-    --list_.size_;
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::const_reference
+ps::deque<T, Allocator>::back() const {
+  return *slot(size_ - 1);
+}
+
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::iterator
+ps::deque<T, Allocator>::begin() noexcept {
+  return iterator(this, 0);
+}
+
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::const_iterator
+ps::deque<T, Allocator>::begin() const noexcept {
+  return const_iterator(this, 0);
+}
+
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::const_iterator
+ps::deque<T, Allocator>::cbegin() const noexcept {
+  return const_iterator(this, 0);
+}
+
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::iterator
+ps::deque<T, Allocator>::end() noexcept {
+  return iterator(this, size_);
+}
+
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::const_iterator
+ps::deque<T, Allocator>::end() const noexcept {
+  return const_iterator(this, size_);
+}
+
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::const_iterator
+ps::deque<T, Allocator>::cend() const noexcept {
+  return const_iterator(this, size_);
+}
+
+template <class T, class Allocator>
+bool ps::deque<T, Allocator>::empty() const {
+  return size_ == 0;
+}
+
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::size_type ps::deque<T, Allocator>::size()
+    const {
+  return size_;
+}
+
+/** How many elements fit before the map has to grow. */
+template <class T, class Allocator>
+typename ps::deque<T, Allocator>::size_type
+ps::deque<T, Allocator>::capacity() const noexcept {
+  return map_blocks_ * kBlockSize;
+}
+
+/** Frees the blocks that hold no elements. */
+template <class T, class Allocator>
+void ps::deque<T, Allocator>::shrink_to_fit() {
+  size_type head_block = head_ / kBlockSize;
+  for (size_type i = 0; i < map_blocks_; ++i) {
+    // Distance from head_ to the first position of block i, along the ring.
+    size_type distance = (i * kBlockSize - head_) & mask_;
+    bool used = size_ > 0 && (i == head_block || distance < size_);
+    if (map_[i] && !used) {
+      deallocateBlock(map_[i]);
+      map_[i] = nullptr;
+    }
   }
 }
 
-template <class T>
-void ps::deque<T>::pop_front() {
-  if (list_.head_) {
-    Node* tmp = list_.head_;
-    list_.head_ = list_.head_->next_;
-    delete tmp;
-    if (list_.head_)
-      list_.head_->prev_ = nullptr;
-    else
-      list_.tail_ = nullptr;
-    --list_.size_;
+template <class T, class Allocator>
+void ps::deque<T, Allocator>::push_back(const T& value) {
+  emplace_back(value);
+}
+
+template <class T, class Allocator>
+void ps::deque<T, Allocator>::push_back(T&& value) {
+  emplace_back(std::move(value));
+}
+
+template <class T, class Allocator>
+void ps::deque<T, Allocator>::push_front(const T& value) {
+  emplace_front(value);
+}
+
+template <class T, class Allocator>
+void ps::deque<T, Allocator>::push_front(T&& value) {
+  emplace_front(std::move(value));
+}
+
+template <class T, class Allocator>
+template <class... Args>
+typename ps::deque<T, Allocator>::reference
+ps::deque<T, Allocator>::emplace_back(Args&&... args) {
+  if (size_ == capacity()) {
+    grow();
   }
+  T* place = claim((head_ + size_) & mask_);
+  alloc_traits::construct(allocator_, place, std::forward<Args>(args)...);
+  ++size_;
+  return *place;
 }
 
-template <class T>
-void ps::deque<T>::clear() noexcept {
-  while (!empty()) {
-    pop_front();
+template <class T, class Allocator>
+template <class... Args>
+typename ps::deque<T, Allocator>::reference
+ps::deque<T, Allocator>::emplace_front(Args&&... args) {
+  if (size_ == capacity()) {
+    grow();
   }
-  list_.size_ = 0;
-  list_.head_ = nullptr;
-  list_.tail_ = nullptr;
+  size_type pos = (head_ - 1) & mask_;
+  T* place = claim(pos);
+  alloc_traits::construct(allocator_, place, std::forward<Args>(args)...);
+  head_ = pos;
+  ++size_;
+  return *place;
 }
 
-template <class T>
-void ps::deque<T>::swap(deque& other) {
-  std::swap(list_.size_, other.list_.size_);
-  std::swap(list_.head_, other.list_.head_);
-  std::swap(list_.tail_, other.list_.tail_);
+template <class T, class Allocator>
+void ps::deque<T, Allocator>::pop_back() {
+  if (size_ > 0) {
+    alloc_traits::destroy(allocator_, slot(size_ - 1));
+    --size_;
+  }
+}
+
+template <class T, class Allocator>
+void ps::deque<T, Allocator>::pop_front() {
+  if (size_ > 0) {
+    alloc_traits::destroy(allocator_, slot(0));
+    head_ = (head_ + 1) & mask_;
+    --size_;
+  }
+}
+
+/** Destroys the elements but keeps the blocks for reuse. */
+template <class T, class Allocator>
+void ps::deque<T, Allocator>::clear() noexcept {
+  for (size_type i = 0; i < size_; ++i) {
+    alloc_traits::destroy(allocator_, slot(i));
+  }
+  size_ = 0;
+  head_ = 0;
+}
+
+/** Swaps the allocators only if they propagate on swap; see vector. */
+template <class T, class Allocator>
+void ps::deque<T, Allocator>::swap(deque& other) noexcept {
+  if constexpr (alloc_traits::propagate_on_container_swap::value) {
+    std::swap(allocator_, other.allocator_);
+  }
+  swapStorage(other);
+}
+
+template <class T, class Allocator>
+T* ps::deque<T, Allocator>::slot(size_type pos) const {
+  size_type ring_pos = (head_ + pos) & mask_;
+  return map_[ring_pos / kBlockSize] + (ring_pos & kBlockMask);
+}
+
+/** The storage at ring_pos, allocating its block if need be. */
+template <class T, class Allocator>
+T* ps::deque<T, Allocator>::claim(size_type ring_pos) {
+  T*& block = map_[ring_pos / kBlockSize];
+  if (!block) {
+    block = allocateBlock();
+  }
+  return block + (ring_pos & kBlockMask);
+}
+
+/**
+ * Doubles the map of a full ring. With the ring twice as large, element i
+ * still sits at (head_ + i) & mask_, which for the elements that had
+ * wrapped past the end is now their old position plus the old capacity.
+ * So the blocks before the head block move up by the old block count,
+ * the ones after it stay, and the wrapped front part of the head block
+ * itself is moved into a new block.
+ */
+template <class T, class Allocator>
+void ps::deque<T, Allocator>::grow() {
+  size_type old_blocks = map_blocks_;
+  size_type new_blocks = old_blocks == 0 ? 1 : old_blocks * 2;
+  map_allocator map_alloc(allocator_);
+  T** map = map_traits::allocate(map_alloc, new_blocks);
+  std::uninitialized_fill_n(map, new_blocks, nullptr);
+  size_type head_block = head_ / kBlockSize;
+  size_type head_offset = head_ & kBlockMask;
+  for (size_type i = 0; i < old_blocks; ++i) {
+    map[i < head_block ? i + old_blocks : i] = map_[i];
+  }
+  if (head_offset > 0) {
+    T* from = map_[head_block];
+    T* to = map[head_block + old_blocks] = allocateBlock();
+    for (size_type i = 0; i < head_offset; ++i) {
+      alloc_traits::construct(allocator_, to + i, std::move(from[i]));
+      alloc_traits::destroy(allocator_, from + i);
+    }
+  }
+  if (map_) {
+    map_traits::deallocate(map_alloc, map_, old_blocks);
+  }
+  map_ = map;
+  map_blocks_ = new_blocks;
+  mask_ = new_blocks * kBlockSize - 1;
+}
+
+template <class T, class Allocator>
+T* ps::deque<T, Allocator>::allocateBlock() {
+  return alloc_traits::allocate(allocator_, kBlockSize);
+}
+
+template <class T, class Allocator>
+void ps::deque<T, Allocator>::deallocateBlock(T* block) {
+  alloc_traits::deallocate(allocator_, block, kBlockSize);
+}
+
+/** Destroys the elements and frees all memory. */
+template <class T, class Allocator>
+void ps::deque<T, Allocator>::release() noexcept {
+  clear();
+  for (size_type i = 0; i < map_blocks_; ++i) {
+    if (map_[i]) {
+      deallocateBlock(map_[i]);
+    }
+  }
+  if (map_) {
+    map_allocator map_alloc(allocator_);
+    map_traits::deallocate(map_alloc, map_, map_blocks_);
+  }
+  map_ = nullptr;
+  map_blocks_ = 0;
+  mask_ = 0;
+}
+
+/** Swaps everything but the allocators. */
+template <class T, class Allocator>
+void ps::deque<T, Allocator>::swapStorage(deque& other) noexcept {
+  std::swap(map_, other.map_);
+  std::swap(map_blocks_, other.map_blocks_);
+  std::swap(mask_, other.mask_);
+  std::swap(head_, other.head_);
+  std::swap(size_, other.size_);
 }
 
-#endif  // CONTAINERS_SRC_PS_DEQUE_H_
\ No newline at end of file
+#endif  // CONTAINERS_SRC_PS_DEQUE_H_
@@ -0,0 +1,489 @@
+#ifndef CONTAINERS_SRC_PS_FLAT_MAP_H_
+#define CONTAINERS_SRC_PS_FLAT_MAP_H_
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "ps_flat_tree.h"
+#include "ps_small_vector.h"
+
+namespace ps {
+
+/**
+ * Sorted map with the interface of map, stored as a FlatTree: keys and
+ * values live in two contiguous vectors, so lookups and iteration touch a
+ * fraction of the cache lines a node-based map does. Insertion and erasure
+ * are O(n) and invalidate iterators, which makes it a fit for tables that
+ * are loaded once, ideally through insert_many or the initializer list,
+ * and then only read. With Eytzinger set lookups use a branch-free search
+ * over a cache-friendly copy of the keys; see flat_index.
+ *
+ * Keys and values take their memory from Allocator, rebound to Key and T;
+ * ps::pmr::flat_map takes it from a std::pmr::memory_resource.
+ */
+template <typename Key, typename T, typename Compare = std::less<>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>,
+          bool Eytzinger = false>
+class flat_map {
+  using tree_type = FlatTree<Key, T, Compare, Allocator, Eytzinger>;
+
+  /** A pair of references can not be pointed to, so -> returns this. */
+  template <typename Ref>
+  struct ArrowProxy {
+    Ref ref;
+    const Ref *operator->() const { return &ref; }
+  };
+
+  /**
+   * Mapped is T for iterator and const T for const_iterator. It yields a
+   * pair of references, so it is only a bidirectional iterator even though
+   * keys and values are contiguous.
+   */
+  template <typename Mapped>
+  class FlatMapIterator {
+    friend flat_map<Key, T, Compare, Allocator, Eytzinger>;
+    const Key *_key;
+    Mapped *_value;
+
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = std::pair<const Key, std::remove_const_t<Mapped>>;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::pair<const Key &, Mapped &>;
+    using pointer = ArrowProxy<reference>;
+
+    FlatMapIterator() {}
+    explicit FlatMapIterator(const Key *key, Mapped *value)
+        : _key(key), _value(value) {}
+    template <typename Other,
+              typename = std::enable_if_t<std::is_const_v<Mapped> &&
+                                          !std::is_same_v<Other, Mapped>>>
+    FlatMapIterator(const FlatMapIterator<Other> &other)
+        : _key(other.key()), _value(other.value()) {}
+
+    const Key *key() const { return _key; }
+    Mapped *value() const { return _value; }
+
+    reference operator*() const { return reference(*_key, *_value); }
+    pointer operator->() const { return {**this}; }
+
+    FlatMapIterator &operator++() {
+      ++_key;
+      ++_value;
+      return *this;
+    }
+
+    FlatMapIterator operator++(int) {
+      FlatMapIterator tmp(*this);
+      ++(*this);
+      return tmp;
+    }
+
+    FlatMapIterator &operator--() {
+      --_key;
+      --_value;
+      return *this;
+    }
+
+    FlatMapIterator operator--(int) {
+      FlatMapIterator tmp(*this);
+      --(*this);
+      return tmp;
+    }
+
+    bool operator==(const FlatMapIterator &other) const noexcept {
+      return other._key == _key;
+    }
+    bool operator!=(const FlatMapIterator &other) const noexcept {
+      return other._key != _key;
+    }
+  };
+
+  tree_type _tree;
+
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using iterator = FlatMapIterator<T>;
+  using const_iterator = FlatMapIterator<const T>;
+  using size_type = size_t;
+  using key_compare = Compare;
+  using allocator_type = Allocator;
+  using key_container_type = typename tree_type::keys_type;
+  using mapped_container_type = typename tree_type::values_type;
+
+  flat_map() = default;
+  explicit flat_map(const Compare &comp,
+                    const Allocator &allocator = Allocator());
+  explicit flat_map(const Allocator &allocator);
+  flat_map(std::initializer_list<value_type> const &items,
+           const Allocator &allocator = Allocator());
+
+  mapped_type &operator[](const Key &key);
+
+  bool empty() const noexcept;
+  size_type size() const noexcept;
+  size_type max_size() const noexcept;
+  key_compare key_comp() const;
+  allocator_type get_allocator() const;
+
+  T &at(const Key &key);
+  const T &at(const Key &key) const;
+
+  iterator begin() noexcept;
+  const_iterator begin() const noexcept;
+  const_iterator cbegin() const noexcept;
+  iterator end() noexcept;
+  const_iterator end() const noexcept;
+  const_iterator cend() const noexcept;
+
+  const key_container_type &keys() const noexcept;
+  const mapped_container_type &values() const noexcept;
+
+  void clear() noexcept;
+  void reserve(size_type count);
+  std::pair<iterator, bool> insert(const value_type &value);
+  std::pair<iterator, bool> insert(const Key &key, const T &obj);
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const Key &key, Args &&...args);
+  std::pair<iterator, bool> insert_or_assign(const Key &key, const T &obj);
+  void erase(iterator pos);
+  size_type erase(const Key &key);
+  void swap(flat_map &other) noexcept;
+  void merge(flat_map &other);
+
+  iterator find(const Key &key);
+  const_iterator find(const Key &key) const;
+  bool contains(const Key &key) const;
+  size_type count(const Key &key) const;
+
+  template <class... Args>
+  insert_many_result<iterator> insert_many(Args &&...args);
+
+ private:
+  iterator iteratorAt(size_t index);
+  const_iterator iteratorAt(size_t index) const;
+};
+
+/** flat_map searched through an Eytzinger-ordered copy of its keys. */
+template <typename Key, typename T, typename Compare = std::less<>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
+using eytzinger_flat_map = flat_map<Key, T, Compare, Allocator, true>;
+
+namespace pmr {
+template <typename Key, typename T, typename Compare = std::less<>>
+using flat_map =
+    ps::flat_map<Key, T, Compare,
+                 std::pmr::polymorphic_allocator<std::pair<const Key, T>>>;
+}  // namespace pmr
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+flat_map<Key, T, Compare, Allocator, Eytzinger>::flat_map(
+    const Compare &comp, const Allocator &allocator)
+    : _tree(comp, allocator) {}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+flat_map<Key, T, Compare, Allocator, Eytzinger>::flat_map(
+    const Allocator &allocator)
+    : _tree(Compare(), allocator) {}
+
+/** Loads items with a single sort; on duplicates the first one is kept. */
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+flat_map<Key, T, Compare, Allocator, Eytzinger>::flat_map(
+    std::initializer_list<value_type> const &items, const Allocator &allocator)
+    : _tree(Compare(), allocator) {
+  _tree.insertBulk(std::vector<value_type>(items));
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::iterator
+flat_map<Key, T, Compare, Allocator, Eytzinger>::iteratorAt(size_t index) {
+  return iterator(_tree.keys().data() + index,
+                  _tree.values().data() + index);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::const_iterator
+flat_map<Key, T, Compare, Allocator, Eytzinger>::iteratorAt(
+    size_t index) const {
+  return const_iterator(_tree.keys().data() + index,
+                        _tree.values().data() + index);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::mapped_type &
+flat_map<Key, T, Compare, Allocator, Eytzinger>::operator[](const Key &key) {
+  return _tree.values()[_tree.tryEmplace(key).first];
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+bool flat_map<Key, T, Compare, Allocator, Eytzinger>::empty() const noexcept {
+  return _tree.size() == 0;
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::size_type
+flat_map<Key, T, Compare, Allocator, Eytzinger>::size() const noexcept {
+  return _tree.size();
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::size_type
+flat_map<Key, T, Compare, Allocator, Eytzinger>::max_size() const noexcept {
+  return _tree.max_size();
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::key_compare
+flat_map<Key, T, Compare, Allocator, Eytzinger>::key_comp() const {
+  return _tree.keyComp();
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::allocator_type
+flat_map<Key, T, Compare, Allocator, Eytzinger>::get_allocator() const {
+  return _tree.getAllocator();
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+T &flat_map<Key, T, Compare, Allocator, Eytzinger>::at(const Key &key) {
+  size_t index = _tree.find(key);
+  if (index == _tree.size()) {
+    throw std::out_of_range("key does not exists");
+  }
+  return _tree.values()[index];
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+const T &flat_map<Key, T, Compare, Allocator, Eytzinger>::at(
+    const Key &key) const {
+  size_t index = _tree.find(key);
+  if (index == _tree.size()) {
+    throw std::out_of_range("key does not exists");
+  }
+  return _tree.values()[index];
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::iterator
+flat_map<Key, T, Compare, Allocator, Eytzinger>::begin() noexcept {
+  return iteratorAt(0);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::const_iterator
+flat_map<Key, T, Compare, Allocator, Eytzinger>::begin() const noexcept {
+  return iteratorAt(0);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::const_iterator
+flat_map<Key, T, Compare, Allocator, Eytzinger>::cbegin() const noexcept {
+  return iteratorAt(0);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::iterator
+flat_map<Key, T, Compare, Allocator, Eytzinger>::end() noexcept {
+  return iteratorAt(_tree.size());
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::const_iterator
+flat_map<Key, T, Compare, Allocator, Eytzinger>::end() const noexcept {
+  return iteratorAt(_tree.size());
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::const_iterator
+flat_map<Key, T, Compare, Allocator, Eytzinger>::cend() const noexcept {
+  return iteratorAt(_tree.size());
+}
+
+/** The keys in order, as one contiguous array. */
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+const typename flat_map<Key, T, Compare, Allocator,
+                        Eytzinger>::key_container_type &
+flat_map<Key, T, Compare, Allocator, Eytzinger>::keys() const noexcept {
+  return _tree.keys();
+}
+
+/** The mapped values, in the order of keys(). */
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+const typename flat_map<Key, T, Compare, Allocator,
+                        Eytzinger>::mapped_container_type &
+flat_map<Key, T, Compare, Allocator, Eytzinger>::values() const noexcept {
+  return _tree.values();
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+void flat_map<Key, T, Compare, Allocator, Eytzinger>::clear() noexcept {
+  _tree.clear();
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+void flat_map<Key, T, Compare, Allocator, Eytzinger>::reserve(size_type count) {
+  _tree.reserve(count);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+std::pair<typename flat_map<Key, T, Compare, Allocator, Eytzinger>::iterator,
+          bool>
+flat_map<Key, T, Compare, Allocator, Eytzinger>::insert(
+    const value_type &value) {
+  return try_emplace(value.first, value.second);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+std::pair<typename flat_map<Key, T, Compare, Allocator, Eytzinger>::iterator,
+          bool>
+flat_map<Key, T, Compare, Allocator, Eytzinger>::insert(const Key &key,
+                                                         const T &obj) {
+  return try_emplace(key, obj);
+}
+
+/** Bulk-loads [first, last) with one sort and one merge. */
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+template <typename InputIt>
+void flat_map<Key, T, Compare, Allocator, Eytzinger>::insert(InputIt first,
+                                                             InputIt last) {
+  _tree.insertBulk(std::vector<value_type>(first, last));
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+template <typename... Args>
+std::pair<typename flat_map<Key, T, Compare, Allocator, Eytzinger>::iterator,
+          bool>
+flat_map<Key, T, Compare, Allocator, Eytzinger>::try_emplace(const Key &key,
+                                                             Args &&...args) {
+  auto result = _tree.tryEmplace(key, std::forward<Args>(args)...);
+  return std::pair<iterator, bool>(iteratorAt(result.first), result.second);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+std::pair<typename flat_map<Key, T, Compare, Allocator, Eytzinger>::iterator,
+          bool>
+flat_map<Key, T, Compare, Allocator, Eytzinger>::insert_or_assign(
+    const Key &key, const T &obj) {
+  auto result = try_emplace(key, obj);
+  if (!result.second) {
+    *result.first._value = obj;
+  }
+  return result;
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+void flat_map<Key, T, Compare, Allocator, Eytzinger>::erase(iterator pos) {
+  _tree.eraseAt(static_cast<size_t>(pos._key - _tree.keys().data()));
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::size_type
+flat_map<Key, T, Compare, Allocator, Eytzinger>::erase(const Key &key) {
+  return _tree.erase(key) ? 1 : 0;
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+void flat_map<Key, T, Compare, Allocator, Eytzinger>::swap(
+    flat_map &other) noexcept {
+  _tree.swap(other._tree);
+}
+
+/**
+ * Moves the elements of other whose keys are not in this map over; the
+ * others stay in other.
+ */
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+void flat_map<Key, T, Compare, Allocator, Eytzinger>::merge(flat_map &other) {
+  _tree.mergeFrom(other._tree);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::iterator
+flat_map<Key, T, Compare, Allocator, Eytzinger>::find(const Key &key) {
+  return iteratorAt(_tree.find(key));
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::const_iterator
+flat_map<Key, T, Compare, Allocator, Eytzinger>::find(const Key &key) const {
+  return iteratorAt(_tree.find(key));
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+bool flat_map<Key, T, Compare, Allocator, Eytzinger>::contains(
+    const Key &key) const {
+  return _tree.find(key) != _tree.size();
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+typename flat_map<Key, T, Compare, Allocator, Eytzinger>::size_type
+flat_map<Key, T, Compare, Allocator, Eytzinger>::count(const Key &key) const {
+  return contains(key) ? 1 : 0;
+}
+
+/**
+ * Inserts all arguments with one sort and one merge instead of shifting
+ * the tail once per element. The iterators are looked up afterwards, as
+ * the merge moves everything.
+ */
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Eytzinger>
+template <class... Args>
+insert_many_result<
+    typename flat_map<Key, T, Compare, Allocator, Eytzinger>::iterator>
+flat_map<Key, T, Compare, Allocator, Eytzinger>::insert_many(Args &&...args) {
+  std::vector<value_type> items{value_type(std::forward<Args>(args))...};
+  std::vector<bool> inserted = _tree.insertBulk(items);
+  insert_many_result<iterator> res;
+  for (size_t i = 0; i < items.size(); i++) {
+    res.push_back(std::pair<iterator, bool>(
+        iteratorAt(_tree.find(items[i].first)), inserted[i]));
+  }
+  return res;
+}
+
+}  // namespace ps
+
+#endif  // CONTAINERS_SRC_PS_FLAT_MAP_H_
@@ -0,0 +1,246 @@
+#ifndef CONTAINERS_SRC_PS_FLAT_SET_H_
+#define CONTAINERS_SRC_PS_FLAT_SET_H_
+
+#include "ps_flat_tree.h"
+#include "ps_small_vector.h"
+
+namespace ps {
+
+/**
+ * Sorted set with the interface of set, stored as a FlatTree with no
+ * mapped values: the keys are one contiguous vector, and iterators are
+ * plain pointers into it. Insertion and erasure are O(n) and invalidate
+ * iterators; see flat_map. The keys take their memory from Allocator;
+ * ps::pmr::flat_set takes it from a std::pmr::memory_resource.
+ */
+template <typename Key, typename Compare = std::less<>,
+          typename Allocator = std::allocator<Key>, bool Eytzinger = false>
+class flat_set {
+  using tree_type = FlatTree<Key, void, Compare, Allocator, Eytzinger>;
+
+  tree_type _tree;
+
+ public:
+  using key_type = Key;
+  using value_type = Key;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using iterator = const Key *;
+  using const_iterator = const Key *;
+  using size_type = size_t;
+  using key_compare = Compare;
+  using allocator_type = Allocator;
+  using container_type = typename tree_type::keys_type;
+
+  flat_set() = default;
+  explicit flat_set(const Compare &comp,
+                    const Allocator &allocator = Allocator());
+  explicit flat_set(const Allocator &allocator);
+  flat_set(std::initializer_list<value_type> const &items,
+           const Allocator &allocator = Allocator());
+
+  bool empty() const noexcept;
+  size_type size() const noexcept;
+  size_type max_size() const noexcept;
+  key_compare key_comp() const;
+  allocator_type get_allocator() const;
+
+  iterator begin() const noexcept;
+  iterator cbegin() const noexcept;
+  iterator end() const noexcept;
+  iterator cend() const noexcept;
+
+  const container_type &keys() const noexcept;
+
+  void clear() noexcept;
+  void reserve(size_type count);
+  std::pair<iterator, bool> insert(const value_type &value);
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last);
+  void erase(iterator pos);
+  size_type erase(const Key &key);
+  void swap(flat_set &other) noexcept;
+  void merge(flat_set &other);
+
+  iterator find(const Key &key) const;
+  bool contains(const Key &key) const;
+  size_type count(const Key &key) const;
+
+  template <class... Args>
+  insert_many_result<iterator> insert_many(Args &&...args);
+};
+
+/** flat_set searched through an Eytzinger-ordered copy of its keys. */
+template <typename Key, typename Compare = std::less<>,
+          typename Allocator = std::allocator<Key>>
+using eytzinger_flat_set = flat_set<Key, Compare, Allocator, true>;
+
+namespace pmr {
+template <typename Key, typename Compare = std::less<>>
+using flat_set =
+    ps::flat_set<Key, Compare, std::pmr::polymorphic_allocator<Key>>;
+}  // namespace pmr
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+flat_set<Key, Compare, Allocator, Eytzinger>::flat_set(
+    const Compare &comp, const Allocator &allocator)
+    : _tree(comp, allocator) {}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+flat_set<Key, Compare, Allocator, Eytzinger>::flat_set(
+    const Allocator &allocator)
+    : _tree(Compare(), allocator) {}
+
+/** Loads items with a single sort. */
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+flat_set<Key, Compare, Allocator, Eytzinger>::flat_set(
+    std::initializer_list<value_type> const &items, const Allocator &allocator)
+    : _tree(Compare(), allocator) {
+  _tree.insertBulk(std::vector<value_type>(items));
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+bool flat_set<Key, Compare, Allocator, Eytzinger>::empty() const noexcept {
+  return _tree.size() == 0;
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+typename flat_set<Key, Compare, Allocator, Eytzinger>::size_type
+flat_set<Key, Compare, Allocator, Eytzinger>::size() const noexcept {
+  return _tree.size();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+typename flat_set<Key, Compare, Allocator, Eytzinger>::size_type
+flat_set<Key, Compare, Allocator, Eytzinger>::max_size() const noexcept {
+  return _tree.max_size();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+typename flat_set<Key, Compare, Allocator, Eytzinger>::key_compare
+flat_set<Key, Compare, Allocator, Eytzinger>::key_comp() const {
+  return _tree.keyComp();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+typename flat_set<Key, Compare, Allocator, Eytzinger>::allocator_type
+flat_set<Key, Compare, Allocator, Eytzinger>::get_allocator() const {
+  return _tree.getAllocator();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+typename flat_set<Key, Compare, Allocator, Eytzinger>::iterator
+flat_set<Key, Compare, Allocator, Eytzinger>::begin() const noexcept {
+  return _tree.keys().data();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+typename flat_set<Key, Compare, Allocator, Eytzinger>::iterator
+flat_set<Key, Compare, Allocator, Eytzinger>::cbegin() const noexcept {
+  return begin();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+typename flat_set<Key, Compare, Allocator, Eytzinger>::iterator
+flat_set<Key, Compare, Allocator, Eytzinger>::end() const noexcept {
+  return _tree.keys().data() + _tree.size();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+typename flat_set<Key, Compare, Allocator, Eytzinger>::iterator
+flat_set<Key, Compare, Allocator, Eytzinger>::cend() const noexcept {
+  return end();
+}
+
+/** The keys in order, as one contiguous array. */
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+const typename flat_set<Key, Compare, Allocator, Eytzinger>::container_type &
+flat_set<Key, Compare, Allocator, Eytzinger>::keys() const noexcept {
+  return _tree.keys();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+void flat_set<Key, Compare, Allocator, Eytzinger>::clear() noexcept {
+  _tree.clear();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+void flat_set<Key, Compare, Allocator, Eytzinger>::reserve(size_type count) {
+  _tree.reserve(count);
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+std::pair<typename flat_set<Key, Compare, Allocator, Eytzinger>::iterator, bool>
+flat_set<Key, Compare, Allocator, Eytzinger>::insert(const value_type &value) {
+  auto result = _tree.tryEmplace(value);
+  return std::pair<iterator, bool>(begin() + result.first, result.second);
+}
+
+/** Bulk-loads [first, last) with one sort and one merge. */
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+template <typename InputIt>
+void flat_set<Key, Compare, Allocator, Eytzinger>::insert(InputIt first,
+                                                          InputIt last) {
+  _tree.insertBulk(std::vector<value_type>(first, last));
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+void flat_set<Key, Compare, Allocator, Eytzinger>::erase(iterator pos) {
+  _tree.eraseAt(static_cast<size_t>(pos - begin()));
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+typename flat_set<Key, Compare, Allocator, Eytzinger>::size_type
+flat_set<Key, Compare, Allocator, Eytzinger>::erase(const Key &key) {
+  return _tree.erase(key) ? 1 : 0;
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+void flat_set<Key, Compare, Allocator, Eytzinger>::swap(
+    flat_set &other) noexcept {
+  _tree.swap(other._tree);
+}
+
+/** Moves the keys of other that are not in this set over. */
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+void flat_set<Key, Compare, Allocator, Eytzinger>::merge(flat_set &other) {
+  _tree.mergeFrom(other._tree);
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+typename flat_set<Key, Compare, Allocator, Eytzinger>::iterator
+flat_set<Key, Compare, Allocator, Eytzinger>::find(const Key &key) const {
+  return begin() + _tree.find(key);
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+bool flat_set<Key, Compare, Allocator, Eytzinger>::contains(
+    const Key &key) const {
+  return _tree.find(key) != _tree.size();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+typename flat_set<Key, Compare, Allocator, Eytzinger>::size_type
+flat_set<Key, Compare, Allocator, Eytzinger>::count(const Key &key) const {
+  return contains(key) ? 1 : 0;
+}
+
+/** Inserts all arguments with one sort and one merge; see flat_map. */
+template <typename Key, typename Compare, typename Allocator, bool Eytzinger>
+template <class... Args>
+insert_many_result<
+    typename flat_set<Key, Compare, Allocator, Eytzinger>::iterator>
+flat_set<Key, Compare, Allocator, Eytzinger>::insert_many(Args &&...args) {
+  std::vector<value_type> items{value_type(std::forward<Args>(args))...};
+  std::vector<bool> inserted = _tree.insertBulk(items);
+  insert_many_result<iterator> res;
+  for (size_t i = 0; i < items.size(); i++) {
+    res.push_back(
+        std::pair<iterator, bool>(find(items[i]), inserted[i]));
+  }
+  return res;
+}
+
+}  // namespace ps
+
+#endif  // CONTAINERS_SRC_PS_FLAT_SET_H_
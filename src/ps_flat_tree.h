@@ -0,0 +1,373 @@
+#ifndef CONTAINERS_SRC_PS_FLAT_TREE_H_
+#define CONTAINERS_SRC_PS_FLAT_TREE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ps_node_traits.h"
+#include "ps_vector.h"
+
+namespace ps {
+
+/**
+ * flat_index - how a FlatTree searches its sorted keys. The plain version
+ * keeps nothing and binary searches the keys themselves.
+ */
+template <typename K, bool Eytzinger, typename Allocator = std::allocator<K>>
+class flat_index {
+ public:
+  flat_index() = default;
+  explicit flat_index(const Allocator &) {}
+
+  void rebuild(const vector<K, Allocator> &) {}
+
+  /** Position of key in sorted, or sorted.size() if it is not there. */
+  template <typename Key2, typename Compare>
+  size_t find(const vector<K, Allocator> &sorted, const Key2 &key,
+              const Compare &comp) const {
+    auto it = std::lower_bound(sorted.begin(), sorted.end(), key, comp);
+    if (it == sorted.end() || comp(key, *it)) {
+      return sorted.size();
+    }
+    return static_cast<size_t>(it - sorted.begin());
+  }
+};
+
+/**
+ * The Eytzinger version keeps a second copy of the keys in BFS order of
+ * the implicit search tree: node k has its children at 2k and 2k + 1. The
+ * search then reads memory front to back, its next cache lines can be
+ * prefetched while the current one is compared, and every step is a
+ * branch-free k = 2k + less. rank_ maps a node back to its sorted position.
+ * Both take their memory from Allocator, like the keys they index.
+ */
+template <typename K, typename Allocator>
+class flat_index<K, true, Allocator> {
+  using rank_allocator = typename std::allocator_traits<
+      Allocator>::template rebind_alloc<size_t>;
+
+  // Both are 1-based: slot 0 is unused.
+  vector<K, Allocator> keys_;
+  vector<size_t, rank_allocator> rank_;
+
+  void fill(const vector<K, Allocator> &sorted, size_t k, size_t &next) {
+    if (k < keys_.size()) {
+      fill(sorted, 2 * k, next);
+      keys_[k] = sorted[next];
+      rank_[k] = next++;
+      fill(sorted, 2 * k + 1, next);
+    }
+  }
+
+ public:
+  flat_index() = default;
+  explicit flat_index(const Allocator &allocator)
+      : keys_(allocator), rank_(rank_allocator(allocator)) {}
+
+  void rebuild(const vector<K, Allocator> &sorted) {
+    keys_ = vector<K, Allocator>(sorted.size() + 1, keys_.get_allocator());
+    rank_ = vector<size_t, rank_allocator>(sorted.size() + 1,
+                                           rank_.get_allocator());
+    size_t next = 0;
+    fill(sorted, 1, next);
+  }
+
+  template <typename Key2, typename Compare>
+  size_t find(const vector<K, Allocator> &sorted, const Key2 &key,
+              const Compare &comp) const {
+    // The 16 descendants of k four levels down are adjacent, for int keys
+    // a cache line or two: fetch them while the levels in between are
+    // compared. A prefetch past the end is harmless and is not checked.
+    constexpr size_t kAhead = 16;
+    auto base = reinterpret_cast<uintptr_t>(keys_.data());
+    size_t n = sorted.size();
+    size_t k = 1;
+    while (k <= n) {
+      __builtin_prefetch(
+          reinterpret_cast<const void *>(base + kAhead * k * sizeof(K)));
+      k = 2 * k + static_cast<size_t>(comp(keys_[k], key));
+    }
+    // Undo the right turns taken after the last left turn; that node is
+    // the lower bound, or 0 if the search only ever went right. Its key is
+    // still in cache, so only a hit has to go through rank_.
+    k >>= __builtin_ffsll(static_cast<long long>(~k));
+    if (k == 0 || comp(key, keys_[k])) {
+      return n;
+    }
+    return rank_[k];
+  }
+};
+
+/** FlatTree keeps no mapped values when V is void. */
+struct no_flat_values {
+  no_flat_values() = default;
+  template <typename Allocator>
+  explicit no_flat_values(const Allocator &) {}
+};
+
+/**
+ * FlatTree - sorted keys in one vector and, unless V is void, the mapped
+ * values at the same positions in another. Lookups are O(log n) through a
+ * flat_index; a single insertion or erasure shifts everything behind it
+ * and is O(n). Batches should go through insertBulk, which sorts only the
+ * new elements and merges them in a single pass.
+ *
+ * Both vectors and the index take their memory from Allocator, rebound to
+ * their element types.
+ */
+template <typename K, typename V, typename Compare = std::less<>,
+          typename Allocator = std::allocator<K>, bool Eytzinger = false>
+class FlatTree {
+  using traits = node_traits<K, V>;
+  template <typename U>
+  using rebind_alloc =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+  static constexpr bool kHasValues = !std::is_void_v<V>;
+
+ public:
+  using value_type = typename node_traits<K, V>::value_type;
+  using keys_type = vector<K, rebind_alloc<K>>;
+  using values_type =
+      std::conditional_t<std::is_void_v<V>, no_flat_values,
+                         vector<V, rebind_alloc<V>>>;
+
+ private:
+  keys_type _keys;
+  values_type _values;
+  flat_index<K, Eytzinger, rebind_alloc<K>> _index;
+  Compare _comp;
+
+ public:
+  FlatTree() = default;
+  explicit FlatTree(const Compare &comp,
+                    const Allocator &allocator = Allocator())
+      : _keys(rebind_alloc<K>(allocator)),
+        _values(allocator),
+        _index(rebind_alloc<K>(allocator)),
+        _comp(comp) {}
+
+  Allocator getAllocator() const { return Allocator(_keys.get_allocator()); }
+  size_t size() const { return _keys.size(); }
+  size_t max_size() const { return _keys.max_size(); }
+  const Compare &keyComp() const { return _comp; }
+  const keys_type &keys() const { return _keys; }
+  values_type &values() { return _values; }
+  const values_type &values() const { return _values; }
+
+  template <typename Key2>
+  size_t lowerBound(const Key2 &key) const;
+  template <typename Key2>
+  size_t find(const Key2 &key) const;
+  template <typename Key2, typename... Args>
+  std::pair<size_t, bool> tryEmplace(Key2 &&key, Args &&...args);
+  void eraseAt(size_t index);
+  template <typename Key2>
+  bool erase(const Key2 &key);
+  void clear();
+  void reserve(size_t count);
+  std::vector<bool> insertBulk(const std::vector<value_type> &items);
+  void mergeFrom(FlatTree &other);
+  void swap(FlatTree &other) noexcept;
+};
+
+/** Position of the first key not less than key, by plain binary search. */
+template <typename K, typename V, typename Compare, typename Allocator,
+          bool Eytzinger>
+template <typename Key2>
+size_t FlatTree<K, V, Compare, Allocator, Eytzinger>::lowerBound(
+    const Key2 &key) const {
+  auto it = std::lower_bound(_keys.begin(), _keys.end(), key, _comp);
+  return static_cast<size_t>(it - _keys.begin());
+}
+
+/** Position of key, or size() if it is not there. */
+template <typename K, typename V, typename Compare, typename Allocator,
+          bool Eytzinger>
+template <typename Key2>
+size_t FlatTree<K, V, Compare, Allocator, Eytzinger>::find(
+    const Key2 &key) const {
+  return _index.find(_keys, key, _comp);
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          bool Eytzinger>
+template <typename Key2, typename... Args>
+std::pair<size_t, bool>
+FlatTree<K, V, Compare, Allocator, Eytzinger>::tryEmplace(Key2 &&key,
+                                                          Args &&...args) {
+  size_t index = lowerBound(key);
+  if (index != _keys.size() && !_comp(key, _keys[index])) {
+    return {index, false};
+  }
+  // Append, then rotate the new element into place.
+  _keys.push_back(K(std::forward<Key2>(key)));
+  std::rotate(_keys.begin() + index, _keys.end() - 1, _keys.end());
+  if constexpr (kHasValues) {
+    _values.push_back(V(std::forward<Args>(args)...));
+    std::rotate(_values.begin() + index, _values.end() - 1, _values.end());
+  }
+  _index.rebuild(_keys);
+  return {index, true};
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          bool Eytzinger>
+void FlatTree<K, V, Compare, Allocator, Eytzinger>::eraseAt(size_t index) {
+  _keys.erase(_keys.begin() + index);
+  if constexpr (kHasValues) {
+    _values.erase(_values.begin() + index);
+  }
+  _index.rebuild(_keys);
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          bool Eytzinger>
+template <typename Key2>
+bool FlatTree<K, V, Compare, Allocator, Eytzinger>::erase(const Key2 &key) {
+  size_t index = find(key);
+  if (index == _keys.size()) {
+    return false;
+  }
+  eraseAt(index);
+  return true;
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          bool Eytzinger>
+void FlatTree<K, V, Compare, Allocator, Eytzinger>::clear() {
+  _keys.clear();
+  if constexpr (kHasValues) {
+    _values.clear();
+  }
+  _index.rebuild(_keys);
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          bool Eytzinger>
+void FlatTree<K, V, Compare, Allocator, Eytzinger>::reserve(size_t count) {
+  _keys.reserve(count);
+  if constexpr (kHasValues) {
+    _values.reserve(count);
+  }
+}
+
+/**
+ * Adds items in O(n + m log m): the new items are sorted on their own and
+ * merged with the current elements in one pass, which moves the current
+ * elements into new vectors and copies the new ones. As with repeated
+ * insertion, a key that is already present, or that came earlier in items,
+ * is not inserted again. Returns which of items were inserted.
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          bool Eytzinger>
+std::vector<bool> FlatTree<K, V, Compare, Allocator, Eytzinger>::insertBulk(
+    const std::vector<value_type> &items) {
+  auto key_of = [&items](size_t i) -> const K & {
+    return traits::key(items[i]);
+  };
+  std::vector<size_t> order(items.size());
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return _comp(key_of(a), key_of(b));
+  });
+
+  std::vector<bool> inserted(items.size(), false);
+  keys_type keys(_keys.get_allocator());
+  values_type values(getAllocator());
+  keys.reserve(_keys.size() + items.size());
+  if constexpr (kHasValues) {
+    values.reserve(_keys.size() + items.size());
+  }
+  size_t i = 0;
+  size_t j = 0;
+  while (i < _keys.size() || j < order.size()) {
+    if (j == order.size() ||
+        (i < _keys.size() && !_comp(key_of(order[j]), _keys[i]))) {
+      keys.push_back(std::move(_keys[i]));
+      if constexpr (kHasValues) {
+        values.push_back(std::move(_values[i]));
+      }
+      i++;
+    } else {
+      size_t item = order[j++];
+      inserted[item] = true;
+      keys.push_back(key_of(item));
+      if constexpr (kHasValues) {
+        values.push_back(items[item].second);
+      }
+    }
+    // Drop the new items with the key just taken.
+    while (j < order.size() && !_comp(keys.back(), key_of(order[j]))) {
+      j++;
+    }
+  }
+  _keys.swap(keys);
+  if constexpr (kHasValues) {
+    _values.swap(values);
+  }
+  _index.rebuild(_keys);
+  return inserted;
+}
+
+/**
+ * Moves the elements of other whose keys are not here over, in one merge
+ * pass over both; the rest stay in other.
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          bool Eytzinger>
+void FlatTree<K, V, Compare, Allocator, Eytzinger>::mergeFrom(FlatTree &other) {
+  if (this == &other) {
+    return;
+  }
+  FlatTree merged(_comp, getAllocator());
+  FlatTree rest(other._comp, other.getAllocator());
+  merged.reserve(_keys.size() + other._keys.size());
+  auto take = [](FlatTree &from, size_t index, FlatTree &to) {
+    to._keys.push_back(std::move(from._keys[index]));
+    if constexpr (kHasValues) {
+      to._values.push_back(std::move(from._values[index]));
+    }
+  };
+  size_t i = 0;
+  size_t j = 0;
+  while (i < _keys.size() || j < other._keys.size()) {
+    if (j == other._keys.size() ||
+        (i < _keys.size() && _comp(_keys[i], other._keys[j]))) {
+      take(*this, i++, merged);
+    } else if (i == _keys.size() || _comp(other._keys[j], _keys[i])) {
+      take(other, j++, merged);
+    } else {
+      take(*this, i++, merged);
+      take(other, j++, rest);
+    }
+  }
+  merged._index.rebuild(merged._keys);
+  rest._index.rebuild(rest._keys);
+  swap(merged);
+  other.swap(rest);
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          bool Eytzinger>
+void FlatTree<K, V, Compare, Allocator, Eytzinger>::swap(
+    FlatTree &other) noexcept {
+  _keys.swap(other._keys);
+  if constexpr (kHasValues) {
+    _values.swap(other._values);
+  }
+  std::swap(_index, other._index);
+  std::swap(_comp, other._comp);
+}
+
+}  // namespace ps
+
+#endif  // CONTAINERS_SRC_PS_FLAT_TREE_H_
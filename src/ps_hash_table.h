@@ -0,0 +1,828 @@
+#ifndef CONTAINERS_SRC_PS_HASH_TABLE_H_
+#define CONTAINERS_SRC_PS_HASH_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "ps_node_traits.h"
+
+namespace ps {
+
+/**
+ * Control byte of a HashTable slot: kEmpty, kDeleted, the kSentinel that
+ * ends iteration, or for a full slot the low seven bits of its hash.
+ */
+using ctrl_t = int8_t;
+
+/**
+ * ctrl_group - kWidth consecutive control bytes, matched all at once: with
+ * one SSE2 or NEON compare where available, byte by byte otherwise.
+ */
+class ctrl_group {
+ public:
+  static constexpr size_t kWidth = 16;
+  static constexpr ctrl_t kEmpty = -128;
+  static constexpr ctrl_t kDeleted = -2;
+  static constexpr ctrl_t kSentinel = -1;
+
+  /**
+   * mask - the bytes of a group that matched. Each byte owns 1 << kShift
+   * bits of which at most the top one is set: NEON has no movemask, so a
+   * compare is narrowed to four bits per byte instead.
+   */
+  class mask {
+    uint64_t bits_;
+
+   public:
+#if !defined(__SSE2__) && defined(__ARM_NEON)
+    static constexpr int kShift = 2;
+    static constexpr uint64_t kAllBytes = 0x8888888888888888ULL;
+#else
+    static constexpr int kShift = 0;
+    static constexpr uint64_t kAllBytes = 0xFFFF;
+#endif
+
+    explicit mask(uint64_t bits) : bits_(bits) {}
+    explicit operator bool() const { return bits_ != 0; }
+
+    /** Index of the first matched byte; the mask must not be empty. */
+    size_t lowest() const {
+      return static_cast<size_t>(__builtin_ctzll(bits_)) >> kShift;
+    }
+    void drop_lowest() { bits_ &= bits_ - 1; }
+    /** Number of unmatched bytes before the first match. */
+    size_t trailing_zeros() const { return bits_ == 0 ? kWidth : lowest(); }
+    /** Number of unmatched bytes after the last match. */
+    size_t leading_zeros() const {
+      if (bits_ == 0) {
+        return kWidth;
+      }
+      size_t unused = 64 - (kWidth << kShift);
+      return (static_cast<size_t>(__builtin_clzll(bits_)) - unused) >> kShift;
+    }
+    mask inverted() const { return mask(~bits_ & kAllBytes); }
+  };
+
+#if defined(__SSE2__)
+  explicit ctrl_group(const ctrl_t *pos)
+      : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pos))) {}
+
+  mask match(ctrl_t h2) const {
+    return bytes(_mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(h2)), ctrl_));
+  }
+  mask match_empty_or_deleted() const {
+    __m128i sentinel = _mm_set1_epi8(static_cast<char>(kSentinel));
+    return bytes(_mm_cmpgt_epi8(sentinel, ctrl_));
+  }
+#elif defined(__ARM_NEON)
+  explicit ctrl_group(const ctrl_t *pos) : ctrl_(vld1q_s8(pos)) {}
+
+  mask match(ctrl_t h2) const {
+    return bytes(vceqq_s8(ctrl_, vdupq_n_s8(h2)));
+  }
+  mask match_empty_or_deleted() const {
+    return bytes(vcltq_s8(ctrl_, vdupq_n_s8(kSentinel)));
+  }
+#else
+  explicit ctrl_group(const ctrl_t *pos) { std::memcpy(ctrl_, pos, kWidth); }
+
+  mask match(ctrl_t h2) const {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < kWidth; i++) {
+      bits |= static_cast<uint64_t>(ctrl_[i] == h2) << i;
+    }
+    return mask(bits);
+  }
+  mask match_empty_or_deleted() const {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < kWidth; i++) {
+      bits |= static_cast<uint64_t>(ctrl_[i] < kSentinel) << i;
+    }
+    return mask(bits);
+  }
+#endif
+
+  mask match_empty() const { return match(kEmpty); }
+  size_t count_leading_empty_or_deleted() const {
+    return match_empty_or_deleted().inverted().trailing_zeros();
+  }
+
+ private:
+#if defined(__SSE2__)
+  static mask bytes(__m128i cmp) {
+    return mask(static_cast<uint16_t>(_mm_movemask_epi8(cmp)));
+  }
+
+  __m128i ctrl_;
+#elif defined(__ARM_NEON)
+  static mask bytes(uint8x16_t cmp) {
+    uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4);
+    return mask(vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) &
+                mask::kAllBytes);
+  }
+
+  int8x16_t ctrl_;
+#else
+  ctrl_t ctrl_[kWidth];
+#endif
+};
+
+/** The control bytes of every table that has no storage yet. */
+inline ctrl_t *empty_ctrl_group() {
+  alignas(ctrl_group::kWidth) static ctrl_t group[ctrl_group::kWidth] = {
+      ctrl_group::kSentinel, ctrl_group::kEmpty, ctrl_group::kEmpty,
+      ctrl_group::kEmpty,    ctrl_group::kEmpty, ctrl_group::kEmpty,
+      ctrl_group::kEmpty,    ctrl_group::kEmpty, ctrl_group::kEmpty,
+      ctrl_group::kEmpty,    ctrl_group::kEmpty, ctrl_group::kEmpty,
+      ctrl_group::kEmpty,    ctrl_group::kEmpty, ctrl_group::kEmpty,
+      ctrl_group::kEmpty};
+  return group;
+}
+
+/**
+ * HashTable - open addressing with a control byte per slot, in the style of
+ * a Swiss table. A hash is split into h1, which picks where probing starts,
+ * and the seven bits of h2, which go into the control byte of the slot. A
+ * lookup compares h2 against a whole ctrl_group at a time, looks only at
+ * the keys of the slots that matched and stops at the first group with an
+ * empty slot.
+ *
+ * The capacity is always 2^n - 1, of which at most 7/8 is used. The control
+ * bytes end with a kSentinel followed by a copy of the first kWidth - 1
+ * bytes, so that a group can be loaded at any slot without wrapping. Erased
+ * slots turn into kDeleted tombstones unless no probe can have passed them.
+ *
+ * Elements live in one flat array and move when the table grows, so an
+ * insertion may invalidate every iterator and pointer into the table.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>,
+          typename Allocator =
+              std::allocator<typename node_traits<K, V>::value_type>>
+class HashTable {
+ public:
+  using value_type = typename node_traits<K, V>::value_type;
+
+ private:
+  using traits = node_traits<K, V>;
+  using slot_allocator = typename std::allocator_traits<
+      Allocator>::template rebind_alloc<value_type>;
+  using slot_traits = std::allocator_traits<slot_allocator>;
+  using ctrl_allocator =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<ctrl_t>;
+  using ctrl_traits = std::allocator_traits<ctrl_allocator>;
+  static constexpr size_t kWidth = ctrl_group::kWidth;
+  static constexpr bool kMoveTakesStorage =
+      slot_traits::propagate_on_container_move_assignment::value ||
+      slot_traits::is_always_equal::value;
+  // Slots whose pair is trivially copyable in all but name are moved as
+  // bytes, for the allocators whose construct is plain placement new.
+  static constexpr bool kBitwiseRelocate =
+      std::is_trivially_copy_constructible_v<value_type> &&
+      std::is_trivially_destructible_v<value_type> &&
+      (std::is_same_v<slot_allocator, std::allocator<value_type>> ||
+       std::is_same_v<slot_allocator,
+                      std::pmr::polymorphic_allocator<value_type>>);
+  // Like std::move_if_noexcept for the key and mapped value together: a
+  // slot is moved out of if neither move throws or it cannot be copied.
+  static constexpr bool kMoveSlots =
+      (std::is_nothrow_move_constructible_v<K> &&
+       std::is_nothrow_move_constructible_v<
+           std::conditional_t<std::is_void_v<V>, K, V>>) ||
+      !std::is_copy_constructible_v<value_type>;
+
+  ctrl_t *_ctrl = empty_ctrl_group();
+  value_type *_slots = nullptr;
+  size_t _capacity = 0;
+  size_t _size = 0;
+  size_t _growthLeft = 0;
+  Hash _hash;
+  KeyEqual _eq;
+  slot_allocator _allocator;
+
+  static bool isFull(ctrl_t ctrl) { return ctrl >= 0; }
+  static size_t h1(size_t hash) { return hash >> 7; }
+  static ctrl_t h2(size_t hash) { return static_cast<ctrl_t>(hash & 0x7F); }
+  static size_t growthOf(size_t capacity) { return capacity - capacity / 8; }
+  template <typename Key2>
+  size_t hashOf(const Key2 &key) const;
+  template <typename Key2>
+  size_t findWithHash(const Key2 &key, size_t hash) const;
+  size_t findFirstNonFull(size_t hash) const;
+  size_t prepareInsert(size_t hash);
+  void commitInsert(size_t index, size_t hash);
+  void setCtrl(size_t index, ctrl_t ctrl);
+  void relocateSlot(value_type *to, value_type &from);
+  void resize(size_t capacity);
+  void rehashAndGrow();
+  void destroyAll() noexcept;
+  void deallocate() noexcept;
+  void copyElements(const HashTable &other);
+  void takeFrom(HashTable &other) noexcept;
+
+ public:
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using allocator_type = Allocator;
+
+  HashTable() = default;
+  explicit HashTable(const Hash &hash, const KeyEqual &eq = KeyEqual(),
+                     const Allocator &allocator = Allocator());
+  HashTable(const HashTable &other);
+  HashTable(HashTable &&other) noexcept;
+  HashTable &operator=(const HashTable &other);
+  HashTable &operator=(HashTable &&other) noexcept(kMoveTakesStorage);
+  ~HashTable();
+
+  size_t size() const { return _size; }
+  size_t max_size() const;
+  size_t capacity() const { return _capacity; }
+  const Hash &hashFunction() const { return _hash; }
+  const KeyEqual &keyEq() const { return _eq; }
+  Allocator getAllocator() const { return Allocator(_allocator); }
+
+  /** Index capacity() is the sentinel, which serves as the end. */
+  ctrl_t *ctrlAt(size_t index) const { return _ctrl + index; }
+  value_type *slotAt(size_t index) const { return _slots + index; }
+  template <typename Slot>
+  static void skipEmpty(const ctrl_t *&ctrl, Slot *&slot);
+
+  template <typename Key2>
+  size_t find(const Key2 &key) const;
+  template <typename Pair>
+  std::pair<size_t, bool> insertUnique(Pair &&value);
+  template <typename... Args>
+  std::pair<size_t, bool> emplace(Args &&...args);
+  template <typename Key2, typename... Args>
+  std::pair<size_t, bool> tryEmplace(Key2 &&key, Args &&...args);
+  void eraseAt(size_t index);
+  template <typename Key2>
+  size_t erase(const Key2 &key);
+  void clear() noexcept;
+  void reserve(size_t count);
+  void mergeFrom(HashTable &other);
+  void swap(HashTable &other) noexcept;
+};
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+HashTable<K, V, Hash, KeyEqual, Allocator>::HashTable(
+    const Hash &hash, const KeyEqual &eq, const Allocator &allocator)
+    : _hash(hash), _eq(eq), _allocator(allocator) {}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+HashTable<K, V, Hash, KeyEqual, Allocator>::HashTable(const HashTable &other)
+    : _hash(other._hash),
+      _eq(other._eq),
+      _allocator(slot_traits::select_on_container_copy_construction(
+          other._allocator)) {
+  copyElements(other);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+HashTable<K, V, Hash, KeyEqual, Allocator>::HashTable(
+    HashTable &&other) noexcept
+    : _ctrl(other._ctrl),
+      _slots(other._slots),
+      _capacity(other._capacity),
+      _size(other._size),
+      _growthLeft(other._growthLeft),
+      _hash(std::move(other._hash)),
+      _eq(std::move(other._eq)),
+      _allocator(std::move(other._allocator)) {
+  other._ctrl = empty_ctrl_group();
+  other._slots = nullptr;
+  other._capacity = 0;
+  other._size = 0;
+  other._growthLeft = 0;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+HashTable<K, V, Hash, KeyEqual, Allocator> &
+HashTable<K, V, Hash, KeyEqual, Allocator>::operator=(
+    const HashTable &other) {
+  if (this != &other) {
+    if constexpr (slot_traits::propagate_on_container_copy_assignment::
+                      value) {
+      if (_allocator != other._allocator) {
+        destroyAll();
+        deallocate();
+      }
+      _allocator = other._allocator;
+    }
+    clear();
+    _hash = other._hash;
+    _eq = other._eq;
+    copyElements(other);
+  }
+  return *this;
+}
+
+/**
+ * Takes over other's storage when the allocators allow it. Otherwise this
+ * table keeps its allocator, and other's elements are moved one by one
+ * into storage that allocator owns.
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+HashTable<K, V, Hash, KeyEqual, Allocator> &
+HashTable<K, V, Hash, KeyEqual, Allocator>::operator=(
+    HashTable &&other) noexcept(kMoveTakesStorage) {
+  if (this == &other) {
+    return *this;
+  }
+  if constexpr (slot_traits::propagate_on_container_move_assignment::value) {
+    destroyAll();
+    deallocate();
+    _allocator = std::move(other._allocator);
+    takeFrom(other);
+  } else if (kMoveTakesStorage || _allocator == other._allocator) {
+    destroyAll();
+    deallocate();
+    takeFrom(other);
+  } else {
+    clear();
+    _hash = other._hash;
+    _eq = other._eq;
+    reserve(other._size);
+    for (size_t i = 0; i < other._capacity; i++) {
+      if (isFull(other._ctrl[i])) {
+        size_t hash = hashOf(traits::key(other._slots[i]));
+        size_t index = findFirstNonFull(hash);
+        relocateSlot(_slots + index, other._slots[i]);
+        commitInsert(index, hash);
+      }
+    }
+    other.clear();
+  }
+  return *this;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+HashTable<K, V, Hash, KeyEqual, Allocator>::~HashTable() {
+  destroyAll();
+  deallocate();
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+size_t HashTable<K, V, Hash, KeyEqual, Allocator>::max_size() const {
+  return std::numeric_limits<size_t>::max() / (sizeof(value_type) + 1);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+template <typename Key2>
+size_t HashTable<K, V, Hash, KeyEqual, Allocator>::hashOf(
+    const Key2 &key) const {
+  // std::hash is the identity for integers. Mix the bits so that h1 and h2
+  // both depend on the whole key.
+  uint64_t hash = static_cast<uint64_t>(_hash(key)) * 0x9E3779B97F4A7C15ULL;
+  return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+template <typename Key2>
+size_t HashTable<K, V, Hash, KeyEqual, Allocator>::findWithHash(
+    const Key2 &key, size_t hash) const {
+  // Groups are visited at triangular offsets, which reaches every group of
+  // a table of 2^n slots.
+  size_t offset = h1(hash) & _capacity;
+  for (size_t step = kWidth;; step += kWidth) {
+    ctrl_group group(_ctrl + offset);
+    for (auto match = group.match(h2(hash)); match; match.drop_lowest()) {
+      size_t index = (offset + match.lowest()) & _capacity;
+      if (_eq(traits::key(_slots[index]), key)) {
+        return index;
+      }
+    }
+    if (group.match_empty()) {
+      return _capacity;
+    }
+    offset = (offset + step) & _capacity;
+  }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+template <typename Key2>
+size_t HashTable<K, V, Hash, KeyEqual, Allocator>::find(
+    const Key2 &key) const {
+  return findWithHash(key, hashOf(key));
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+size_t HashTable<K, V, Hash, KeyEqual, Allocator>::findFirstNonFull(
+    size_t hash) const {
+  size_t offset = h1(hash) & _capacity;
+  for (size_t step = kWidth;; step += kWidth) {
+    auto free = ctrl_group(_ctrl + offset).match_empty_or_deleted();
+    if (free) {
+      return (offset + free.lowest()) & _capacity;
+    }
+    offset = (offset + step) & _capacity;
+  }
+}
+
+/**
+ * Finds the slot a new element with this hash goes to, growing the table
+ * first if that slot is empty and no growth is left. Reusing a tombstone
+ * never needs to grow.
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+size_t HashTable<K, V, Hash, KeyEqual, Allocator>::prepareInsert(
+    size_t hash) {
+  size_t index = findFirstNonFull(hash);
+  if (_growthLeft == 0 && _ctrl[index] != ctrl_group::kDeleted) {
+    rehashAndGrow();
+    index = findFirstNonFull(hash);
+  }
+  return index;
+}
+
+/** Marks the slot full once its element has been constructed. */
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashTable<K, V, Hash, KeyEqual, Allocator>::commitInsert(size_t index,
+                                                              size_t hash) {
+  if (_ctrl[index] == ctrl_group::kEmpty) {
+    _growthLeft--;
+  }
+  setCtrl(index, h2(hash));
+  _size++;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashTable<K, V, Hash, KeyEqual, Allocator>::setCtrl(size_t index,
+                                                         ctrl_t ctrl) {
+  // The first kWidth - 1 bytes are mirrored after the sentinel; for any
+  // other index the second store hits index itself.
+  _ctrl[index] = ctrl;
+  _ctrl[((index - (kWidth - 1)) & _capacity) + (kWidth - 1)] = ctrl;
+}
+
+/**
+ * Constructs the slot to from the element in from, which the caller then
+ * destroys. The key is moved out of its const pair, as nothing looks the
+ * old slot up again; elements whose moves may throw are copied, so that
+ * from stays intact if that fails.
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashTable<K, V, Hash, KeyEqual, Allocator>::relocateSlot(
+    value_type *to, value_type &from) {
+  if constexpr (kBitwiseRelocate) {
+    std::memcpy(static_cast<void *>(to), &from, sizeof(value_type));
+  } else if constexpr (!kMoveSlots) {
+    slot_traits::construct(_allocator, to, std::as_const(from));
+  } else if constexpr (std::is_void_v<V>) {
+    slot_traits::construct(_allocator, to, std::move(from));
+  } else {
+    slot_traits::construct(_allocator, to,
+                           std::move(const_cast<K &>(from.first)),
+                           std::move(from.second));
+  }
+}
+
+/**
+ * Moves every element into new arrays of capacity slots. The old elements
+ * are destroyed only once all are in place; if building one throws, the
+ * new arrays are freed and the table is left as it was.
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashTable<K, V, Hash, KeyEqual, Allocator>::resize(size_t capacity) {
+  ctrl_t *old_ctrl = _ctrl;
+  value_type *old_slots = _slots;
+  size_t old_capacity = _capacity;
+  size_t old_growth_left = _growthLeft;
+
+  ctrl_allocator ctrl_alloc(_allocator);
+  _ctrl = ctrl_traits::allocate(ctrl_alloc, capacity + kWidth);
+  try {
+    _slots = slot_traits::allocate(_allocator, capacity);
+  } catch (...) {
+    ctrl_traits::deallocate(ctrl_alloc, _ctrl, capacity + kWidth);
+    _ctrl = old_ctrl;
+    throw;
+  }
+  std::memset(_ctrl, ctrl_group::kEmpty, capacity + kWidth);
+  _ctrl[capacity] = ctrl_group::kSentinel;
+  _capacity = capacity;
+  _growthLeft = growthOf(capacity) - _size;
+
+  try {
+    for (size_t i = 0; i < old_capacity; i++) {
+      if (isFull(old_ctrl[i])) {
+        size_t hash = hashOf(traits::key(old_slots[i]));
+        size_t index = findFirstNonFull(hash);
+        relocateSlot(_slots + index, old_slots[i]);
+        setCtrl(index, h2(hash));
+      }
+    }
+  } catch (...) {
+    destroyAll();
+    deallocate();
+    _ctrl = old_ctrl;
+    _slots = old_slots;
+    _capacity = old_capacity;
+    _growthLeft = old_growth_left;
+    throw;
+  }
+  if (old_capacity != 0) {
+    if constexpr (!std::is_trivially_destructible_v<value_type>) {
+      for (size_t i = 0; i < old_capacity; i++) {
+        if (isFull(old_ctrl[i])) {
+          slot_traits::destroy(_allocator, old_slots + i);
+        }
+      }
+    }
+    ctrl_traits::deallocate(ctrl_alloc, old_ctrl, old_capacity + kWidth);
+    slot_traits::deallocate(_allocator, old_slots, old_capacity);
+  }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashTable<K, V, Hash, KeyEqual, Allocator>::rehashAndGrow() {
+  if (_capacity == 0) {
+    resize(kWidth - 1);
+  } else if (_size <= growthOf(_capacity) / 2) {
+    // Mostly tombstones: rebuilding at the same capacity frees them.
+    resize(_capacity);
+  } else {
+    resize(_capacity * 2 + 1);
+  }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashTable<K, V, Hash, KeyEqual, Allocator>::destroyAll() noexcept {
+  if constexpr (!std::is_trivially_destructible_v<value_type>) {
+    for (size_t i = 0; i < _capacity; i++) {
+      if (isFull(_ctrl[i])) {
+        slot_traits::destroy(_allocator, _slots + i);
+      }
+    }
+  }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashTable<K, V, Hash, KeyEqual, Allocator>::deallocate() noexcept {
+  if (_capacity != 0) {
+    ctrl_allocator ctrl_alloc(_allocator);
+    ctrl_traits::deallocate(ctrl_alloc, _ctrl, _capacity + kWidth);
+    slot_traits::deallocate(_allocator, _slots, _capacity);
+  }
+  _ctrl = empty_ctrl_group();
+  _slots = nullptr;
+  _capacity = 0;
+  _growthLeft = 0;
+}
+
+/** Inserts other's elements, whose keys are known to be distinct. */
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashTable<K, V, Hash, KeyEqual, Allocator>::copyElements(
+    const HashTable &other) {
+  reserve(other._size);
+  for (size_t i = 0; i < other._capacity; i++) {
+    if (isFull(other._ctrl[i])) {
+      size_t hash = hashOf(traits::key(other._slots[i]));
+      size_t index = findFirstNonFull(hash);
+      slot_traits::construct(_allocator, _slots + index, other._slots[i]);
+      commitInsert(index, hash);
+    }
+  }
+}
+
+/** Takes other's storage and functors; this table must hold no storage. */
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashTable<K, V, Hash, KeyEqual, Allocator>::takeFrom(
+    HashTable &other) noexcept {
+  _ctrl = std::exchange(other._ctrl, empty_ctrl_group());
+  _slots = std::exchange(other._slots, nullptr);
+  _capacity = std::exchange(other._capacity, 0);
+  _size = std::exchange(other._size, 0);
+  _growthLeft = std::exchange(other._growthLeft, 0);
+  _hash = std::move(other._hash);
+  _eq = std::move(other._eq);
+}
+
+/** Advances ctrl and slot to the next full slot or to the sentinel. */
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+template <typename Slot>
+void HashTable<K, V, Hash, KeyEqual, Allocator>::skipEmpty(
+    const ctrl_t *&ctrl, Slot *&slot) {
+  while (*ctrl < ctrl_group::kSentinel) {
+    size_t shift = ctrl_group(ctrl).count_leading_empty_or_deleted();
+    ctrl += shift;
+    slot += shift;
+  }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+template <typename Pair>
+std::pair<size_t, bool>
+HashTable<K, V, Hash, KeyEqual, Allocator>::insertUnique(Pair &&value) {
+  size_t hash = hashOf(traits::key(value));
+  size_t found = findWithHash(traits::key(value), hash);
+  if (found != _capacity) {
+    return {found, false};
+  }
+  size_t index = prepareInsert(hash);
+  slot_traits::construct(_allocator, _slots + index,
+                         std::forward<Pair>(value));
+  commitInsert(index, hash);
+  return {index, true};
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+template <typename... Args>
+std::pair<size_t, bool>
+HashTable<K, V, Hash, KeyEqual, Allocator>::emplace(Args &&...args) {
+  // The key is only known once the element exists. It is then moved out
+  // of the pair, which insertUnique would copy.
+  value_type value(std::forward<Args>(args)...);
+  size_t hash = hashOf(traits::key(value));
+  size_t found = findWithHash(traits::key(value), hash);
+  if (found != _capacity) {
+    return {found, false};
+  }
+  size_t index = prepareInsert(hash);
+  relocateSlot(_slots + index, value);
+  commitInsert(index, hash);
+  return {index, true};
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+template <typename Key2, typename... Args>
+std::pair<size_t, bool>
+HashTable<K, V, Hash, KeyEqual, Allocator>::tryEmplace(Key2 &&key,
+                                                       Args &&...args) {
+  size_t hash = hashOf(key);
+  size_t found = findWithHash(key, hash);
+  if (found != _capacity) {
+    return {found, false};
+  }
+  size_t index = prepareInsert(hash);
+  if constexpr (std::is_void_v<V>) {
+    slot_traits::construct(_allocator, _slots + index,
+                           std::forward<Key2>(key));
+  } else {
+    slot_traits::construct(
+        _allocator, _slots + index, std::piecewise_construct,
+        std::forward_as_tuple(std::forward<Key2>(key)),
+        std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+  commitInsert(index, hash);
+  return {index, true};
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashTable<K, V, Hash, KeyEqual, Allocator>::eraseAt(size_t index) {
+  slot_traits::destroy(_allocator, _slots + index);
+  _size--;
+  // A probe only moves past a group without empty slots. If every window of
+  // kWidth slots around index has one, no probe has ever passed index and
+  // it can become empty again.
+  auto empty_after = ctrl_group(_ctrl + index).match_empty();
+  auto empty_before =
+      ctrl_group(_ctrl + ((index - kWidth) & _capacity)).match_empty();
+  bool was_never_full = empty_before && empty_after &&
+                        empty_after.trailing_zeros() +
+                                empty_before.leading_zeros() <
+                            kWidth;
+  if (was_never_full) {
+    setCtrl(index, ctrl_group::kEmpty);
+    _growthLeft++;
+  } else {
+    setCtrl(index, ctrl_group::kDeleted);
+  }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+template <typename Key2>
+size_t HashTable<K, V, Hash, KeyEqual, Allocator>::erase(const Key2 &key) {
+  size_t index = find(key);
+  if (index == _capacity) {
+    return 0;
+  }
+  eraseAt(index);
+  return 1;
+}
+
+/** Destroys every element but keeps the storage. */
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashTable<K, V, Hash, KeyEqual, Allocator>::clear() noexcept {
+  destroyAll();
+  if (_capacity != 0) {
+    std::memset(_ctrl, ctrl_group::kEmpty, _capacity + kWidth);
+    _ctrl[_capacity] = ctrl_group::kSentinel;
+  }
+  _size = 0;
+  _growthLeft = growthOf(_capacity);
+}
+
+/**
+ * Makes room for count elements without growing again. Tombstones take up
+ * growth until a rehash drops them, so the room left is _growthLeft, not
+ * growthOf(_capacity); a table with enough capacity but too many
+ * tombstones is rebuilt at the same size.
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashTable<K, V, Hash, KeyEqual, Allocator>::reserve(size_t count) {
+  if (count <= _size + _growthLeft) {
+    return;
+  }
+  if (count <= growthOf(_capacity)) {
+    resize(_capacity);
+    return;
+  }
+  size_t capacity = kWidth - 1;
+  while (growthOf(capacity) < count) {
+    capacity = capacity * 2 + 1;
+  }
+  resize(capacity);
+}
+
+/**
+ * Moves every element of other whose key is not in this table over. The
+ * elements are relocated slot by slot, as there are no nodes to relink.
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashTable<K, V, Hash, KeyEqual, Allocator>::mergeFrom(HashTable &other) {
+  if (this == &other) {
+    return;
+  }
+  for (size_t i = 0; i < other._capacity; i++) {
+    if (!isFull(other._ctrl[i])) {
+      continue;
+    }
+    value_type &value = other._slots[i];
+    size_t hash = hashOf(traits::key(value));
+    if (findWithHash(traits::key(value), hash) == _capacity) {
+      size_t index = prepareInsert(hash);
+      relocateSlot(_slots + index, value);
+      commitInsert(index, hash);
+      other.eraseAt(i);
+    }
+  }
+}
+
+/**
+ * Swaps the allocators only if they propagate on swap; otherwise they must
+ * compare equal, as for the standard containers.
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual,
+          typename Allocator>
+void HashTable<K, V, Hash, KeyEqual, Allocator>::swap(
+    HashTable &other) noexcept {
+  if constexpr (slot_traits::propagate_on_container_swap::value) {
+    std::swap(_allocator, other._allocator);
+  }
+  std::swap(_ctrl, other._ctrl);
+  std::swap(_slots, other._slots);
+  std::swap(_capacity, other._capacity);
+  std::swap(_size, other._size);
+  std::swap(_growthLeft, other._growthLeft);
+  std::swap(_hash, other._hash);
+  std::swap(_eq, other._eq);
+}
+
+}  // namespace ps
+
+#endif  // CONTAINERS_SRC_PS_HASH_TABLE_H_
@@ -0,0 +1,134 @@
+#ifndef CONTAINERS_SRC_PS_HUGE_PAGE_ALLOCATOR_H_
+#define CONTAINERS_SRC_PS_HUGE_PAGE_ALLOCATOR_H_
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+
+namespace ps {
+
+/**
+ * huge_page_allocator - maps blocks of kMapThreshold bytes and more
+ * straight from the kernel and leaves smaller ones to std::allocator.
+ *
+ * A mapped block is advised with MADV_HUGEPAGE, so that transparent huge
+ * pages cut the TLB misses of scanning it. reallocate() grows a mapped
+ * block with mremap, which moves page table entries instead of bytes: a
+ * vector that reaches several gigabytes never copies its elements. Where
+ * mremap is not available (outside Linux) reallocate() copies.
+ */
+template <typename T>
+class huge_page_allocator {
+ public:
+  using value_type = T;
+
+  /** One huge page on x86-64; smaller blocks gain nothing from mapping. */
+  static constexpr size_t kMapThreshold = size_t{2} << 20;
+
+  huge_page_allocator() = default;
+  template <typename U>
+  huge_page_allocator(const huge_page_allocator<U> &) noexcept {}
+
+  T *allocate(size_t n);
+  void deallocate(T *ptr, size_t n) noexcept;
+  T *reallocate(T *ptr, size_t old_n, size_t new_n);
+
+  template <typename U>
+  bool operator==(const huge_page_allocator<U> &) const noexcept {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const huge_page_allocator<U> &) const noexcept {
+    return false;
+  }
+
+ private:
+  static bool mapped(size_t bytes) { return bytes >= kMapThreshold; }
+  static size_t mapped_length(size_t bytes);
+  static void advise_huge(void *ptr, size_t length) noexcept;
+};
+
+template <typename T>
+T *huge_page_allocator<T>::allocate(size_t n) {
+  if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+    throw std::bad_array_new_length();
+  }
+  size_t bytes = n * sizeof(T);
+  if (!mapped(bytes)) {
+    return std::allocator<T>().allocate(n);
+  }
+  size_t length = mapped_length(bytes);
+  void *ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ptr == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  advise_huge(ptr, length);
+  return static_cast<T *>(ptr);
+}
+
+template <typename T>
+void huge_page_allocator<T>::deallocate(T *ptr, size_t n) noexcept {
+  size_t bytes = n * sizeof(T);
+  if (mapped(bytes)) {
+    munmap(ptr, mapped_length(bytes));
+  } else {
+    std::allocator<T>().deallocate(ptr, n);
+  }
+}
+
+/**
+ * Resizes the block at ptr, keeping its first min(old_n, new_n) objects as
+ * bytes; only meant for trivially copyable T. Returns the block, which may
+ * have moved.
+ */
+template <typename T>
+T *huge_page_allocator<T>::reallocate(T *ptr, size_t old_n, size_t new_n) {
+  size_t old_bytes = old_n * sizeof(T);
+  size_t new_bytes = new_n * sizeof(T);
+#ifdef __linux__
+  if (mapped(old_bytes) && mapped(new_bytes) &&
+      new_n <= std::numeric_limits<size_t>::max() / sizeof(T)) {
+    size_t length = mapped_length(new_bytes);
+    void *moved =
+        mremap(ptr, mapped_length(old_bytes), length, MREMAP_MAYMOVE);
+    if (moved == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    advise_huge(moved, length);
+    return static_cast<T *>(moved);
+  }
+#endif
+  T *fresh = allocate(new_n);
+  std::memcpy(static_cast<void *>(fresh), ptr, std::min(old_bytes, new_bytes));
+  deallocate(ptr, old_n);
+  return fresh;
+}
+
+template <typename T>
+size_t huge_page_allocator<T>::mapped_length(size_t bytes) {
+  static const size_t page = size_t(sysconf(_SC_PAGESIZE));
+  return (bytes + page - 1) / page * page;
+}
+
+/** Only a hint: kernels without transparent huge pages just ignore it. */
+template <typename T>
+void huge_page_allocator<T>::advise_huge(void *ptr, size_t length) noexcept {
+#ifdef MADV_HUGEPAGE
+  madvise(ptr, length, MADV_HUGEPAGE);
+#else
+  static_cast<void>(ptr);
+  static_cast<void>(length);
+#endif
+}
+
+}  // namespace ps
+
+#endif  // CONTAINERS_SRC_PS_HUGE_PAGE_ALLOCATOR_H_
@@ -1,12 +1,16 @@
 #ifndef CONTAINERS_SRC_PS_LIST_H_
 #define CONTAINERS_SRC_PS_LIST_H_
 
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <memory_resource>
 
 namespace ps {
 template <class T, class Allocator = std::allocator<T> >
 class list {
  public:
+  struct NodeBase;
   struct Node;
   class ListIterator;
   class ListConstIterator;
@@ -14,11 +18,11 @@ class list {
     friend ps::list<T, Allocator>;
 
    public:
-    using node_type = Node;
+    using node_type = NodeBase;
     ListIterator() {}
     ListIterator(node_type* node) : node_(node) {}
 
-    const T& operator*() const { return node_->value_; }
+    const T& operator*() const { return static_cast<Node*>(node_)->value_; }
     ListIterator& operator++() {
       node_ = node_->next_;
       return *this;
@@ -59,19 +63,19 @@ class list {
     ~ListIterator() { node_ = nullptr; }
 
    private:
-    Node* node_;
+    NodeBase* node_;
   };
 
   class ListConstIterator {
     friend ps::list<T, Allocator>;
 
    public:
-    using node_type = Node;
+    using node_type = NodeBase;
 
     ListConstIterator() {}
     explicit ListConstIterator(node_type* node) { node_ = node; }
 
-    const T& operator*() const { return node_->value_; }
+    const T& operator*() const { return static_cast<Node*>(node_)->value_; }
 
     ListConstIterator& operator++() {
       node_ = node_->next_;
@@ -113,7 +117,7 @@ class list {
     ~ListConstIterator() { node_ = nullptr; }
 
    private:
-    Node* node_;
+    NodeBase* node_;
   };
 
   using value_type = T;
@@ -148,6 +152,7 @@ class list {
   using list_type = ps::list<value_type, allocator_type>;
 
   list();
+  explicit list(const Allocator& allocator);
   list(size_type count);
   list(std::initializer_list<T> init);
   list(const list& other);
@@ -155,7 +160,9 @@ class list {
   ~list() { clear(); }
 
   list& operator=(const list_type& other);
-  list& operator=(list_type&& other) noexcept;
+  list& operator=(list_type&& other) noexcept(kMoveTakesNodes);
+
+  allocator_type get_allocator() const noexcept;
 
   reference front();  // Reference to the first element
   const_reference front() const;
@@ -188,10 +195,14 @@ class list {
   void pop_front();
   void swap(list& other) noexcept;
   void merge(list& other);
+  template <class Compare>
+  void merge(list& other, Compare comp);
   void splice(const_iterator pos, list& other);
   void reverse() noexcept;
   void unique();
   void sort();
+  template <class Compare>
+  void sort(Compare comp);
 
   template <class... Args>
   iterator insert_many(const_iterator pos, Args&&... args);
@@ -202,9 +213,16 @@ class list {
   template <class... Args>
   void insert_many_front(Args&&... args);
 
-  struct Node {
-    Node* next_;
-    Node* prev_;
+  /**
+   * The links alone. The sentinel is one, kept inside the list, so end()
+   * is valid and an empty list owns no memory.
+   */
+  struct NodeBase {
+    NodeBase* next_;
+    NodeBase* prev_;
+  };
+
+  struct Node : NodeBase {
     T value_;
 
     Node();
@@ -212,25 +230,44 @@ class list {
   };
 
  private:
-  Node* head_;
-  Node* tail_;
-  Node* fake_node_;
+  // A moved-to list can take over the nodes whenever it also takes the
+  // allocator along, or when any two allocators are equal.
+  static constexpr bool kMoveTakesNodes =
+      node_allocator::propagate_on_container_move_assignment::value ||
+      node_allocator::is_always_equal::value;
+
+  NodeBase sentinel_;
   size_type size_;
   rebind_allocator_type allocator_;
 
   Node* allocate_node();
-  void deallocate_node(Node* ptr) noexcept;
-  void quick_sort(iterator first, iterator last, size_type size);
+  void deallocate_node(NodeBase* ptr) noexcept;
+  bool can_relink(const list& other) const noexcept;
+  Node* move_node(NodeBase* node);
+  static T& value_of(NodeBase* node) noexcept;
+  void link_node(NodeBase* pos, NodeBase* node) noexcept;
+  void unlink_node(NodeBase* node) noexcept;
+  void transfer(NodeBase* pos, NodeBase* first, NodeBase* last) noexcept;
+  void attach_sentinel() noexcept;
+  void take_nodes(list& other) noexcept;
+  template <class Compare>
+  static NodeBase* merge_runs(NodeBase* left, NodeBase* right,
+                              Compare& comp);
 };
+
+namespace pmr {
+template <class T>
+using list = ps::list<T, std::pmr::polymorphic_allocator<T>>;
+}  // namespace pmr
 }  // namespace ps
 
 template <class T, class Allocator>
-ps::list<T, Allocator>::Node::Node() : next_(nullptr), prev_(nullptr) {}
+ps::list<T, Allocator>::Node::Node() : NodeBase{nullptr, nullptr} {}
 
 template <class T, class Allocator>
 ps::list<T, Allocator>::Node::~Node() {
-  next_ = nullptr;
-  prev_ = nullptr;
+  this->next_ = nullptr;
+  this->prev_ = nullptr;
 }
 
 template <class T, class Allocator>
@@ -242,19 +279,39 @@ typename ps::list<T, Allocator>::Node* ps::list<T, Allocator>::allocate_node() {
 }
 
 template <class T, class Allocator>
-void ps::list<T, Allocator>::deallocate_node(Node* ptr) noexcept {
-  node_allocator::destroy(allocator_, ptr);
-  node_allocator::deallocate(allocator_, ptr, 1);
+void ps::list<T, Allocator>::deallocate_node(NodeBase* ptr) noexcept {
+  Node* node = static_cast<Node*>(ptr);
+  node_allocator::destroy(allocator_, node);
+  node_allocator::deallocate(allocator_, node, 1);
 }
 
+/** True when this list may free nodes allocated by other's allocator. */
 template <class T, class Allocator>
-ps::list<T, Allocator>::list() : allocator_() {
-  size_ = 0;
-  head_ = nullptr;
-  tail_ = nullptr;
-  fake_node_ = nullptr;
+bool ps::list<T, Allocator>::can_relink(const list& other) const noexcept {
+  return node_allocator::is_always_equal::value ||
+         allocator_ == other.allocator_;
+}
+
+/** A new, unlinked node of this list holding the value moved out of node. */
+template <class T, class Allocator>
+typename ps::list<T, Allocator>::Node* ps::list<T, Allocator>::move_node(
+    NodeBase* node) {
+  Node* moved = allocate_node();
+  moved->value_ = std::move(value_of(node));
+  return moved;
 }
 
+template <class T, class Allocator>
+ps::list<T, Allocator>::list() : list(Allocator()) {}
+
+/**
+ * Nodes are allocated with allocator rebound to Node; a list built on a
+ * std::pmr::memory_resource keeps all of its nodes in that resource.
+ */
+template <class T, class Allocator>
+ps::list<T, Allocator>::list(const Allocator& allocator)
+    : sentinel_{&sentinel_, &sentinel_}, size_(0), allocator_(allocator) {}
+
 template <class T, class Allocator>
 ps::list<T, Allocator>::list(size_type count) : list() {
   while (count > 0) {
@@ -272,23 +329,17 @@ ps::list<T, Allocator>::list(std::initializer_list<T> init) : list() {
 
 template <class T, class Allocator>
 ps::list<T, Allocator>::list(const list& other) : list() {
-  Node* tmp = other.head_;
-  while (tmp != other.fake_node_) {
-    push_back(tmp->value_);
-    tmp = tmp->next_;
+  for (auto it = other.cbegin(); it != other.cend(); ++it) {
+    push_back(*it);
   }
 }
 
 template <class T, class Allocator>
-ps::list<T, Allocator>::list(list&& other) {
-  size_ = other.size_;
-  head_ = other.head_;
-  tail_ = other.tail_;
-  fake_node_ = other.fake_node_;
-  other.size_ = 0;
-  other.head_ = nullptr;
-  other.tail_ = nullptr;
-  other.fake_node_ = nullptr;
+ps::list<T, Allocator>::list(list&& other)
+    : sentinel_{&sentinel_, &sentinel_},
+      size_(0),
+      allocator_(other.allocator_) {
+  take_nodes(other);
 }
 
 template <class T, class Allocator>
@@ -296,10 +347,8 @@ ps::list<T, Allocator>& ps::list<T, Allocator>::operator=(
     const list_type& other) {
   if (this != &other) {
     clear();
-    Node* tmp = other.head_;
-    while (tmp != other.fake_node_) {
-      push_back(tmp->value_);
-      tmp = tmp->next_;
+    for (auto it = other.cbegin(); it != other.cend(); ++it) {
+      push_back(*it);
     }
   }
   return *this;
@@ -307,77 +356,88 @@ ps::list<T, Allocator>& ps::list<T, Allocator>::operator=(
 
 template <class T, class Allocator>
 ps::list<T, Allocator>& ps::list<T, Allocator>::operator=(
-    list_type&& other) noexcept {
-  if (this != &other) {
+    list_type&& other) noexcept(kMoveTakesNodes) {
+  if (this == &other) {
+    return *this;
+  }
+  if (!kMoveTakesNodes && !(allocator_ == other.allocator_)) {
+    // The nodes cannot be freed through this list's allocator, so the
+    // values are copied over instead.
+    *this = other;
+    other.clear();
+  } else {
     clear();
-    head_ = other.head_;
-    tail_ = other.tail_;
-    size_ = other.size_;
-    fake_node_ = other.fake_node_;
-    other.head_ = nullptr;
-    other.tail_ = nullptr;
-    other.fake_node_ = nullptr;
-    other.size_ = 0;
+    if constexpr (node_allocator::propagate_on_container_move_assignment::
+                      value) {
+      allocator_ = other.allocator_;
+    }
+    take_nodes(other);
   }
   return *this;
 }
 
+template <class T, class Allocator>
+typename ps::list<T, Allocator>::allocator_type
+ps::list<T, Allocator>::get_allocator() const noexcept {
+  return Allocator(allocator_);
+}
+
 template <class T, class Allocator>
 typename ps::list<T, Allocator>::reference ps::list<T, Allocator>::front() {
-  return head_->value_;
+  return value_of(sentinel_.next_);
 }
 
 template <class T, class Allocator>
 typename ps::list<T, Allocator>::const_reference ps::list<T, Allocator>::front()
     const {
-  return head_->value_;
+  return value_of(sentinel_.next_);
 }
 
 template <class T, class Allocator>
 typename ps::list<T, Allocator>::reference ps::list<T, Allocator>::back() {
-  return tail_->value_;
+  return value_of(sentinel_.prev_);
 }
 
 template <class T, class Allocator>
 typename ps::list<T, Allocator>::const_reference ps::list<T, Allocator>::back()
     const {
-  return tail_->value_;
+  return value_of(sentinel_.prev_);
 }
 
 template <class T, class Allocator>
 typename ps::list<T, Allocator>::iterator
 ps::list<T, Allocator>::begin() noexcept {
-  return ListIterator(head_);
+  return ListIterator(sentinel_.next_);
 }
 
 template <class T, class Allocator>
 typename ps::list<T, Allocator>::const_iterator ps::list<T, Allocator>::begin()
     const noexcept {
-  return ListConstIterator(head_);
+  return ListConstIterator(sentinel_.next_);
 }
 
 template <class T, class Allocator>
 typename ps::list<T, Allocator>::const_iterator ps::list<T, Allocator>::cbegin()
     const noexcept {
-  return ListConstIterator(head_);
+  return ListConstIterator(sentinel_.next_);
 }
 
 template <class T, class Allocator>
 typename ps::list<T, Allocator>::iterator
 ps::list<T, Allocator>::end() noexcept {
-  return ListIterator(fake_node_);
+  return ListIterator(&sentinel_);
 }
 
 template <class T, class Allocator>
 typename ps::list<T, Allocator>::const_iterator ps::list<T, Allocator>::end()
     const noexcept {
-  return ListConstIterator(fake_node_);
+  return ListConstIterator(const_cast<NodeBase*>(&sentinel_));
 }
 
 template <class T, class Allocator>
 typename ps::list<T, Allocator>::const_iterator ps::list<T, Allocator>::cend()
     const noexcept {
-  return ListConstIterator(fake_node_);
+  return ListConstIterator(const_cast<NodeBase*>(&sentinel_));
 }
 
 template <class T, class Allocator>
@@ -399,184 +459,157 @@ typename ps::list<T, Allocator>::size_type ps::list<T, Allocator>::max_size()
 
 template <class T, class Allocator>
 void ps::list<T, Allocator>::clear() noexcept {
-  if (size_ == 0) {
-    return;
-  }
-  while (size_ > 0) {
-    pop_back();
+  NodeBase* node = sentinel_.next_;
+  while (node != &sentinel_) {
+    NodeBase* next = node->next_;
+    deallocate_node(node);
+    node = next;
   }
-  deallocate_node(fake_node_);
-  head_ = nullptr;
-  tail_ = nullptr;
-  fake_node_ = nullptr;
   size_ = 0;
+  attach_sentinel();
 }
 
+/** Links a new node in front of pos; O(1), as pos holds the node. */
 template <class T, class Allocator>
 typename ps::list<T, Allocator>::iterator ps::list<T, Allocator>::insert(
     const_iterator pos, const T& value) {
-  ListIterator it = begin();
-  if (pos != begin() && pos != end()) {
-    Node* new_node = allocate_node();
-    new_node->value_ = value;
-    while (it != pos) {
-      ++it;
-    }
-    Node* cur = it.node_;
-    Node* back = cur->prev_;
-    cur->prev_ = new_node;
-    back->next_ = new_node;
-    new_node->next_ = cur;
-    new_node->prev_ = back;
-    ++size_;
-    --it;
-  } else if (pos == begin()) {
-    push_front(value);
-    it = begin();
-  } else {
-    push_back(value);
-    it = end();
-  }
-  return it;
+  Node* new_node = allocate_node();
+  new_node->value_ = value;
+  link_node(pos.node_, new_node);
+  ++size_;
+  return ListIterator(new_node);
 }
 
+/** Unlinks the node at pos and returns the one after it; O(1). */
 template <class T, class Allocator>
 typename ps::list<T, Allocator>::iterator ps::list<T, Allocator>::erase(
     const_iterator pos) {
-  ListIterator it = begin();
-  if (pos != begin() && pos != tail_) {
-    while (it.node_ != pos.node_) {
-      ++it;
-    }
-    Node* cur = it.node_;
-    Node* back = cur->prev_;
-    Node* next = cur->next_;
-    back->next_ = next;
-    next->prev_ = back;
-    it.node_ = next;
-    deallocate_node(cur);
-    cur = nullptr;
-    --size_;
-  } else if (pos == begin()) {
-    pop_front();
-    it = begin();
-  } else {
-    pop_back();
-    it = end();
-  }
-  return it;
+  NodeBase* node = pos.node_;
+  NodeBase* next = node->next_;
+  unlink_node(node);
+  deallocate_node(node);
+  --size_;
+  return ListIterator(next);
 }
 
 template <class T, class Allocator>
 void ps::list<T, Allocator>::push_back(const T& value) {
-  Node* new_node = allocate_node();
-  new_node->value_ = value;
-  if (head_) {
-    new_node->prev_ = tail_;
-    tail_->next_ = new_node;
-    tail_ = tail_->next_;
-    tail_->next_ = fake_node_;
-    fake_node_->prev_ = tail_;
-  } else {
-    head_ = new_node;
-    tail_ = new_node;
-    fake_node_ = allocate_node();
-    head_->prev_ = fake_node_;
-    tail_->next_ = fake_node_;
-    fake_node_->next_ = head_;
-    fake_node_->prev_ = tail_;
-  }
-  ++size_;
+  insert(cend(), value);
 }
 
 template <class T, class Allocator>
 void ps::list<T, Allocator>::pop_back() {
-  Node* tmp = tail_;
-  tail_ = tail_->prev_;
-  tail_->next_ = fake_node_;
-  fake_node_->prev_ = tail_;
-  deallocate_node(tmp);
-  --size_;
+  erase(ListConstIterator(sentinel_.prev_));
 }
 
 template <class T, class Allocator>
 void ps::list<T, Allocator>::push_front(const T& value) {
-  Node* new_node = allocate_node();
-  new_node->value_ = value;
-  if (head_) {
-    head_->prev_ = new_node;
-    new_node->next_ = head_;
-    head_ = head_->prev_;
-    head_->prev_ = fake_node_;
-    fake_node_->next_ = head_;
-  } else {
-    head_ = new_node;
-    tail_ = new_node;
-    fake_node_ = allocate_node();
-    head_->prev_ = fake_node_;
-    tail_->next_ = fake_node_;
-    fake_node_->next_ = head_;
-    fake_node_->prev_ = tail_;
-  }
-  ++size_;
+  insert(cbegin(), value);
 }
 
 template <class T, class Allocator>
 void ps::list<T, Allocator>::pop_front() {
-  Node* tmp = head_;
-  head_ = head_->next_;
-  head_->prev_ = fake_node_;
-  fake_node_->next_ = head_;
-  deallocate_node(tmp);
-  --size_;
+  erase(ListConstIterator(sentinel_.next_));
 }
 
 template <class T, class Allocator>
 void ps::list<T, Allocator>::swap(list& other) noexcept {
   if (this != &other) {
+    if constexpr (node_allocator::propagate_on_container_swap::value) {
+      std::swap(allocator_, other.allocator_);
+    }
+    std::swap(sentinel_, other.sentinel_);
     std::swap(size_, other.size_);
-    std::swap(head_, other.head_);
-    std::swap(tail_, other.tail_);
-    std::swap(fake_node_, other.fake_node_);
+    attach_sentinel();
+    other.attach_sentinel();
   }
 }
 
+/**
+ * Merges the sorted other into this sorted list by relinking its nodes; no
+ * element is copied or allocated. Equal elements of this list stay in
+ * front of those of other. If the allocators differ, the values of other
+ * are moved into new nodes instead.
+ */
 template <class T, class Allocator>
 void ps::list<T, Allocator>::merge(list& other) {
-  ListConstIterator it_this = cbegin();
-  ListConstIterator it_other = other.cbegin();
-  while (it_this != cend() && it_other != other.cend()) {
-    if (it_other.node_->value_ < it_this.node_->value_) {
-      insert(it_this, *it_other);
-      ++it_other;
-    } else {
-      ++it_this;
+  merge(other, std::less<>());
+}
+
+template <class T, class Allocator>
+template <class Compare>
+void ps::list<T, Allocator>::merge(list& other, Compare comp) {
+  if (this == &other || other.size_ == 0) {
+    return;
+  }
+  NodeBase* cur = sentinel_.next_;
+  NodeBase* from = other.sentinel_.next_;
+  if (!can_relink(other)) {
+    while (from != &other.sentinel_) {
+      if (cur == &sentinel_ || comp(value_of(from), value_of(cur))) {
+        link_node(cur, move_node(from));
+        ++size_;
+        from = from->next_;
+      } else {
+        cur = cur->next_;
+      }
     }
+    other.clear();
+    return;
   }
-  while (it_other != other.cend()) {
-    insert(it_this, *it_other);
-    ++it_other;
+  while (from != &other.sentinel_) {
+    if (cur == &sentinel_) {
+      // Whatever is left of other goes at the end in one piece.
+      transfer(&sentinel_, from, other.sentinel_.prev_);
+      break;
+    }
+    if (comp(value_of(from), value_of(cur))) {
+      NodeBase* next = from->next_;
+      transfer(cur, from, from);
+      from = next;
+    } else {
+      cur = cur->next_;
+    }
   }
-  other.clear();
+  size_ += other.size_;
+  other.size_ = 0;
+  other.attach_sentinel();
 }
 
+/**
+ * Moves all elements of other in front of pos by relinking other's chain
+ * as a whole, in O(1). If the allocators differ, the values are moved into
+ * new nodes one by one instead.
+ */
 template <class T, class Allocator>
 void ps::list<T, Allocator>::splice(const_iterator pos, list& other) {
-  for (iterator it = other.begin(); it != other.end(); ++it) {
-    insert(pos, *it);
+  if (this == &other || other.size_ == 0) {
+    return;
   }
+  if (!can_relink(other)) {
+    for (NodeBase* node = other.sentinel_.next_; node != &other.sentinel_;
+         node = node->next_) {
+      link_node(pos.node_, move_node(node));
+      ++size_;
+    }
+    other.clear();
+    return;
+  }
+  transfer(pos.node_, other.sentinel_.next_, other.sentinel_.prev_);
+  size_ += other.size_;
+  other.size_ = 0;
+  other.attach_sentinel();
 }
 
+/** Swaps the links of every node, the sentinel included; no value moves. */
 template <class T, class Allocator>
 void ps::list<T, Allocator>::reverse() noexcept {
-  if (size_ > 0) {
-    ListIterator lhs = begin();
-    ListIterator rhs = --end();
-    for (size_type i = 0; i < size() / 2; ++i) {
-      std::swap(lhs.node_->value_, rhs.node_->value_);
-      ++lhs;
-      --rhs;
-    }
+  if (size_ > 1) {
+    NodeBase* node = &sentinel_;
+    do {
+      std::swap(node->next_, node->prev_);
+      node = node->prev_;
+    } while (node != &sentinel_);
   }
 }
 
@@ -600,37 +633,138 @@ void ps::list<T, Allocator>::unique() {
 
 template <class T, class Allocator>
 void ps::list<T, Allocator>::sort() {
-  quick_sort(begin(), --end(), size_);
-}
-
-template <class T, class Allocator>
-void ps::list<T, Allocator>::quick_sort(ListIterator first, ListIterator last,
-                                        size_type size) {
-  if (first != last && size > 1) {
-    ListIterator pivot_it = first;
-    ListIterator lhs = first;
-    ListIterator rhs = last;
-    size_type shift = 0;
-    ++pivot_it;
-    value_type pivot = *pivot_it;
-    shift = 0;
-    while (true) {
-      while (*lhs < pivot && lhs != rhs) {
-        ++lhs;
-        ++shift;
-      }
-      while (*rhs >= pivot && rhs != lhs) --rhs;
-      if (lhs == rhs) {
-        break;
-      }
-      std::swap(lhs.node_->value_, rhs.node_->value_);
+  sort(std::less<>());
+}
+
+/**
+ * Bottom-up merge sort on the links alone: values never move, so sorting
+ * large records costs no more than sorting ints. bins[i] holds a sorted
+ * run of 2^i nodes, chained through next_ only; each node is merged in
+ * like a carry through a binary counter. A run always sits in front of
+ * the runs that came after it, which keeps the sort stable. O(n log n)
+ * comparisons whatever the input, and no allocation.
+ */
+template <class T, class Allocator>
+template <class Compare>
+void ps::list<T, Allocator>::sort(Compare comp) {
+  if (size_ < 2) {
+    return;
+  }
+  NodeBase* bins[64] = {};
+  NodeBase* node = sentinel_.next_;
+  while (node != &sentinel_) {
+    NodeBase* next = node->next_;
+    node->next_ = nullptr;
+    NodeBase* run = node;
+    size_type i = 0;
+    for (; bins[i]; ++i) {
+      run = merge_runs(bins[i], run, comp);
+      bins[i] = nullptr;
     }
-    ListIterator next_it = lhs;
-    size_type next_size_lhs = shift;
-    quick_sort(first, --next_it, next_size_lhs);
-    size_type next_size_rhs = size - shift;
-    quick_sort(next_it, last, next_size_rhs);
+    bins[i] = run;
+    node = next;
+  }
+  NodeBase* sorted = nullptr;
+  for (NodeBase* bin : bins) {
+    if (bin) {
+      sorted = sorted ? merge_runs(bin, sorted, comp) : bin;
+    }
+  }
+  // Restore the prev_ links and close the ring through the sentinel.
+  NodeBase* prev = &sentinel_;
+  for (node = sorted; node; node = node->next_) {
+    node->prev_ = prev;
+    prev->next_ = node;
+    prev = node;
   }
+  prev->next_ = &sentinel_;
+  sentinel_.prev_ = prev;
+}
+
+/**
+ * Merges two null-terminated runs, left holding the earlier elements, and
+ * returns the head of the result. On ties left goes first.
+ */
+template <class T, class Allocator>
+template <class Compare>
+typename ps::list<T, Allocator>::NodeBase*
+ps::list<T, Allocator>::merge_runs(NodeBase* left, NodeBase* right,
+                                   Compare& comp) {
+  NodeBase* head = nullptr;
+  NodeBase** tail = &head;
+  while (left && right) {
+    if (comp(value_of(right), value_of(left))) {
+      *tail = right;
+      right = right->next_;
+    } else {
+      *tail = left;
+      left = left->next_;
+    }
+    tail = &(*tail)->next_;
+  }
+  *tail = left ? left : right;
+  return head;
+}
+
+template <class T, class Allocator>
+T& ps::list<T, Allocator>::value_of(NodeBase* node) noexcept {
+  return static_cast<Node*>(node)->value_;
+}
+
+/** Links node in front of pos. */
+template <class T, class Allocator>
+void ps::list<T, Allocator>::link_node(NodeBase* pos,
+                                       NodeBase* node) noexcept {
+  node->prev_ = pos->prev_;
+  node->next_ = pos;
+  pos->prev_->next_ = node;
+  pos->prev_ = node;
+}
+
+template <class T, class Allocator>
+void ps::list<T, Allocator>::unlink_node(NodeBase* node) noexcept {
+  node->prev_->next_ = node->next_;
+  node->next_->prev_ = node->prev_;
+}
+
+/**
+ * Relinks the chain from first to last, inclusive, in front of pos. The
+ * chain may belong to another list, whose ends and size the caller fixes.
+ */
+template <class T, class Allocator>
+void ps::list<T, Allocator>::transfer(NodeBase* pos, NodeBase* first,
+                                      NodeBase* last) noexcept {
+  first->prev_->next_ = last->next_;
+  last->next_->prev_ = first->prev_;
+  first->prev_ = pos->prev_;
+  last->next_ = pos;
+  pos->prev_->next_ = first;
+  pos->prev_ = last;
+}
+
+/**
+ * Points the first and last nodes back at sentinel_ after its links were
+ * copied from another list, or closes it on itself when the list is empty.
+ */
+template <class T, class Allocator>
+void ps::list<T, Allocator>::attach_sentinel() noexcept {
+  if (size_ == 0) {
+    sentinel_.next_ = &sentinel_;
+    sentinel_.prev_ = &sentinel_;
+  } else {
+    sentinel_.next_->prev_ = &sentinel_;
+    sentinel_.prev_->next_ = &sentinel_;
+  }
+}
+
+/** Moves all of other's nodes into this list, which has to be empty. */
+template <class T, class Allocator>
+void ps::list<T, Allocator>::take_nodes(list& other) noexcept {
+  sentinel_ = other.sentinel_;
+  size_ = other.size_;
+  other.size_ = 0;
+  attach_sentinel();
+  other.attach_sentinel();
 }
 
 template <class T, class Allocator>
@@ -2,27 +2,41 @@
 #define CONTAINERS_SRC_PS_MAP_H_
 
 #include <iostream>
+#include <memory_resource>
 #include <stdexcept>
 
 #include "ps_rb_tree.h"
+#include "ps_small_vector.h"
 #include "ps_vector.h"
 
 namespace ps {
 
-template <typename Key, typename T>
+/**
+ * When Ranked is true every node also keeps the size of its subtree, which
+ * gives nth() and rank() in O(log n) at the price of a walk to the root on
+ * every insertion and erasure.
+ */
+template <typename Key, typename T, typename Compare = std::less<>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>,
+          bool Ranked = false>
 class map {
+  using tree_type =
+      RBTree<Key, T, Compare, Allocator,
+             std::conditional_t<Ranked, unit_weight, no_weight>>;
+
   class MapIterator;
   class MapConstIterator;
 
   class MapIterator {
-    friend ps::map<Key, T>;
+    friend ps::map<Key, T, Compare, Allocator, Ranked>;
+    friend MapConstIterator;
     using node_type = rbnode<Key, T>;
     node_type *_node;
-    RBTree<Key, T> *_tree;
+    tree_type *_tree;
 
    public:
     MapIterator() {}
-    explicit MapIterator(RBTree<Key, T> *tree, rbnode<Key, T> *node)
+    explicit MapIterator(tree_type *tree, rbnode<Key, T> *node)
         : _node(node), _tree(tree) {}
 
     const std::pair<const Key, T> &operator*() const { return _node->value; }
@@ -69,16 +83,18 @@ class map {
   };
 
   class MapConstIterator {
-    friend ps::map<Key, T>;
+    friend ps::map<Key, T, Compare, Allocator, Ranked>;
     using node_type = rbnode<Key, T>;
     const node_type *_node;
-    const RBTree<Key, T> *_tree;
+    const tree_type *_tree;
 
    public:
     MapConstIterator() {}
-    explicit MapConstIterator(const RBTree<Key, T> *tree,
+    explicit MapConstIterator(const tree_type *tree,
                               const rbnode<Key, T> *node)
         : _node(node), _tree(tree) {}
+    MapConstIterator(const MapIterator &other)
+        : _node(other._node), _tree(other._tree) {}
 
     const std::pair<const Key, T> &operator*() const { return _node->value; }
     const std::pair<const Key, T> *operator->() const {
@@ -125,7 +141,7 @@ class map {
     ~MapConstIterator() { _node = nullptr; }
   };
 
-  RBTree<Key, T> *_tree;
+  tree_type *_tree;
 
  public:
   using key_type = Key;
@@ -136,14 +152,26 @@ class map {
   using iterator = MapIterator;
   using const_iterator = MapConstIterator;
   using size_type = size_t;
+  using allocator_type = Allocator;
+  using key_compare = Compare;
+  using node_type = typename tree_type::node_type;
+
+  struct insert_return_type {
+    iterator position;
+    bool inserted;
+    node_type node;
+  };
 
   map();
+  explicit map(const Compare &comp);
+  explicit map(const Allocator &allocator);
   map(const map &m);
   map(map &&m) noexcept;
   explicit map(std::initializer_list<value_type> const &items);
   ~map();
 
   mapped_type &operator[](const Key &key);
+  mapped_type &operator[](Key &&key);
   const mapped_type &operator[](const Key &key) const;
   map &operator=(const map &other);
   map &operator=(map &&other) noexcept;
@@ -151,9 +179,14 @@ class map {
   bool empty() const noexcept;
   size_type size() const noexcept;
   size_type max_size() const noexcept;
+  key_compare key_comp() const;
 
   T &at(const Key &key);
   const T &at(const Key &key) const;
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  T &at(const K2 &key);
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  const T &at(const K2 &key) const;
 
   iterator begin() noexcept;
   const_iterator begin() const noexcept;
@@ -163,122 +196,221 @@ class map {
   const_iterator cend() const noexcept;
 
   void clear() noexcept;
+  void clear_async();
   std::pair<iterator, bool> insert(const value_type &value);
+  std::pair<iterator, bool> insert(value_type &&value);
   std::pair<iterator, bool> insert(const Key &key, const T &obj);
-  std::pair<iterator, bool> insert_or_assign(const Key &key, const T &obj);
+  iterator insert(const_iterator hint, const value_type &value);
+  iterator insert(const_iterator hint, value_type &&value);
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args &&...args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const Key &key, Args &&...args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(Key &&key, Args &&...args);
+  template <typename... Args>
+  iterator emplace_hint(const_iterator hint, Args &&...args);
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(const Key &key, M &&obj);
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(Key &&key, M &&obj);
   void erase(iterator pos);
   void erase(const Key &key);
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  void erase(const K2 &key);
   void swap(map &other);
   void merge(map &other);
-
-  bool contains(const Key &key);
+  node_type extract(iterator pos);
+  node_type extract(const Key &key);
+  insert_return_type insert(node_type &&node);
+
+  iterator find(const Key &key);
+  const_iterator find(const Key &key) const;
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  iterator find(const K2 &key);
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  const_iterator find(const K2 &key) const;
+  bool contains(const Key &key) const;
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  bool contains(const K2 &key) const;
+  iterator nth(size_type k);
+  const_iterator nth(size_type k) const;
+  size_type rank(const Key &key) const;
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  size_type rank(const K2 &key) const;
 
   template <class... Args>
-  vector<std::pair<iterator, bool>> insert_many(Args &&...args);
+  insert_many_result<iterator> insert_many(Args &&...args);
+
+  template <typename ForwardIt>
+  static map from_sorted(ForwardIt first, ForwardIt last);
+  template <typename ForwardIt>
+  void assign_sorted(ForwardIt first, ForwardIt last);
 
  private:
-  std::pair<iterator, bool> insert(const value_type &value, bool assign);
+  std::pair<iterator, bool> nodeResult(std::pair<rbnode<Key, T> *, bool> r);
 };
 
-template <typename Key, typename T>
-map<Key, T>::map() {
-  _tree = new RBTree<Key, T>{};
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+map<Key, T, Compare, Allocator, Ranked>::map() {
+  _tree = new tree_type{};
 }
 
-template <typename Key, typename T>
-map<Key, T>::map(const map &m) {
-  _tree = new RBTree<Key, T>{};
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+map<Key, T, Compare, Allocator, Ranked>::map(const Compare &comp) {
+  _tree = new tree_type{comp};
+}
 
-  for (MapConstIterator start = m.cbegin(); start != m.cend(); start++) {
-    std::pair<Key, T> start_pair = *start;
+/** Nodes come from allocator's slabs, see node_pool. */
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+map<Key, T, Compare, Allocator, Ranked>::map(const Allocator &allocator) {
+  _tree = new tree_type{Compare(), allocator};
+}
 
-    auto copy_pair =
-        std::pair<const Key, T>{start_pair.first, start_pair.second};
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+map<Key, T, Compare, Allocator, Ranked>::map(const map &m) {
+  _tree = new tree_type{m._tree->keyComp()};
 
-    _tree->insert(copy_pair);
+  for (MapConstIterator start = m.cbegin(); start != m.cend(); start++) {
+    _tree->insert(*start);
   }
 }
 
-template <typename Key, typename T>
-map<Key, T>::map(std::initializer_list<value_type> const &items) : map() {
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+map<Key, T, Compare, Allocator, Ranked>::map(
+    std::initializer_list<value_type> const &items) : map() {
   for (auto i = items.begin(); i < items.end(); i++) {
     insert(*i);
   }
 }
 
-template <typename Key, typename T>
-map<Key, T>::map(map &&m) noexcept {
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+map<Key, T, Compare, Allocator, Ranked>::map(map &&m) noexcept {
   _tree = m._tree;
 
   m._tree = nullptr;
 }
 
-template <typename Key, typename T>
-map<Key, T>::~map() {
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+map<Key, T, Compare, Allocator, Ranked>::~map() {
   if (_tree != nullptr) {
     delete _tree;
   }
 }
 
-template <typename Key, typename T>
-bool map<Key, T>::empty() const noexcept {
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+bool map<Key, T, Compare, Allocator, Ranked>::empty() const noexcept {
   return _tree->size() == 0;
 }
 
-template <typename Key, typename T>
-typename map<Key, T>::size_type map<Key, T>::size() const noexcept {
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::size_type
+map<Key, T, Compare, Allocator, Ranked>::size() const noexcept {
   return _tree->size();
 }
 
-template <typename Key, typename T>
-typename map<Key, T>::size_type map<Key, T>::max_size() const noexcept {
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::size_type
+map<Key, T, Compare, Allocator, Ranked>::max_size() const noexcept {
   return _tree->max_size();
 }
 
-template <typename Key, typename T>
-T &map<Key, T>::at(const Key &key) {
-  if (!contains(key)) {
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::key_compare
+map<Key, T, Compare, Allocator, Ranked>::key_comp() const {
+  return _tree->keyComp();
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+T &map<Key, T, Compare, Allocator, Ranked>::at(const Key &key) {
+  auto node = _tree->findNode(key);
+  if (node == nullptr) {
+    throw std::out_of_range("key does not exists");
+  }
+  return node->value.second;
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+const T &map<Key, T, Compare, Allocator, Ranked>::at(const Key &key) const {
+  auto node = _tree->findNode(key);
+  if (node == nullptr) {
     throw std::out_of_range("key does not exists");
   }
-  return _tree->find(key).second;
+  return node->value.second;
 }
 
-template <typename Key, typename T>
-const T &map<Key, T>::at(const Key &key) const {
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+template <typename K2, typename>
+T &map<Key, T, Compare, Allocator, Ranked>::at(const K2 &key) {
   auto node = _tree->findNode(key);
   if (node == nullptr) {
     throw std::out_of_range("key does not exists");
   }
-  return _tree->find(key).second;
+  return node->value.second;
 }
 
-template <typename Key, typename T>
-typename map<Key, T>::mapped_type &map<Key, T>::operator[](const Key &key) {
-  if (!_tree->contains(key)) {
-    std::pair<const Key, T> pair = std::pair<Key, T>(key, T());
-    insert(pair);
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+template <typename K2, typename>
+const T &map<Key, T, Compare, Allocator, Ranked>::at(const K2 &key) const {
+  auto node = _tree->findNode(key);
+  if (node == nullptr) {
+    throw std::out_of_range("key does not exists");
   }
-  return _tree->find(key).second;
+  return node->value.second;
 }
 
-template <typename Key, typename T>
-const typename map<Key, T>::mapped_type &map<Key, T>::operator[](
-    const Key &key) const {
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::mapped_type &
+map<Key, T, Compare, Allocator, Ranked>::operator[](const Key &key) {
+  return _tree->tryEmplace(key).first->value.second;
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::mapped_type &
+map<Key, T, Compare, Allocator, Ranked>::operator[](Key &&key) {
+  return _tree->tryEmplace(std::move(key)).first->value.second;
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+const typename map<Key, T, Compare, Allocator, Ranked>::mapped_type &
+map<Key, T, Compare, Allocator, Ranked>::operator[](const Key &key) const {
   return _tree->find(key).second;
 }
 
-template <typename Key, typename T>
-map<Key, T> &map<Key, T>::operator=(const map &other) {
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+map<Key, T, Compare, Allocator, Ranked> &
+map<Key, T, Compare, Allocator, Ranked>::operator=(const map &other) {
   if (this == &other) return *this;
-  map<Key, T> temp_map(other);
+  map<Key, T, Compare, Allocator, Ranked> temp_map(other);
   delete _tree;
   this->_tree = temp_map._tree;
   temp_map._tree = nullptr;
   return *this;
 }
 
-template <typename Key, typename T>
-map<Key, T> &map<Key, T>::operator=(map &&other) noexcept {
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+map<Key, T, Compare, Allocator, Ranked> &
+map<Key, T, Compare, Allocator, Ranked>::operator=(map &&other) noexcept {
   if (this == &other) return *this;
   delete _tree;
   _tree = other._tree;
@@ -286,134 +418,385 @@ map<Key, T> &map<Key, T>::operator=(map &&other) noexcept {
   return *this;
 }
 
-template <typename Key, typename T>
-typename map<Key, T>::iterator map<Key, T>::begin() noexcept {
-  return map::iterator(_tree, _tree->minNode());
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::iterator
+map<Key, T, Compare, Allocator, Ranked>::begin() noexcept {
+  return map::iterator(_tree, _tree->beginNode());
 }
 
-template <typename Key, typename T>
-typename map<Key, T>::const_iterator map<Key, T>::begin() const noexcept {
-  return map::const_iterator(_tree, _tree->minNode());
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::const_iterator
+map<Key, T, Compare, Allocator, Ranked>::begin() const noexcept {
+  return map::const_iterator(_tree, _tree->beginNode());
 }
 
-template <typename Key, typename T>
-typename map<Key, T>::const_iterator map<Key, T>::cbegin() const noexcept {
-  rbnode<Key, T> *node = _tree->minNode();
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::const_iterator
+map<Key, T, Compare, Allocator, Ranked>::cbegin() const noexcept {
+  rbnode<Key, T> *node = _tree->beginNode();
   map::MapConstIterator iterator(_tree, node);
   return iterator;
 }
 
-template <typename Key, typename T>
-typename map<Key, T>::iterator map<Key, T>::end() noexcept {
-  return map::iterator(_tree, _tree->nextNode(_tree->maxNode()));
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::iterator
+map<Key, T, Compare, Allocator, Ranked>::end() noexcept {
+  return map::iterator(_tree, _tree->endNode());
 }
 
-template <typename Key, typename T>
-typename map<Key, T>::const_iterator map<Key, T>::end() const noexcept {
-  return map::const_iterator(_tree, _tree->nextNode(_tree->maxNode()));
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::const_iterator
+map<Key, T, Compare, Allocator, Ranked>::end() const noexcept {
+  return map::const_iterator(_tree, _tree->endNode());
 }
 
-template <typename Key, typename T>
-typename map<Key, T>::const_iterator map<Key, T>::cend() const noexcept {
-  return map::const_iterator(_tree, _tree->nextNode(_tree->maxNode()));
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::const_iterator
+map<Key, T, Compare, Allocator, Ranked>::cend() const noexcept {
+  return map::const_iterator(_tree, _tree->endNode());
 }
 
-template <typename Key, typename T>
-void map<Key, T>::clear() noexcept {
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+void map<Key, T, Compare, Allocator, Ranked>::clear() noexcept {
   _tree->clear();
 }
 
-template <typename Key, typename T>
-std::pair<typename map<Key, T>::iterator, bool> map<Key, T>::insert(
-    const map::value_type &value, bool assign) {
-  rbnode<Key, T> *found_node = _tree->findNode(value.first);
-  rbnode<Key, T> *result_node;
-  bool inserted;
-  if (found_node != nullptr) {
-    result_node = found_node;
-    if (assign) {
-      result_node->value.second = value.second;
-    }
-    inserted = false;
-  } else {
-    map::value_type copy_value(value);
-    result_node = _tree->insert(copy_value);
-    inserted = true;
-  }
+/**
+ * Like clear(), but the elements are destroyed on the background reclaimer
+ * thread, so the call returns in constant time. Only with std::allocator:
+ * other allocators may not be used from that thread, and clear() runs.
+ */
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+void map<Key, T, Compare, Allocator, Ranked>::clear_async() {
+  _tree->clearAsync();
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+std::pair<typename map<Key, T, Compare, Allocator, Ranked>::iterator, bool>
+map<Key, T, Compare, Allocator, Ranked>::nodeResult(
+    std::pair<rbnode<Key, T> *, bool> r) {
+  return std::pair<iterator, bool>(iterator(_tree, r.first), r.second);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+std::pair<typename map<Key, T, Compare, Allocator, Ranked>::iterator, bool>
+map<Key, T, Compare, Allocator, Ranked>::insert(const map::value_type &value) {
+  return nodeResult(_tree->insertUnique(value));
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+std::pair<typename map<Key, T, Compare, Allocator, Ranked>::iterator, bool>
+map<Key, T, Compare, Allocator, Ranked>::insert(map::value_type &&value) {
+  return nodeResult(_tree->insertUnique(std::move(value)));
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+std::pair<typename map<Key, T, Compare, Allocator, Ranked>::iterator, bool>
+map<Key, T, Compare, Allocator, Ranked>::insert(const Key &key, const T &obj) {
+  return try_emplace(key, obj);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::iterator
+map<Key, T, Compare, Allocator, Ranked>::insert(const_iterator hint,
+                                                const value_type &value) {
+  return nodeResult(_tree->insertHint(hint._node, value)).first;
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::iterator
+map<Key, T, Compare, Allocator, Ranked>::insert(const_iterator hint,
+                                                value_type &&value) {
+  return nodeResult(_tree->insertHint(hint._node, std::move(value))).first;
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+template <typename... Args>
+typename map<Key, T, Compare, Allocator, Ranked>::iterator
+map<Key, T, Compare, Allocator, Ranked>::emplace_hint(const_iterator hint,
+                                                      Args &&...args) {
+  auto result = _tree->emplaceHint(hint._node, std::forward<Args>(args)...);
+  return nodeResult(result).first;
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+template <typename... Args>
+std::pair<typename map<Key, T, Compare, Allocator, Ranked>::iterator, bool>
+map<Key, T, Compare, Allocator, Ranked>::emplace(Args &&...args) {
+  return nodeResult(_tree->emplace(std::forward<Args>(args)...));
+}
 
-  iterator result_node_iterator(_tree, result_node);
-  return std::pair<iterator, bool>(result_node_iterator, inserted);
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+template <typename... Args>
+std::pair<typename map<Key, T, Compare, Allocator, Ranked>::iterator, bool>
+map<Key, T, Compare, Allocator, Ranked>::try_emplace(const Key &key,
+                                                     Args &&...args) {
+  return nodeResult(_tree->tryEmplace(key, std::forward<Args>(args)...));
 }
 
-template <typename Key, typename T>
-std::pair<typename map<Key, T>::iterator, bool> map<Key, T>::insert(
-    const map::value_type &value) {
-  return insert(value, false);
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+template <typename... Args>
+std::pair<typename map<Key, T, Compare, Allocator, Ranked>::iterator, bool>
+map<Key, T, Compare, Allocator, Ranked>::try_emplace(Key &&key,
+                                                     Args &&...args) {
+  return nodeResult(
+      _tree->tryEmplace(std::move(key), std::forward<Args>(args)...));
 }
 
-template <typename Key, typename T>
-std::pair<typename map<Key, T>::iterator, bool> map<Key, T>::insert(
-    const Key &key, const T &obj) {
-  return insert(value_type(key, obj));
+/**
+ * Builds the value from obj if key is new, or assigns obj to the mapped
+ * value otherwise; an rvalue obj is moved either way.
+ */
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+template <typename M>
+std::pair<typename map<Key, T, Compare, Allocator, Ranked>::iterator, bool>
+map<Key, T, Compare, Allocator, Ranked>::insert_or_assign(const Key &key,
+                                                          M &&obj) {
+  auto result = _tree->tryEmplace(key, std::forward<M>(obj));
+  if (!result.second) {
+    result.first->value.second = std::forward<M>(obj);
+  }
+  return nodeResult(result);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+template <typename M>
+std::pair<typename map<Key, T, Compare, Allocator, Ranked>::iterator, bool>
+map<Key, T, Compare, Allocator, Ranked>::insert_or_assign(Key &&key,
+                                                          M &&obj) {
+  auto result = _tree->tryEmplace(std::move(key), std::forward<M>(obj));
+  if (!result.second) {
+    result.first->value.second = std::forward<M>(obj);
+  }
+  return nodeResult(result);
 }
 
-template <typename Key, typename T>
-std::pair<typename map<Key, T>::iterator, bool> map<Key, T>::insert_or_assign(
-    const Key &key, const T &obj) {
-  return insert(std::pair<Key, T>(key, obj), true);
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+void map<Key, T, Compare, Allocator, Ranked>::erase(
+    map<Key, T, Compare, Allocator, Ranked>::iterator pos) {
+  _tree->delNode(pos._node);
 }
 
-template <typename Key, typename T>
-void map<Key, T>::erase(map<Key, T>::iterator pos) {
-  erase(pos->first);
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+void map<Key, T, Compare, Allocator, Ranked>::erase(const Key &key) {
+  _tree->del(key);
 }
 
-template <typename Key, typename T>
-void map<Key, T>::erase(const Key &key) {
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+template <typename K2, typename>
+void map<Key, T, Compare, Allocator, Ranked>::erase(const K2 &key) {
   _tree->del(key);
 }
 
-template <typename Key, typename T>
-void map<Key, T>::swap(map &other) {
-  RBTree<Key, T> *temp_tree = this->_tree;
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+void map<Key, T, Compare, Allocator, Ranked>::swap(map &other) {
+  tree_type *temp_tree = this->_tree;
   this->_tree = other._tree;
   other._tree = temp_tree;
 }
 
-template <typename Key, typename T>
-void map<Key, T>::merge(map &other) {
-  vector<Key> moved_values;
-  for (MapIterator start = other.begin(); start != other.end(); start++) {
-    if (!contains((*start).first)) {
-      insert(*start);
-      moved_values.push_back((*start).first);
-    }
-  }
-  for (auto i : moved_values) {
-    other.erase(i);
-  }
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+void map<Key, T, Compare, Allocator, Ranked>::merge(map &other) {
+  _tree->mergeNodes(*other._tree, [](rbnode<Key, T> *, rbnode<Key, T> *) {
+    return false;
+  });
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::node_type
+map<Key, T, Compare, Allocator, Ranked>::extract(iterator pos) {
+  return _tree->extract(pos._node);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::node_type
+map<Key, T, Compare, Allocator, Ranked>::extract(const Key &key) {
+  rbnode<Key, T> *node = _tree->findNode(key);
+  return node != nullptr ? _tree->extract(node) : node_type();
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::insert_return_type
+map<Key, T, Compare, Allocator, Ranked>::insert(node_type &&node) {
+  auto result = _tree->insertNode(std::move(node));
+  return insert_return_type{iterator(_tree, result.first), result.second,
+                            std::move(node)};
 }
 
-template <typename Key, typename T>
-bool map<Key, T>::contains(const Key &key) {
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::iterator
+map<Key, T, Compare, Allocator, Ranked>::find(const Key &key) {
   auto node = _tree->findNode(key);
-  if (node == nullptr) {
-    return false;
-  }
-  return true;
+  return iterator(_tree, node != nullptr ? node : _tree->endNode());
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::const_iterator
+map<Key, T, Compare, Allocator, Ranked>::find(const Key &key) const {
+  auto node = _tree->findNode(key);
+  return const_iterator(_tree, node != nullptr ? node : _tree->endNode());
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+template <typename K2, typename>
+typename map<Key, T, Compare, Allocator, Ranked>::iterator
+map<Key, T, Compare, Allocator, Ranked>::find(const K2 &key) {
+  auto node = _tree->findNode(key);
+  return iterator(_tree, node != nullptr ? node : _tree->endNode());
 }
 
-template <typename Key, typename T>
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+template <typename K2, typename>
+typename map<Key, T, Compare, Allocator, Ranked>::const_iterator
+map<Key, T, Compare, Allocator, Ranked>::find(const K2 &key) const {
+  auto node = _tree->findNode(key);
+  return const_iterator(_tree, node != nullptr ? node : _tree->endNode());
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+bool map<Key, T, Compare, Allocator, Ranked>::contains(const Key &key) const {
+  return _tree->contains(key);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+template <typename K2, typename>
+bool map<Key, T, Compare, Allocator, Ranked>::contains(const K2 &key) const {
+  return _tree->contains(key);
+}
+
+/** The element at position k in key order, end() when k >= size(). */
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::iterator
+map<Key, T, Compare, Allocator, Ranked>::nth(size_type k) {
+  size_t offset;
+  return iterator(_tree, _tree->selectNode(k, offset));
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::const_iterator
+map<Key, T, Compare, Allocator, Ranked>::nth(size_type k) const {
+  size_t offset;
+  return const_iterator(_tree, _tree->selectNode(k, offset));
+}
+
+/**
+ * The number of elements whose keys are less than key, which is the
+ * position of key in the map if present. O(log n).
+ */
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+typename map<Key, T, Compare, Allocator, Ranked>::size_type
+map<Key, T, Compare, Allocator, Ranked>::rank(const Key &key) const {
+  return _tree->rankOf(key);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+template <typename K2, typename>
+typename map<Key, T, Compare, Allocator, Ranked>::size_type
+map<Key, T, Compare, Allocator, Ranked>::rank(const K2 &key) const {
+  return _tree->rankOf(key);
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
 template <class... Args>
-vector<std::pair<typename map<Key, T>::iterator, bool>>
-map<Key, T>::insert_many(Args &&...args) {
-  vector<std::pair<iterator, bool>> res{};
+insert_many_result<
+    typename map<Key, T, Compare, Allocator, Ranked>::iterator>
+map<Key, T, Compare, Allocator, Ranked>::insert_many(Args &&...args) {
+  insert_many_result<iterator> res;
+  // Batches are often sorted, so each key is tried next to the previous one.
+  const rbnode<Key, T> *hint = _tree->endNode();
   for (const auto &arg : {args...}) {
-    res.push_back(insert(arg));
+    auto result = _tree->insertHint(hint, arg);
+    hint = result.first;
+    res.push_back(nodeResult(result));
   }
   return res;
 }
 
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+template <typename ForwardIt>
+map<Key, T, Compare, Allocator, Ranked>
+map<Key, T, Compare, Allocator, Ranked>::from_sorted(ForwardIt first,
+                                                     ForwardIt last) {
+  map result;
+  result.assign_sorted(first, last);
+  return result;
+}
+
+template <typename Key, typename T, typename Compare, typename Allocator,
+          bool Ranked>
+template <typename ForwardIt>
+void map<Key, T, Compare, Allocator, Ranked>::assign_sorted(ForwardIt first,
+                                                            ForwardIt last) {
+  // [first, last) must be sorted by key; of equal keys only the first one
+  // is kept, just like with repeated insert().
+  const Compare &comp = _tree->keyComp();
+  auto next_run = [last, &comp](ForwardIt &it) {
+    ForwardIt run = it;
+    while (++it != last && !comp((*run).first, (*it).first)) {
+    }
+    return run;
+  };
+  size_type count = 0;
+  for (ForwardIt it = first; it != last; next_run(it)) {
+    count++;
+  }
+  _tree->assignSorted(count, [&]() -> decltype(*first) {
+    return *next_run(first);
+  });
+}
+
+/** map with nth() and rank(). */
+template <typename Key, typename T, typename Compare = std::less<>>
+using ranked_map =
+    map<Key, T, Compare, std::allocator<std::pair<const Key, T>>, true>;
+
+namespace pmr {
+template <typename Key, typename T, typename Compare = std::less<>>
+using map =
+    ps::map<Key, T, Compare,
+            std::pmr::polymorphic_allocator<std::pair<const Key, T>>>;
+}  // namespace pmr
+
 }  // namespace ps
 
 #endif
\ No newline at end of file
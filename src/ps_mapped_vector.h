@@ -0,0 +1,507 @@
+#ifndef CONTAINERS_SRC_PS_MAPPED_VECTOR_H_
+#define CONTAINERS_SRC_PS_MAPPED_VECTOR_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+namespace ps {
+/**
+ * mapped_vector - a vector of trivially copyable elements that lives in a
+ * file mapped into memory. The file is a short header, which records the
+ * element size and the size, followed by capacity() elements. Growing
+ * extends the file with ftruncate and remaps it, so the data set may be
+ * larger than RAM: the kernel pages elements in and out as they are used.
+ *
+ * open() on an existing file maps it as it is; nothing is read or copied,
+ * and reopening a vector of any size takes a few system calls. Changes
+ * reach the file when the kernel writes the pages back, at the latest on
+ * munmap; sync() forces them to disk. Iterators are plain pointers into
+ * the mapping and are invalidated whenever it grows or is closed.
+ *
+ * A default-constructed mapped_vector is closed and empty; everything but
+ * open() needs an open one.
+ */
+template <class T>
+class mapped_vector {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "mapped_vector stores its elements as raw file bytes");
+  static_assert(alignof(T) <= 64, "mapped_vector aligns elements to 64");
+
+ public:
+  using value_type = T;
+  using reference = T&;
+  using const_reference = const T&;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using size_type = size_t;
+
+  mapped_vector() = default;
+  explicit mapped_vector(const std::string& path);
+  mapped_vector(const mapped_vector&) = delete;
+  mapped_vector(mapped_vector&& v) noexcept;
+  ~mapped_vector();
+
+  mapped_vector& operator=(const mapped_vector&) = delete;
+  mapped_vector& operator=(mapped_vector&& other) noexcept;
+
+  void open(const std::string& path);
+  void close() noexcept;
+  bool is_open() const noexcept;
+  void sync();
+
+  reference at(size_type pos);
+  const_reference at(size_type pos) const;
+
+  reference operator[](size_type pos);
+  const_reference operator[](size_type pos) const;
+
+  const_reference front() const;
+  const_reference back() const;
+  iterator data() noexcept;
+  const_iterator data() const noexcept;
+
+  iterator begin() noexcept;
+  const_iterator begin() const noexcept;
+  const_iterator cbegin() const noexcept;
+  iterator end() noexcept;
+  const_iterator end() const noexcept;
+  const_iterator cend() const noexcept;
+
+  bool empty() const noexcept;
+  size_type size() const noexcept;
+  size_type max_size() const noexcept;
+  void reserve(size_type new_cap);
+  size_type capacity() const noexcept;
+  void shrink_to_fit();
+
+  void clear() noexcept;
+  iterator insert(const_iterator pos, const T& value);
+  iterator erase(const_iterator pos);
+  iterator erase(const_iterator first, const_iterator last);
+  void push_back(const T& value);
+  template <class... Args>
+  reference emplace_back(Args&&... args);
+  void pop_back();
+  void swap(mapped_vector& other) noexcept;
+
+ private:
+  // The file starts with this, padded so that the elements after it are
+  // aligned for any T.
+  struct alignas(64) file_header {
+    uint64_t magic;
+    uint64_t element_size;
+    uint64_t size;
+  };
+
+  static constexpr uint64_t kMagic = 0x70736d6170766563;  // "psmapvec"
+
+  static size_type fileLength(size_type capacity);
+  [[noreturn]] static void fail(const char* what);
+  [[noreturn]] void closeAndFail(const char* what);
+  void remap(size_type new_cap);
+  size_type grownCapacity() const;
+
+  int fd_ = -1;
+  file_header* header_ = nullptr;
+  T* data_ = nullptr;
+  size_type capacity_ = 0;
+  // Bytes mapped: the whole file, which may end in a partial element.
+  size_type length_ = 0;
+};
+}  // namespace ps
+
+template <class T>
+ps::mapped_vector<T>::mapped_vector(const std::string& path) {
+  open(path);
+}
+
+template <class T>
+ps::mapped_vector<T>::mapped_vector(mapped_vector&& v) noexcept {
+  swap(v);
+}
+
+template <class T>
+ps::mapped_vector<T>::~mapped_vector() {
+  close();
+}
+
+template <class T>
+ps::mapped_vector<T>& ps::mapped_vector<T>::operator=(
+    mapped_vector&& other) noexcept {
+  if (this != &other) {
+    close();
+    swap(other);
+  }
+  return *this;
+}
+
+/**
+ * Opens path, creating an empty vector there if the file does not exist
+ * or is empty, and maps it. Throws std::system_error if the file cannot be
+ * opened or mapped, and std::runtime_error if it does not hold a
+ * mapped_vector of this element size; either way the vector is closed.
+ */
+template <class T>
+void ps::mapped_vector<T>::open(const std::string& path) {
+  close();
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    fail("mapped_vector: open");
+  }
+  struct stat st;
+  if (fstat(fd_, &st) != 0) {
+    closeAndFail("mapped_vector: fstat");
+  }
+  size_type length = size_type(st.st_size);
+  bool fresh = length == 0;
+  if (fresh) {
+    length = fileLength(0);
+    if (ftruncate(fd_, off_t(length)) != 0) {
+      closeAndFail("mapped_vector: ftruncate");
+    }
+  } else if (length < sizeof(file_header)) {
+    close();
+    throw std::runtime_error("mapped_vector: not a mapped_vector file");
+  }
+  void* mapping =
+      mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (mapping == MAP_FAILED) {
+    closeAndFail("mapped_vector: mmap");
+  }
+  header_ = static_cast<file_header*>(mapping);
+  data_ = reinterpret_cast<T*>(header_ + 1);
+  capacity_ = (length - sizeof(file_header)) / sizeof(T);
+  length_ = length;
+  if (fresh) {
+    header_->magic = kMagic;
+    header_->element_size = sizeof(T);
+    header_->size = 0;
+  } else if (header_->magic != kMagic || header_->element_size != sizeof(T) ||
+             header_->size > capacity_) {
+    close();
+    throw std::runtime_error("mapped_vector: not a mapped_vector of T");
+  }
+}
+
+/** Unmaps the file and closes it; the vector is then empty. */
+template <class T>
+void ps::mapped_vector<T>::close() noexcept {
+  if (header_ != nullptr) {
+    munmap(header_, length_);
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+  fd_ = -1;
+  header_ = nullptr;
+  data_ = nullptr;
+  capacity_ = 0;
+  length_ = 0;
+}
+
+template <class T>
+bool ps::mapped_vector<T>::is_open() const noexcept {
+  return header_ != nullptr;
+}
+
+/** Writes the changed pages back and waits until they are on disk. */
+template <class T>
+void ps::mapped_vector<T>::sync() {
+  if (msync(header_, length_, MS_SYNC) != 0) {
+    fail("mapped_vector: msync");
+  }
+}
+
+template <class T>
+typename ps::mapped_vector<T>::reference ps::mapped_vector<T>::at(
+    size_type pos) {
+  if (pos >= size()) {
+    throw std::out_of_range("Out of range");
+  }
+  return data_[pos];
+}
+
+template <class T>
+typename ps::mapped_vector<T>::const_reference ps::mapped_vector<T>::at(
+    size_type pos) const {
+  if (pos >= size()) {
+    throw std::out_of_range("Out of range");
+  }
+  return data_[pos];
+}
+
+template <class T>
+typename ps::mapped_vector<T>::reference ps::mapped_vector<T>::operator[](
+    size_type pos) {
+  return data_[pos];
+}
+
+template <class T>
+typename ps::mapped_vector<T>::const_reference
+ps::mapped_vector<T>::operator[](size_type pos) const {
+  return data_[pos];
+}
+
+template <class T>
+typename ps::mapped_vector<T>::const_reference ps::mapped_vector<T>::front()
+    const {
+  return data_[0];
+}
+
+template <class T>
+typename ps::mapped_vector<T>::const_reference ps::mapped_vector<T>::back()
+    const {
+  return data_[size() - 1];
+}
+
+template <class T>
+typename ps::mapped_vector<T>::iterator ps::mapped_vector<T>::data() noexcept {
+  return data_;
+}
+
+template <class T>
+typename ps::mapped_vector<T>::const_iterator ps::mapped_vector<T>::data()
+    const noexcept {
+  return data_;
+}
+
+template <class T>
+typename ps::mapped_vector<T>::iterator
+ps::mapped_vector<T>::begin() noexcept {
+  return data_;
+}
+
+template <class T>
+typename ps::mapped_vector<T>::const_iterator ps::mapped_vector<T>::begin()
+    const noexcept {
+  return data_;
+}
+
+template <class T>
+typename ps::mapped_vector<T>::const_iterator ps::mapped_vector<T>::cbegin()
+    const noexcept {
+  return data_;
+}
+
+template <class T>
+typename ps::mapped_vector<T>::iterator ps::mapped_vector<T>::end() noexcept {
+  return data_ + size();
+}
+
+template <class T>
+typename ps::mapped_vector<T>::const_iterator ps::mapped_vector<T>::end()
+    const noexcept {
+  return data_ + size();
+}
+
+template <class T>
+typename ps::mapped_vector<T>::const_iterator ps::mapped_vector<T>::cend()
+    const noexcept {
+  return data_ + size();
+}
+
+template <class T>
+bool ps::mapped_vector<T>::empty() const noexcept {
+  return size() == 0;
+}
+
+template <class T>
+typename ps::mapped_vector<T>::size_type ps::mapped_vector<T>::size()
+    const noexcept {
+  return header_ != nullptr ? size_type(header_->size) : 0;
+}
+
+template <class T>
+typename ps::mapped_vector<T>::size_type ps::mapped_vector<T>::max_size()
+    const noexcept {
+  return (size_type(std::numeric_limits<off_t>::max()) - sizeof(file_header)) /
+         sizeof(T);
+}
+
+template <class T>
+void ps::mapped_vector<T>::reserve(size_type new_cap) {
+  if (new_cap > max_size()) {
+    throw std::length_error("Length error");
+  }
+  if (new_cap > capacity_) {
+    remap(new_cap);
+  }
+}
+
+template <class T>
+typename ps::mapped_vector<T>::size_type ps::mapped_vector<T>::capacity()
+    const noexcept {
+  return capacity_;
+}
+
+/** Truncates the file to the elements in use. */
+template <class T>
+void ps::mapped_vector<T>::shrink_to_fit() {
+  if (capacity_ > size()) {
+    remap(size());
+  }
+}
+
+template <class T>
+void ps::mapped_vector<T>::clear() noexcept {
+  if (header_ != nullptr) {
+    header_->size = 0;
+  }
+}
+
+template <class T>
+typename ps::mapped_vector<T>::iterator ps::mapped_vector<T>::insert(
+    const_iterator pos, const T& value) {
+  size_type index = size_type(pos - begin());
+  if (index > size()) {
+    throw std::out_of_range("Out of range");
+  }
+  // value may be an element, which the shift or the remap would move.
+  T copy = value;
+  if (size() == capacity_) {
+    remap(grownCapacity());
+  }
+  std::memmove(static_cast<void*>(data_ + index + 1), data_ + index,
+               (size() - index) * sizeof(T));
+  std::memcpy(static_cast<void*>(data_ + index), &copy, sizeof(T));
+  ++header_->size;
+  return data_ + index;
+}
+
+template <class T>
+typename ps::mapped_vector<T>::iterator ps::mapped_vector<T>::erase(
+    const_iterator pos) {
+  if (pos >= cend()) {
+    return end();
+  }
+  return erase(pos, pos + 1);
+}
+
+template <class T>
+typename ps::mapped_vector<T>::iterator ps::mapped_vector<T>::erase(
+    const_iterator first, const_iterator last) {
+  size_type index = size_type(first - begin());
+  size_type count = size_type(last - first);
+  if (count > 0) {
+    std::memmove(static_cast<void*>(data_ + index), data_ + index + count,
+                 (size() - index - count) * sizeof(T));
+    header_->size -= count;
+  }
+  return data_ + index;
+}
+
+template <class T>
+void ps::mapped_vector<T>::push_back(const T& value) {
+  emplace_back(value);
+}
+
+template <class T>
+template <class... Args>
+typename ps::mapped_vector<T>::reference ps::mapped_vector<T>::emplace_back(
+    Args&&... args) {
+  // args may refer to an element, which the remap would move.
+  T value(std::forward<Args>(args)...);
+  if (size() == capacity_) {
+    remap(grownCapacity());
+  }
+  T* place = data_ + size();
+  std::memcpy(static_cast<void*>(place), &value, sizeof(T));
+  ++header_->size;
+  return *place;
+}
+
+template <class T>
+void ps::mapped_vector<T>::pop_back() {
+  if (size() > 0) {
+    --header_->size;
+  }
+}
+
+template <class T>
+void ps::mapped_vector<T>::swap(mapped_vector& other) noexcept {
+  std::swap(fd_, other.fd_);
+  std::swap(header_, other.header_);
+  std::swap(data_, other.data_);
+  std::swap(capacity_, other.capacity_);
+  std::swap(length_, other.length_);
+}
+
+template <class T>
+typename ps::mapped_vector<T>::size_type ps::mapped_vector<T>::fileLength(
+    size_type capacity) {
+  return sizeof(file_header) + capacity * sizeof(T);
+}
+
+template <class T>
+void ps::mapped_vector<T>::fail(const char* what) {
+  int error = errno;
+  throw std::system_error(error, std::generic_category(), what);
+}
+
+/** Like fail, but first closes the vector so the descriptor is not lost. */
+template <class T>
+void ps::mapped_vector<T>::closeAndFail(const char* what) {
+  int error = errno;
+  close();
+  errno = error;
+  fail(what);
+}
+
+/**
+ * Resizes the file to new_cap elements and maps it again. On Linux mremap
+ * moves the page table entries, so none of the data is touched; elsewhere
+ * the file is unmapped and mapped anew, which is just as cheap as the
+ * pages stay in the page cache.
+ */
+template <class T>
+void ps::mapped_vector<T>::remap(size_type new_cap) {
+  size_type old_length = length_;
+  size_type new_length = fileLength(new_cap);
+  if (new_length > old_length && ftruncate(fd_, off_t(new_length)) != 0) {
+    fail("mapped_vector: ftruncate");
+  }
+#ifdef __linux__
+  void* mapping = mremap(header_, old_length, new_length, MREMAP_MAYMOVE);
+#else
+  munmap(header_, old_length);
+  header_ = nullptr;
+  void* mapping =
+      mmap(nullptr, new_length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (mapping == MAP_FAILED) {
+    closeAndFail("mapped_vector: mmap");
+  }
+#endif
+  if (mapping == MAP_FAILED) {
+    fail("mapped_vector: mremap");
+  }
+  header_ = static_cast<file_header*>(mapping);
+  data_ = reinterpret_cast<T*>(header_ + 1);
+  capacity_ = new_cap;
+  length_ = new_length;
+  if (new_length < old_length && ftruncate(fd_, off_t(new_length)) != 0) {
+    fail("mapped_vector: ftruncate");
+  }
+}
+
+/** Doubles, but grows by at least a page's worth of elements. */
+template <class T>
+typename ps::mapped_vector<T>::size_type
+ps::mapped_vector<T>::grownCapacity() const {
+  size_type page = std::max<size_type>(4096 / sizeof(T), 1);
+  return std::min(std::max(capacity_ * 2, capacity_ + page), max_size());
+}
+
+#endif  // CONTAINERS_SRC_PS_MAPPED_VECTOR_H_
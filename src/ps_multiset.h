@@ -1,29 +1,43 @@
 #ifndef CONTAINERS_SRC_PS_MULTISET_H_
 #define CONTAINERS_SRC_PS_MULTISET_H_
 
+#include <memory_resource>
 #include <stdexcept>
 
 #include "ps_rb_tree.h"
+#include "ps_small_vector.h"
 #include "ps_vector.h"
 
 namespace ps {
 
-template <typename Key>
+struct set_algebra;
+
+/**
+ * Ranked adds nth() and rank(), as for map. Every copy of a key counts as
+ * an element of its own.
+ */
+template <typename Key, typename Compare = std::less<>,
+          typename Allocator = std::allocator<Key>, bool Ranked = false>
 class multiset {
+  friend set_algebra;
+
+  using tree_type =
+      RBTree<Key, size_t, Compare, Allocator,
+             std::conditional_t<Ranked, mapped_weight, no_weight>>;
+
   class MultisetIterator;
   class MultisetConstIterator;
 
   class MultisetIterator {
-    friend multiset<Key>;
+    friend multiset<Key, Compare, Allocator, Ranked>;
     using node_type = rbnode<Key, size_t>;
     node_type *_node;
-    RBTree<Key, size_t> *_tree;
+    tree_type *_tree;
     size_t _pos = 0;
 
    public:
     MultisetIterator() {}
-    explicit MultisetIterator(RBTree<Key, size_t> *tree,
-                              rbnode<Key, size_t> *node)
+    explicit MultisetIterator(tree_type *tree, rbnode<Key, size_t> *node)
         : _node(node), _tree(tree) {}
 
     const Key &operator*() const { return _node->value.first; }
@@ -79,15 +93,15 @@ class multiset {
   };
 
   class MultisetConstIterator {
-    friend multiset<Key>;
+    friend multiset<Key, Compare, Allocator, Ranked>;
     using node_type = rbnode<Key, size_t>;
     const node_type *_node;
-    const RBTree<Key, size_t> *_tree;
+    const tree_type *_tree;
     size_t _pos = 0;
 
    public:
     MultisetConstIterator() {}
-    explicit MultisetConstIterator(const RBTree<Key, size_t> *tree,
+    explicit MultisetConstIterator(const tree_type *tree,
                                    const rbnode<Key, size_t> *node)
         : _node(node), _tree(tree) {}
 
@@ -143,7 +157,7 @@ class multiset {
     ~MultisetConstIterator() { _node = nullptr; }
   };
 
-  RBTree<Key, size_t> *_tree;
+  tree_type *_tree;
   size_t _size = 0;
 
  public:
@@ -154,8 +168,15 @@ class multiset {
   using iterator = MultisetIterator;
   using const_iterator = MultisetConstIterator;
   using size_type = size_t;
+  using allocator_type = Allocator;
+  using key_compare = Compare;
+  using node_type =
+      typename tree_type::node_type;
 
   multiset();
+  explicit multiset(const Compare &comp);
+  explicit multiset(const Allocator &allocator);
+  multiset(const Compare &comp, const Allocator &allocator);
   multiset(const multiset &m);
   multiset(multiset &&m) noexcept;
   multiset(std::initializer_list<value_type> const &items);
@@ -167,6 +188,8 @@ class multiset {
   bool empty() const noexcept;
   size_type size() const noexcept;
   size_type max_size() const noexcept;
+  key_compare key_comp() const;
+  allocator_type get_allocator() const;
 
   iterator begin() noexcept;
   const_iterator begin() const noexcept;
@@ -176,31 +199,81 @@ class multiset {
   const_iterator cend() const noexcept;
 
   void clear() noexcept;
+  void clear_async();
   std::pair<iterator, bool> insert(const value_type &value);
   void erase(iterator pos);
-  void erase(Key key);
+  void erase(const Key &key);
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  void erase(const K2 &key);
   void swap(multiset &other);
   void merge(multiset &other);
-
-  size_type count(const Key &key);
-  bool contains(const Key &key);
+  node_type extract(iterator pos);
+  node_type extract(const Key &key);
+  iterator insert(node_type &&node);
+
+  size_type count(const Key &key) const;
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  size_type count(const K2 &key) const;
+  bool contains(const Key &key) const;
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  bool contains(const K2 &key) const;
   iterator find(const Key &key);
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  iterator find(const K2 &key);
+  iterator nth(size_type k);
+  size_type rank(const Key &key) const;
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  size_type rank(const K2 &key) const;
   std::pair<iterator, iterator> equal_range(const Key &key);
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  std::pair<iterator, iterator> equal_range(const K2 &key);
   iterator lower_bound(const Key &key);
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  iterator lower_bound(const K2 &key);
   iterator upper_bound(const Key &key);
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  iterator upper_bound(const K2 &key);
 
   template <class... Args>
-  vector<std::pair<iterator, bool>> insert_many(Args &&...args);
+  insert_many_result<iterator> insert_many(Args &&...args);
+
+  template <typename ForwardIt>
+  static multiset from_sorted(ForwardIt first, ForwardIt last);
+  template <typename ForwardIt>
+  void assign_sorted(ForwardIt first, ForwardIt last);
+
+ private:
+  void eraseOne(rbnode<Key, size_t> *node);
+  iterator nodeIterator(rbnode<Key, size_t> *node, size_t pos = 0);
+  std::pair<iterator, iterator> nodeRange(rbnode<Key, size_t> *node);
 };
 
-template <typename Key>
-multiset<Key>::multiset() {
-  _tree = new RBTree<Key, size_t>{};
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+multiset<Key, Compare, Allocator, Ranked>::multiset() {
+  _tree = new tree_type{};
 }
 
-template <typename Key>
-multiset<Key>::multiset(const multiset &m) {
-  _tree = new RBTree<Key, size_t>{};
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+multiset<Key, Compare, Allocator, Ranked>::multiset(const Compare &comp) {
+  _tree = new tree_type{comp};
+}
+
+/** Nodes come from allocator's slabs, see node_pool. */
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+multiset<Key, Compare, Allocator, Ranked>::multiset(
+    const Allocator &allocator) {
+  _tree = new tree_type{Compare(), allocator};
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+multiset<Key, Compare, Allocator, Ranked>::multiset(
+    const Compare &comp, const Allocator &allocator) {
+  _tree = new tree_type{comp, allocator};
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+multiset<Key, Compare, Allocator, Ranked>::multiset(const multiset &m) {
+  _tree = new tree_type{m._tree->keyComp()};
 
   for (MultisetConstIterator start = m.begin(); start != m.end(); start++) {
     Key value = *start;
@@ -209,109 +282,148 @@ multiset<Key>::multiset(const multiset &m) {
   }
 }
 
-template <typename Key>
-multiset<Key>::multiset(std::initializer_list<value_type> const &items)
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+multiset<Key, Compare, Allocator, Ranked>::multiset(
+    std::initializer_list<value_type> const &items)
     : multiset() {
   for (auto i = items.begin(); i < items.end(); i++) {
     insert(*i);
   }
 }
 
-template <typename Key>
-multiset<Key>::multiset(multiset &&m) noexcept {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+multiset<Key, Compare, Allocator, Ranked>::multiset(multiset &&m) noexcept {
   _tree = m._tree;
   _size = m._size;
 
   m._tree = nullptr;
 }
 
-template <typename Key>
-multiset<Key>::~multiset() {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+multiset<Key, Compare, Allocator, Ranked>::~multiset() {
   if (_tree != nullptr) {
     delete _tree;
   }
 }
 
-template <typename Key>
-multiset<Key> &multiset<Key>::operator=(const multiset &other) {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+multiset<Key, Compare, Allocator, Ranked> &
+multiset<Key, Compare, Allocator, Ranked>::operator=(const multiset &other) {
   if (this == &other) return *this;
-  multiset<Key> temp_set(other);
+  multiset<Key, Compare, Allocator, Ranked> temp_set(other);
   delete _tree;
   this->_tree = temp_set._tree;
+  _size = temp_set._size;
   temp_set._tree = nullptr;
   return *this;
 }
 
-template <typename Key>
-multiset<Key> &multiset<Key>::operator=(multiset &&other) noexcept {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+multiset<Key, Compare, Allocator, Ranked> &
+multiset<Key, Compare, Allocator, Ranked>::operator=(
+    multiset &&other) noexcept {
   if (this == &other) return *this;
   delete _tree;
   _tree = other._tree;
+  _size = other._size;
   other._tree = nullptr;
   return *this;
 }
 
-template <typename Key>
-bool multiset<Key>::empty() const noexcept {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+bool multiset<Key, Compare, Allocator, Ranked>::empty() const noexcept {
   return _size == 0;
 }
 
-template <typename Key>
-typename multiset<Key>::size_type multiset<Key>::size() const noexcept {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::size_type
+multiset<Key, Compare, Allocator, Ranked>::size() const noexcept {
   return _size;
 }
 
-template <typename Key>
-typename multiset<Key>::size_type multiset<Key>::max_size() const noexcept {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::size_type
+multiset<Key, Compare, Allocator, Ranked>::max_size() const noexcept {
   return _tree->max_size();
 }
 
-template <typename Key>
-typename multiset<Key>::iterator multiset<Key>::begin() noexcept {
-  return multiset::iterator(_tree, _tree->minNode());
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::key_compare
+multiset<Key, Compare, Allocator, Ranked>::key_comp() const {
+  return _tree->keyComp();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::allocator_type
+multiset<Key, Compare, Allocator, Ranked>::get_allocator() const {
+  return _tree->getAllocator();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::iterator
+multiset<Key, Compare, Allocator, Ranked>::begin() noexcept {
+  return multiset::iterator(_tree, _tree->beginNode());
 }
 
-template <typename Key>
-typename multiset<Key>::const_iterator multiset<Key>::begin() const noexcept {
-  multiset::const_iterator iterator(_tree, _tree->minNode());
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::const_iterator
+multiset<Key, Compare, Allocator, Ranked>::begin() const noexcept {
+  multiset::const_iterator iterator(_tree, _tree->beginNode());
   return iterator;
 }
 
-template <typename Key>
-typename multiset<Key>::const_iterator multiset<Key>::cbegin() const noexcept {
-  multiset::const_iterator iterator(_tree, _tree->minNode());
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::const_iterator
+multiset<Key, Compare, Allocator, Ranked>::cbegin() const noexcept {
+  multiset::const_iterator iterator(_tree, _tree->beginNode());
   return iterator;
 }
 
-template <typename Key>
-typename multiset<Key>::iterator multiset<Key>::end() noexcept {
-  return multiset::iterator(_tree, _tree->nextNode(_tree->maxNode()));
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::iterator
+multiset<Key, Compare, Allocator, Ranked>::end() noexcept {
+  return multiset::iterator(_tree, _tree->endNode());
 }
 
-template <typename Key>
-typename multiset<Key>::const_iterator multiset<Key>::end() const noexcept {
-  return multiset::const_iterator(_tree, _tree->nextNode(_tree->maxNode()));
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::const_iterator
+multiset<Key, Compare, Allocator, Ranked>::end() const noexcept {
+  return multiset::const_iterator(_tree, _tree->endNode());
 }
 
-template <typename Key>
-typename multiset<Key>::const_iterator multiset<Key>::cend() const noexcept {
-  return multiset::const_iterator(_tree, _tree->nextNode(_tree->maxNode()));
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::const_iterator
+multiset<Key, Compare, Allocator, Ranked>::cend() const noexcept {
+  return multiset::const_iterator(_tree, _tree->endNode());
 }
 
-template <typename Key>
-void multiset<Key>::clear() noexcept {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+void multiset<Key, Compare, Allocator, Ranked>::clear() noexcept {
   _tree->clear();
   _size = 0;
 }
 
-template <typename Key>
-std::pair<typename multiset<Key>::iterator, bool> multiset<Key>::insert(
+/**
+ * Like clear(), but the elements are destroyed on the background reclaimer
+ * thread, so the call returns in constant time. Only with std::allocator:
+ * other allocators may not be used from that thread, and clear() runs.
+ */
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+void multiset<Key, Compare, Allocator, Ranked>::clear_async() {
+  _tree->clearAsync();
+  _size = 0;
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+std::pair<typename multiset<Key, Compare, Allocator, Ranked>::iterator, bool>
+multiset<Key, Compare, Allocator, Ranked>::insert(
     const multiset::value_type &value) {
   rbnode<Key, size_t> *found_node = _tree->findNode(value);
   rbnode<Key, size_t> *result_node;
   bool inserted;
   if (found_node != nullptr) {
     found_node->value.second += 1;
+    _tree->reweigh(found_node);
     result_node = found_node;
     inserted = false;
   } else {
@@ -325,28 +437,41 @@ std::pair<typename multiset<Key>::iterator, bool> multiset<Key>::insert(
   return std::pair<iterator, bool>(result_node_iterator, inserted);
 }
 
-template <typename Key>
-void multiset<Key>::erase(multiset<Key>::iterator pos) {
-  erase(*pos);
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+void multiset<Key, Compare, Allocator, Ranked>::erase(
+    multiset<Key, Compare, Allocator, Ranked>::iterator pos) {
+  eraseOne(pos._node);
 }
 
-template <typename Key>
-void multiset<Key>::erase(Key key) {
-  auto found_node = _tree->findNode(key);
-  if (found_node == nullptr) {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+void multiset<Key, Compare, Allocator, Ranked>::erase(const Key &key) {
+  eraseOne(_tree->findNode(key));
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename K2, typename>
+void multiset<Key, Compare, Allocator, Ranked>::erase(const K2 &key) {
+  eraseOne(_tree->findNode(key));
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+void multiset<Key, Compare, Allocator, Ranked>::eraseOne(
+    rbnode<Key, size_t> *node) {
+  if (node == nullptr) {
     return;
   }
-  if (found_node->value.second > 1) {
-    found_node->value.second -= 1;
+  if (node->value.second > 1) {
+    node->value.second -= 1;
+    _tree->reweigh(node);
   } else {
-    _tree->del(key);
+    _tree->delNode(node);
   }
   _size--;
 }
 
-template <typename Key>
-void multiset<Key>::swap(multiset &other) {
-  RBTree<Key, size_t> *temp_tree = this->_tree;
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+void multiset<Key, Compare, Allocator, Ranked>::swap(multiset &other) {
+  tree_type *temp_tree = this->_tree;
   size_t temp_size = this->_size;
   this->_size = other._size;
   other._size = temp_size;
@@ -354,91 +479,260 @@ void multiset<Key>::swap(multiset &other) {
   other._tree = temp_tree;
 }
 
-template <typename Key>
-void multiset<Key>::merge(multiset &other) {
-  std::vector<Key> moved_values;
-  for (MultisetIterator start = other.begin(); start != other.end(); start++) {
-    if (!contains(*start)) {
-      insert(*start);
-      moved_values.push_back(*start);
-    }
-  }
-  for (auto start : moved_values) {
-    other.erase(other.find(start));
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+void multiset<Key, Compare, Allocator, Ranked>::merge(multiset &other) {
+  if (&other == this) {
+    return;
   }
+  // Like set::merge, keys that are already present stay in other.
+  size_type kept = 0;
+  _tree->mergeNodes(*other._tree, [&kept](rbnode<Key, size_t> *,
+                                          rbnode<Key, size_t> *node) {
+    kept += node->value.second;
+    return false;
+  });
+  _size += other._size - kept;
+  other._size = kept;
 }
 
-template <typename Key>
-typename multiset<Key>::size_type multiset<Key>::count(const Key &key) {
-  auto found_node = _tree->findNode(key);
-  if (found_node != nullptr) {
-    return found_node->value.second;
+/**
+ * Takes the element at pos out of the multiset. A node stores every copy of
+ * its key, so when there are others left a one-copy node is allocated for
+ * the handle.
+ */
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::node_type
+multiset<Key, Compare, Allocator, Ranked>::extract(iterator pos) {
+  rbnode<Key, size_t> *node = pos._node;
+  node_type handle;
+  if (node->value.second > 1) {
+    handle = _tree->makeNode(node->value.first, size_t{1});
+    node->value.second -= 1;
+    _tree->reweigh(node);
   } else {
-    return 0;
+    handle = _tree->extract(node);
   }
+  _size--;
+  return handle;
 }
 
-template <typename Key>
-bool multiset<Key>::contains(const Key &key) {
-  auto node = _tree->findNode(key);
-  if (node == nullptr) {
-    return false;
-  }
-  return true;
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::node_type
+multiset<Key, Compare, Allocator, Ranked>::extract(const Key &key) {
+  rbnode<Key, size_t> *node = _tree->findNode(key);
+  return node != nullptr ? extract(nodeIterator(node)) : node_type();
 }
 
-template <typename Key>
-std::pair<typename multiset<Key>::iterator, typename multiset<Key>::iterator>
-multiset<Key>::equal_range(const Key &key) {
-  multiset<Key>::iterator start_iter = find(key);
-  multiset<Key>::iterator end_iter = find(key);
-  size_t key_count = count(key);
-  for (size_t i = 0; i < key_count - 1; i++) {
-    end_iter++;
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::iterator
+multiset<Key, Compare, Allocator, Ranked>::insert(node_type &&node) {
+  if (node.empty()) {
+    return end();
+  }
+  size_t count = node.mapped();
+  auto result = _tree->insertNode(std::move(node));
+  if (!result.second) {
+    result.first->value.second += count;
+    _tree->reweigh(result.first);
+    node = node_type();
   }
-  return std::pair<multiset<Key>::iterator, multiset<Key>::iterator>(start_iter,
-                                                                     end_iter);
+  _size += count;
+  return nodeIterator(result.first);
 }
 
-template <typename Key>
-typename multiset<Key>::iterator multiset<Key>::lower_bound(const Key &key) {
-  auto found_node = _tree->findLowerBoundNode(key);
-  if (found_node == nullptr) {
-    return end();
-  }
-  return multiset<Key>::iterator(_tree, found_node);
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::size_type
+multiset<Key, Compare, Allocator, Ranked>::count(const Key &key) const {
+  auto found_node = _tree->findNode(key);
+  return found_node != nullptr ? found_node->value.second : 0;
 }
 
-template <typename Key>
-typename multiset<Key>::iterator multiset<Key>::upper_bound(const Key &key) {
-  auto found_node = _tree->findLowerBoundNode(key);
-  if (found_node == nullptr) {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename K2, typename>
+typename multiset<Key, Compare, Allocator, Ranked>::size_type
+multiset<Key, Compare, Allocator, Ranked>::count(const K2 &key) const {
+  auto found_node = _tree->findNode(key);
+  return found_node != nullptr ? found_node->value.second : 0;
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+bool multiset<Key, Compare, Allocator, Ranked>::contains(const Key &key) const {
+  return _tree->contains(key);
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename K2, typename>
+bool multiset<Key, Compare, Allocator, Ranked>::contains(const K2 &key) const {
+  return _tree->contains(key);
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+std::pair<typename multiset<Key, Compare, Allocator, Ranked>::iterator,
+          typename multiset<Key, Compare, Allocator, Ranked>::iterator>
+multiset<Key, Compare, Allocator, Ranked>::equal_range(const Key &key) {
+  return nodeRange(_tree->findNode(key));
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename K2, typename>
+std::pair<typename multiset<Key, Compare, Allocator, Ranked>::iterator,
+          typename multiset<Key, Compare, Allocator, Ranked>::iterator>
+multiset<Key, Compare, Allocator, Ranked>::equal_range(const K2 &key) {
+  return nodeRange(_tree->findNode(key));
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::iterator
+multiset<Key, Compare, Allocator, Ranked>::lower_bound(const Key &key) {
+  return nodeIterator(_tree->findLowerBoundNode(key));
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename K2, typename>
+typename multiset<Key, Compare, Allocator, Ranked>::iterator
+multiset<Key, Compare, Allocator, Ranked>::lower_bound(const K2 &key) {
+  return nodeIterator(_tree->findLowerBoundNode(key));
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::iterator
+multiset<Key, Compare, Allocator, Ranked>::upper_bound(const Key &key) {
+  return nodeIterator(_tree->findUpperBoundNode(key));
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename K2, typename>
+typename multiset<Key, Compare, Allocator, Ranked>::iterator
+multiset<Key, Compare, Allocator, Ranked>::upper_bound(const K2 &key) {
+  return nodeIterator(_tree->findUpperBoundNode(key));
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::iterator
+multiset<Key, Compare, Allocator, Ranked>::find(const Key &key) {
+  return nodeIterator(_tree->findNode(key));
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename K2, typename>
+typename multiset<Key, Compare, Allocator, Ranked>::iterator
+multiset<Key, Compare, Allocator, Ranked>::find(const K2 &key) {
+  return nodeIterator(_tree->findNode(key));
+}
+
+/**
+ * The element at position k in sorted order, counting every copy of a key;
+ * end() when k >= size(). O(log n).
+ */
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::iterator
+multiset<Key, Compare, Allocator, Ranked>::nth(size_type k) {
+  size_t offset;
+  rbnode<Key, size_t> *node = _tree->selectNode(k, offset);
+  return nodeIterator(node, offset);
+}
+
+/** The number of elements less than key, copies included. O(log n). */
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::size_type
+multiset<Key, Compare, Allocator, Ranked>::rank(const Key &key) const {
+  return _tree->rankOf(key);
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename K2, typename>
+typename multiset<Key, Compare, Allocator, Ranked>::size_type
+multiset<Key, Compare, Allocator, Ranked>::rank(const K2 &key) const {
+  return _tree->rankOf(key);
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename multiset<Key, Compare, Allocator, Ranked>::iterator
+multiset<Key, Compare, Allocator, Ranked>::nodeIterator(
+    rbnode<Key, size_t> *node, size_t pos) {
+  if (node == nullptr) {
     return end();
-  } else {
-    if (key == found_node->value.first) {
-      return multiset<Key>::iterator(_tree, _tree->nextNode(found_node));
-    } else {
-      return multiset<Key>::iterator(_tree, found_node);
-    }
   }
+  iterator result(_tree, node);
+  result._pos = pos;
+  return result;
 }
 
-template <typename Key>
-typename multiset<Key>::iterator multiset<Key>::find(const Key &key) {
-  return multiset<Key>::iterator(_tree, _tree->findNode(key));
+/**
+ * The range spans the copies of a single node, from the first one to the
+ * last one inclusive; (end(), end()) when the key is missing.
+ */
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+std::pair<typename multiset<Key, Compare, Allocator, Ranked>::iterator,
+          typename multiset<Key, Compare, Allocator, Ranked>::iterator>
+multiset<Key, Compare, Allocator, Ranked>::nodeRange(
+    rbnode<Key, size_t> *node) {
+  if (node == nullptr) {
+    return std::pair<iterator, iterator>(end(), end());
+  }
+  return std::pair<iterator, iterator>(
+      nodeIterator(node), nodeIterator(node, node->value.second - 1));
 }
 
-template <typename Key>
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
 template <class... Args>
-vector<std::pair<typename multiset<Key>::iterator, bool>>
-multiset<Key>::insert_many(Args &&...args) {
-  vector<std::pair<iterator, bool>> res{};
+insert_many_result<
+    typename multiset<Key, Compare, Allocator, Ranked>::iterator>
+multiset<Key, Compare, Allocator, Ranked>::insert_many(Args &&...args) {
+  insert_many_result<iterator> res;
   for (const auto &arg : {args...}) {
     res.push_back(insert(arg));
   }
   return res;
 }
 
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename ForwardIt>
+multiset<Key, Compare, Allocator, Ranked>
+multiset<Key, Compare, Allocator, Ranked>::from_sorted(ForwardIt first,
+                                                       ForwardIt last) {
+  multiset result;
+  result.assign_sorted(first, last);
+  return result;
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename ForwardIt>
+void multiset<Key, Compare, Allocator, Ranked>::assign_sorted(ForwardIt first,
+                                                              ForwardIt last) {
+  // [first, last) must be sorted; every run of equal keys becomes one node
+  // holding the length of the run.
+  const Compare &comp = _tree->keyComp();
+  auto next_run = [last, &comp](ForwardIt &it) {
+    ForwardIt run = it;
+    size_t run_length = 1;
+    while (++it != last && !comp(*run, *it)) {
+      run_length++;
+    }
+    return std::pair<ForwardIt, size_t>(run, run_length);
+  };
+  size_type count = 0;
+  size_type total = 0;
+  for (ForwardIt it = first; it != last; count++) {
+    total += next_run(it).second;
+  }
+  _tree->assignSorted(count, [&]() {
+    auto run = next_run(first);
+    return std::pair<const Key, size_t>(*run.first, run.second);
+  });
+  _size = total;
+}
+
+/** multiset with nth() and rank(). */
+template <typename Key, typename Compare = std::less<>>
+using ranked_multiset = multiset<Key, Compare, std::allocator<Key>, true>;
+
+namespace pmr {
+template <typename Key, typename Compare = std::less<>>
+using multiset =
+    ps::multiset<Key, Compare, std::pmr::polymorphic_allocator<Key>>;
+}  // namespace pmr
+
 }  // namespace ps
 
 #endif
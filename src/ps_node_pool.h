@@ -0,0 +1,317 @@
+#ifndef CONTAINERS_SRC_PS_NODE_POOL_H_
+#define CONTAINERS_SRC_PS_NODE_POOL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ps {
+
+template <typename Pool>
+class pool_group;
+
+/**
+ * node_pool - hands out raw storage for fixed-size nodes.
+ *
+ * Storage is carved out of slabs obtained from Allocator; each slab is twice
+ * the size of the previous one, up to kMaxSlabSlots. Freed nodes go to a free
+ * list and are reused before the current slab is touched again. reserve()
+ * makes room for a known number of nodes with a single slab. release()
+ * returns every slab to Allocator at once, without visiting single nodes.
+ *
+ * The pool only manages memory: constructing and destroying the Node objects
+ * is up to the caller. It counts its users, the containers and node handles
+ * that allocate from or free into it, for pool_group.
+ */
+template <typename Node, typename Allocator = std::allocator<Node>>
+class node_pool {
+  friend class pool_group<node_pool>;
+
+  union slot {
+    slot *next;
+    struct {
+      slot *next;
+      size_t size;
+    } slab;
+    alignas(Node) unsigned char storage[sizeof(Node)];
+  };
+
+  using slot_allocator =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<slot>;
+  using slot_traits = std::allocator_traits<slot_allocator>;
+
+  static constexpr size_t kMinSlabSlots = 16;
+  static constexpr size_t kMaxSlabSlots = 4096;
+
+  slot_allocator allocator_;
+  slot *slabs_ = nullptr;
+  slot *free_list_ = nullptr;
+  slot *cursor_ = nullptr;
+  slot *cursor_end_ = nullptr;
+  size_t next_slab_slots_ = kMinSlabSlots;
+  size_t users_ = 1;
+
+  void grow(size_t slots);
+
+ public:
+  using allocator_type = Allocator;
+
+  node_pool() = default;
+  explicit node_pool(const Allocator &allocator) : allocator_(allocator) {}
+  node_pool(const node_pool &) = delete;
+  node_pool &operator=(const node_pool &) = delete;
+  ~node_pool() { release(); }
+
+  Allocator get_allocator() const { return Allocator(allocator_); }
+
+  Node *allocate();
+  void deallocate(Node *node) noexcept;
+  void reserve(size_t count);
+  void release() noexcept;
+
+  void attach() noexcept { users_++; }
+  void detach() noexcept { users_--; }
+};
+
+template <typename Node, typename Allocator>
+void node_pool<Node, Allocator>::grow(size_t slots) {
+  // The first slot of every slab links it to the previous one.
+  slot *slab = slot_traits::allocate(allocator_, slots);
+  slab->slab.next = slabs_;
+  slab->slab.size = slots;
+  slabs_ = slab;
+  cursor_ = slab + 1;
+  cursor_end_ = slab + slots;
+}
+
+template <typename Node, typename Allocator>
+Node *node_pool<Node, Allocator>::allocate() {
+  slot *result;
+  if (free_list_ != nullptr) {
+    result = free_list_;
+    free_list_ = free_list_->next;
+  } else {
+    if (cursor_ == cursor_end_) {
+      grow(next_slab_slots_);
+      if (next_slab_slots_ < kMaxSlabSlots) {
+        next_slab_slots_ *= 2;
+      }
+    }
+    result = cursor_++;
+  }
+  return reinterpret_cast<Node *>(result->storage);
+}
+
+template <typename Node, typename Allocator>
+void node_pool<Node, Allocator>::deallocate(Node *node) noexcept {
+  slot *freed = reinterpret_cast<slot *>(node);
+  freed->next = free_list_;
+  free_list_ = freed;
+}
+
+template <typename Node, typename Allocator>
+void node_pool<Node, Allocator>::reserve(size_t count) {
+  size_t available = static_cast<size_t>(cursor_end_ - cursor_);
+  if (available < count) {
+    grow(count + 1);
+  }
+}
+
+template <typename Node, typename Allocator>
+void node_pool<Node, Allocator>::release() noexcept {
+  while (slabs_ != nullptr) {
+    slot *next = slabs_->slab.next;
+    slot_traits::deallocate(allocator_, slabs_, slabs_->slab.size);
+    slabs_ = next;
+  }
+  free_list_ = nullptr;
+  cursor_ = nullptr;
+  cursor_end_ = nullptr;
+  next_slab_slots_ = kMinSlabSlots;
+}
+
+/**
+ * pool_group - owns the pools of containers that have exchanged nodes.
+ *
+ * Once a node carved from one pool is relinked into another container, the
+ * memory of both pools has to live as long as either container does. Every
+ * container keeps allocating from and freeing into its own Pool only; the
+ * group just keeps all of them alive together. Merging two groups moves the
+ * pools of one into the other and leaves a forwarding link behind, so
+ * holders of the old group still keep the merged one alive.
+ *
+ * A pool whose container is gone stays in the group as long as nodes carved
+ * from it are linked somewhere. trim() finds pools without users whose
+ * slots all sit on free lists again and releases them, so that a container
+ * that keeps merging in other containers holds memory for its live nodes
+ * only.
+ *
+ * Nothing here is synchronized. Containers that have exchanged nodes share
+ * a group, and with it pools_, merged_into_ and each other's free lists,
+ * so they have to be used from one thread at a time, as if they were a
+ * single container. The one exception is the reclaimer thread: it only
+ * drops its reference to a group, and the reference count is atomic.
+ */
+template <typename Pool>
+class pool_group {
+  std::vector<std::unique_ptr<Pool>> pools_;
+  std::shared_ptr<pool_group> merged_into_;
+  // trim() only sweeps once the group has twice as many pools as after the
+  // previous sweep, which keeps its cost proportional to the merges.
+  size_t trim_at_ = 2;
+
+  void release_unused(Pool *keep);
+
+ public:
+  template <typename... Args>
+  Pool *add(Args &&...args) {
+    pools_.push_back(std::make_unique<Pool>(std::forward<Args>(args)...));
+    return pools_.back().get();
+  }
+
+  /** The group that currently owns the pools of group. */
+  static std::shared_ptr<pool_group> root(std::shared_ptr<pool_group> group) {
+    while (group->merged_into_ != nullptr) {
+      group = group->merged_into_;
+    }
+    return group;
+  }
+
+  /** True when nothing but the caller's reference keeps group alive. */
+  static bool exclusive(const std::shared_ptr<pool_group> &group) {
+    return group->merged_into_ == nullptr && group.use_count() == 1;
+  }
+
+  /** Moves the pools of other into into and makes other forward to it. */
+  static void merge(const std::shared_ptr<pool_group> &into,
+                    const std::shared_ptr<pool_group> &other) {
+    if (into == other) {
+      return;
+    }
+    for (auto &pool : other->pools_) {
+      into->pools_.push_back(std::move(pool));
+    }
+    other->pools_.clear();
+    other->merged_into_ = into;
+  }
+
+  /**
+   * Releases the pools that nobody uses and that have no live nodes left,
+   * once enough pools have been merged in since the last time. keep has to
+   * be a pool of the group with a user.
+   */
+  void trim(Pool *keep) {
+    if (pools_.size() >= trim_at_) {
+      release_unused(keep);
+      trim_at_ = 2 * pools_.size();
+    }
+  }
+
+  /** Frees every pool except keep, which is only released. */
+  void release_all_but(Pool *keep) noexcept {
+    for (auto &pool : pools_) {
+      if (pool.get() == keep) {
+        pool->release();
+        std::swap(pool, pools_.front());
+      }
+    }
+    pools_.resize(1);
+  }
+};
+
+/**
+ * A pool without users is unused once every slot it has carved is on a
+ * free list, its own or that of another pool of the group. The slots of
+ * unused pools are taken off all free lists before the pools are released;
+ * foreign slots on their own free lists move over to keep.
+ */
+template <typename Pool>
+void pool_group<Pool>::release_unused(Pool *keep) {
+  using slot = typename Pool::slot;
+  struct slab_range {
+    const slot *begin;
+    const slot *end;
+    size_t pool;
+  };
+  const size_t none = pools_.size();
+  std::vector<slab_range> slabs;
+  // Slots carved from each pool that are not on a free list.
+  std::vector<size_t> in_use(pools_.size(), 0);
+  for (size_t i = 0; i < pools_.size(); i++) {
+    const Pool &pool = *pools_[i];
+    if (pool.users_ != 0) {
+      continue;
+    }
+    for (slot *slab = pool.slabs_; slab != nullptr; slab = slab->slab.next) {
+      slabs.push_back({slab + 1, slab + slab->slab.size, i});
+      in_use[i] += slab->slab.size - 1;
+    }
+    in_use[i] -= static_cast<size_t>(pool.cursor_end_ - pool.cursor_);
+  }
+  if (slabs.empty()) {
+    return;
+  }
+  std::less<const slot *> before;
+  std::sort(slabs.begin(), slabs.end(),
+            [&](const slab_range &a, const slab_range &b) {
+              return before(a.begin, b.begin);
+            });
+  auto owner = [&](const slot *s) {
+    auto next = std::upper_bound(
+        slabs.begin(), slabs.end(), s,
+        [&](const slot *p, const slab_range &r) { return before(p, r.begin); });
+    if (next == slabs.begin() || !before(s, std::prev(next)->end)) {
+      return none;
+    }
+    return std::prev(next)->pool;
+  };
+
+  for (auto &pool : pools_) {
+    for (const slot *s = pool->free_list_; s != nullptr; s = s->next) {
+      size_t i = owner(s);
+      if (i != none) {
+        in_use[i]--;
+      }
+    }
+  }
+  std::vector<bool> unused(pools_.size(), false);
+  bool any = false;
+  for (size_t i = 0; i < pools_.size(); i++) {
+    unused[i] = pools_[i]->users_ == 0 && in_use[i] == 0;
+    any = any || unused[i];
+  }
+  if (!any) {
+    return;
+  }
+
+  for (size_t i = 0; i < pools_.size(); i++) {
+    slot **link = &pools_[i]->free_list_;
+    while (*link != nullptr) {
+      slot *s = *link;
+      size_t o = owner(s);
+      if (o != none && unused[o]) {
+        *link = s->next;
+      } else if (unused[i]) {
+        *link = s->next;
+        s->next = keep->free_list_;
+        keep->free_list_ = s;
+      } else {
+        link = &s->next;
+      }
+    }
+  }
+  size_t kept = 0;
+  for (size_t i = 0; i < pools_.size(); i++) {
+    if (!unused[i]) {
+      std::swap(pools_[kept++], pools_[i]);
+    }
+  }
+  pools_.resize(kept);
+}
+
+}  // namespace ps
+
+#endif  // CONTAINERS_SRC_PS_NODE_POOL_H_
@@ -0,0 +1,34 @@
+#ifndef CONTAINERS_SRC_PS_NODE_TRAITS_H_
+#define CONTAINERS_SRC_PS_NODE_TRAITS_H_
+
+#include <utility>
+
+namespace ps {
+
+/**
+ * node_traits - what an element of RBTree<K, V> or HashTable<K, V> is and
+ * how its key is read out of it. Elements are std::pair<const K, V>; with
+ * V = void they are just the key, so that sets do not store every key
+ * twice.
+ */
+template <typename K, typename V>
+struct node_traits {
+  using value_type = std::pair<const K, V>;
+  template <typename Pair>
+  static const auto &key(const Pair &value) {
+    return value.first;
+  }
+};
+
+template <typename K>
+struct node_traits<K, void> {
+  using value_type = K;
+  template <typename Key2>
+  static const Key2 &key(const Key2 &value) {
+    return value;
+  }
+};
+
+}  // namespace ps
+
+#endif  // CONTAINERS_SRC_PS_NODE_TRAITS_H_
@@ -0,0 +1,179 @@
+#ifndef CONTAINERS_SRC_PS_POOL_ALLOCATOR_H_
+#define CONTAINERS_SRC_PS_POOL_ALLOCATOR_H_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ps {
+
+/**
+ * pool_arena - fixed-size blocks of up to kMaxBlock bytes, one free list
+ * per size class.
+ *
+ * Sizes are rounded up to kGranule, and every class carves its blocks out
+ * of chunks from operator new that, as in node_pool, double in size from
+ * kMinChunkBlocks up to kMaxChunkBlocks blocks. A freed block goes to the
+ * free list of its class and is handed out again before the chunk is
+ * touched. Chunks are only returned when the arena is destroyed.
+ *
+ * An arena is not synchronized: everything that allocates from it has to
+ * be used from one thread at a time.
+ */
+class pool_arena {
+ public:
+  static constexpr size_t kGranule = sizeof(void *);
+  static constexpr size_t kMaxBlock = 256;
+
+  pool_arena() = default;
+  pool_arena(const pool_arena &) = delete;
+  pool_arena &operator=(const pool_arena &) = delete;
+  ~pool_arena() { release(); }
+
+  /** bytes has to be in [1, kMaxBlock]. */
+  void *allocate(size_t bytes) {
+    size_class &sc = classes_[(bytes - 1) / kGranule];
+    if (sc.free_list != nullptr) {
+      block *result = sc.free_list;
+      sc.free_list = result->next;
+      return result;
+    }
+    if (sc.cursor == sc.end) {
+      refill(sc, (bytes - 1) / kGranule + 1);
+    }
+    void *result = sc.cursor;
+    sc.cursor += ((bytes - 1) / kGranule + 1) * kGranule;
+    return result;
+  }
+
+  void deallocate(void *ptr, size_t bytes) noexcept {
+    size_class &sc = classes_[(bytes - 1) / kGranule];
+    block *freed = static_cast<block *>(ptr);
+    freed->next = sc.free_list;
+    sc.free_list = freed;
+  }
+
+ private:
+  static constexpr size_t kMinChunkBlocks = 16;
+  static constexpr size_t kMaxChunkBlocks = 4096;
+
+  struct block {
+    block *next;
+  };
+
+  // Heads every chunk; padded so that the blocks after it are aligned for
+  // any fundamental type.
+  struct alignas(std::max_align_t) chunk {
+    chunk *next;
+    size_t bytes;
+  };
+
+  struct size_class {
+    block *free_list = nullptr;
+    unsigned char *cursor = nullptr;
+    unsigned char *end = nullptr;
+    size_t next_chunk_blocks = kMinChunkBlocks;
+  };
+
+  size_class classes_[kMaxBlock / kGranule];
+  chunk *chunks_ = nullptr;
+
+  [[gnu::noinline]] void refill(size_class &sc, size_t granules) {
+    size_t bytes = sizeof(chunk) + sc.next_chunk_blocks * granules * kGranule;
+    chunk *fresh = static_cast<chunk *>(::operator new(bytes));
+    fresh->next = chunks_;
+    fresh->bytes = bytes;
+    chunks_ = fresh;
+    sc.cursor = reinterpret_cast<unsigned char *>(fresh + 1);
+    sc.end = reinterpret_cast<unsigned char *>(fresh) + bytes;
+    if (sc.next_chunk_blocks < kMaxChunkBlocks) {
+      sc.next_chunk_blocks *= 2;
+    }
+  }
+
+  void release() noexcept {
+    while (chunks_ != nullptr) {
+      chunk *next = chunks_->next;
+      ::operator delete(chunks_, chunks_->bytes);
+      chunks_ = next;
+    }
+  }
+};
+
+/**
+ * pool_allocator - serves single nodes from a shared pool_arena instead of
+ * making one malloc per node.
+ *
+ * A default-constructed allocator creates a fresh arena. Copies, including
+ * copies rebound to another type, share it, compare equal and can free
+ * each other's memory; the arena lives until the last of them is gone. A
+ * list therefore allocates its nodes from its own arena. Lists built on one
+ * allocator splice and merge by relinking nodes, lists on different arenas
+ * move the elements over. Moving and swapping containers take the
+ * allocator along.
+ *
+ * Arrays, objects larger than kMaxBlock bytes and over-aligned types go
+ * to std::allocator. The tree containers already pool their nodes in slabs,
+ * see node_pool, and only get those slabs from here.
+ */
+template <typename T>
+class pool_allocator {
+  template <typename U>
+  friend class pool_allocator;
+
+  static constexpr bool kPooled =
+      sizeof(T) <= pool_arena::kMaxBlock &&
+      alignof(T) <= alignof(std::max_align_t);
+
+  std::shared_ptr<pool_arena> arena_;
+
+ public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  pool_allocator() : arena_(std::make_shared<pool_arena>()) {}
+  explicit pool_allocator(std::shared_ptr<pool_arena> arena)
+      : arena_(std::move(arena)) {}
+  // Declared so that a "move" copies: a moved-from allocator still has to
+  // free what it allocated.
+  pool_allocator(const pool_allocator &) noexcept = default;
+  pool_allocator &operator=(const pool_allocator &) noexcept = default;
+  template <typename U>
+  pool_allocator(const pool_allocator<U> &other) noexcept
+      : arena_(other.arena_) {}
+
+  const std::shared_ptr<pool_arena> &arena() const noexcept { return arena_; }
+
+  T *allocate(size_t n) {
+    if (kPooled && n == 1) {
+      return static_cast<T *>(arena_->allocate(sizeof(T)));
+    }
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T *ptr, size_t n) noexcept {
+    if (kPooled && n == 1) {
+      arena_->deallocate(ptr, sizeof(T));
+    } else {
+      std::allocator<T>().deallocate(ptr, n);
+    }
+  }
+
+  template <typename U>
+  bool operator==(const pool_allocator<U> &other) const noexcept {
+    return arena_ == other.arena_;
+  }
+
+  template <typename U>
+  bool operator!=(const pool_allocator<U> &other) const noexcept {
+    return arena_ != other.arena_;
+  }
+};
+
+}  // namespace ps
+
+#endif  // CONTAINERS_SRC_PS_POOL_ALLOCATOR_H_
@@ -38,6 +38,11 @@ class queue {
  private:
   Container deque_;
 };
+
+namespace pmr {
+template <class T>
+using queue = ps::queue<T, ps::pmr::deque<T>>;
+}  // namespace pmr
 }  // namespace ps
 
 template <class T, class Container>
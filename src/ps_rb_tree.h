@@ -1,8 +1,17 @@
 #ifndef CONTAINERS_SRC_PS_RB_TREE_H_
 #define CONTAINERS_SRC_PS_RB_TREE_H_
 
+#include <functional>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 
+#include "ps_node_pool.h"
+#include "ps_node_traits.h"
+#include "ps_reclaimer.h"
+
 namespace ps {
 
 enum Color {
@@ -10,33 +19,162 @@ enum Color {
   BLACK,
 };
 
+/**
+ * is_transparent - true when Compare can order keys against other types
+ * (it declares Compare::is_transparent, like std::less<>). Containers only
+ * offer heterogeneous lookup overloads for such comparators.
+ */
+template <typename Compare, typename = void>
+struct is_transparent : std::false_type {};
+
+template <typename Compare>
+struct is_transparent<Compare, std::void_t<typename Compare::is_transparent>>
+    : std::true_type {};
+
+template <typename Compare, typename Key2>
+using transparent_key_t =
+    std::enable_if_t<is_transparent<Compare>::value, Key2>;
+
 template <typename K, typename V>
 struct rbnode {
-  std::pair<const K, V> value;
+  typename node_traits<K, V>::value_type value;
   struct rbnode *left = nullptr;
   struct rbnode *right = nullptr;
   struct rbnode *parent = nullptr;
   Color color = RED;
 };
 
+/**
+ * weighted_rbnode - node of a tree with order statistics. subtree_weight is
+ * the sum of the weights of all values in the subtree rooted at the node.
+ */
 template <typename K, typename V>
+struct weighted_rbnode : rbnode<K, V> {
+  size_t subtree_weight = 0;
+};
+
+/**
+ * Weight policies for RBTree. no_weight keeps plain nodes and disables
+ * order statistics; unit_weight counts every value once; mapped_weight
+ * counts a value as many times as its mapped number says, which is how
+ * multiset stores repeated keys.
+ */
+struct no_weight {};
+
+struct unit_weight {
+  template <typename Pair>
+  size_t operator()(const Pair &) const {
+    return 1;
+  }
+};
+
+struct mapped_weight {
+  template <typename Pair>
+  size_t operator()(const Pair &value) const {
+    return static_cast<size_t>(value.second);
+  }
+};
+
+/**
+ * has_three_way_compare - true when Compare also provides
+ * compare(a, b) returning a negative, zero or positive value, in the spirit
+ * of operator<=>. The tree then needs a single call per level to tell
+ * "less", "equal" and "greater" apart and can stop as soon as the key is
+ * found.
+ */
+template <typename Compare, typename A, typename B, typename = void>
+struct has_three_way_compare : std::false_type {};
+
+template <typename Compare, typename A, typename B>
+struct has_three_way_compare<
+    Compare, A, B,
+    std::void_t<decltype(std::declval<const Compare &>().compare(
+        std::declval<const A &>(), std::declval<const B &>()))>>
+    : std::true_type {};
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+class node_handle;
+
+/**
+ * With a Weigh policy other than no_weight every node also stores the total
+ * weight of its subtree, which makes selectNode() and rankOf() O(log n).
+ * The weights are kept up to date by linkNode, unlinkNode and the
+ * rotations; whoever changes what Weigh returns for a linked value has to
+ * call reweigh() on its node.
+ */
+template <typename K, typename V, typename Compare = std::less<>,
+          typename Allocator =
+              std::allocator<typename node_traits<K, V>::value_type>,
+          typename Weigh = no_weight>
 class RBTree {
+  friend node_handle<K, V, Compare, Allocator, Weigh>;
+  static constexpr bool kWeighted = !std::is_same_v<Weigh, no_weight>;
+  using node_t =
+      std::conditional_t<kWeighted, weighted_rbnode<K, V>, rbnode<K, V>>;
+  using pool_type = node_pool<node_t, Allocator>;
+  using traits = node_traits<K, V>;
+  using pool_group_type = pool_group<pool_type>;
+
   struct rbnode<K, V> *_root = nullptr;
   struct rbnode<K, V> *_sentinelNode = nullptr;
   struct rbnode<K, V> *_endNode = nullptr;
   struct rbnode<K, V> *_startNode = nullptr;
+  struct rbnode<K, V> *_leftmost = nullptr;
+  struct rbnode<K, V> *_rightmost = nullptr;
   size_t _size = 0;
+  // Nodes are allocated from and freed into _pool. _pools also holds the
+  // pools of trees this one has taken nodes from, see pool_group.
+  std::shared_ptr<pool_group_type> _pools;
+  pool_type *_pool;
+  Compare _comp;
 
+  template <typename... Args>
+  rbnode<K, V> *createNode(Args &&...args);
+  template <typename Key2, typename... Args>
+  rbnode<K, V> *createNodeWithKey(Key2 &&key, Args &&...args);
+  static const K &keyOf(const rbnode<K, V> *x);
+  void destroyNode(rbnode<K, V> *x);
+  static rbnode<K, V> *createSentinel();
+  static void destroyValue(rbnode<K, V> *x);
+  size_t subtreeWeight(const rbnode<K, V> *x) const;
+  void pullWeight(rbnode<K, V> *x);
   void insertFixUp(rbnode<K, V> *z);
   void rotateRight(rbnode<K, V> *x);
   void rotateLeft(rbnode<K, V> *x);
   void transplant(rbnode<K, V> *u, rbnode<K, V> *v);
   void delFixUp(rbnode<K, V> *x);
-  void clearNodeRecursive(rbnode<K, V> *x);
+  static void destroySubtree(rbnode<K, V> *x, const rbnode<K, V> *nil,
+                             pool_type *pool);
+  void unlinkNode(rbnode<K, V> *z);
+  void adoptPools(const std::shared_ptr<pool_group_type> &pools);
+  template <typename Key2>
+  rbnode<K, V> *findInsertPos(const Key2 &key, rbnode<K, V> *&parent,
+                              bool &left) const;
+  template <typename Key2>
+  rbnode<K, V> *findHintPos(const rbnode<K, V> *hint, const Key2 &key,
+                            rbnode<K, V> *&parent, bool &left) const;
+  void linkNode(rbnode<K, V> *node, rbnode<K, V> *parent, bool left);
+  template <typename Generator>
+  rbnode<K, V> *buildSortedSubtree(rbnode<K, V> *parent, size_t count,
+                                   size_t depth, size_t red_depth,
+                                   Generator &next);
 
  public:
-  rbnode<K, V> *findNode(K value);
-  rbnode<K, V> *findLowerBoundNode(K value);
+  using value_type = typename node_traits<K, V>::value_type;
+  using key_compare = Compare;
+  using allocator_type = Allocator;
+  using node_type = node_handle<K, V, Compare, Allocator, Weigh>;
+
+  template <typename Key2>
+  rbnode<K, V> *findNode(const Key2 &value) const;
+  template <typename Key2>
+  rbnode<K, V> *findLowerBoundNode(const Key2 &value) const;
+  template <typename Key2>
+  rbnode<K, V> *findUpperBoundNode(const Key2 &value) const;
+  template <typename Key2>
+  rbnode<K, V> *findLowerBoundFrom(const rbnode<K, V> *finger,
+                                   const Key2 &value) const;
 
   rbnode<K, V> *minNode() const;
   rbnode<K, V> *maxNode() const;
@@ -44,74 +182,545 @@ class RBTree {
   rbnode<K, V> *maxNode(rbnode<K, V> *x) const;
   rbnode<K, V> *nextNode(const rbnode<K, V> *x) const;
   rbnode<K, V> *prevNode(const rbnode<K, V> *x) const;
+  rbnode<K, V> *beginNode() const;
+  rbnode<K, V> *endNode() const;
   size_t size();
   size_t max_size();
+  const Compare &keyComp() const;
+  Allocator getAllocator() const;
 
   RBTree();
+  explicit RBTree(const Compare &comp,
+                  const Allocator &allocator = Allocator());
   ~RBTree();
-  rbnode<K, V> *insert(std::pair<const K, V> &value);
-  std::pair<const K, V> &find(K value);
-  bool contains(K value);
-  void del(K key);
+  rbnode<K, V> *insert(const value_type &value);
+  rbnode<K, V> *insert(value_type &&value);
+  template <typename Pair>
+  std::pair<rbnode<K, V> *, bool> insertUnique(Pair &&value);
+  template <typename... Args>
+  std::pair<rbnode<K, V> *, bool> emplace(Args &&...args);
+  template <typename Key2, typename... Args>
+  std::pair<rbnode<K, V> *, bool> tryEmplace(Key2 &&key, Args &&...args);
+  template <typename Pair>
+  std::pair<rbnode<K, V> *, bool> insertHint(const rbnode<K, V> *hint,
+                                             Pair &&value);
+  template <typename... Args>
+  std::pair<rbnode<K, V> *, bool> emplaceHint(const rbnode<K, V> *hint,
+                                              Args &&...args);
+  template <typename Key2, typename... Args>
+  std::pair<rbnode<K, V> *, bool> tryEmplaceHint(const rbnode<K, V> *hint,
+                                                 Key2 &&key, Args &&...args);
+  template <typename Key2>
+  value_type &find(const Key2 &value);
+  template <typename Key2>
+  bool contains(const Key2 &value) const;
+  template <typename Key2>
+  void del(const Key2 &key);
+  void delNode(rbnode<K, V> *z);
   void clear();
+  void clearAsync();
+
+  node_type extract(rbnode<K, V> *z);
+  template <typename... Args>
+  node_type makeNode(Args &&...args);
+  std::pair<rbnode<K, V> *, bool> insertNode(node_type &&handle);
+  template <typename OnDuplicate>
+  void mergeNodes(RBTree &other, OnDuplicate onDuplicate);
+
+  template <typename Generator>
+  void assignSorted(size_t count, Generator next);
+
+  void reweigh(rbnode<K, V> *x);
+  size_t totalWeight() const;
+  rbnode<K, V> *selectNode(size_t k, size_t &offset) const;
+  template <typename Key2>
+  size_t rankOf(const Key2 &key) const;
 };
 
-template <typename K, typename V>
-RBTree<K, V>::RBTree() {
-  _endNode = new rbnode<K, V>{};
-  _startNode = new rbnode<K, V>{};
-  _sentinelNode = new rbnode<K, V>{};
-  _sentinelNode->color = BLACK;
-  _sentinelNode->parent = _sentinelNode;
-  _sentinelNode->left = _sentinelNode;
-  _sentinelNode->right = _sentinelNode;
+/**
+ * node_handle - owns a node that has been taken out of a tree, together with
+ * its value. It can be inserted into any tree of the same type without
+ * copying or allocating; if it is dropped instead, the node is destroyed.
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+class node_handle {
+  using tree_type = RBTree<K, V, Compare, Allocator, Weigh>;
+  friend tree_type;
+  using pool_type = typename tree_type::pool_type;
+
+  rbnode<K, V> *_node = nullptr;
+  pool_type *_pool = nullptr;
+  std::shared_ptr<pool_group<pool_type>> _pools;
+
+  node_handle(rbnode<K, V> *node, pool_type *pool,
+              std::shared_ptr<pool_group<pool_type>> pools)
+      : _node(node), _pool(pool), _pools(std::move(pools)) {
+    _pool->attach();
+  }
+
+  void reset() noexcept {
+    if (_node != nullptr) {
+      tree_type::destroyValue(_node);
+      _pool->deallocate(static_cast<typename tree_type::node_t *>(_node));
+      _node = nullptr;
+    }
+    release();
+  }
+
+  /** Lets go of the pools once the node is gone. */
+  void release() noexcept {
+    if (_pool != nullptr) {
+      _pool->detach();
+      _pool = nullptr;
+    }
+    _pools.reset();
+  }
+
+ public:
+  node_handle() = default;
+  node_handle(node_handle &&other) noexcept
+      : _node(other._node),
+        _pool(other._pool),
+        _pools(std::move(other._pools)) {
+    other._node = nullptr;
+    other._pool = nullptr;
+  }
+  node_handle &operator=(node_handle &&other) noexcept {
+    if (this != &other) {
+      reset();
+      _node = other._node;
+      _pool = other._pool;
+      _pools = std::move(other._pools);
+      other._node = nullptr;
+      other._pool = nullptr;
+    }
+    return *this;
+  }
+  ~node_handle() { reset(); }
+
+  bool empty() const noexcept { return _node == nullptr; }
+  explicit operator bool() const noexcept { return _node != nullptr; }
+
+  const K &key() const { return tree_type::keyOf(_node); }
+  auto &mapped() const { return _node->value.second; }
+  const K &value() const { return tree_type::keyOf(_node); }
+};
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+RBTree<K, V, Compare, Allocator, Weigh>::RBTree() : RBTree(Compare()) {}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+RBTree<K, V, Compare, Allocator, Weigh>::RBTree(const Compare &comp,
+                                                const Allocator &allocator)
+    : _pools(std::make_shared<pool_group_type>()),
+      _pool(_pools->add(allocator)),
+      _comp(comp) {
+  _endNode = new node_t{};
+  _startNode = new node_t{};
+  _sentinelNode = createSentinel();
   _root = _sentinelNode;
+  _leftmost = _sentinelNode;
+  _rightmost = _sentinelNode;
 }
 
-template <typename K, typename V>
-RBTree<K, V>::~RBTree() {
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+RBTree<K, V, Compare, Allocator, Weigh>::~RBTree() {
   clear();
-  delete _sentinelNode;
-  delete _startNode;
-  delete _endNode;
+  _pool->detach();
+  delete static_cast<node_t *>(_sentinelNode);
+  delete static_cast<node_t *>(_startNode);
+  delete static_cast<node_t *>(_endNode);
 }
 
-template <typename K, typename V>
-rbnode<K, V> *ps::RBTree<K, V>::insert(std::pair<const K, V> &value) {
-  struct rbnode<K, V> *parent = _sentinelNode;
-  struct rbnode<K, V> *tree = _root;
-
-  while (tree != _sentinelNode) {
-    parent = tree;
-    if (value.first < tree->value.first) {
-      tree = tree->left;
-    } else if (value.first > tree->value.first) {
-      tree = tree->right;
+/**
+ * Builds the stored pair directly inside the node from args, so moved-in
+ * or piecewise-constructed values are never copied.
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename... Args>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::createNode(
+    Args &&...args) {
+  node_t *node = _pool->allocate();
+  try {
+    if constexpr (kWeighted) {
+      new (node) node_t{{value_type(std::forward<Args>(args)...)}};
     } else {
+      new (node) node_t{value_type(std::forward<Args>(args)...)};
+    }
+  } catch (...) {
+    _pool->deallocate(node);
+    throw;
+  }
+  return node;
+}
+
+/**
+ * A node holding key, with the mapped value built from args; a key-only
+ * node takes no args.
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Key2, typename... Args>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::createNodeWithKey(
+    Key2 &&key, Args &&...args) {
+  if constexpr (std::is_void_v<V>) {
+    static_assert(sizeof...(Args) == 0, "key-only nodes have no mapped value");
+    return createNode(std::forward<Key2>(key));
+  } else {
+    return createNode(std::piecewise_construct,
+                      std::forward_as_tuple(std::forward<Key2>(key)),
+                      std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+const K &RBTree<K, V, Compare, Allocator, Weigh>::keyOf(
+    const rbnode<K, V> *x) {
+  return traits::key(x->value);
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::destroyNode(rbnode<K, V> *x) {
+  destroyValue(x);
+  _pool->deallocate(static_cast<node_t *>(x));
+}
+
+/** The nil node: black, linked to itself, of weight 0. */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::createSentinel() {
+  rbnode<K, V> *sentinel = new node_t{};
+  sentinel->color = BLACK;
+  sentinel->parent = sentinel;
+  sentinel->left = sentinel;
+  sentinel->right = sentinel;
+  return sentinel;
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::destroyValue(rbnode<K, V> *x) {
+  static_cast<node_t *>(x)->~node_t();
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+size_t RBTree<K, V, Compare, Allocator, Weigh>::subtreeWeight(
+    const rbnode<K, V> *x) const {
+  if constexpr (kWeighted) {
+    return x == _sentinelNode ? 0
+                              : static_cast<const node_t *>(x)->subtree_weight;
+  } else {
+    return 0;
+  }
+}
+
+/** Recomputes the subtree weight of x from its own value and children. */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::pullWeight(rbnode<K, V> *x) {
+  if constexpr (kWeighted) {
+    static_cast<node_t *>(x)->subtree_weight =
+        Weigh()(x->value) + subtreeWeight(x->left) + subtreeWeight(x->right);
+  }
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::insert(
+    const value_type &value) {
+  auto result = insertUnique(value);
+  return result.second ? result.first : nullptr;
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::insert(
+    value_type &&value) {
+  auto result = insertUnique(std::move(value));
+  return result.second ? result.first : nullptr;
+}
+
+/**
+ * Inserts value unless its key is already present. Returns the node holding
+ * the key and whether it was inserted; value is left untouched on a
+ * duplicate.
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Pair>
+std::pair<rbnode<K, V> *, bool>
+RBTree<K, V, Compare, Allocator, Weigh>::insertUnique(Pair &&value) {
+  rbnode<K, V> *parent;
+  bool left;
+  if (auto found = findInsertPos(traits::key(value), parent, left)) {
+    return {found, false};
+  }
+  auto *node = createNode(std::forward<Pair>(value));
+  linkNode(node, parent, left);
+  return {node, true};
+}
+
+/**
+ * Constructs the pair from args first, as the key is only known afterwards,
+ * then links it in with a single descent. On a duplicate the new node is
+ * dropped.
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename... Args>
+std::pair<rbnode<K, V> *, bool>
+RBTree<K, V, Compare, Allocator, Weigh>::emplace(Args &&...args) {
+  auto *node = createNode(std::forward<Args>(args)...);
+  rbnode<K, V> *parent;
+  bool left;
+  rbnode<K, V> *found;
+  try {
+    found = findInsertPos(keyOf(node), parent, left);
+  } catch (...) {
+    destroyNode(node);
+    throw;
+  }
+  if (found != nullptr) {
+    destroyNode(node);
+    return {found, false};
+  }
+  linkNode(node, parent, left);
+  return {node, true};
+}
+
+/**
+ * Like emplace, but looks the key up first: when it is already present
+ * neither key nor args are touched and no node is created. Otherwise the
+ * value is constructed in place from args (value-initialized when empty).
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Key2, typename... Args>
+std::pair<rbnode<K, V> *, bool>
+RBTree<K, V, Compare, Allocator, Weigh>::tryEmplace(Key2 &&key,
+                                                    Args &&...args) {
+  rbnode<K, V> *parent;
+  bool left;
+  if (auto found = findInsertPos(key, parent, left)) {
+    return {found, false};
+  }
+  auto *node = createNodeWithKey(std::forward<Key2>(key),
+                                 std::forward<Args>(args)...);
+  linkNode(node, parent, left);
+  return {node, true};
+}
+
+/**
+ * insertUnique and emplace with a position hint, see findHintPos. hint may
+ * be any node of this tree, endNode() or nullptr.
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Pair>
+std::pair<rbnode<K, V> *, bool>
+RBTree<K, V, Compare, Allocator, Weigh>::insertHint(const rbnode<K, V> *hint,
+                                                    Pair &&value) {
+  rbnode<K, V> *parent;
+  bool left;
+  if (auto found = findHintPos(hint, traits::key(value), parent, left)) {
+    return {found, false};
+  }
+  auto *node = createNode(std::forward<Pair>(value));
+  linkNode(node, parent, left);
+  return {node, true};
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename... Args>
+std::pair<rbnode<K, V> *, bool>
+RBTree<K, V, Compare, Allocator, Weigh>::emplaceHint(const rbnode<K, V> *hint,
+                                                     Args &&...args) {
+  auto *node = createNode(std::forward<Args>(args)...);
+  rbnode<K, V> *parent;
+  bool left;
+  rbnode<K, V> *found;
+  try {
+    found = findHintPos(hint, keyOf(node), parent, left);
+  } catch (...) {
+    destroyNode(node);
+    throw;
+  }
+  if (found != nullptr) {
+    destroyNode(node);
+    return {found, false};
+  }
+  linkNode(node, parent, left);
+  return {node, true};
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Key2, typename... Args>
+std::pair<rbnode<K, V> *, bool>
+RBTree<K, V, Compare, Allocator, Weigh>::tryEmplaceHint(
+    const rbnode<K, V> *hint, Key2 &&key, Args &&...args) {
+  rbnode<K, V> *parent;
+  bool left;
+  if (auto found = findHintPos(hint, key, parent, left)) {
+    return {found, false};
+  }
+  auto *node = createNodeWithKey(std::forward<Key2>(key),
+                                 std::forward<Args>(args)...);
+  linkNode(node, parent, left);
+  return {node, true};
+}
+
+/**
+ * Finds where key belongs. Returns the node that already holds an
+ * equivalent key, or nullptr and sets parent/left to the leaf slot for a
+ * new node.
+ *
+ * Without a three-way comparator the descent asks a single "key < node"
+ * question per level and settles equality once at the bottom, against the
+ * in-order predecessor of the slot.
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Key2>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::findInsertPos(
+    const Key2 &key, rbnode<K, V> *&parent, bool &left) const {
+  rbnode<K, V> *tree = _root;
+  parent = _sentinelNode;
+  left = true;
+  if constexpr (has_three_way_compare<Compare, Key2, K>::value) {
+    while (tree != _sentinelNode) {
+      auto order = _comp.compare(key, keyOf(tree));
+      if (order == 0) {
+        return tree;
+      }
+      parent = tree;
+      left = order < 0;
+      tree = left ? tree->left : tree->right;
+    }
+    return nullptr;
+  } else {
+    while (tree != _sentinelNode) {
+      parent = tree;
+      left = _comp(key, keyOf(tree));
+      tree = left ? tree->left : tree->right;
+    }
+    rbnode<K, V> *predecessor = parent;
+    if (left) {
+      if (parent == _sentinelNode || parent == _leftmost) {
+        return nullptr;
+      }
+      predecessor = prevNode(parent);
+    }
+    return _comp(keyOf(predecessor), key) ? nullptr : predecessor;
+  }
+}
+
+/**
+ * Same contract as findInsertPos, but first tries the slots right next to
+ * hint: when key sorts between hint and one of its neighbours no descent is
+ * needed. Stepping to a neighbour is amortized O(1), so inserting keys in
+ * order with the previous position as hint costs O(1) per key on average.
+ * Falls back to a full descent when the hint does not fit.
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Key2>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::findHintPos(
+    const rbnode<K, V> *hint, const Key2 &key, rbnode<K, V> *&parent,
+    bool &left) const {
+  if (_size == 0 || hint == nullptr || hint == _startNode) {
+    return findInsertPos(key, parent, left);
+  }
+  if (hint == _endNode) {
+    if (_comp(keyOf(_rightmost), key)) {
+      parent = _rightmost;
+      left = false;
+      return nullptr;
+    }
+    return findInsertPos(key, parent, left);
+  }
+
+  auto *position = const_cast<rbnode<K, V> *>(hint);
+  if (_comp(key, keyOf(position))) {
+    // key goes before hint.
+    if (position == _leftmost) {
+      parent = position;
+      left = true;
+      return nullptr;
+    }
+    rbnode<K, V> *before = prevNode(position);
+    if (_comp(keyOf(before), key)) {
+      if (before->right == _sentinelNode) {
+        parent = before;
+        left = false;
+      } else {
+        parent = position;
+        left = true;
+      }
       return nullptr;
     }
+  } else if (_comp(keyOf(position), key)) {
+    // key goes after hint.
+    if (position == _rightmost) {
+      parent = position;
+      left = false;
+      return nullptr;
+    }
+    rbnode<K, V> *after = nextNode(position);
+    if (_comp(key, keyOf(after))) {
+      if (position->right == _sentinelNode) {
+        parent = position;
+        left = false;
+      } else {
+        parent = after;
+        left = true;
+      }
+      return nullptr;
+    }
+  } else {
+    return position;
   }
-  auto *node = new rbnode<K, V>{value};
+  return findInsertPos(key, parent, left);
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::linkNode(rbnode<K, V> *node,
+                                                       rbnode<K, V> *parent,
+                                                       bool left) {
   node->parent = parent;
   node->left = _sentinelNode;
   node->right = _sentinelNode;
 
   if (parent == _sentinelNode) {
     _root = node;
-  } else if (value.first < parent->value.first) {
+    _leftmost = node;
+    _rightmost = node;
+  } else if (left) {
     parent->left = node;
+    if (parent == _leftmost) _leftmost = node;
   } else {
     parent->right = node;
+    if (parent == _rightmost) _rightmost = node;
   }
   _size++;
   node->color = RED;
+  reweigh(node);
   insertFixUp(node);
-
-  return node;
 }
 
-template <typename K, typename V>
-void RBTree<K, V>::insertFixUp(rbnode<K, V> *z) {
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::insertFixUp(rbnode<K, V> *z) {
   while (z->parent != nullptr && z->parent->parent != nullptr &&
          z->parent->color == RED) {
     rbnode<K, V> *u;
@@ -152,101 +761,204 @@ void RBTree<K, V>::insertFixUp(rbnode<K, V> *z) {
   _root->color = BLACK;
 }
 
-template <typename K, typename V>
-void RBTree<K, V>::rotateLeft(rbnode<K, V> *x) {
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::rotateLeft(rbnode<K, V> *x) {
   rbnode<K, V> *y = x->right;
   x->right = y->left;
   if (y->left != _sentinelNode) {
     y->left->parent = x;
   }
   y->parent = x->parent;
-  if (x == x->parent->left) {
+  if (x->parent == _sentinelNode) {
+    _root = y;
+  } else if (x == x->parent->left) {
     x->parent->left = y;
   } else {
     x->parent->right = y;
   }
-  if (x == _root) {
-    _root = y;
-  }
   y->left = x;
   x->parent = y;
+  pullWeight(x);
+  pullWeight(y);
 }
 
-template <typename K, typename V>
-void RBTree<K, V>::rotateRight(rbnode<K, V> *x) {
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::rotateRight(rbnode<K, V> *x) {
   rbnode<K, V> *y = x->left;
   x->left = y->right;
   if (y->right != _sentinelNode) {
     y->right->parent = x;
   }
   y->parent = x->parent;
-  if (x == x->parent->left) {
+  if (x->parent == _sentinelNode) {
+    _root = y;
+  } else if (x == x->parent->left) {
     x->parent->left = y;
   } else {
     x->parent->right = y;
   }
-  if (x == _root) {
-    _root = y;
-  }
   y->right = x;
   x->parent = y;
+  pullWeight(x);
+  pullWeight(y);
 }
 
-template <typename K, typename V>
-std::pair<const K, V> &ps::RBTree<K, V>::find(const K value) {
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Key2>
+typename RBTree<K, V, Compare, Allocator, Weigh>::value_type &
+RBTree<K, V, Compare, Allocator, Weigh>::find(
+    const Key2 &value) {
   auto node = findNode(value);
 
   return node->value;
 }
 
-template <typename K, typename V>
-bool ps::RBTree<K, V>::contains(const K value) {
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Key2>
+bool RBTree<K, V, Compare, Allocator, Weigh>::contains(
+    const Key2 &value) const {
   auto node = findNode(value);
 
   return node != nullptr;
 }
 
-template <typename K, typename V>
-rbnode<K, V> *ps::RBTree<K, V>::findNode(const K value) {
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Key2>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::findNode(
+    const Key2 &value) const {
+  if constexpr (has_three_way_compare<Compare, Key2, K>::value) {
+    auto tree = _root;
+    while (tree != _sentinelNode) {
+      auto order = _comp.compare(value, keyOf(tree));
+      if (order < 0) {
+        tree = tree->left;
+      } else if (order > 0) {
+        tree = tree->right;
+      } else {
+        return tree;
+      }
+    }
+    return nullptr;
+  } else {
+    auto node = findLowerBoundNode(value);
+    if (node == nullptr || _comp(value, keyOf(node))) {
+      return nullptr;
+    }
+    return node;
+  }
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Key2>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::findLowerBoundNode(
+    const Key2 &value) const {
   auto tree = _root;
+  rbnode<K, V> *response_node = nullptr;
   while (tree != _sentinelNode) {
-    if (value < tree->value.first) {
-      tree = tree->left;
-    } else if (value > tree->value.first) {
+    if (_comp(keyOf(tree), value)) {
       tree = tree->right;
     } else {
-      return tree;
+      response_node = tree;
+      tree = tree->left;
     }
   }
-  return nullptr;
+  return response_node;
 }
 
-template <typename K, typename V>
-rbnode<K, V> *RBTree<K, V>::findLowerBoundNode(K value) {
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Key2>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::findUpperBoundNode(
+    const Key2 &value) const {
   auto tree = _root;
   rbnode<K, V> *response_node = nullptr;
   while (tree != _sentinelNode) {
-    if (value <= tree->value.first) response_node = tree;
-    if (value < tree->value.first) {
+    if (_comp(value, keyOf(tree))) {
+      response_node = tree;
       tree = tree->left;
-    } else if (value > tree->value.first) {
+    } else {
+      tree = tree->right;
+    }
+  }
+  return response_node;
+}
+
+/**
+ * findLowerBoundNode for a key that is known to sort after every node
+ * before finger, e.g. when looking up ascending keys one after another.
+ * The search climbs from finger only as far as needed and descends again,
+ * so it costs O(log d) for a result d positions away instead of O(log n).
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Key2>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::findLowerBoundFrom(
+    const rbnode<K, V> *finger, const Key2 &value) const {
+  if (!_comp(keyOf(finger), value)) {
+    return const_cast<rbnode<K, V> *>(finger);
+  }
+  // Every node up to x sorts before value. Climb until x is the left child
+  // of a node that does not; the result is then that node or in between.
+  const rbnode<K, V> *x = finger;
+  rbnode<K, V> *response_node = nullptr;
+  while (x->parent != _sentinelNode) {
+    rbnode<K, V> *parent = x->parent;
+    if (x == parent->left && !_comp(keyOf(parent), value)) {
+      response_node = parent;
+      break;
+    }
+    x = parent;
+  }
+  rbnode<K, V> *tree = x->right;
+  while (tree != _sentinelNode) {
+    if (_comp(keyOf(tree), value)) {
       tree = tree->right;
     } else {
-      return tree;
+      response_node = tree;
+      tree = tree->left;
     }
   }
   return response_node;
 }
 
-template <typename K, typename V>
-void RBTree<K, V>::del(K key) {
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Key2>
+void RBTree<K, V, Compare, Allocator, Weigh>::del(const Key2 &key) {
   rbnode<K, V> *z = findNode(key);
-  if (z == nullptr) {
-    return;
+  if (z != nullptr) {
+    delNode(z);
+  }
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::delNode(rbnode<K, V> *z) {
+  unlinkNode(z);
+  destroyNode(z);
+}
+
+/** Takes z out of the tree and rebalances; z itself is left untouched. */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::unlinkNode(rbnode<K, V> *z) {
+  if (z == _leftmost) {
+    _leftmost = z->right != _sentinelNode ? minNode(z->right) : z->parent;
+  }
+  if (z == _rightmost) {
+    _rightmost = z->left != _sentinelNode ? maxNode(z->left) : z->parent;
   }
 
   rbnode<K, V> *y = z;
   rbnode<K, V> *x;
+  // Lowest node whose subtree lost a value.
+  rbnode<K, V> *lightened = z->parent;
   Color y_color = y->color;
   if (z->left == _sentinelNode) {
     x = z->right;
@@ -260,7 +972,9 @@ void RBTree<K, V>::del(K key) {
     x = y->right;
     if (y->parent == z) {
       x->parent = y;
+      lightened = y;
     } else {
+      lightened = y->parent;
       transplant(y, y->right);
       y->right = z->right;
       y->right->parent = y;
@@ -270,40 +984,285 @@ void RBTree<K, V>::del(K key) {
     y->left->parent = y;
     y->color = z->color;
   }
+  reweigh(lightened);
   if (y_color == BLACK) {
     delFixUp(x);
   }
   _size--;
-  delete z;
 }
 
-template <typename K, typename V>
-void RBTree<K, V>::clearNodeRecursive(rbnode<K, V> *x) {
-  if (x->left != _sentinelNode) {
-    clearNodeRecursive(x->left);
+/**
+ * Makes every pool of pools live as long as this tree, so that nodes taken
+ * over from their owner stay valid. Pools merged in earlier whose nodes
+ * have all been freed since are released, see pool_group::trim.
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::adoptPools(
+    const std::shared_ptr<pool_group_type> &pools) {
+  _pools = pool_group_type::root(_pools);
+  pool_group_type::merge(_pools, pool_group_type::root(pools));
+  _pools->trim(_pool);
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+typename RBTree<K, V, Compare, Allocator, Weigh>::node_type
+RBTree<K, V, Compare, Allocator, Weigh>::extract(rbnode<K, V> *z) {
+  unlinkNode(z);
+  return node_type(z, _pool, _pools);
+}
+
+/** A node that is not linked into the tree yet, built from args. */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename... Args>
+typename RBTree<K, V, Compare, Allocator, Weigh>::node_type
+RBTree<K, V, Compare, Allocator, Weigh>::makeNode(Args &&...args) {
+  return node_type(createNode(std::forward<Args>(args)...), _pool, _pools);
+}
+
+/**
+ * Links the node owned by handle unless its key is already present, in
+ * which case handle keeps the node. Returns the node holding the key and
+ * whether the handle's node was inserted.
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+std::pair<rbnode<K, V> *, bool>
+RBTree<K, V, Compare, Allocator, Weigh>::insertNode(node_type &&handle) {
+  if (handle.empty()) {
+    return {_endNode, false};
   }
-  if (x->right != _sentinelNode) {
-    clearNodeRecursive(x->right);
+  rbnode<K, V> *parent;
+  bool left;
+  if (auto found = findInsertPos(handle.key(), parent, left)) {
+    return {found, false};
   }
+  adoptPools(handle._pools);
+  rbnode<K, V> *node = handle._node;
+  handle._node = nullptr;
+  handle.release();
+  linkNode(node, parent, left);
+  return {node, true};
+}
 
-  if (x == _root) {
-    _root = _sentinelNode;
+/**
+ * Moves the nodes of other into this tree by relinking them; nothing is
+ * allocated or copied. When a key is already present onDuplicate(existing,
+ * node) decides: true destroys node, false leaves it in other.
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename OnDuplicate>
+void RBTree<K, V, Compare, Allocator, Weigh>::mergeNodes(
+    RBTree &other, OnDuplicate onDuplicate) {
+  if (&other == this || other._size == 0) {
+    return;
   }
-  if (x != _sentinelNode) {
-    delete x;
+  adoptPools(other._pools);
+  // other is walked in ascending order, so the previous position is a good
+  // hint for the next key.
+  const rbnode<K, V> *hint = _endNode;
+  rbnode<K, V> *node = other.beginNode();
+  while (node != other._endNode) {
+    rbnode<K, V> *next = other.nextNode(node);
+    rbnode<K, V> *parent;
+    bool left;
+    if (auto found = findHintPos(hint, keyOf(node), parent, left)) {
+      if (onDuplicate(found, node)) {
+        other.delNode(node);
+      }
+      hint = found;
+    } else {
+      other.unlinkNode(node);
+      linkNode(node, parent, left);
+      hint = node;
+    }
+    node = next;
   }
 }
 
-template <typename K, typename V>
-void RBTree<K, V>::clear() {
-  if (_root != _sentinelNode) {
-    clearNodeRecursive(_root);
-    _size = 0;
+/**
+ * Destroys the subtree rooted at x in post-order without recursion: it
+ * descends to a leaf, destroys it, unhooks it from its parent and climbs
+ * back up. Only pointers are compared against nil, it is never written.
+ * With a pool the storage goes back to its free list, otherwise only the
+ * values are destroyed and the caller drops the storage in bulk.
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::destroySubtree(
+    rbnode<K, V> *x, const rbnode<K, V> *nil, pool_type *pool) {
+  rbnode<K, V> *const top = x;
+  while (x != nil) {
+    if (x->left != nil) {
+      x = x->left;
+    } else if (x->right != nil) {
+      x = x->right;
+    } else {
+      rbnode<K, V> *parent = nullptr;
+      if (x != top) {
+        parent = x->parent;
+        (parent->left == x ? parent->left : parent->right) =
+            const_cast<rbnode<K, V> *>(nil);
+      }
+      destroyValue(x);
+      if (pool != nullptr) {
+        pool->deallocate(static_cast<node_t *>(x));
+      }
+      if (parent == nullptr) {
+        return;
+      }
+      x = parent;
+    }
   }
 }
 
-template <typename K, typename V>
-void RBTree<K, V>::transplant(rbnode<K, V> *u, rbnode<K, V> *v) {
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::clear() {
+  _pools = pool_group_type::root(_pools);
+  if (pool_group_type::exclusive(_pools)) {
+    // No other tree or node handle can reference our pools, so node storage
+    // goes back in one piece and the tree is only walked when there are
+    // destructors to run.
+    if constexpr (!std::is_trivially_destructible_v<node_t>) {
+      if (_root != _sentinelNode) {
+        destroySubtree(_root, _sentinelNode, nullptr);
+      }
+    }
+    _pools->release_all_but(_pool);
+  } else if (_root != _sentinelNode) {
+    // Some of the storage is shared, every node goes back to the free list.
+    destroySubtree(_root, _sentinelNode, _pool);
+  }
+  _root = _sentinelNode;
+  _size = 0;
+  _leftmost = _sentinelNode;
+  _rightmost = _sentinelNode;
+}
+
+/**
+ * Empties the tree at once and leaves destroying the old nodes to the
+ * reclaimer thread. The detached nodes keep the old nil node and pools,
+ * while the tree carries on with fresh ones. If other trees still share
+ * the old pools, their storage is only released together with them.
+ *
+ * The reclaimer frees the old slabs through the allocator, which only
+ * std::allocator is known to allow from another thread; any other
+ * allocator, a pmr resource for one, gets a plain clear().
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::clearAsync() {
+  constexpr bool kThreadSafeAllocator = std::is_same_v<
+      Allocator, std::allocator<typename Allocator::value_type>>;
+  if (!kThreadSafeAllocator || _root == _sentinelNode) {
+    clear();
+    return;
+  }
+  auto sentinel = std::unique_ptr<node_t>(
+      static_cast<node_t *>(createSentinel()));
+  auto pools = std::make_shared<pool_group_type>();
+  pool_type *pool = pools->add(_pool->get_allocator());
+
+  std::function<void()> reclaim =
+      [root = _root, nil = _sentinelNode,
+       old_pools = pool_group_type::root(_pools)]() mutable {
+        if constexpr (!std::is_trivially_destructible_v<node_t>) {
+          destroySubtree(root, nil, nullptr);
+        }
+        delete static_cast<node_t *>(nil);
+        old_pools.reset();
+      };
+
+  // The job has to hold the last reference to the old pools before it is
+  // started, or their slabs could be freed under it.
+  _sentinelNode = sentinel.release();
+  _root = _sentinelNode;
+  _leftmost = _sentinelNode;
+  _rightmost = _sentinelNode;
+  _size = 0;
+  _pool->detach();
+  _pools = std::move(pools);
+  _pool = pool;
+  reclaimer::instance().submit(std::move(reclaim));
+}
+
+/**
+ * Replaces the contents of the tree with count nodes whose values are
+ * produced by next() in strictly ascending key order.
+ *
+ * The tree is built directly in balanced shape in O(n): every subtree is
+ * split around its middle element, so all nil leaves end up on the last two
+ * levels. Painting the deepest level red and everything else black then
+ * satisfies the red-black invariants without any rotations.
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Generator>
+void RBTree<K, V, Compare, Allocator, Weigh>::assignSorted(size_t count,
+                                                           Generator next) {
+  clear();
+  if (count == 0) {
+    return;
+  }
+  _pool->reserve(count);
+
+  size_t red_depth = 0;
+  for (size_t n = count; n > 1; n /= 2) {
+    red_depth++;
+  }
+  _root = buildSortedSubtree(_sentinelNode, count, 0, red_depth, next);
+  _root->color = BLACK;
+  _leftmost = minNode(_root);
+  _rightmost = maxNode(_root);
+  _size = count;
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Generator>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::buildSortedSubtree(
+    rbnode<K, V> *parent, size_t count, size_t depth, size_t red_depth,
+    Generator &next) {
+  if (count == 0) {
+    return _sentinelNode;
+  }
+  size_t left_count = (count - 1) / 2;
+  rbnode<K, V> *left = buildSortedSubtree(_sentinelNode, left_count, depth + 1,
+                                          red_depth, next);
+  rbnode<K, V> *node = nullptr;
+  try {
+    node = createNode(next());
+    node->left = left;
+    node->right = buildSortedSubtree(node, count - 1 - left_count, depth + 1,
+                                     red_depth, next);
+  } catch (...) {
+    // Subtrees that are not linked to the root yet have to be torn down
+    // here.
+    if (left != _sentinelNode) {
+      destroySubtree(left, _sentinelNode, _pool);
+    }
+    if (node != nullptr) {
+      destroyNode(node);
+    }
+    throw;
+  }
+  if (left != _sentinelNode) {
+    left->parent = node;
+  }
+  node->parent = parent;
+  node->color = depth == red_depth ? RED : BLACK;
+  pullWeight(node);
+  return node;
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::transplant(rbnode<K, V> *u,
+                                                         rbnode<K, V> *v) {
   if (u->parent == _sentinelNode) {
     _root = v;
   } else if (u == u->parent->left) {
@@ -314,8 +1273,10 @@ void RBTree<K, V>::transplant(rbnode<K, V> *u, rbnode<K, V> *v) {
   v->parent = u->parent;
 }
 
-template <typename K, typename V>
-rbnode<K, V> *RBTree<K, V>::minNode(rbnode<K, V> *x) const {
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::minNode(
+    rbnode<K, V> *x) const {
   rbnode<K, V> *node = x;
   while (node->left != _sentinelNode) {
     node = node->left;
@@ -323,13 +1284,16 @@ rbnode<K, V> *RBTree<K, V>::minNode(rbnode<K, V> *x) const {
   return node;
 }
 
-template <typename K, typename V>
-rbnode<K, V> *RBTree<K, V>::minNode() const {
-  return minNode(_root);
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::minNode() const {
+  return _leftmost;
 }
 
-template <typename K, typename V>
-rbnode<K, V> *RBTree<K, V>::maxNode(rbnode<K, V> *x) const {
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::maxNode(
+    rbnode<K, V> *x) const {
   rbnode<K, V> *node = x;
   while (node->right != _sentinelNode) {
     node = node->right;
@@ -337,73 +1301,71 @@ rbnode<K, V> *RBTree<K, V>::maxNode(rbnode<K, V> *x) const {
   return node;
 }
 
-template <typename K, typename V>
-rbnode<K, V> *RBTree<K, V>::maxNode() const {
-  return maxNode(_root);
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::maxNode() const {
+  return _rightmost;
 }
 
-template <typename K, typename V>
-rbnode<K, V> *RBTree<K, V>::nextNode(const rbnode<K, V> *x) const {
-  rbnode<K, V> *max_node = maxNode();
-
-  if (x == max_node) {
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::nextNode(
+    const rbnode<K, V> *x) const {
+  if (x == _endNode || x == _rightmost) {
     return _endNode;
   }
-
   if (x == _startNode) {
-    return minNode();
+    return beginNode();
+  }
+  if (x->right != _sentinelNode) {
+    return minNode(x->right);
   }
 
-  rbnode<K, V> *tree = _root;
-  rbnode<K, V> *successor = nullptr;
-  while (tree != _sentinelNode) {
-    if (x->value.first < tree->value.first) {
-      successor = tree;
-      tree = tree->left;
-    } else if (x->value.first > tree->value.first) {
-      tree = tree->right;
-    } else {
-      if (tree->right != _sentinelNode) {
-        return minNode(tree->right);
-      }
-      return successor;
-    }
+  rbnode<K, V> *parent = x->parent;
+  while (parent != _sentinelNode && x == parent->right) {
+    x = parent;
+    parent = parent->parent;
   }
-  return nullptr;
+  return parent == _sentinelNode ? _endNode : parent;
 }
 
-template <typename K, typename V>
-rbnode<K, V> *RBTree<K, V>::prevNode(const rbnode<K, V> *x) const {
-  rbnode<K, V> *min_node = minNode();
-
-  if (x == min_node) {
-    return min_node - 1;
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::prevNode(
+    const rbnode<K, V> *x) const {
+  if (x == _startNode || x == _leftmost) {
+    return _startNode;
   }
-
   if (x == _endNode) {
-    return maxNode();
+    return _size == 0 ? _startNode : _rightmost;
+  }
+  if (x->left != _sentinelNode) {
+    return maxNode(x->left);
   }
 
-  rbnode<K, V> *tree = _root;
-  rbnode<K, V> *predecessor = nullptr;
-  while (tree != _sentinelNode) {
-    if (x->value.first < tree->value.first) {
-      tree = tree->left;
-    } else if (x->value.first > tree->value.first) {
-      predecessor = tree;
-      tree = tree->right;
-    } else {
-      if (tree->left != _sentinelNode) {
-        return maxNode(tree->left);
-      }
-      return predecessor;
-    }
+  rbnode<K, V> *parent = x->parent;
+  while (parent != _sentinelNode && x == parent->left) {
+    x = parent;
+    parent = parent->parent;
   }
-  return nullptr;
+  return parent == _sentinelNode ? _startNode : parent;
 }
 
-template <typename K, typename V>
-void RBTree<K, V>::delFixUp(rbnode<K, V> *x) {
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::beginNode() const {
+  return _size == 0 ? _endNode : _leftmost;
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::endNode() const {
+  return _endNode;
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::delFixUp(rbnode<K, V> *x) {
   while (x != _root && x->color == BLACK) {
     if (x == x->parent->left) {
       rbnode<K, V> *w = x->parent->right;
@@ -458,14 +1420,101 @@ void RBTree<K, V>::delFixUp(rbnode<K, V> *x) {
   x->color = BLACK;
 }
 
-template <typename K, typename V>
-size_t RBTree<K, V>::size() {
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+size_t RBTree<K, V, Compare, Allocator, Weigh>::size() {
   return _size;
 }
 
-template <typename K, typename V>
-size_t RBTree<K, V>::max_size() {
-  return std::numeric_limits<size_t>::max() / sizeof(rbnode<K, V>);
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+const Compare &RBTree<K, V, Compare, Allocator, Weigh>::keyComp() const {
+  return _comp;
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+Allocator RBTree<K, V, Compare, Allocator, Weigh>::getAllocator() const {
+  return _pool->get_allocator();
+}
+
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+size_t RBTree<K, V, Compare, Allocator, Weigh>::max_size() {
+  return std::numeric_limits<size_t>::max() / sizeof(node_t);
+}
+
+/**
+ * Recomputes the subtree weights from x up to the root, after the weight
+ * of the value in x changed. O(log n).
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+void RBTree<K, V, Compare, Allocator, Weigh>::reweigh(rbnode<K, V> *x) {
+  if constexpr (kWeighted) {
+    for (; x != _sentinelNode; x = x->parent) {
+      pullWeight(x);
+    }
+  }
+}
+
+/** Sum of the weights of all values, size() for unit_weight. */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+size_t RBTree<K, V, Compare, Allocator, Weigh>::totalWeight() const {
+  static_assert(kWeighted, "order statistics need a Weigh policy");
+  return subtreeWeight(_root);
+}
+
+/**
+ * Finds the value at position k (from 0) in key order, where every value
+ * takes as many positions as its weight. offset is set to the position of
+ * k among those taken by the returned node. Returns endNode() when k is
+ * not below totalWeight().
+ */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+rbnode<K, V> *RBTree<K, V, Compare, Allocator, Weigh>::selectNode(
+    size_t k, size_t &offset) const {
+  static_assert(kWeighted, "order statistics need a Weigh policy");
+  rbnode<K, V> *x = _root;
+  while (x != _sentinelNode) {
+    size_t left = subtreeWeight(x->left);
+    if (k < left) {
+      x = x->left;
+      continue;
+    }
+    k -= left;
+    size_t own = Weigh()(x->value);
+    if (k < own) {
+      offset = k;
+      return x;
+    }
+    k -= own;
+    x = x->right;
+  }
+  offset = 0;
+  return _endNode;
+}
+
+/** Total weight of the values whose keys are less than key. */
+template <typename K, typename V, typename Compare, typename Allocator,
+          typename Weigh>
+template <typename Key2>
+size_t RBTree<K, V, Compare, Allocator, Weigh>::rankOf(
+    const Key2 &key) const {
+  static_assert(kWeighted, "order statistics need a Weigh policy");
+  size_t rank = 0;
+  rbnode<K, V> *x = _root;
+  while (x != _sentinelNode) {
+    if (_comp(keyOf(x), key)) {
+      rank += subtreeWeight(x->left) + Weigh()(x->value);
+      x = x->right;
+    } else {
+      x = x->left;
+    }
+  }
+  return rank;
 }
 
 }  // namespace ps
@@ -0,0 +1,107 @@
+#ifndef CONTAINERS_SRC_PS_RECLAIMER_H_
+#define CONTAINERS_SRC_PS_RECLAIMER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace ps {
+
+/**
+ * reclaimer - a single background thread that tears down memory handed to
+ * it, so that dropping a large container does not stall the calling thread.
+ *
+ * Jobs run one at a time in submission order. The thread is started by the
+ * first submit() and finishes every queued job before the program exits.
+ * A job that cannot be queued runs on the calling thread.
+ */
+class reclaimer {
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  std::deque<std::function<void()>> jobs_;
+  size_t running_ = 0;
+  bool stopping_ = false;
+  std::thread worker_;
+
+  reclaimer() = default;
+  void run();
+
+ public:
+  reclaimer(const reclaimer &) = delete;
+  reclaimer &operator=(const reclaimer &) = delete;
+  ~reclaimer();
+
+  static reclaimer &instance();
+
+  void submit(std::function<void()> job);
+  /** Blocks until every job submitted so far has finished. */
+  void wait_idle();
+};
+
+inline reclaimer &reclaimer::instance() {
+  static reclaimer instance;
+  return instance;
+}
+
+inline void reclaimer::submit(std::function<void()> job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    try {
+      if (!worker_.joinable()) {
+        worker_ = std::thread(&reclaimer::run, this);
+      }
+      jobs_.push_back(std::move(job));
+      wake_.notify_one();
+      return;
+    } catch (...) {
+      // No thread or no room in the queue: reclaim right here instead.
+    }
+  }
+  job();
+}
+
+inline void reclaimer::wait_idle() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this] { return jobs_.empty() && running_ == 0; });
+}
+
+inline void reclaimer::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+    if (jobs_.empty()) {
+      return;
+    }
+    std::function<void()> job = std::move(jobs_.front());
+    jobs_.pop_front();
+    running_++;
+    lock.unlock();
+    job();
+    job = nullptr;
+    lock.lock();
+    running_--;
+    if (jobs_.empty() && running_ == 0) {
+      idle_.notify_all();
+    }
+  }
+}
+
+inline reclaimer::~reclaimer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    wake_.notify_one();
+  }
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+}  // namespace ps
+
+#endif  // CONTAINERS_SRC_PS_RECLAIMER_H_
@@ -1,30 +1,43 @@
 #ifndef CONTAINERS_SRC_PS_SET_H_
 #define CONTAINERS_SRC_PS_SET_H_
 
+#include <memory_resource>
 #include <stdexcept>
 
 #include "ps_rb_tree.h"
+#include "ps_small_vector.h"
 #include "ps_vector.h"
 
 namespace ps {
 
-template <typename Key>
+struct set_algebra;
+
+/** Ranked adds nth() and rank(), as for map. */
+template <typename Key, typename Compare = std::less<>,
+          typename Allocator = std::allocator<Key>, bool Ranked = false>
 class set {
+  friend set_algebra;
+
+  using tree_type =
+      RBTree<Key, void, Compare, Allocator,
+             std::conditional_t<Ranked, unit_weight, no_weight>>;
+
   class SetIterator;
   class SetConstIterator;
 
   class SetIterator {
-    friend set<Key>;
-    using node_type = rbnode<Key, Key>;
+    friend set<Key, Compare, Allocator, Ranked>;
+    friend SetConstIterator;
+    using node_type = rbnode<Key, void>;
     node_type *_node;
-    RBTree<Key, Key> *_tree;
+    tree_type *_tree;
 
    public:
     SetIterator() {}
-    explicit SetIterator(RBTree<Key, Key> *tree, rbnode<Key, Key> *node)
+    explicit SetIterator(tree_type *tree, rbnode<Key, void> *node)
         : _node(node), _tree(tree) {}
 
-    const Key &operator*() const { return _node->value.first; }
+    const Key &operator*() const { return _node->value; }
 
     SetIterator &operator++() {
       _node = _tree->nextNode(_node);
@@ -67,18 +80,20 @@ class set {
   };
 
   class SetConstIterator {
-    friend set<Key>;
-    using node_type = rbnode<Key, Key>;
+    friend set<Key, Compare, Allocator, Ranked>;
+    using node_type = rbnode<Key, void>;
     const node_type *_node;
-    const RBTree<Key, Key> *_tree;
+    const tree_type *_tree;
 
    public:
     SetConstIterator() {}
-    explicit SetConstIterator(const RBTree<Key, Key> *tree,
-                              const rbnode<Key, Key> *node)
+    explicit SetConstIterator(const tree_type *tree,
+                              const rbnode<Key, void> *node)
         : _node(node), _tree(tree) {}
+    SetConstIterator(const SetIterator &other)
+        : _node(other._node), _tree(other._tree) {}
 
-    const Key &operator*() const { return _node->value.first; }
+    const Key &operator*() const { return _node->value; }
 
     SetConstIterator &operator++() {
       _node = _tree->nextNode(_node);
@@ -120,7 +135,7 @@ class set {
     ~SetConstIterator() { _node = nullptr; }
   };
 
-  RBTree<Key, Key> *_tree;
+  tree_type *_tree;
 
  public:
   using key_type = Key;
@@ -130,8 +145,20 @@ class set {
   using iterator = SetIterator;
   using const_iterator = SetConstIterator;
   using size_type = size_t;
+  using allocator_type = Allocator;
+  using key_compare = Compare;
+  using node_type = typename tree_type::node_type;
+
+  struct insert_return_type {
+    iterator position;
+    bool inserted;
+    node_type node;
+  };
 
   set();
+  explicit set(const Compare &comp);
+  explicit set(const Allocator &allocator);
+  set(const Compare &comp, const Allocator &allocator);
   set(const set &m);
   set(set &&m) noexcept;
   set(std::initializer_list<value_type> const &items);
@@ -143,6 +170,8 @@ class set {
   bool empty() const noexcept;
   size_type size() const noexcept;
   size_type max_size() const noexcept;
+  key_compare key_comp() const;
+  allocator_type get_allocator() const;
 
   iterator begin() noexcept;
   const_iterator begin() const noexcept;
@@ -152,27 +181,66 @@ class set {
   const_iterator cend() const noexcept;
 
   void clear() noexcept;
+  void clear_async();
   std::pair<iterator, bool> insert(const value_type &value);
+  iterator insert(const_iterator hint, const value_type &value);
+  template <typename... Args>
+  iterator emplace_hint(const_iterator hint, Args &&...args);
   void erase(iterator pos);
-  void erase(Key key);
+  void erase(const Key &key);
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  void erase(const K2 &key);
   void swap(set &other);
   void merge(set &other);
+  node_type extract(iterator pos);
+  node_type extract(const Key &key);
+  insert_return_type insert(node_type &&node);
 
-  bool contains(const Key &key);
+  bool contains(const Key &key) const;
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  bool contains(const K2 &key) const;
   iterator find(const Key &key);
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  iterator find(const K2 &key);
+  iterator nth(size_type k);
+  size_type rank(const Key &key) const;
+  template <typename K2, typename = transparent_key_t<key_compare, K2>>
+  size_type rank(const K2 &key) const;
 
   template <class... Args>
-  vector<std::pair<iterator, bool>> insert_many(Args &&...args);
+  insert_many_result<iterator> insert_many(Args &&...args);
+
+  template <typename ForwardIt>
+  static set from_sorted(ForwardIt first, ForwardIt last);
+  template <typename ForwardIt>
+  void assign_sorted(ForwardIt first, ForwardIt last);
 };
 
-template <typename Key>
-set<Key>::set() {
-  _tree = new RBTree<Key, Key>{};
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+set<Key, Compare, Allocator, Ranked>::set() {
+  _tree = new tree_type{};
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+set<Key, Compare, Allocator, Ranked>::set(const Compare &comp) {
+  _tree = new tree_type{comp};
 }
 
-template <typename Key>
-set<Key>::set(const set &m) {
-  _tree = new RBTree<Key, Key>{};
+/** Nodes come from allocator's slabs, see node_pool. */
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+set<Key, Compare, Allocator, Ranked>::set(const Allocator &allocator) {
+  _tree = new tree_type{Compare(), allocator};
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+set<Key, Compare, Allocator, Ranked>::set(const Compare &comp,
+                                          const Allocator &allocator) {
+  _tree = new tree_type{comp, allocator};
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+set<Key, Compare, Allocator, Ranked>::set(const set &m) {
+  _tree = new tree_type{m._tree->keyComp()};
 
   for (SetConstIterator start = m.begin(); start != m.end(); start++) {
     Key value = *start;
@@ -181,39 +249,42 @@ set<Key>::set(const set &m) {
   }
 }
 
-template <typename Key>
-set<Key>::set(std::initializer_list<value_type> const &items) : set() {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+set<Key, Compare, Allocator, Ranked>::set(
+    std::initializer_list<value_type> const &items) : set() {
   for (auto i = items.begin(); i < items.end(); i++) {
     insert(*i);
   }
 }
 
-template <typename Key>
-set<Key>::set(set &&m) noexcept {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+set<Key, Compare, Allocator, Ranked>::set(set &&m) noexcept {
   _tree = m._tree;
 
   m._tree = nullptr;
 }
 
-template <typename Key>
-set<Key>::~set() {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+set<Key, Compare, Allocator, Ranked>::~set() {
   if (_tree != nullptr) {
     delete _tree;
   }
 }
 
-template <typename Key>
-set<Key> &set<Key>::operator=(const set &other) {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+set<Key, Compare, Allocator, Ranked> &
+set<Key, Compare, Allocator, Ranked>::operator=(const set &other) {
   if (this == &other) return *this;
-  set<Key> temp_set(other);
+  set<Key, Compare, Allocator, Ranked> temp_set(other);
   delete _tree;
   this->_tree = temp_set._tree;
   temp_set._tree = nullptr;
   return *this;
 }
 
-template <typename Key>
-set<Key> &set<Key>::operator=(set &&other) noexcept {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+set<Key, Compare, Allocator, Ranked> &
+set<Key, Compare, Allocator, Ranked>::operator=(set &&other) noexcept {
   if (this == &other) return *this;
   delete _tree;
   _tree = other._tree;
@@ -221,133 +292,268 @@ set<Key> &set<Key>::operator=(set &&other) noexcept {
   return *this;
 }
 
-template <typename Key>
-bool set<Key>::empty() const noexcept {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+bool set<Key, Compare, Allocator, Ranked>::empty() const noexcept {
   return _tree->size() == 0;
 }
 
-template <typename Key>
-typename set<Key>::size_type set<Key>::size() const noexcept {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::size_type
+set<Key, Compare, Allocator, Ranked>::size() const noexcept {
   return _tree->size();
 }
 
-template <typename Key>
-typename set<Key>::size_type set<Key>::max_size() const noexcept {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::size_type
+set<Key, Compare, Allocator, Ranked>::max_size() const noexcept {
   return _tree->max_size();
 }
 
-template <typename Key>
-typename set<Key>::iterator set<Key>::begin() noexcept {
-  return set::iterator(_tree, _tree->minNode());
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::key_compare
+set<Key, Compare, Allocator, Ranked>::key_comp() const {
+  return _tree->keyComp();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::allocator_type
+set<Key, Compare, Allocator, Ranked>::get_allocator() const {
+  return _tree->getAllocator();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::iterator
+set<Key, Compare, Allocator, Ranked>::begin() noexcept {
+  return set::iterator(_tree, _tree->beginNode());
 }
 
-template <typename Key>
-typename set<Key>::const_iterator set<Key>::begin() const noexcept {
-  set::const_iterator iterator(_tree, _tree->minNode());
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::const_iterator
+set<Key, Compare, Allocator, Ranked>::begin() const noexcept {
+  set::const_iterator iterator(_tree, _tree->beginNode());
   return iterator;
 }
 
-template <typename Key>
-typename set<Key>::const_iterator set<Key>::cbegin() const noexcept {
-  set::const_iterator iterator(_tree, _tree->minNode());
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::const_iterator
+set<Key, Compare, Allocator, Ranked>::cbegin() const noexcept {
+  set::const_iterator iterator(_tree, _tree->beginNode());
   return iterator;
 }
 
-template <typename Key>
-typename set<Key>::iterator set<Key>::end() noexcept {
-  return set::iterator(_tree, _tree->nextNode(_tree->maxNode()));
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::iterator
+set<Key, Compare, Allocator, Ranked>::end() noexcept {
+  return set::iterator(_tree, _tree->endNode());
 }
 
-template <typename Key>
-typename set<Key>::const_iterator set<Key>::end() const noexcept {
-  return set::const_iterator(_tree, _tree->nextNode(_tree->maxNode()));
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::const_iterator
+set<Key, Compare, Allocator, Ranked>::end() const noexcept {
+  return set::const_iterator(_tree, _tree->endNode());
 }
 
-template <typename Key>
-typename set<Key>::const_iterator set<Key>::cend() const noexcept {
-  return set::const_iterator(_tree, _tree->nextNode(_tree->maxNode()));
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::const_iterator
+set<Key, Compare, Allocator, Ranked>::cend() const noexcept {
+  return set::const_iterator(_tree, _tree->endNode());
 }
 
-template <typename Key>
-void set<Key>::clear() noexcept {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+void set<Key, Compare, Allocator, Ranked>::clear() noexcept {
   _tree->clear();
 }
 
-template <typename Key>
-std::pair<typename set<Key>::iterator, bool> set<Key>::insert(
-    const set::value_type &value) {
-  rbnode<Key, Key> *found_node = _tree->findNode(value);
-  rbnode<Key, Key> *result_node;
-  bool inserted;
-  if (found_node != nullptr) {
-    result_node = found_node;
-    inserted = false;
-  } else {
-    auto value_pair = std::pair<const Key, Key>(value, value);
-    result_node = _tree->insert(value_pair);
-    inserted = true;
-  }
+/**
+ * Like clear(), but the elements are destroyed on the background reclaimer
+ * thread, so the call returns in constant time. Only with std::allocator:
+ * other allocators may not be used from that thread, and clear() runs.
+ */
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+void set<Key, Compare, Allocator, Ranked>::clear_async() {
+  _tree->clearAsync();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+std::pair<typename set<Key, Compare, Allocator, Ranked>::iterator, bool>
+set<Key, Compare, Allocator, Ranked>::insert(const set::value_type &value) {
+  auto result = _tree->tryEmplace(value);
+  return std::pair<iterator, bool>(iterator(_tree, result.first),
+                                   result.second);
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::iterator
+set<Key, Compare, Allocator, Ranked>::insert(const_iterator hint,
+                                             const value_type &value) {
+  return iterator(_tree, _tree->tryEmplaceHint(hint._node, value).first);
+}
 
-  iterator result_node_iterator(_tree, result_node);
-  return std::pair<iterator, bool>(result_node_iterator, inserted);
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename... Args>
+typename set<Key, Compare, Allocator, Ranked>::iterator
+set<Key, Compare, Allocator, Ranked>::emplace_hint(const_iterator hint,
+                                                   Args &&...args) {
+  Key key(std::forward<Args>(args)...);
+  auto result = _tree->tryEmplaceHint(hint._node, std::move(key));
+  return iterator(_tree, result.first);
 }
 
-template <typename Key>
-void set<Key>::erase(set<Key>::iterator pos) {
-  _tree->del(*pos);
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+void set<Key, Compare, Allocator, Ranked>::erase(
+    set<Key, Compare, Allocator, Ranked>::iterator pos) {
+  _tree->delNode(pos._node);
 }
 
-template <typename Key>
-void set<Key>::erase(Key key) {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+void set<Key, Compare, Allocator, Ranked>::erase(const Key &key) {
   _tree->del(key);
 }
 
-template <typename Key>
-void set<Key>::swap(set &other) {
-  RBTree<Key, Key> *temp_tree = this->_tree;
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename K2, typename>
+void set<Key, Compare, Allocator, Ranked>::erase(const K2 &key) {
+  _tree->del(key);
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+void set<Key, Compare, Allocator, Ranked>::swap(set &other) {
+  tree_type *temp_tree = this->_tree;
   this->_tree = other._tree;
   other._tree = temp_tree;
 }
 
-template <typename Key>
-void set<Key>::merge(set &other) {
-  vector<Key> moved_values;
-  for (SetIterator start = other.begin(); start != other.end(); start++) {
-    if (!contains(*start)) {
-      insert(*start);
-      moved_values.push_back(*start);
-    }
-  }
-  for (auto start : moved_values) {
-    other.erase(other.find(start));
-  }
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+void set<Key, Compare, Allocator, Ranked>::merge(set &other) {
+  _tree->mergeNodes(*other._tree, [](rbnode<Key, void> *, rbnode<Key, void> *) {
+    return false;
+  });
 }
 
-template <typename Key>
-bool set<Key>::contains(const Key &key) {
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::node_type
+set<Key, Compare, Allocator, Ranked>::extract(iterator pos) {
+  return _tree->extract(pos._node);
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::node_type
+set<Key, Compare, Allocator, Ranked>::extract(const Key &key) {
+  rbnode<Key, void> *node = _tree->findNode(key);
+  return node != nullptr ? _tree->extract(node) : node_type();
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::insert_return_type
+set<Key, Compare, Allocator, Ranked>::insert(node_type &&node) {
+  auto result = _tree->insertNode(std::move(node));
+  return insert_return_type{iterator(_tree, result.first), result.second,
+                            std::move(node)};
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+bool set<Key, Compare, Allocator, Ranked>::contains(const Key &key) const {
+  return _tree->contains(key);
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename K2, typename>
+bool set<Key, Compare, Allocator, Ranked>::contains(const K2 &key) const {
+  return _tree->contains(key);
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::iterator
+set<Key, Compare, Allocator, Ranked>::find(const Key &key) {
   auto node = _tree->findNode(key);
-  if (node == nullptr) {
-    return false;
-  }
-  return true;
+  return iterator(_tree, node != nullptr ? node : _tree->endNode());
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename K2, typename>
+typename set<Key, Compare, Allocator, Ranked>::iterator
+set<Key, Compare, Allocator, Ranked>::find(const K2 &key) {
+  auto node = _tree->findNode(key);
+  return iterator(_tree, node != nullptr ? node : _tree->endNode());
+}
+
+/** The element at position k in key order, end() when k >= size(). */
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::iterator
+set<Key, Compare, Allocator, Ranked>::nth(size_type k) {
+  size_t offset;
+  return iterator(_tree, _tree->selectNode(k, offset));
 }
 
-template <typename Key>
-typename set<Key>::iterator set<Key>::find(const Key &key) {
-  return set<Key>::iterator(_tree, _tree->findNode(key));
+/** The number of elements less than key. O(log n). */
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+typename set<Key, Compare, Allocator, Ranked>::size_type
+set<Key, Compare, Allocator, Ranked>::rank(const Key &key) const {
+  return _tree->rankOf(key);
 }
 
-template <typename Key>
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename K2, typename>
+typename set<Key, Compare, Allocator, Ranked>::size_type
+set<Key, Compare, Allocator, Ranked>::rank(const K2 &key) const {
+  return _tree->rankOf(key);
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
 template <class... Args>
-vector<std::pair<typename set<Key>::iterator, bool>> set<Key>::insert_many(
-    Args &&...args) {
-  vector<std::pair<iterator, bool>> res{};
+insert_many_result<
+    typename set<Key, Compare, Allocator, Ranked>::iterator>
+set<Key, Compare, Allocator, Ranked>::insert_many(Args &&...args) {
+  insert_many_result<iterator> res;
+  // Batches are often sorted, so each key is tried next to the previous one.
+  const rbnode<Key, void> *hint = _tree->endNode();
   for (const auto &arg : {args...}) {
-    res.push_back(insert(arg));
+    auto result = _tree->tryEmplaceHint(hint, arg);
+    hint = result.first;
+    res.push_back(std::pair<iterator, bool>(iterator(_tree, result.first),
+                                            result.second));
   }
   return res;
 }
 
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename ForwardIt>
+set<Key, Compare, Allocator, Ranked>
+set<Key, Compare, Allocator, Ranked>::from_sorted(ForwardIt first,
+                                                  ForwardIt last) {
+  set result;
+  result.assign_sorted(first, last);
+  return result;
+}
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+template <typename ForwardIt>
+void set<Key, Compare, Allocator, Ranked>::assign_sorted(ForwardIt first,
+                                                         ForwardIt last) {
+  // [first, last) must be sorted; duplicates are skipped.
+  const Compare &comp = _tree->keyComp();
+  auto next_run = [last, &comp](ForwardIt &it) {
+    ForwardIt run = it;
+    while (++it != last && !comp(*run, *it)) {
+    }
+    return run;
+  };
+  size_type count = 0;
+  for (ForwardIt it = first; it != last; next_run(it)) {
+    count++;
+  }
+  _tree->assignSorted(count, [&]() -> const Key & { return *next_run(first); });
+}
+
+/** set with nth() and rank(). */
+template <typename Key, typename Compare = std::less<>>
+using ranked_set = set<Key, Compare, std::allocator<Key>, true>;
+
+namespace pmr {
+template <typename Key, typename Compare = std::less<>>
+using set = ps::set<Key, Compare, std::pmr::polymorphic_allocator<Key>>;
+}  // namespace pmr
+
 }  // namespace ps
 
 #endif
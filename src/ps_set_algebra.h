@@ -0,0 +1,262 @@
+#ifndef CONTAINERS_SRC_PS_SET_ALGEBRA_H_
+#define CONTAINERS_SRC_PS_SET_ALGEBRA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ps_multiset.h"
+#include "ps_set.h"
+
+namespace ps {
+
+/**
+ * set_algebra - union, intersection, difference and inclusion of two sets
+ * or two multisets ordered by the same comparator.
+ *
+ * Both trees are walked side by side in key order, so the result is known
+ * after O(n + m) comparisons, and it is then built with assignSorted in
+ * O(k) without a single rotation. A node stands for some copies of its key
+ * (always one in a set); an operation is given by how many copies it keeps
+ * of a key that a holds x times and b holds y times.
+ */
+struct set_algebra {
+  /** Below this size ratio set_intersection walks both trees. */
+  static constexpr size_t kGallopRatio = 16;
+
+  template <typename Container, typename Keep>
+  static Container combine(const Container &a, const Container &b,
+                           Keep keep);
+  template <typename Container>
+  static Container intersect(const Container &a, const Container &b);
+  template <typename Container>
+  static Container intersect_galloping(const Container &a,
+                                       const Container &b);
+  template <typename Container>
+  static bool includes(const Container &a, const Container &b);
+
+ private:
+  template <typename K, typename V>
+  static const K &key_of(const rbnode<K, V> *node);
+  template <typename K, typename V>
+  static size_t copies(const rbnode<K, V> *node);
+  template <typename Container, typename K, typename V>
+  static Container build(
+      const Container &like,
+      const std::vector<std::pair<rbnode<K, V> *, size_t>> &runs);
+};
+
+template <typename K, typename V>
+const K &set_algebra::key_of(const rbnode<K, V> *node) {
+  return node_traits<K, V>::key(node->value);
+}
+
+template <typename K, typename V>
+size_t set_algebra::copies(const rbnode<K, V> *node) {
+  if constexpr (std::is_void_v<V>) {
+    return 1;
+  } else {
+    return node->value.second;
+  }
+}
+
+/** A container ordered like `like`, holding runs[i].second copies of each
+ * runs[i].first in turn. */
+template <typename Container, typename K, typename V>
+Container set_algebra::build(
+    const Container &like,
+    const std::vector<std::pair<rbnode<K, V> *, size_t>> &runs) {
+  Container result(like.key_comp(), like.get_allocator());
+  size_t next = 0;
+  if constexpr (std::is_void_v<V>) {
+    result._tree->assignSorted(runs.size(), [&]() -> const K & {
+      return key_of(runs[next++].first);
+    });
+  } else {
+    size_t total = 0;
+    result._tree->assignSorted(runs.size(), [&]() {
+      const auto &run = runs[next++];
+      total += run.second;
+      return std::pair<const K, size_t>(key_of(run.first), run.second);
+    });
+    result._size = total;
+  }
+  return result;
+}
+
+template <typename Container, typename Keep>
+Container set_algebra::combine(const Container &a, const Container &b,
+                               Keep keep) {
+  auto &tree_a = *a._tree;
+  auto &tree_b = *b._tree;
+  const auto &comp = tree_a.keyComp();
+  using node_ptr = decltype(tree_a.beginNode());
+  std::vector<std::pair<node_ptr, size_t>> runs;
+
+  node_ptr x = tree_a.beginNode();
+  node_ptr y = tree_b.beginNode();
+  while (x != tree_a.endNode() && y != tree_b.endNode()) {
+    node_ptr from = x;
+    size_t kept;
+    if (comp(key_of(x), key_of(y))) {
+      kept = keep(copies(x), size_t{0});
+      x = tree_a.nextNode(x);
+    } else if (comp(key_of(y), key_of(x))) {
+      from = y;
+      kept = keep(size_t{0}, copies(y));
+      y = tree_b.nextNode(y);
+    } else {
+      kept = keep(copies(x), copies(y));
+      x = tree_a.nextNode(x);
+      y = tree_b.nextNode(y);
+    }
+    if (kept > 0) {
+      runs.emplace_back(from, kept);
+    }
+  }
+  // Whatever is left has no counterpart. Operations that keep nothing of
+  // such keys are done here.
+  if (keep(size_t{1}, size_t{0}) > 0) {
+    for (; x != tree_a.endNode(); x = tree_a.nextNode(x)) {
+      runs.emplace_back(x, keep(copies(x), size_t{0}));
+    }
+  }
+  if (keep(size_t{0}, size_t{1}) > 0) {
+    for (; y != tree_b.endNode(); y = tree_b.nextNode(y)) {
+      runs.emplace_back(y, keep(size_t{0}, copies(y)));
+    }
+  }
+  return build(a, runs);
+}
+
+/**
+ * Gallops when one tree has kGallopRatio times as many nodes as the other.
+ * Node counts, not sizes, decide: both walks visit a multiset's copies of
+ * a key in one step.
+ */
+template <typename Container>
+Container set_algebra::intersect(const Container &a, const Container &b) {
+  size_t small = std::min(a._tree->size(), b._tree->size());
+  size_t large = std::max(a._tree->size(), b._tree->size());
+  if (small * kGallopRatio < large) {
+    return intersect_galloping(a, b);
+  }
+  return combine(a, b, [](size_t x, size_t y) { return std::min(x, y); });
+}
+
+/**
+ * Intersection that walks only the smaller container and looks its keys up
+ * in the larger one with findLowerBoundFrom, starting from the previous
+ * match. For sizes m < n that is O(m log(n / m)) instead of O(n + m).
+ */
+template <typename Container>
+Container set_algebra::intersect_galloping(const Container &a,
+                                           const Container &b) {
+  bool a_smaller = a._tree->size() <= b._tree->size();
+  auto &small = a_smaller ? *a._tree : *b._tree;
+  auto &large = a_smaller ? *b._tree : *a._tree;
+  const auto &comp = small.keyComp();
+  using node_ptr = decltype(small.beginNode());
+  std::vector<std::pair<node_ptr, size_t>> runs;
+
+  if (large.size() != 0) {
+    node_ptr finger = large.beginNode();
+    for (node_ptr x = small.beginNode(); x != small.endNode();
+         x = small.nextNode(x)) {
+      node_ptr y = large.findLowerBoundFrom(finger, key_of(x));
+      if (y == nullptr) {
+        break;
+      }
+      if (!comp(key_of(x), key_of(y))) {
+        runs.emplace_back(x, std::min(copies(x), copies(y)));
+      }
+      finger = y;
+    }
+  }
+  return build(a, runs);
+}
+
+template <typename Container>
+bool set_algebra::includes(const Container &a, const Container &b) {
+  auto &tree_a = *a._tree;
+  auto &tree_b = *b._tree;
+  const auto &comp = tree_a.keyComp();
+  auto x = tree_a.beginNode();
+  auto y = tree_b.beginNode();
+  while (y != tree_b.endNode()) {
+    if (x == tree_a.endNode() || comp(key_of(y), key_of(x))) {
+      return false;
+    }
+    if (comp(key_of(x), key_of(y))) {
+      x = tree_a.nextNode(x);
+      continue;
+    }
+    if (copies(x) < copies(y)) {
+      return false;
+    }
+    x = tree_a.nextNode(x);
+    y = tree_b.nextNode(y);
+  }
+  return true;
+}
+
+/** is_ordered_set - true for ps::set and ps::multiset. */
+template <typename Container>
+struct is_ordered_set : std::false_type {};
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+struct is_ordered_set<set<Key, Compare, Allocator, Ranked>> : std::true_type {
+};
+
+template <typename Key, typename Compare, typename Allocator, bool Ranked>
+struct is_ordered_set<multiset<Key, Compare, Allocator, Ranked>>
+    : std::true_type {};
+
+template <typename Container, typename Result = Container>
+using ordered_set_t =
+    std::enable_if_t<is_ordered_set<Container>::value, Result>;
+
+/** Keys found in a or b; a multiset keeps the larger count of each key. */
+template <typename Container>
+ordered_set_t<Container> set_union(const Container &a, const Container &b) {
+  return set_algebra::combine(
+      a, b, [](size_t x, size_t y) { return std::max(x, y); });
+}
+
+/**
+ * Keys found in both a and b; a multiset keeps the smaller count. Switches
+ * to set_intersection_galloping when one side has kGallopRatio times as
+ * many distinct keys.
+ */
+template <typename Container>
+ordered_set_t<Container> set_intersection(const Container &a,
+                                          const Container &b) {
+  return set_algebra::intersect(a, b);
+}
+
+template <typename Container>
+ordered_set_t<Container> set_intersection_galloping(const Container &a,
+                                                    const Container &b) {
+  return set_algebra::intersect_galloping(a, b);
+}
+
+/** Keys of a that are not in b; a multiset subtracts the counts. */
+template <typename Container>
+ordered_set_t<Container> set_difference(const Container &a,
+                                        const Container &b) {
+  return set_algebra::combine(
+      a, b, [](size_t x, size_t y) { return x > y ? x - y : 0; });
+}
+
+/** True when every key of b is in a, at least as many times. */
+template <typename Container>
+ordered_set_t<Container, bool> includes(const Container &a,
+                                        const Container &b) {
+  return set_algebra::includes(a, b);
+}
+
+}  // namespace ps
+
+#endif  // CONTAINERS_SRC_PS_SET_ALGEBRA_H_
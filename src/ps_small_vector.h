@@ -0,0 +1,820 @@
+#ifndef CONTAINERS_SRC_PS_SMALL_VECTOR_H_
+#define CONTAINERS_SRC_PS_SMALL_VECTOR_H_
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace ps {
+/**
+ * small_vector - a vector that keeps its first N elements in the object
+ * itself and only goes to the heap once it outgrows them. Small vectors
+ * are built and destroyed without calling malloc at all. The price is that
+ * moving one that is still inline moves its elements one by one, and that
+ * any move or swap invalidates its iterators.
+ *
+ * The heap buffer comes from Allocator, and elements are constructed and
+ * destroyed through std::allocator_traits, as in vector. When a vector is
+ * moved into one whose allocator cannot free its buffer, the elements are
+ * moved one by one instead. ps::pmr::small_vector takes its buffer from a
+ * std::pmr::memory_resource.
+ */
+template <class T, size_t N, class Allocator = std::allocator<T>>
+class small_vector {
+  static_assert(N > 0, "small_vector needs room for at least one element");
+  using alloc_traits = std::allocator_traits<Allocator>;
+  static_assert(std::is_same_v<typename alloc_traits::value_type, T>,
+                "Allocator::value_type must be T");
+  // Whether a move assignment can always take the other vector's buffer.
+  static constexpr bool kMoveTakesStorage =
+      alloc_traits::propagate_on_container_move_assignment::value ||
+      alloc_traits::is_always_equal::value;
+  // Moving as bytes skips Allocator::construct; see vector.
+  static constexpr bool kBitwiseRelocate =
+      std::is_trivially_copyable_v<T> &&
+      (std::is_same_v<Allocator, std::allocator<T>> ||
+       std::is_same_v<Allocator, std::pmr::polymorphic_allocator<T>>);
+
+ public:
+  using value_type = T;
+  using reference = T&;
+  using const_reference = const T&;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using size_type = size_t;
+  using allocator_type = Allocator;
+
+  small_vector();
+  explicit small_vector(const Allocator& allocator) noexcept;
+  explicit small_vector(size_type n, const Allocator& allocator = Allocator());
+  explicit small_vector(std::initializer_list<value_type> const& items,
+                        const Allocator& allocator = Allocator());
+  small_vector(const small_vector& v);
+  small_vector(small_vector&& v) noexcept(
+      std::is_nothrow_move_constructible_v<T>);
+  ~small_vector();
+
+  small_vector& operator=(const small_vector& other);
+  small_vector& operator=(small_vector&& other) noexcept(
+      kMoveTakesStorage && std::is_nothrow_move_constructible_v<T>);
+
+  allocator_type get_allocator() const noexcept;
+
+  reference at(size_type pos);
+  const_reference at(size_type pos) const;
+
+  reference operator[](size_type pos);
+  const_reference operator[](size_type pos) const;
+
+  const_reference front();
+  const_reference front() const;
+  const_reference back();
+  const_reference back() const;
+  iterator data() noexcept;
+  const_iterator data() const noexcept;
+
+  iterator begin() noexcept;
+  const_iterator begin() const noexcept;
+  const_iterator cbegin() const noexcept;
+  iterator end() noexcept;
+  const_iterator end() const noexcept;
+  const_iterator cend() const noexcept;
+
+  bool empty() const noexcept;
+  size_type size() const noexcept;
+  size_type max_size() const noexcept;
+  void reserve(size_type new_cap);
+  size_type capacity() const noexcept;
+  void shrink_to_fit();
+  bool is_inline() const noexcept;
+
+  void clear() noexcept;
+  iterator insert(const_iterator pos, const T& value);
+  iterator insert(const_iterator pos, T&& value);
+  template <class InputIt, class = typename std::iterator_traits<
+                               InputIt>::iterator_category>
+  iterator insert(const_iterator pos, InputIt first, InputIt last);
+  template <class... Args>
+  iterator emplace(const_iterator pos, Args&&... args);
+  iterator erase(const_iterator pos);
+  iterator erase(const_iterator first, const_iterator last);
+  void push_back(const_reference value);
+  void push_back(T&& value);
+  template <class... Args>
+  reference emplace_back(Args&&... args);
+  void pop_back();
+  void swap(small_vector& other) noexcept(
+      kMoveTakesStorage && std::is_nothrow_move_constructible_v<T>);
+
+  template <class... Args>
+  iterator insert_many(const_iterator pos, Args&&... args);
+
+  template <class... Args>
+  void insert_many_back(Args&&... args);
+
+ private:
+  T* allocate(size_type n);
+  void deallocate(T* data, size_type n) noexcept;
+  template <class... Args>
+  void construct(T* place, Args&&... args);
+  void relocateTo(T* data, size_type new_cap, size_type index,
+                  size_type count);
+  void destroy(T* first, T* last) noexcept;
+  T* inlineData() noexcept;
+  void releaseHeap() noexcept;
+  void takeFrom(small_vector& other) noexcept(
+      std::is_nothrow_move_constructible_v<T>);
+  template <class ForwardIt>
+  void insertRange(size_type index, ForwardIt first, size_type count);
+  void shiftTail(size_type index, size_type count);
+  void reallocate(size_type new_cap);
+  template <class... Args>
+  [[gnu::noinline]] void reallocateEmplace(size_type index, Args&&... args);
+
+  // Stateless allocators take no room.
+  [[no_unique_address]] Allocator allocator_;
+  T* data_;
+  size_type size_ = 0;
+  size_type capacity_ = N;
+  alignas(T) unsigned char inline_[N * sizeof(T)];
+};
+
+/**
+ * What the associative containers return from insert_many: calls with up
+ * to eight arguments get their results back without allocating.
+ */
+template <class Iterator>
+using insert_many_result = small_vector<std::pair<Iterator, bool>, 8>;
+
+namespace pmr {
+template <class T, size_t N>
+using small_vector =
+    ps::small_vector<T, N, std::pmr::polymorphic_allocator<T>>;
+}  // namespace pmr
+}  // namespace ps
+
+template <class T, size_t N, class Allocator>
+ps::small_vector<T, N, Allocator>::small_vector() : data_(inlineData()) {}
+
+template <class T, size_t N, class Allocator>
+ps::small_vector<T, N, Allocator>::small_vector(
+    const Allocator& allocator) noexcept
+    : allocator_(allocator), data_(inlineData()) {}
+
+// The constructors below delegate to the one above, so that the destructor
+// cleans up after an element constructor that throws.
+template <class T, size_t N, class Allocator>
+ps::small_vector<T, N, Allocator>::small_vector(size_type n,
+                                                const Allocator& allocator)
+    : small_vector(allocator) {
+  reserve(n);
+  for (; size_ < n; ++size_) {
+    construct(data_ + size_);
+  }
+}
+
+template <class T, size_t N, class Allocator>
+ps::small_vector<T, N, Allocator>::small_vector(
+    std::initializer_list<value_type> const& items, const Allocator& allocator)
+    : small_vector(allocator) {
+  reserve(items.size());
+  for (const T& item : items) {
+    construct(data_ + size_, item);
+    ++size_;
+  }
+}
+
+template <class T, size_t N, class Allocator>
+ps::small_vector<T, N, Allocator>::small_vector(const small_vector& v)
+    : small_vector(
+          alloc_traits::select_on_container_copy_construction(v.allocator_)) {
+  *this = v;
+}
+
+template <class T, size_t N, class Allocator>
+ps::small_vector<T, N, Allocator>::small_vector(small_vector&& v) noexcept(
+    std::is_nothrow_move_constructible_v<T>)
+    : allocator_(std::move(v.allocator_)), data_(inlineData()) {
+  takeFrom(v);
+}
+
+template <class T, size_t N, class Allocator>
+ps::small_vector<T, N, Allocator>::~small_vector() {
+  destroy(data_, data_ + size_);
+  releaseHeap();
+}
+
+template <class T, size_t N, class Allocator>
+ps::small_vector<T, N, Allocator>&
+ps::small_vector<T, N, Allocator>::operator=(const small_vector& other) {
+  if (this != &other) {
+    clear();
+    if constexpr (alloc_traits::propagate_on_container_copy_assignment::
+                      value) {
+      if (allocator_ != other.allocator_) {
+        releaseHeap();
+      }
+      allocator_ = other.allocator_;
+    }
+    reserve(other.size_);
+    for (const T& item : other) {
+      construct(data_ + size_, item);
+      ++size_;
+    }
+  }
+  return *this;
+}
+
+/**
+ * Takes over other's heap buffer when the allocators allow it; see
+ * vector::operator=. Otherwise the elements are moved one by one.
+ */
+template <class T, size_t N, class Allocator>
+ps::small_vector<T, N, Allocator>&
+ps::small_vector<T, N, Allocator>::operator=(small_vector&& other) noexcept(
+    kMoveTakesStorage && std::is_nothrow_move_constructible_v<T>) {
+  if (this == &other) {
+    return *this;
+  }
+  clear();
+  if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+    releaseHeap();
+    allocator_ = std::move(other.allocator_);
+    takeFrom(other);
+  } else if (kMoveTakesStorage || allocator_ == other.allocator_) {
+    takeFrom(other);
+  } else {
+    reserve(other.size_);
+    for (T& item : other) {
+      construct(data_ + size_, std::move(item));
+      ++size_;
+    }
+    other.clear();
+  }
+  return *this;
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::allocator_type
+ps::small_vector<T, N, Allocator>::get_allocator() const noexcept {
+  return allocator_;
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::reference
+ps::small_vector<T, N, Allocator>::operator[](size_type pos) {
+  return data_[pos];
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::const_reference
+ps::small_vector<T, N, Allocator>::operator[](size_type pos) const {
+  return data_[pos];
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::reference
+ps::small_vector<T, N, Allocator>::at(size_type pos) {
+  if (pos >= size_) {
+    throw std::out_of_range("Out of range");
+  }
+  return data_[pos];
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::const_reference
+ps::small_vector<T, N, Allocator>::at(size_type pos) const {
+  if (pos >= size_) {
+    throw std::out_of_range("Out of range");
+  }
+  return data_[pos];
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::const_reference
+ps::small_vector<T, N, Allocator>::front() {
+  return data_[0];
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::const_reference
+ps::small_vector<T, N, Allocator>::front() const {
+  return data_[0];
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::const_reference
+ps::small_vector<T, N, Allocator>::back() {
+  return data_[size_ - 1];
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::const_reference
+ps::small_vector<T, N, Allocator>::back() const {
+  return data_[size_ - 1];
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::iterator
+ps::small_vector<T, N, Allocator>::data() noexcept {
+  return data_;
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::const_iterator
+ps::small_vector<T, N, Allocator>::data() const noexcept {
+  return data_;
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::iterator
+ps::small_vector<T, N, Allocator>::begin() noexcept {
+  return data_;
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::const_iterator
+ps::small_vector<T, N, Allocator>::begin() const noexcept {
+  return data_;
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::const_iterator
+ps::small_vector<T, N, Allocator>::cbegin() const noexcept {
+  return data_;
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::iterator
+ps::small_vector<T, N, Allocator>::end() noexcept {
+  return data_ + size_;
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::const_iterator
+ps::small_vector<T, N, Allocator>::end() const noexcept {
+  return data_ + size_;
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::const_iterator
+ps::small_vector<T, N, Allocator>::cend() const noexcept {
+  return data_ + size_;
+}
+
+template <class T, size_t N, class Allocator>
+bool ps::small_vector<T, N, Allocator>::empty() const noexcept {
+  return size_ == 0;
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::size_type
+ps::small_vector<T, N, Allocator>::size() const noexcept {
+  return size_;
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::size_type
+ps::small_vector<T, N, Allocator>::max_size() const noexcept {
+  return std::numeric_limits<size_type>::max() / sizeof(value_type);
+}
+
+template <class T, size_t N, class Allocator>
+void ps::small_vector<T, N, Allocator>::reserve(size_type new_cap) {
+  if (new_cap > max_size()) {
+    throw std::length_error("Length error");
+  }
+  if (new_cap > capacity_) {
+    reallocate(new_cap);
+  }
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::size_type
+ps::small_vector<T, N, Allocator>::capacity() const noexcept {
+  return capacity_;
+}
+
+/** Moves the elements back inline if they fit there again. */
+template <class T, size_t N, class Allocator>
+void ps::small_vector<T, N, Allocator>::shrink_to_fit() {
+  if (is_inline() || capacity_ == size_) {
+    return;
+  }
+  if (size_ <= N) {
+    relocateTo(inlineData(), N, size_, 0);
+  } else {
+    reallocate(size_);
+  }
+}
+
+/** Whether the elements are still stored in the object itself. */
+template <class T, size_t N, class Allocator>
+bool ps::small_vector<T, N, Allocator>::is_inline() const noexcept {
+  return static_cast<const void*>(data_) == inline_;
+}
+
+template <class T, size_t N, class Allocator>
+void ps::small_vector<T, N, Allocator>::clear() noexcept {
+  destroy(data_, data_ + size_);
+  size_ = 0;
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::iterator
+ps::small_vector<T, N, Allocator>::insert(const_iterator pos, const T& value) {
+  return emplace(pos, value);
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::iterator
+ps::small_vector<T, N, Allocator>::insert(const_iterator pos, T&& value) {
+  return emplace(pos, std::move(value));
+}
+
+/**
+ * Inserts [first, last) in front of pos with at most one growth and one
+ * move of the tail; see vector::insert.
+ */
+template <class T, size_t N, class Allocator>
+template <class InputIt, class>
+typename ps::small_vector<T, N, Allocator>::iterator
+ps::small_vector<T, N, Allocator>::insert(const_iterator pos, InputIt first,
+                                          InputIt last) {
+  size_type index = size_type(pos - begin());
+  if (index > size_) {
+    throw std::out_of_range("Out of range");
+  }
+  using category = typename std::iterator_traits<InputIt>::iterator_category;
+  if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+    insertRange(index, first, size_type(std::distance(first, last)));
+  } else {
+    small_vector buffer(allocator_);
+    for (; first != last; ++first) {
+      buffer.emplace_back(*first);
+    }
+    insertRange(index, std::make_move_iterator(buffer.begin()),
+                buffer.size_);
+  }
+  return begin() + index;
+}
+
+/** Constructs an element in front of pos; see vector::emplace. */
+template <class T, size_t N, class Allocator>
+template <class... Args>
+typename ps::small_vector<T, N, Allocator>::iterator
+ps::small_vector<T, N, Allocator>::emplace(const_iterator pos, Args&&... args) {
+  size_type index = size_type(pos - begin());
+  if (index > size_) {
+    throw std::out_of_range("Out of range");
+  }
+  if (size_ == capacity_) {
+    reallocateEmplace(index, std::forward<Args>(args)...);
+  } else if (index == size_) {
+    construct(data_ + size_, std::forward<Args>(args)...);
+    ++size_;
+  } else {
+    // args may refer to an element that is about to move.
+    T value(std::forward<Args>(args)...);
+    if constexpr (kBitwiseRelocate) {
+      shiftTail(index, 1);
+      construct(data_ + index, std::move(value));
+    } else {
+      construct(data_ + size_, std::move(data_[size_ - 1]));
+      std::move_backward(data_ + index, data_ + size_ - 1, data_ + size_);
+      data_[index] = std::move(value);
+    }
+    ++size_;
+  }
+  return begin() + index;
+}
+
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::iterator
+ps::small_vector<T, N, Allocator>::erase(const_iterator pos) {
+  if (pos >= cend()) {
+    return end();
+  }
+  return erase(pos, pos + 1);
+}
+
+/** Moves the tail down over [first, last) in one pass; see vector::erase. */
+template <class T, size_t N, class Allocator>
+typename ps::small_vector<T, N, Allocator>::iterator
+ps::small_vector<T, N, Allocator>::erase(const_iterator first,
+                                         const_iterator last) {
+  size_type index = size_type(first - begin());
+  size_type count = size_type(last - first);
+  if (count > 0) {
+    if constexpr (kBitwiseRelocate) {
+      std::memmove(static_cast<void*>(data_ + index), data_ + index + count,
+                   (size_ - index - count) * sizeof(T));
+    } else {
+      std::move(data_ + index + count, data_ + size_, data_ + index);
+      destroy(data_ + size_ - count, data_ + size_);
+    }
+    size_ -= count;
+  }
+  return begin() + index;
+}
+
+template <class T, size_t N, class Allocator>
+void ps::small_vector<T, N, Allocator>::push_back(const_reference value) {
+  emplace_back(value);
+}
+
+template <class T, size_t N, class Allocator>
+void ps::small_vector<T, N, Allocator>::push_back(T&& value) {
+  emplace_back(std::move(value));
+}
+
+template <class T, size_t N, class Allocator>
+template <class... Args>
+typename ps::small_vector<T, N, Allocator>::reference
+ps::small_vector<T, N, Allocator>::emplace_back(Args&&... args) {
+  if (size_ == capacity_) {
+    reallocateEmplace(size_, std::forward<Args>(args)...);
+  } else {
+    construct(data_ + size_, std::forward<Args>(args)...);
+    ++size_;
+  }
+  return data_[size_ - 1];
+}
+
+template <class T, size_t N, class Allocator>
+void ps::small_vector<T, N, Allocator>::pop_back() {
+  if (size_ > 0) {
+    --size_;
+    alloc_traits::destroy(allocator_, data_ + size_);
+  }
+}
+
+/** Swaps through a third vector, as inline elements cannot trade places. */
+template <class T, size_t N, class Allocator>
+void ps::small_vector<T, N, Allocator>::swap(small_vector& other) noexcept(
+    kMoveTakesStorage && std::is_nothrow_move_constructible_v<T>) {
+  if (this != &other) {
+    small_vector tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+}
+
+/**
+ * Inserts the arguments in front of pos with one growth and one shift.
+ * As if each were inserted at pos in turn, they end up in reverse order.
+ */
+template <class T, size_t N, class Allocator>
+template <class... Args>
+typename ps::small_vector<T, N, Allocator>::iterator
+ps::small_vector<T, N, Allocator>::insert_many(const_iterator pos,
+                                               Args&&... args) {
+  size_type index = size_type(pos - begin());
+  if (index > size_) {
+    throw std::out_of_range("Out of range");
+  }
+  if constexpr (sizeof...(Args) > 0) {
+    // Built before anything moves, as args may refer to elements.
+    T items[] = {T(std::forward<Args>(args))...};
+    insertRange(index, std::make_move_iterator(std::rbegin(items)),
+                sizeof...(Args));
+  }
+  return begin() + index;
+}
+
+template <class T, size_t N, class Allocator>
+template <class... Args>
+void ps::small_vector<T, N, Allocator>::insert_many_back(Args&&... args) {
+  reserve(size_ + sizeof...(Args));
+  (emplace_back(std::forward<Args>(args)), ...);
+}
+
+template <class T, size_t N, class Allocator>
+T* ps::small_vector<T, N, Allocator>::allocate(size_type n) {
+  return alloc_traits::allocate(allocator_, n);
+}
+
+template <class T, size_t N, class Allocator>
+void ps::small_vector<T, N, Allocator>::deallocate(T* data,
+                                                   size_type n) noexcept {
+  alloc_traits::deallocate(allocator_, data, n);
+}
+
+template <class T, size_t N, class Allocator>
+template <class... Args>
+void ps::small_vector<T, N, Allocator>::construct(T* place, Args&&... args) {
+  alloc_traits::construct(allocator_, place, std::forward<Args>(args)...);
+}
+
+/**
+ * Moves the elements into data around the count elements already
+ * constructed at index and makes it the storage; see vector::relocateTo.
+ * data is either a new heap block of new_cap elements or, when shrinking,
+ * the inline buffer, which is not freed if a copy throws.
+ */
+template <class T, size_t N, class Allocator>
+void ps::small_vector<T, N, Allocator>::relocateTo(T* data,
+                                                   size_type new_cap,
+                                                   size_type index,
+                                                   size_type count) {
+  if constexpr (kBitwiseRelocate) {
+    if (size_ > 0) {
+      std::memcpy(static_cast<void*>(data), data_, index * sizeof(T));
+      std::memcpy(static_cast<void*>(data + index + count), data_ + index,
+                  (size_ - index) * sizeof(T));
+    }
+  } else {
+    size_type built = 0;
+    try {
+      for (; built < index; ++built) {
+        construct(data + built, std::move_if_noexcept(data_[built]));
+      }
+      for (; built < size_; ++built) {
+        construct(data + built + count, std::move_if_noexcept(data_[built]));
+      }
+    } catch (...) {
+      destroy(data, data + std::min(built, index));
+      destroy(data + index, data + std::max(built, index) + count);
+      if (data != inlineData()) {
+        deallocate(data, new_cap);
+      }
+      throw;
+    }
+    destroy(data_, data_ + size_);
+  }
+  releaseHeap();
+  data_ = data;
+  capacity_ = new_cap;
+  size_ += count;
+}
+
+template <class T, size_t N, class Allocator>
+void ps::small_vector<T, N, Allocator>::destroy(T* first, T* last) noexcept {
+  if constexpr (!kBitwiseRelocate || !std::is_trivially_destructible_v<T>) {
+    for (; first != last; ++first) {
+      alloc_traits::destroy(allocator_, first);
+    }
+  }
+}
+
+template <class T, size_t N, class Allocator>
+T* ps::small_vector<T, N, Allocator>::inlineData() noexcept {
+  return reinterpret_cast<T*>(inline_);
+}
+
+/** Frees the heap buffer, if any, and points back at the inline one. */
+template <class T, size_t N, class Allocator>
+void ps::small_vector<T, N, Allocator>::releaseHeap() noexcept {
+  if (!is_inline()) {
+    deallocate(data_, capacity_);
+    data_ = inlineData();
+    capacity_ = N;
+  }
+}
+
+/**
+ * Takes other's elements into this empty vector: a heap buffer changes
+ * hands, inline elements are moved over one by one. If a move throws, the
+ * ones already moved are destroyed and other keeps all its elements.
+ */
+template <class T, size_t N, class Allocator>
+void ps::small_vector<T, N, Allocator>::takeFrom(small_vector& other) noexcept(
+    std::is_nothrow_move_constructible_v<T>) {
+  releaseHeap();
+  if (other.is_inline()) {
+    if constexpr (kBitwiseRelocate) {
+      if (other.size_ > 0) {
+        std::memcpy(static_cast<void*>(data_), other.data_,
+                    other.size_ * sizeof(T));
+      }
+    } else if constexpr (std::is_nothrow_move_constructible_v<T>) {
+      for (size_type i = 0; i < other.size_; ++i) {
+        construct(data_ + i, std::move(other.data_[i]));
+      }
+      other.destroy(other.data_, other.data_ + other.size_);
+    } else {
+      size_type built = 0;
+      try {
+        for (; built < other.size_; ++built) {
+          construct(data_ + built, std::move(other.data_[built]));
+        }
+      } catch (...) {
+        destroy(data_, data_ + built);
+        throw;
+      }
+      other.destroy(other.data_, other.data_ + other.size_);
+    }
+  } else {
+    data_ = std::exchange(other.data_, other.inlineData());
+    capacity_ = std::exchange(other.capacity_, N);
+  }
+  size_ = std::exchange(other.size_, 0);
+}
+
+/**
+ * Constructs count elements from first in front of index, growing at most
+ * once; see vector::insertRange.
+ */
+template <class T, size_t N, class Allocator>
+template <class ForwardIt>
+void ps::small_vector<T, N, Allocator>::insertRange(size_type index,
+                                                    ForwardIt first,
+                                                    size_type count) {
+  if (count == 0) {
+    return;
+  }
+  if (count > max_size() - size_) {
+    throw std::length_error("Length error");
+  }
+  if (size_ + count > capacity_) {
+    size_type new_cap = std::max(capacity_ * 2, size_ + count);
+    T* data = allocate(new_cap);
+    size_type built = 0;
+    try {
+      for (; built < count; ++built, ++first) {
+        construct(data + index + built, *first);
+      }
+    } catch (...) {
+      destroy(data + index, data + index + built);
+      deallocate(data, new_cap);
+      throw;
+    }
+    relocateTo(data, new_cap, index, count);
+  } else if constexpr (kBitwiseRelocate &&
+                       std::is_nothrow_constructible_v<
+                           T, typename std::iterator_traits<
+                                  ForwardIt>::reference>) {
+    shiftTail(index, count);
+    for (size_type i = 0; i < count; ++i, ++first) {
+      construct(data_ + index + i, *first);
+    }
+    size_ += count;
+  } else {
+    T* pos = data_ + index;
+    T* old_end = data_ + size_;
+    size_type after = size_ - index;
+    if (after > count) {
+      for (T* from = old_end - count; from != old_end; ++from) {
+        construct(data_ + size_, std::move(*from));
+        ++size_;
+      }
+      std::move_backward(pos, old_end - count, old_end);
+      std::copy_n(first, count, pos);
+    } else {
+      ForwardIt mid = std::next(
+          first,
+          typename std::iterator_traits<ForwardIt>::difference_type(after));
+      for (ForwardIt it = mid; size_ < index + count; ++it) {
+        construct(data_ + size_, *it);
+        ++size_;
+      }
+      for (T* from = pos; from != old_end; ++from) {
+        construct(data_ + size_, std::move(*from));
+        ++size_;
+      }
+      std::copy(first, mid, pos);
+    }
+  }
+}
+
+/**
+ * Moves the trivially copyable elements from index on up by count with
+ * one memmove. The count slots at index are then left uninitialized.
+ */
+template <class T, size_t N, class Allocator>
+void ps::small_vector<T, N, Allocator>::shiftTail(size_type index,
+                                                  size_type count) {
+  std::memmove(static_cast<void*>(data_ + index + count), data_ + index,
+               (size_ - index) * sizeof(T));
+}
+
+template <class T, size_t N, class Allocator>
+void ps::small_vector<T, N, Allocator>::reallocate(size_type new_cap) {
+  relocateTo(allocate(new_cap), new_cap, size_, 0);
+}
+
+template <class T, size_t N, class Allocator>
+template <class... Args>
+void ps::small_vector<T, N, Allocator>::reallocateEmplace(size_type index,
+                                                          Args&&... args) {
+  size_type new_cap = capacity_ * 2;
+  T* data = allocate(new_cap);
+  // Constructed before anything moves, as args may refer to an element.
+  try {
+    construct(data + index, std::forward<Args>(args)...);
+  } catch (...) {
+    deallocate(data, new_cap);
+    throw;
+  }
+  relocateTo(data, new_cap, index, 1);
+}
+
+#endif  // CONTAINERS_SRC_PS_SMALL_VECTOR_H_
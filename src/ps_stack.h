@@ -36,6 +36,11 @@ class stack {
  private:
   Container deque_;
 };
+
+namespace pmr {
+template <class T>
+using stack = ps::stack<T, ps::pmr::deque<T>>;
+}  // namespace pmr
 }  // namespace ps
 
 template <class T, class Container>
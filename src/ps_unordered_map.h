@@ -0,0 +1,527 @@
+#ifndef CONTAINERS_SRC_PS_UNORDERED_MAP_H_
+#define CONTAINERS_SRC_PS_UNORDERED_MAP_H_
+
+#include <memory_resource>
+#include <stdexcept>
+
+#include "ps_hash_table.h"
+#include "ps_small_vector.h"
+#include "ps_vector.h"
+
+namespace ps {
+
+/**
+ * Hash map with the interface of map, minus everything that needs an
+ * order. Elements are stored inline in a HashTable, so unlike with map an
+ * insertion may invalidate iterators and references.
+ */
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
+class unordered_map {
+  using table_type = HashTable<Key, T, Hash, KeyEqual, Allocator>;
+
+  class UnorderedMapIterator;
+  class UnorderedMapConstIterator;
+
+  class UnorderedMapIterator {
+    friend unordered_map<Key, T, Hash, KeyEqual, Allocator>;
+    friend UnorderedMapConstIterator;
+    const ctrl_t *_ctrl;
+    std::pair<const Key, T> *_slot;
+
+   public:
+    UnorderedMapIterator() {}
+    explicit UnorderedMapIterator(const ctrl_t *ctrl,
+                                  std::pair<const Key, T> *slot)
+        : _ctrl(ctrl), _slot(slot) {}
+
+    std::pair<const Key, T> &operator*() const { return *_slot; }
+    std::pair<const Key, T> *operator->() const { return _slot; }
+
+    UnorderedMapIterator &operator++() {
+      ++_ctrl;
+      ++_slot;
+      table_type::skipEmpty(_ctrl, _slot);
+      return *this;
+    }
+
+    UnorderedMapIterator operator++(int) {
+      UnorderedMapIterator tmp(*this);
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const UnorderedMapConstIterator &other) const noexcept {
+      return other._ctrl == _ctrl;
+    }
+    bool operator!=(const UnorderedMapConstIterator &other) const noexcept {
+      return other._ctrl != _ctrl;
+    }
+    bool operator==(const UnorderedMapIterator &other) const noexcept {
+      return other._ctrl == _ctrl;
+    }
+    bool operator!=(const UnorderedMapIterator &other) const noexcept {
+      return other._ctrl != _ctrl;
+    }
+  };
+
+  class UnorderedMapConstIterator {
+    friend unordered_map<Key, T, Hash, KeyEqual, Allocator>;
+    const ctrl_t *_ctrl;
+    const std::pair<const Key, T> *_slot;
+
+   public:
+    UnorderedMapConstIterator() {}
+    explicit UnorderedMapConstIterator(const ctrl_t *ctrl,
+                                       const std::pair<const Key, T> *slot)
+        : _ctrl(ctrl), _slot(slot) {}
+    UnorderedMapConstIterator(const UnorderedMapIterator &other)
+        : _ctrl(other._ctrl), _slot(other._slot) {}
+
+    const std::pair<const Key, T> &operator*() const { return *_slot; }
+    const std::pair<const Key, T> *operator->() const { return _slot; }
+
+    UnorderedMapConstIterator &operator++() {
+      ++_ctrl;
+      ++_slot;
+      table_type::skipEmpty(_ctrl, _slot);
+      return *this;
+    }
+
+    UnorderedMapConstIterator operator++(int) {
+      UnorderedMapConstIterator tmp(*this);
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const UnorderedMapConstIterator &other) const noexcept {
+      return other._ctrl == _ctrl;
+    }
+    bool operator!=(const UnorderedMapConstIterator &other) const noexcept {
+      return other._ctrl != _ctrl;
+    }
+    bool operator==(const UnorderedMapIterator &other) const noexcept {
+      return other._ctrl == _ctrl;
+    }
+    bool operator!=(const UnorderedMapIterator &other) const noexcept {
+      return other._ctrl != _ctrl;
+    }
+  };
+
+  table_type _table;
+
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using iterator = UnorderedMapIterator;
+  using const_iterator = UnorderedMapConstIterator;
+  using size_type = size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using allocator_type = Allocator;
+
+  unordered_map() = default;
+  explicit unordered_map(size_type bucket_count, const Hash &hash = Hash(),
+                         const KeyEqual &eq = KeyEqual());
+  explicit unordered_map(const Allocator &allocator);
+  unordered_map(std::initializer_list<value_type> const &items);
+
+  mapped_type &operator[](const Key &key);
+  mapped_type &operator[](Key &&key);
+
+  bool empty() const noexcept;
+  size_type size() const noexcept;
+  size_type max_size() const noexcept;
+  size_type bucket_count() const noexcept;
+  float load_factor() const noexcept;
+  hasher hash_function() const;
+  key_equal key_eq() const;
+
+  T &at(const Key &key);
+  const T &at(const Key &key) const;
+
+  iterator begin() noexcept;
+  const_iterator begin() const noexcept;
+  const_iterator cbegin() const noexcept;
+  iterator end() noexcept;
+  const_iterator end() const noexcept;
+  const_iterator cend() const noexcept;
+
+  void clear() noexcept;
+  void reserve(size_type count);
+  std::pair<iterator, bool> insert(const value_type &value);
+  std::pair<iterator, bool> insert(value_type &&value);
+  std::pair<iterator, bool> insert(const Key &key, const T &obj);
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args &&...args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const Key &key, Args &&...args);
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(Key &&key, Args &&...args);
+  std::pair<iterator, bool> insert_or_assign(const Key &key, const T &obj);
+  void erase(iterator pos);
+  size_type erase(const Key &key);
+  void swap(unordered_map &other) noexcept;
+  void merge(unordered_map &other);
+
+  iterator find(const Key &key);
+  const_iterator find(const Key &key) const;
+  bool contains(const Key &key) const;
+  size_type count(const Key &key) const;
+
+  template <class... Args>
+  insert_many_result<iterator> insert_many(Args &&...args);
+
+ private:
+  iterator iteratorAt(size_t index) const;
+  std::pair<iterator, bool> indexResult(std::pair<size_t, bool> r) const;
+};
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::unordered_map(
+    size_type bucket_count, const Hash &hash, const KeyEqual &eq)
+    : _table(hash, eq) {
+  _table.reserve(bucket_count);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::unordered_map(
+    const Allocator &allocator)
+    : _table(Hash(), KeyEqual(), allocator) {}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::unordered_map(
+    std::initializer_list<value_type> const &items) {
+  _table.reserve(items.size());
+  for (auto i = items.begin(); i < items.end(); i++) {
+    insert(*i);
+  }
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::iterator
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::iteratorAt(
+    size_t index) const {
+  return iterator(_table.ctrlAt(index), _table.slotAt(index));
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+std::pair<typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::indexResult(
+    std::pair<size_t, bool> r) const {
+  return std::pair<iterator, bool>(iteratorAt(r.first), r.second);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::mapped_type &
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::operator[](const Key &key) {
+  return _table.slotAt(_table.tryEmplace(key).first)->second;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::mapped_type &
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::operator[](Key &&key) {
+  return _table.slotAt(_table.tryEmplace(std::move(key)).first)->second;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+bool unordered_map<Key, T, Hash, KeyEqual, Allocator>::empty() const noexcept {
+  return _table.size() == 0;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::size_type
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::size() const noexcept {
+  return _table.size();
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::size_type
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::max_size() const noexcept {
+  return _table.max_size();
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::size_type
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::bucket_count()
+    const noexcept {
+  return _table.capacity();
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+float unordered_map<Key, T, Hash, KeyEqual, Allocator>::load_factor()
+    const noexcept {
+  if (_table.capacity() == 0) {
+    return 0;
+  }
+  return static_cast<float>(_table.size()) /
+         static_cast<float>(_table.capacity());
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::hasher
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::hash_function() const {
+  return _table.hashFunction();
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::key_equal
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::key_eq() const {
+  return _table.keyEq();
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+T &unordered_map<Key, T, Hash, KeyEqual, Allocator>::at(const Key &key) {
+  size_t index = _table.find(key);
+  if (index == _table.capacity()) {
+    throw std::out_of_range("key does not exists");
+  }
+  return _table.slotAt(index)->second;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+const T &unordered_map<Key, T, Hash, KeyEqual, Allocator>::at(
+    const Key &key) const {
+  size_t index = _table.find(key);
+  if (index == _table.capacity()) {
+    throw std::out_of_range("key does not exists");
+  }
+  return _table.slotAt(index)->second;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::iterator
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::begin() noexcept {
+  iterator it = iteratorAt(0);
+  table_type::skipEmpty(it._ctrl, it._slot);
+  return it;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::const_iterator
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::begin() const noexcept {
+  return cbegin();
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::const_iterator
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::cbegin() const noexcept {
+  iterator it = iteratorAt(0);
+  table_type::skipEmpty(it._ctrl, it._slot);
+  return it;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::iterator
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::end() noexcept {
+  return iteratorAt(_table.capacity());
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::const_iterator
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::end() const noexcept {
+  return iteratorAt(_table.capacity());
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::const_iterator
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::cend() const noexcept {
+  return iteratorAt(_table.capacity());
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+void unordered_map<Key, T, Hash, KeyEqual, Allocator>::clear() noexcept {
+  _table.clear();
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+void unordered_map<Key, T, Hash, KeyEqual, Allocator>::reserve(
+    size_type count) {
+  _table.reserve(count);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+std::pair<typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::insert(
+    const value_type &value) {
+  return indexResult(_table.insertUnique(value));
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+std::pair<typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::insert(value_type &&value) {
+  return indexResult(_table.insertUnique(std::move(value)));
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+std::pair<typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::insert(const Key &key,
+                                                         const T &obj) {
+  return try_emplace(key, obj);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+template <typename... Args>
+std::pair<typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::emplace(Args &&...args) {
+  return indexResult(_table.emplace(std::forward<Args>(args)...));
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+template <typename... Args>
+std::pair<typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::try_emplace(
+    const Key &key, Args &&...args) {
+  return indexResult(_table.tryEmplace(key, std::forward<Args>(args)...));
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+template <typename... Args>
+std::pair<typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::try_emplace(
+    Key &&key, Args &&...args) {
+  return indexResult(
+      _table.tryEmplace(std::move(key), std::forward<Args>(args)...));
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+std::pair<typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::insert_or_assign(
+    const Key &key, const T &obj) {
+  auto result = _table.tryEmplace(key, obj);
+  if (!result.second) {
+    _table.slotAt(result.first)->second = obj;
+  }
+  return indexResult(result);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+void unordered_map<Key, T, Hash, KeyEqual, Allocator>::erase(iterator pos) {
+  _table.eraseAt(static_cast<size_t>(pos._slot - _table.slotAt(0)));
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::size_type
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::erase(const Key &key) {
+  return _table.erase(key);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+void unordered_map<Key, T, Hash, KeyEqual, Allocator>::swap(
+    unordered_map &other) noexcept {
+  _table.swap(other._table);
+}
+
+/**
+ * Moves the elements of other whose keys are not in this map over; the
+ * others stay in other.
+ */
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+void unordered_map<Key, T, Hash, KeyEqual, Allocator>::merge(
+    unordered_map &other) {
+  _table.mergeFrom(other._table);
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::iterator
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::find(const Key &key) {
+  return iteratorAt(_table.find(key));
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::const_iterator
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::find(const Key &key) const {
+  return iteratorAt(_table.find(key));
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+bool unordered_map<Key, T, Hash, KeyEqual, Allocator>::contains(
+    const Key &key) const {
+  return _table.find(key) != _table.capacity();
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::size_type
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::count(
+    const Key &key) const {
+  return contains(key) ? 1 : 0;
+}
+
+template <typename Key, typename T, typename Hash, typename KeyEqual,
+          typename Allocator>
+template <class... Args>
+insert_many_result<
+    typename unordered_map<Key, T, Hash, KeyEqual, Allocator>::iterator>
+unordered_map<Key, T, Hash, KeyEqual, Allocator>::insert_many(
+    Args &&...args) {
+  insert_many_result<iterator> res;
+  // Growing halfway through would invalidate the iterators returned so far.
+  _table.reserve(_table.size() + sizeof...(Args));
+  for (const auto &arg : {args...}) {
+    res.push_back(indexResult(_table.insertUnique(arg)));
+  }
+  return res;
+}
+
+namespace pmr {
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+using unordered_map =
+    ps::unordered_map<Key, T, Hash, KeyEqual,
+                      std::pmr::polymorphic_allocator<std::pair<const Key, T>>>;
+}  // namespace pmr
+
+}  // namespace ps
+
+#endif  // CONTAINERS_SRC_PS_UNORDERED_MAP_H_
@@ -0,0 +1,307 @@
+#ifndef CONTAINERS_SRC_PS_UNORDERED_SET_H_
+#define CONTAINERS_SRC_PS_UNORDERED_SET_H_
+
+#include <memory_resource>
+
+#include "ps_hash_table.h"
+#include "ps_small_vector.h"
+#include "ps_vector.h"
+
+namespace ps {
+
+/**
+ * Hash set with the interface of set, minus everything that needs an
+ * order. An insertion may invalidate iterators, see HashTable.
+ */
+template <typename Key, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<Key>>
+class unordered_set {
+  using table_type = HashTable<Key, void, Hash, KeyEqual, Allocator>;
+
+  class UnorderedSetIterator {
+    friend unordered_set<Key, Hash, KeyEqual, Allocator>;
+    const ctrl_t *_ctrl;
+    const Key *_slot;
+
+   public:
+    UnorderedSetIterator() {}
+    explicit UnorderedSetIterator(const ctrl_t *ctrl, const Key *slot)
+        : _ctrl(ctrl), _slot(slot) {}
+
+    const Key &operator*() const { return *_slot; }
+    const Key *operator->() const { return _slot; }
+
+    UnorderedSetIterator &operator++() {
+      ++_ctrl;
+      ++_slot;
+      table_type::skipEmpty(_ctrl, _slot);
+      return *this;
+    }
+
+    UnorderedSetIterator operator++(int) {
+      UnorderedSetIterator tmp(*this);
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const UnorderedSetIterator &other) const noexcept {
+      return other._ctrl == _ctrl;
+    }
+    bool operator!=(const UnorderedSetIterator &other) const noexcept {
+      return other._ctrl != _ctrl;
+    }
+  };
+
+  table_type _table;
+
+ public:
+  using key_type = Key;
+  using value_type = Key;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using iterator = UnorderedSetIterator;
+  using const_iterator = UnorderedSetIterator;
+  using size_type = size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using allocator_type = Allocator;
+
+  unordered_set() = default;
+  explicit unordered_set(size_type bucket_count, const Hash &hash = Hash(),
+                         const KeyEqual &eq = KeyEqual());
+  explicit unordered_set(const Allocator &allocator);
+  unordered_set(std::initializer_list<value_type> const &items);
+
+  bool empty() const noexcept;
+  size_type size() const noexcept;
+  size_type max_size() const noexcept;
+  size_type bucket_count() const noexcept;
+  hasher hash_function() const;
+  key_equal key_eq() const;
+
+  iterator begin() const noexcept;
+  iterator cbegin() const noexcept;
+  iterator end() const noexcept;
+  iterator cend() const noexcept;
+
+  void clear() noexcept;
+  void reserve(size_type count);
+  std::pair<iterator, bool> insert(const value_type &value);
+  std::pair<iterator, bool> insert(value_type &&value);
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args &&...args);
+  void erase(iterator pos);
+  size_type erase(const Key &key);
+  void swap(unordered_set &other) noexcept;
+  void merge(unordered_set &other);
+
+  iterator find(const Key &key) const;
+  bool contains(const Key &key) const;
+  size_type count(const Key &key) const;
+
+  template <class... Args>
+  insert_many_result<iterator> insert_many(Args &&...args);
+
+ private:
+  iterator iteratorAt(size_t index) const;
+  std::pair<iterator, bool> indexResult(std::pair<size_t, bool> r) const;
+};
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+unordered_set<Key, Hash, KeyEqual, Allocator>::unordered_set(
+    size_type bucket_count, const Hash &hash, const KeyEqual &eq)
+    : _table(hash, eq) {
+  _table.reserve(bucket_count);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+unordered_set<Key, Hash, KeyEqual, Allocator>::unordered_set(
+    const Allocator &allocator)
+    : _table(Hash(), KeyEqual(), allocator) {}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+unordered_set<Key, Hash, KeyEqual, Allocator>::unordered_set(
+    std::initializer_list<value_type> const &items) {
+  _table.reserve(items.size());
+  for (auto i = items.begin(); i < items.end(); i++) {
+    insert(*i);
+  }
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename unordered_set<Key, Hash, KeyEqual, Allocator>::iterator
+unordered_set<Key, Hash, KeyEqual, Allocator>::iteratorAt(
+    size_t index) const {
+  return iterator(_table.ctrlAt(index), _table.slotAt(index));
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+std::pair<typename unordered_set<Key, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+unordered_set<Key, Hash, KeyEqual, Allocator>::indexResult(
+    std::pair<size_t, bool> r) const {
+  return std::pair<iterator, bool>(iteratorAt(r.first), r.second);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+bool unordered_set<Key, Hash, KeyEqual, Allocator>::empty() const noexcept {
+  return _table.size() == 0;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename unordered_set<Key, Hash, KeyEqual, Allocator>::size_type
+unordered_set<Key, Hash, KeyEqual, Allocator>::size() const noexcept {
+  return _table.size();
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename unordered_set<Key, Hash, KeyEqual, Allocator>::size_type
+unordered_set<Key, Hash, KeyEqual, Allocator>::max_size() const noexcept {
+  return _table.max_size();
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename unordered_set<Key, Hash, KeyEqual, Allocator>::size_type
+unordered_set<Key, Hash, KeyEqual, Allocator>::bucket_count() const noexcept {
+  return _table.capacity();
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename unordered_set<Key, Hash, KeyEqual, Allocator>::hasher
+unordered_set<Key, Hash, KeyEqual, Allocator>::hash_function() const {
+  return _table.hashFunction();
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename unordered_set<Key, Hash, KeyEqual, Allocator>::key_equal
+unordered_set<Key, Hash, KeyEqual, Allocator>::key_eq() const {
+  return _table.keyEq();
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename unordered_set<Key, Hash, KeyEqual, Allocator>::iterator
+unordered_set<Key, Hash, KeyEqual, Allocator>::begin() const noexcept {
+  iterator it = iteratorAt(0);
+  table_type::skipEmpty(it._ctrl, it._slot);
+  return it;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename unordered_set<Key, Hash, KeyEqual, Allocator>::iterator
+unordered_set<Key, Hash, KeyEqual, Allocator>::cbegin() const noexcept {
+  return begin();
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename unordered_set<Key, Hash, KeyEqual, Allocator>::iterator
+unordered_set<Key, Hash, KeyEqual, Allocator>::end() const noexcept {
+  return iteratorAt(_table.capacity());
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename unordered_set<Key, Hash, KeyEqual, Allocator>::iterator
+unordered_set<Key, Hash, KeyEqual, Allocator>::cend() const noexcept {
+  return end();
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void unordered_set<Key, Hash, KeyEqual, Allocator>::clear() noexcept {
+  _table.clear();
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void unordered_set<Key, Hash, KeyEqual, Allocator>::reserve(size_type count) {
+  _table.reserve(count);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+std::pair<typename unordered_set<Key, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+unordered_set<Key, Hash, KeyEqual, Allocator>::insert(
+    const value_type &value) {
+  return indexResult(_table.tryEmplace(value));
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+std::pair<typename unordered_set<Key, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+unordered_set<Key, Hash, KeyEqual, Allocator>::insert(value_type &&value) {
+  return indexResult(_table.tryEmplace(std::move(value)));
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+template <typename... Args>
+std::pair<typename unordered_set<Key, Hash, KeyEqual, Allocator>::iterator,
+          bool>
+unordered_set<Key, Hash, KeyEqual, Allocator>::emplace(Args &&...args) {
+  return indexResult(_table.emplace(std::forward<Args>(args)...));
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void unordered_set<Key, Hash, KeyEqual, Allocator>::erase(iterator pos) {
+  _table.eraseAt(static_cast<size_t>(pos._slot - _table.slotAt(0)));
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename unordered_set<Key, Hash, KeyEqual, Allocator>::size_type
+unordered_set<Key, Hash, KeyEqual, Allocator>::erase(const Key &key) {
+  return _table.erase(key);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void unordered_set<Key, Hash, KeyEqual, Allocator>::swap(
+    unordered_set &other) noexcept {
+  _table.swap(other._table);
+}
+
+/** Moves the keys of other that are not in this set over. */
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void unordered_set<Key, Hash, KeyEqual, Allocator>::merge(
+    unordered_set &other) {
+  _table.mergeFrom(other._table);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename unordered_set<Key, Hash, KeyEqual, Allocator>::iterator
+unordered_set<Key, Hash, KeyEqual, Allocator>::find(const Key &key) const {
+  return iteratorAt(_table.find(key));
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+bool unordered_set<Key, Hash, KeyEqual, Allocator>::contains(
+    const Key &key) const {
+  return _table.find(key) != _table.capacity();
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename unordered_set<Key, Hash, KeyEqual, Allocator>::size_type
+unordered_set<Key, Hash, KeyEqual, Allocator>::count(const Key &key) const {
+  return contains(key) ? 1 : 0;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+template <class... Args>
+insert_many_result<
+    typename unordered_set<Key, Hash, KeyEqual, Allocator>::iterator>
+unordered_set<Key, Hash, KeyEqual, Allocator>::insert_many(Args &&...args) {
+  insert_many_result<iterator> res;
+  // Growing halfway through would invalidate the iterators returned so far.
+  _table.reserve(_table.size() + sizeof...(Args));
+  for (const auto &arg : {args...}) {
+    res.push_back(indexResult(_table.tryEmplace(arg)));
+  }
+  return res;
+}
+
+namespace pmr {
+template <typename Key, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+using unordered_set =
+    ps::unordered_set<Key, Hash, KeyEqual,
+                      std::pmr::polymorphic_allocator<Key>>;
+}  // namespace pmr
+
+}  // namespace ps
+
+#endif  // CONTAINERS_SRC_PS_UNORDERED_SET_H_
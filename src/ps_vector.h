@@ -1,9 +1,87 @@
 #ifndef CONTAINERS_SRC_PS_VECTOR_H_
 #define CONTAINERS_SRC_PS_VECTOR_H_
 
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
 namespace ps {
-template <class T>
+/**
+ * Growth policies for vector: given the capacity of a full vector, they
+ * return the capacity to grow to. doubling_growth is the default.
+ * one_and_half_growth leaves less slack and lets the allocator reuse the
+ * blocks a vector has outgrown. fixed_growth<Step> adds Step elements at a
+ * time, which makes push_back O(n) but bounds the slack, for vectors whose
+ * final size is roughly known.
+ */
+struct doubling_growth {
+  size_t operator()(size_t capacity) const {
+    return capacity == 0 ? 1 : capacity * 2;
+  }
+};
+
+struct one_and_half_growth {
+  size_t operator()(size_t capacity) const {
+    return capacity + capacity / 2 + 1;
+  }
+};
+
+template <size_t Step>
+struct fixed_growth {
+  static_assert(Step > 0, "fixed_growth needs a positive step");
+  size_t operator()(size_t capacity) const { return capacity + Step; }
+};
+
+/**
+ * has_reallocate - true when Allocator also offers reallocate(ptr, old_n,
+ * new_n), which resizes a block and keeps its contents as bytes, possibly
+ * without copying them; see huge_page_allocator. Such an allocator has to
+ * construct trivially copyable objects with plain placement new.
+ */
+template <class Allocator, class = void>
+struct has_reallocate : std::false_type {};
+
+template <class Allocator>
+struct has_reallocate<
+    Allocator,
+    std::void_t<decltype(std::declval<Allocator&>().reallocate(
+        std::declval<typename Allocator::value_type*>(), size_t(), size_t()))>>
+    : std::true_type {};
+
+/**
+ * vector - elements live in uninitialized storage and are constructed in
+ * place, so growing moves them instead of default-constructing a new array
+ * and copy-assigning into it. Trivially copyable elements are relocated
+ * with a single memcpy.
+ *
+ * Storage comes from Allocator and elements are constructed and destroyed
+ * through std::allocator_traits, which honours the allocator's propagation
+ * traits on copy, move and swap. ps::pmr::vector takes its memory from a
+ * std::pmr::memory_resource, for example a monotonic arena that is dropped
+ * in one go. With an allocator that has reallocate, trivially copyable
+ * elements are grown in place.
+ *
+ * Growth decides how much a full vector grows; see doubling_growth.
+ */
+template <class T, class Allocator = std::allocator<T>,
+          class Growth = doubling_growth>
 class vector {
+  using alloc_traits = std::allocator_traits<Allocator>;
+  static_assert(std::is_same_v<typename alloc_traits::value_type, T>,
+                "Allocator::value_type must be T");
+  // Whether a move assignment can always take the other vector's storage.
+  static constexpr bool kMoveTakesStorage =
+      alloc_traits::propagate_on_container_move_assignment::value ||
+      alloc_traits::is_always_equal::value;
+
  public:
   using value_type = T;
   using reference = T&;
@@ -11,16 +89,23 @@ class vector {
   using iterator = T*;
   using const_iterator = const T*;
   using size_type = size_t;
+  using allocator_type = Allocator;
 
   vector();
-  explicit vector(size_type n);
-  explicit vector(std::initializer_list<value_type> const& items);
+  explicit vector(const Allocator& allocator) noexcept;
+  explicit vector(size_type n, const Allocator& allocator = Allocator());
+  explicit vector(std::initializer_list<value_type> const& items,
+                  const Allocator& allocator = Allocator());
   vector(const vector& v);
+  vector(const vector& v, const Allocator& allocator);
   vector(vector&& v) noexcept;
-  ~vector() { delete[] data_; }
+  vector(vector&& v, const Allocator& allocator);
+  ~vector();
 
   vector& operator=(const vector& other);
-  vector& operator=(vector&& other) noexcept;
+  vector& operator=(vector&& other) noexcept(kMoveTakesStorage);
+
+  allocator_type get_allocator() const noexcept;
 
   reference at(size_type pos);
   const_reference at(size_type pos) const;
@@ -51,8 +136,18 @@ class vector {
 
   void clear() noexcept;
   iterator insert(const_iterator pos, const T& value);
+  iterator insert(const_iterator pos, T&& value);
+  template <class InputIt, class = typename std::iterator_traits<
+                               InputIt>::iterator_category>
+  iterator insert(const_iterator pos, InputIt first, InputIt last);
+  template <class... Args>
+  iterator emplace(const_iterator pos, Args&&... args);
   iterator erase(const_iterator pos);
+  iterator erase(const_iterator first, const_iterator last);
   void push_back(const_reference value);
+  void push_back(T&& value);
+  template <class... Args>
+  reference emplace_back(Args&&... args);
   void pop_back();
   void swap(vector& other) noexcept;
 
@@ -63,279 +158,719 @@ class vector {
   void insert_many_back(Args&&... args);
 
  private:
+  // Relocating as bytes skips Allocator::construct, so it is only done for
+  // the allocators whose construct is known to be plain placement new for
+  // such types.
+  static constexpr bool kBitwiseRelocate =
+      std::is_trivially_copyable_v<T> &&
+      (std::is_same_v<Allocator, std::allocator<T>> ||
+       std::is_same_v<Allocator, std::pmr::polymorphic_allocator<T>> ||
+       has_reallocate<Allocator>::value);
+  // Growing hands the whole block to Allocator::reallocate.
+  static constexpr bool kReallocates =
+      kBitwiseRelocate && has_reallocate<Allocator>::value;
+
+  T* allocate(size_type n);
+  void deallocate(T* data, size_type n) noexcept;
+  template <class... Args>
+  void construct(T* place, Args&&... args);
+  void relocateTo(T* data, size_type new_cap, size_type index,
+                  size_type count);
+  void destroy(T* first, T* last) noexcept;
+  void release() noexcept;
+  void steal(vector& other) noexcept;
+  template <class InputIt>
+  void append(InputIt first, InputIt last, size_type n);
+  template <class ForwardIt>
+  void insertRange(size_type index, ForwardIt first, size_type count);
+  void shiftTail(size_type index, size_type count);
+  size_type grownCapacity() const;
+  void reallocate(size_type new_cap);
+  template <class... Args>
+  [[gnu::noinline]] void reallocateEmplace(size_type index, Args&&... args);
+
+  // Stateless allocators take no room.
+  [[no_unique_address]] Allocator allocator_;
   size_type size_ = 0;
   size_type capacity_ = 0;
   T* data_ = nullptr;
 };
-}  // namespace ps
 
+namespace pmr {
 template <class T>
-ps::vector<T>::vector() {}
+using vector = ps::vector<T, std::pmr::polymorphic_allocator<T>>;
+}  // namespace pmr
+}  // namespace ps
 
-template <class T>
-ps::vector<T>::vector(size_type n) {
-  size_ = n;
-  capacity_ = n;
-  data_ = nullptr;
-  if (size_ > 0) {
-    data_ = new T[capacity_];
+template <class T, class Allocator, class Growth>
+ps::vector<T, Allocator, Growth>::vector() : allocator_() {}
+
+template <class T, class Allocator, class Growth>
+ps::vector<T, Allocator, Growth>::vector(const Allocator& allocator) noexcept
+    : allocator_(allocator) {}
+
+// The constructors below delegate to the one above, so that the destructor
+// cleans up after an element constructor that throws.
+template <class T, class Allocator, class Growth>
+ps::vector<T, Allocator, Growth>::vector(size_type n,
+                                         const Allocator& allocator)
+    : vector(allocator) {
+  reserve(n);
+  for (; size_ < n; ++size_) {
+    construct(data_ + size_);
   }
 }
 
-template <class T>
-ps::vector<T>::vector(std::initializer_list<value_type> const& items)
-    : size_(items.size()), capacity_(items.size()), data_(new T[items.size()]) {
-  std::copy(items.begin(), items.end(), data_);
+template <class T, class Allocator, class Growth>
+ps::vector<T, Allocator, Growth>::vector(
+    std::initializer_list<value_type> const& items, const Allocator& allocator)
+    : vector(allocator) {
+  append(items.begin(), items.end(), items.size());
 }
 
-template <class T>
-ps::vector<T>::vector(const vector& v) {
-  size_ = v.size_;
-  capacity_ = v.capacity_;
-  data_ = nullptr;
-  if (size_ > 0) {
-    data_ = new T[capacity_];
+template <class T, class Allocator, class Growth>
+ps::vector<T, Allocator, Growth>::vector(const vector& v)
+    : vector(alloc_traits::select_on_container_copy_construction(
+          v.allocator_)) {
+  append(v.begin(), v.end(), v.size_);
+}
+
+template <class T, class Allocator, class Growth>
+ps::vector<T, Allocator, Growth>::vector(const vector& v,
+                                         const Allocator& allocator)
+    : vector(allocator) {
+  append(v.begin(), v.end(), v.size_);
+}
+
+template <class T, class Allocator, class Growth>
+ps::vector<T, Allocator, Growth>::vector(vector&& v) noexcept
+    : allocator_(std::move(v.allocator_)) {
+  steal(v);
+}
+
+/** Takes over v's storage if allocator can free it, else moves elements. */
+template <class T, class Allocator, class Growth>
+ps::vector<T, Allocator, Growth>::vector(vector&& v, const Allocator& allocator)
+    : vector(allocator) {
+  if (allocator_ == v.allocator_) {
+    steal(v);
+  } else {
+    append(std::make_move_iterator(v.begin()), std::make_move_iterator(v.end()),
+           v.size_);
+    v.clear();
   }
-  std::copy(v.begin(), v.end(), data_);
 }
 
-template <class T>
-ps::vector<T>::vector(vector&& v) noexcept {
-  size_ = std::exchange(v.size_, 0);
-  capacity_ = std::exchange(v.capacity_, 0);
-  data_ = std::exchange(v.data_, nullptr);
+template <class T, class Allocator, class Growth>
+ps::vector<T, Allocator, Growth>::~vector() {
+  release();
 }
 
-template <class T>
-ps::vector<T>& ps::vector<T>::operator=(const vector& other) {
+template <class T, class Allocator, class Growth>
+ps::vector<T, Allocator, Growth>& ps::vector<T, Allocator, Growth>::operator=(
+    const vector& other) {
   if (this != &other) {
-    delete[] data_;
-    if (other.size_ > 0) {
-      data_ = new T[other.capacity_];
-      std::copy(other.begin(), other.end(), data_);
+    if constexpr (alloc_traits::propagate_on_container_copy_assignment::
+                      value) {
+      if (allocator_ != other.allocator_) {
+        release();
+      }
+      allocator_ = other.allocator_;
     }
-    size_ = other.size_;
-    capacity_ = other.capacity_;
+    clear();
+    append(other.begin(), other.end(), other.size_);
   }
   return *this;
 }
 
-template <class T>
-ps::vector<T>& ps::vector<T>::operator=(vector&& other) noexcept {
-  size_ = std::exchange(other.size_, 0);
-  capacity_ = std::exchange(other.capacity_, 0);
-  data_ = std::exchange(other.data_, nullptr);
+/**
+ * Takes over other's storage when the allocators allow it. Otherwise this
+ * vector keeps its allocator, and other's elements are moved one by one
+ * into storage that allocator owns.
+ */
+template <class T, class Allocator, class Growth>
+ps::vector<T, Allocator, Growth>& ps::vector<T, Allocator, Growth>::operator=(
+    vector&& other) noexcept(kMoveTakesStorage) {
+  if (this == &other) {
+    return *this;
+  }
+  if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+    release();
+    allocator_ = std::move(other.allocator_);
+    steal(other);
+  } else if (kMoveTakesStorage || allocator_ == other.allocator_) {
+    release();
+    steal(other);
+  } else {
+    clear();
+    append(std::make_move_iterator(other.begin()),
+           std::make_move_iterator(other.end()), other.size_);
+    other.clear();
+  }
   return *this;
 }
 
-template <class T>
-typename ps::vector<T>::reference ps::vector<T>::operator[](size_type pos) {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::allocator_type
+ps::vector<T, Allocator, Growth>::get_allocator() const noexcept {
+  return allocator_;
+}
+
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::reference
+ps::vector<T, Allocator, Growth>::operator[](size_type pos) {
   return data_[pos];
 }
 
-template <class T>
-typename ps::vector<T>::const_reference ps::vector<T>::operator[](
-    size_type pos) const {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::const_reference
+ps::vector<T, Allocator, Growth>::operator[](size_type pos) const {
   return data_[pos];
 }
 
-template <class T>
-typename ps::vector<T>::reference ps::vector<T>::at(size_type pos) {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::reference
+ps::vector<T, Allocator, Growth>::at(size_type pos) {
   if (pos >= size_) {
     throw std::out_of_range("Out of range");
   }
   return data_[pos];
 }
 
-template <class T>
-typename ps::vector<T>::const_reference ps::vector<T>::at(size_type pos) const {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::const_reference
+ps::vector<T, Allocator, Growth>::at(size_type pos) const {
   if (pos >= size_) {
     throw std::out_of_range("Out of range");
   }
   return data_[pos];
 }
 
-template <class T>
-typename ps::vector<T>::const_reference ps::vector<T>::front() {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::const_reference
+ps::vector<T, Allocator, Growth>::front() {
   return data_[0];
 }
 
-template <class T>
-typename ps::vector<T>::const_reference ps::vector<T>::front() const {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::const_reference
+ps::vector<T, Allocator, Growth>::front() const {
   return data_[0];
 }
 
-template <class T>
-typename ps::vector<T>::const_reference ps::vector<T>::back() {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::const_reference
+ps::vector<T, Allocator, Growth>::back() {
   return data_[size_ - 1];
 }
 
-template <class T>
-typename ps::vector<T>::const_reference ps::vector<T>::back() const {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::const_reference
+ps::vector<T, Allocator, Growth>::back() const {
   return data_[size_ - 1];
 }
 
-template <class T>
-typename ps::vector<T>::iterator ps::vector<T>::data() noexcept {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::iterator
+ps::vector<T, Allocator, Growth>::data() noexcept {
   return data_;
 }
 
-template <class T>
-typename ps::vector<T>::const_iterator ps::vector<T>::data() const noexcept {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::const_iterator
+ps::vector<T, Allocator, Growth>::data() const noexcept {
   return data_;
 }
 
-template <class T>
-typename ps::vector<T>::iterator ps::vector<T>::begin() noexcept {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::iterator
+ps::vector<T, Allocator, Growth>::begin() noexcept {
   return data_;
 }
 
-template <class T>
-typename ps::vector<T>::const_iterator ps::vector<T>::begin() const noexcept {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::const_iterator
+ps::vector<T, Allocator, Growth>::begin() const noexcept {
   return data_;
 }
 
-template <class T>
-typename ps::vector<T>::const_iterator ps::vector<T>::cbegin() const noexcept {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::const_iterator
+ps::vector<T, Allocator, Growth>::cbegin() const noexcept {
   return data_;
 }
 
-template <class T>
-typename ps::vector<T>::iterator ps::vector<T>::end() noexcept {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::iterator
+ps::vector<T, Allocator, Growth>::end() noexcept {
   return data_ + size_;
 }
 
-template <class T>
-typename ps::vector<T>::const_iterator ps::vector<T>::end() const noexcept {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::const_iterator
+ps::vector<T, Allocator, Growth>::end() const noexcept {
   return data_ + size_;
 }
 
-template <class T>
-typename ps::vector<T>::const_iterator ps::vector<T>::cend() const noexcept {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::const_iterator
+ps::vector<T, Allocator, Growth>::cend() const noexcept {
   return data_ + size_;
 }
 
-template <class T>
-bool ps::vector<T>::empty() const noexcept {
+template <class T, class Allocator, class Growth>
+bool ps::vector<T, Allocator, Growth>::empty() const noexcept {
   return size_ == 0;
 }
 
-template <class T>
-typename ps::vector<T>::size_type ps::vector<T>::size() const noexcept {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::size_type
+ps::vector<T, Allocator, Growth>::size()
+    const noexcept {
   return size_;
 }
 
-template <class T>
-typename ps::vector<T>::size_type ps::vector<T>::max_size() const noexcept {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::size_type
+ps::vector<T, Allocator, Growth>::max_size() const noexcept {
   return std::numeric_limits<size_type>::max() / sizeof(value_type);
 }
 
-template <class T>
-void ps::vector<T>::reserve(size_type new_cap) {
+template <class T, class Allocator, class Growth>
+void ps::vector<T, Allocator, Growth>::reserve(size_type new_cap) {
   if (new_cap > max_size()) {
     throw std::length_error("Length error");
   }
   if (new_cap > capacity_) {
-    T* tmp = new T[new_cap];
-    std::copy(begin(), end(), tmp);
-    delete[] data_;
-    data_ = tmp;
-    capacity_ = new_cap;
+    reallocate(new_cap);
   }
 }
 
-template <class T>
-typename ps::vector<T>::size_type ps::vector<T>::capacity() const noexcept {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::size_type
+ps::vector<T, Allocator, Growth>::capacity() const noexcept {
   return capacity_;
 }
 
-template <class T>
-void ps::vector<T>::shrink_to_fit() {
+template <class T, class Allocator, class Growth>
+void ps::vector<T, Allocator, Growth>::shrink_to_fit() {
   if (capacity_ > size_) {
-    T* tmp = new T[size_];
-    std::copy(begin(), end(), tmp);
-    delete[] data_;
-    data_ = tmp;
-    capacity_ = size_;
+    reallocate(size_);
   }
 }
 
-template <class T>
-void ps::vector<T>::clear() noexcept {
+template <class T, class Allocator, class Growth>
+void ps::vector<T, Allocator, Growth>::clear() noexcept {
+  destroy(data_, data_ + size_);
   size_ = 0;
 }
 
-template <class T>
-typename ps::vector<T>::iterator ps::vector<T>::insert(const_iterator pos,
-                                                       const T& value) {
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::iterator
+ps::vector<T, Allocator, Growth>::insert(const_iterator pos, const T& value) {
+  return emplace(pos, value);
+}
+
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::iterator
+ps::vector<T, Allocator, Growth>::insert(const_iterator pos, T&& value) {
+  return emplace(pos, std::move(value));
+}
+
+/**
+ * Constructs an element in front of pos. Without room, the element is
+ * constructed in the new storage first and the old elements are relocated
+ * around it; otherwise the tail is moved up by one.
+ */
+template <class T, class Allocator, class Growth>
+template <class... Args>
+typename ps::vector<T, Allocator, Growth>::iterator
+ps::vector<T, Allocator, Growth>::emplace(const_iterator pos, Args&&... args) {
   size_type index = size_type(pos - begin());
   if (index > size_) {
     throw std::out_of_range("Out of range");
   }
-  if (capacity_ == size_) {
-    reserve(capacity_ * 2);
-  }
-  value_type tmp = value;
-  for (size_type i = index; i <= size_; ++i) {
-    value_type item = *(data_ + i);
-    *(data_ + i) = tmp;
-    tmp = item;
+  if (size_ == capacity_) {
+    reallocateEmplace(index, std::forward<Args>(args)...);
+  } else if (index == size_) {
+    construct(data_ + size_, std::forward<Args>(args)...);
+    ++size_;
+  } else {
+    // args may refer to an element that is about to move.
+    T value(std::forward<Args>(args)...);
+    if constexpr (kBitwiseRelocate) {
+      shiftTail(index, 1);
+      construct(data_ + index, std::move(value));
+    } else {
+      construct(data_ + size_, std::move(data_[size_ - 1]));
+      std::move_backward(data_ + index, data_ + size_ - 1, data_ + size_);
+      data_[index] = std::move(value);
+    }
+    ++size_;
   }
-  ++size_;
   return begin() + index;
 }
 
-template <class T>
-typename ps::vector<T>::iterator ps::vector<T>::erase(const_iterator pos) {
+/**
+ * Inserts [first, last) in front of pos, growing the storage at most once
+ * and moving the tail once. Input iterators that cannot be walked twice
+ * are read into a temporary vector first.
+ */
+template <class T, class Allocator, class Growth>
+template <class InputIt, class>
+typename ps::vector<T, Allocator, Growth>::iterator
+ps::vector<T, Allocator, Growth>::insert(
+    const_iterator pos, InputIt first, InputIt last) {
   size_type index = size_type(pos - begin());
-  if (index >= size_) {
+  if (index > size_) {
+    throw std::out_of_range("Out of range");
+  }
+  using category = typename std::iterator_traits<InputIt>::iterator_category;
+  if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+    insertRange(index, first, size_type(std::distance(first, last)));
+  } else {
+    vector buffer(allocator_);
+    for (; first != last; ++first) {
+      buffer.emplace_back(*first);
+    }
+    insertRange(index, std::make_move_iterator(buffer.begin()),
+                buffer.size_);
+  }
+  return begin() + index;
+}
+
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::iterator
+ps::vector<T, Allocator, Growth>::erase(const_iterator pos) {
+  if (pos >= cend()) {
     return end();
   }
-  std::copy(begin(), const_cast<iterator>(pos), data_);
-  std::copy(const_cast<iterator>(pos + 1), end(), data_ + index);
-  --size_;
+  return erase(pos, pos + 1);
+}
+
+/**
+ * Moves the tail down over [first, last) in one pass, or with one memmove
+ * for trivially copyable elements, and destroys what is left at the end.
+ */
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::iterator
+ps::vector<T, Allocator, Growth>::erase(
+    const_iterator first, const_iterator last) {
+  size_type index = size_type(first - begin());
+  size_type count = size_type(last - first);
+  if (count > 0) {
+    if constexpr (kBitwiseRelocate) {
+      std::memmove(static_cast<void*>(data_ + index), data_ + index + count,
+                   (size_ - index - count) * sizeof(T));
+    } else {
+      std::move(data_ + index + count, data_ + size_, data_ + index);
+      destroy(data_ + size_ - count, data_ + size_);
+    }
+    size_ -= count;
+  }
   return begin() + index;
 }
 
-template <class T>
-void ps::vector<T>::push_back(const_reference value) {
-  if (capacity_ == size_) {
-    reserve(capacity_ * 2);
-    if (capacity_ == 0) reserve(1);
+template <class T, class Allocator, class Growth>
+void ps::vector<T, Allocator, Growth>::push_back(const_reference value) {
+  emplace_back(value);
+}
+
+template <class T, class Allocator, class Growth>
+void ps::vector<T, Allocator, Growth>::push_back(T&& value) {
+  emplace_back(std::move(value));
+}
+
+template <class T, class Allocator, class Growth>
+template <class... Args>
+typename ps::vector<T, Allocator, Growth>::reference
+ps::vector<T, Allocator, Growth>::emplace_back(Args&&... args) {
+  if (size_ == capacity_) {
+    reallocateEmplace(size_, std::forward<Args>(args)...);
+  } else {
+    construct(data_ + size_, std::forward<Args>(args)...);
+    ++size_;
   }
-  data_[size_] = value;
-  ++size_;
+  return data_[size_ - 1];
 }
 
-template <class T>
-void ps::vector<T>::pop_back() {
-  erase(end() - 1);
+template <class T, class Allocator, class Growth>
+void ps::vector<T, Allocator, Growth>::pop_back() {
+  if (size_ > 0) {
+    --size_;
+    alloc_traits::destroy(allocator_, data_ + size_);
+  }
 }
 
-template <class T>
-void ps::vector<T>::swap(vector& other) noexcept {
+/**
+ * Swaps the allocators only if they propagate on swap; otherwise they must
+ * compare equal, as for the standard containers.
+ */
+template <class T, class Allocator, class Growth>
+void ps::vector<T, Allocator, Growth>::swap(vector& other) noexcept {
+  if constexpr (alloc_traits::propagate_on_container_swap::value) {
+    std::swap(allocator_, other.allocator_);
+  }
   std::swap(data_, other.data_);
   std::swap(size_, other.size_);
   std::swap(capacity_, other.capacity_);
 }
 
-template <class T>
+/**
+ * Inserts the arguments in front of pos with one growth and one shift.
+ * As if each were inserted at pos in turn, they end up in reverse order.
+ */
+template <class T, class Allocator, class Growth>
 template <class... Args>
-typename ps::vector<T>::iterator ps::vector<T>::insert_many(const_iterator pos,
-                                                            Args&&... args) {
+typename ps::vector<T, Allocator, Growth>::iterator
+ps::vector<T, Allocator, Growth>::insert_many(const_iterator pos,
+                                              Args&&... args) {
   size_type index = size_type(pos - begin());
-  for (const auto& arg : {args...}) {
-    insert(begin() + index, arg);
+  if (index > size_) {
+    throw std::out_of_range("Out of range");
+  }
+  if constexpr (sizeof...(Args) > 0) {
+    // Built before anything moves, as args may refer to elements.
+    T items[] = {T(std::forward<Args>(args))...};
+    insertRange(index,
+                std::make_move_iterator(std::rbegin(items)),
+                sizeof...(Args));
   }
   return begin() + index;
 }
 
-template <class T>
+template <class T, class Allocator, class Growth>
 template <class... Args>
-void ps::vector<T>::insert_many_back(Args&&... args) {
-  for (const auto& arg : {args...}) {
-    push_back(arg);
+void ps::vector<T, Allocator, Growth>::insert_many_back(Args&&... args) {
+  reserve(size_ + sizeof...(Args));
+  (emplace_back(std::forward<Args>(args)), ...);
+}
+
+template <class T, class Allocator, class Growth>
+T* ps::vector<T, Allocator, Growth>::allocate(size_type n) {
+  return n == 0 ? nullptr : alloc_traits::allocate(allocator_, n);
+}
+
+template <class T, class Allocator, class Growth>
+void ps::vector<T, Allocator, Growth>::deallocate(T* data,
+                                                  size_type n) noexcept {
+  if (data) {
+    alloc_traits::deallocate(allocator_, data, n);
+  }
+}
+
+template <class T, class Allocator, class Growth>
+template <class... Args>
+void ps::vector<T, Allocator, Growth>::construct(T* place, Args&&... args) {
+  alloc_traits::construct(allocator_, place, std::forward<Args>(args)...);
+}
+
+/**
+ * Moves the elements into data, a new block of new_cap elements, around
+ * the count elements already constructed at index, and makes it the
+ * storage. Trivially copyable types are copied as bytes. Otherwise the old
+ * elements are destroyed only once every element is in place; if a copy
+ * throws, data is destroyed and freed and this vector is left unchanged.
+ */
+template <class T, class Allocator, class Growth>
+void ps::vector<T, Allocator, Growth>::relocateTo(T* data, size_type new_cap,
+                                                  size_type index,
+                                                  size_type count) {
+  if constexpr (kBitwiseRelocate) {
+    if (size_ > 0) {
+      std::memcpy(static_cast<void*>(data), data_, index * sizeof(T));
+      std::memcpy(static_cast<void*>(data + index + count), data_ + index,
+                  (size_ - index) * sizeof(T));
+    }
+  } else {
+    size_type built = 0;
+    try {
+      for (; built < index; ++built) {
+        construct(data + built, std::move_if_noexcept(data_[built]));
+      }
+      for (; built < size_; ++built) {
+        construct(data + built + count, std::move_if_noexcept(data_[built]));
+      }
+    } catch (...) {
+      destroy(data, data + std::min(built, index));
+      destroy(data + index, data + std::max(built, index) + count);
+      deallocate(data, new_cap);
+      throw;
+    }
+    destroy(data_, data_ + size_);
+  }
+  deallocate(data_, capacity_);
+  data_ = data;
+  capacity_ = new_cap;
+  size_ += count;
+}
+
+template <class T, class Allocator, class Growth>
+void ps::vector<T, Allocator, Growth>::destroy(T* first, T* last) noexcept {
+  if constexpr (!kBitwiseRelocate || !std::is_trivially_destructible_v<T>) {
+    for (; first != last; ++first) {
+      alloc_traits::destroy(allocator_, first);
+    }
+  }
+}
+
+/** Destroys the elements and frees the storage. */
+template <class T, class Allocator, class Growth>
+void ps::vector<T, Allocator, Growth>::release() noexcept {
+  destroy(data_, data_ + size_);
+  deallocate(data_, capacity_);
+  data_ = nullptr;
+  size_ = 0;
+  capacity_ = 0;
+}
+
+/** Takes other's storage; the allocators must be able to free each other's. */
+template <class T, class Allocator, class Growth>
+void ps::vector<T, Allocator, Growth>::steal(vector& other) noexcept {
+  size_ = std::exchange(other.size_, 0);
+  capacity_ = std::exchange(other.capacity_, 0);
+  data_ = std::exchange(other.data_, nullptr);
+}
+
+/** Copy- or move-constructs the n elements of [first, last) at the end. */
+template <class T, class Allocator, class Growth>
+template <class InputIt>
+void ps::vector<T, Allocator, Growth>::append(InputIt first, InputIt last,
+                                              size_type n) {
+  reserve(size_ + n);
+  for (; first != last; ++first) {
+    construct(data_ + size_, *first);
+    ++size_;
+  }
+}
+
+/**
+ * Constructs count elements from first in front of index. Without room,
+ * they are constructed in new storage and the old elements relocated
+ * around them. Otherwise a trivially copyable tail is moved up with one
+ * memmove, as long as the new elements cannot throw while it is open, and
+ * any other tail is moved up by count in one pass, the part that lands
+ * past the old end being move-constructed there.
+ */
+template <class T, class Allocator, class Growth>
+template <class ForwardIt>
+void ps::vector<T, Allocator, Growth>::insertRange(size_type index,
+                                                   ForwardIt first,
+                                                   size_type count) {
+  if (count == 0) {
+    return;
+  }
+  if (count > max_size() - size_) {
+    throw std::length_error("Length error");
+  }
+  if (size_ + count > capacity_ && kReallocates) {
+    reallocate(std::max(grownCapacity(), size_ + count));
+  }
+  if (size_ + count > capacity_) {
+    size_type new_cap = std::max(grownCapacity(), size_ + count);
+    T* data = allocate(new_cap);
+    size_type built = 0;
+    try {
+      for (; built < count; ++built, ++first) {
+        construct(data + index + built, *first);
+      }
+    } catch (...) {
+      destroy(data + index, data + index + built);
+      deallocate(data, new_cap);
+      throw;
+    }
+    relocateTo(data, new_cap, index, count);
+  } else if constexpr (kBitwiseRelocate &&
+                       std::is_nothrow_constructible_v<
+                           T, typename std::iterator_traits<
+                                  ForwardIt>::reference>) {
+    shiftTail(index, count);
+    for (size_type i = 0; i < count; ++i, ++first) {
+      construct(data_ + index + i, *first);
+    }
+    size_ += count;
+  } else {
+    T* pos = data_ + index;
+    T* old_end = data_ + size_;
+    size_type after = size_ - index;
+    if (after > count) {
+      for (T* from = old_end - count; from != old_end; ++from) {
+        construct(data_ + size_, std::move(*from));
+        ++size_;
+      }
+      std::move_backward(pos, old_end - count, old_end);
+      std::copy_n(first, count, pos);
+    } else {
+      ForwardIt mid = std::next(
+          first,
+          typename std::iterator_traits<ForwardIt>::difference_type(after));
+      for (ForwardIt it = mid; size_ < index + count; ++it) {
+        construct(data_ + size_, *it);
+        ++size_;
+      }
+      for (T* from = pos; from != old_end; ++from) {
+        construct(data_ + size_, std::move(*from));
+        ++size_;
+      }
+      std::copy(first, mid, pos);
+    }
+  }
+}
+
+/**
+ * Moves the trivially copyable elements from index on up by count with
+ * one memmove. The count slots at index are then left uninitialized.
+ */
+template <class T, class Allocator, class Growth>
+void ps::vector<T, Allocator, Growth>::shiftTail(size_type index,
+                                                 size_type count) {
+  std::memmove(static_cast<void*>(data_ + index + count), data_ + index,
+               (size_ - index) * sizeof(T));
+}
+
+template <class T, class Allocator, class Growth>
+typename ps::vector<T, Allocator, Growth>::size_type
+ps::vector<T, Allocator, Growth>::grownCapacity() const {
+  // At least one more, whatever the policy, and never past max_size().
+  size_type grown = std::max(Growth()(capacity_), capacity_ + 1);
+  return std::min(grown, max_size());
+}
+
+template <class T, class Allocator, class Growth>
+void ps::vector<T, Allocator, Growth>::reallocate(size_type new_cap) {
+  if constexpr (kReallocates) {
+    if (data_ != nullptr && new_cap != 0) {
+      data_ = allocator_.reallocate(data_, capacity_, new_cap);
+      capacity_ = new_cap;
+      return;
+    }
+  }
+  relocateTo(allocate(new_cap), new_cap, size_, 0);
+}
+
+template <class T, class Allocator, class Growth>
+template <class... Args>
+void ps::vector<T, Allocator, Growth>::reallocateEmplace(size_type index,
+                                                         Args&&... args) {
+  if constexpr (kReallocates) {
+    // args are read before the block may move.
+    T value(std::forward<Args>(args)...);
+    reallocate(grownCapacity());
+    shiftTail(index, 1);
+    construct(data_ + index, std::move(value));
+    ++size_;
+    return;
+  }
+  size_type new_cap = grownCapacity();
+  T* data = allocate(new_cap);
+  // Constructed before anything moves, as args may refer to an element.
+  try {
+    construct(data + index, std::forward<Args>(args)...);
+  } catch (...) {
+    deallocate(data, new_cap);
+    throw;
   }
+  relocateTo(data, new_cap, index, 1);
 }
 
-#endif  // CONTAINERS_SRC_PS_VECTOR_H_
\ No newline at end of file
+#endif  // CONTAINERS_SRC_PS_VECTOR_H_
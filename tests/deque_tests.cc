@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 
 #include <deque>
+#include <memory_resource>
+#include <string>
 
 #include "../src/ps_deque.h"
 
@@ -162,4 +164,100 @@ TEST(SwapFunctionTestDeque, Test_1) {
   ASSERT_EQ(deq1.size(), deq3.size());
   ASSERT_EQ(deq1.back(), deq3.back());
   ASSERT_EQ(deq1.front(), deq3.front());
-}
\ No newline at end of file
+}
+
+TEST(IndexFunctionTestDeque, Test_1) {
+  ps::deque<int> deq1{1, 2, 3};
+  deq1.push_front(0);
+  ASSERT_EQ(deq1[0], 0);
+  ASSERT_EQ(deq1.at(3), 3);
+  deq1[1] = 10;
+  ASSERT_EQ(deq1.at(1), 10);
+  ASSERT_THROW(deq1.at(4), std::out_of_range);
+}
+
+TEST(IteratorTestDeque, Test_1) {
+  ps::deque<int> deq1;
+  for (int i = 0; i < 1000; i++) {
+    deq1.push_back(i);
+  }
+  int expected = 0;
+  for (auto it = deq1.begin(); it != deq1.end(); ++it) {
+    ASSERT_EQ(*it, expected++);
+  }
+  const ps::deque<int>& const_deq = deq1;
+  ASSERT_EQ(const_deq.end() - const_deq.begin(), 1000);
+  ASSERT_EQ(*(const_deq.begin() + 500), 500);
+  ASSERT_EQ(deq1.begin()[999], 999);
+}
+
+// Pushes on both ends, with the ring wrapped when it grows, against
+// std::deque.
+TEST(MixedPushPopTestDeque, Test_1) {
+  ps::deque<std::string> deq1;
+  std::deque<std::string> deq2;
+  for (int i = 0; i < 20000; i++) {
+    std::string value = std::to_string(i);
+    switch (i % 7) {
+      case 0:
+      case 1:
+        deq1.push_front(value);
+        deq2.push_front(value);
+        break;
+      case 2:
+        deq1.pop_back();
+        deq2.pop_back();
+        break;
+      case 3:
+        deq1.pop_front();
+        deq2.pop_front();
+        break;
+      default:
+        deq1.push_back(value);
+        deq2.push_back(value);
+    }
+  }
+  ASSERT_EQ(deq1.size(), deq2.size());
+  for (size_t i = 0; i < deq2.size(); i++) {
+    ASSERT_EQ(deq1[i], deq2[i]);
+  }
+  ps::deque<std::string> copy(deq1);
+  ASSERT_EQ(copy.front(), deq2.front());
+  ASSERT_EQ(copy.back(), deq2.back());
+}
+
+TEST(ShrinkToFitTestDeque, Test_1) {
+  ps::deque<int> deq1;
+  for (int i = 0; i < 10000; i++) {
+    deq1.push_back(i);
+  }
+  size_t capacity = deq1.capacity();
+  for (int i = 0; i < 9990; i++) {
+    deq1.pop_front();
+  }
+  deq1.shrink_to_fit();
+  ASSERT_EQ(deq1.capacity(), capacity);
+  for (int i = 0; i < 10000; i++) {
+    deq1.push_back(i);
+    deq1.pop_front();
+  }
+  ASSERT_EQ(deq1.size(), 10);
+  ASSERT_EQ(deq1.front(), 9990);
+  ASSERT_EQ(deq1.capacity(), capacity);
+}
+
+TEST(AllocatorDeque, Test_1) {
+  alignas(int) char buffer[16384];
+  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                            std::pmr::null_memory_resource());
+  ps::pmr::deque<int> deq(&arena);
+  for (int i = 0; i < 1000; ++i) {
+    deq.push_back(i);
+    deq.push_front(-i);
+  }
+  ASSERT_EQ(deq.get_allocator().resource(), &arena);
+  ASSERT_GE(&deq.front(), reinterpret_cast<int*>(buffer));
+  ASSERT_LT(&deq.back(), reinterpret_cast<int*>(buffer + sizeof(buffer)));
+  ASSERT_EQ(deq.front(), -999);
+  ASSERT_EQ(deq.back(), 999);
+}
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <type_traits>
+
+#include "../src/ps_flat_map.h"
+
+using namespace ps;
+
+TEST(flatMapConstructors, constructors) {
+  flat_map<int, std::string> empty_map;
+  ASSERT_TRUE(empty_map.empty());
+  ASSERT_TRUE(empty_map.begin() == empty_map.end());
+
+  flat_map<int, std::string> my_map{{3, "c"}, {1, "a"}, {2, "b"}, {1, "x"}};
+  ASSERT_EQ(my_map.size(), 3);
+  ASSERT_EQ(my_map.at(1), "a");
+  ASSERT_EQ(my_map.keys()[0], 1);
+  ASSERT_EQ(my_map.values()[2], "c");
+  flat_map<int, std::string> copy_map(my_map);
+  copy_map.erase(1);
+  ASSERT_TRUE(my_map.contains(1));
+  flat_map<int, std::string> moved_map(std::move(copy_map));
+  ASSERT_EQ(moved_map.size(), 2);
+}
+
+TEST(flatMapAccess, at_and_subscript) {
+  flat_map<std::string, int> my_map;
+  my_map["b"] = 2;
+  my_map["a"] = 1;
+  my_map["b"] += 10;
+  ASSERT_EQ(my_map.at("b"), 12);
+  ASSERT_THROW(my_map.at("c"), std::out_of_range);
+  const auto &const_map = my_map;
+  ASSERT_EQ(const_map.find("a")->second, 1);
+  ASSERT_TRUE(const_map.find("z") == const_map.end());
+  auto it = my_map.begin();
+  ASSERT_EQ((*it).first, "a");
+  it->second = 5;
+  ASSERT_EQ(my_map.at("a"), 5);
+  ASSERT_EQ((++it)->first, "b");
+}
+
+template <bool Eytzinger>
+void check_against_std() {
+  srand(11);
+  flat_map<int, int, std::less<>, std::allocator<std::pair<const int, int>>,
+           Eytzinger>
+      my_map;
+  std::map<int, int> std_map;
+  for (int i = 0; i < 3000; i++) {
+    int key = rand() % 500;
+    if (rand() % 3 == 0) {
+      ASSERT_EQ(my_map.erase(key), std_map.erase(key));
+    } else {
+      ASSERT_EQ(my_map.insert(key, i).second,
+                std_map.insert({key, i}).second);
+    }
+    int probe = rand() % 520 - 10;
+    ASSERT_EQ(my_map.contains(probe), std_map.count(probe) == 1);
+  }
+  ASSERT_EQ(my_map.size(), std_map.size());
+  auto std_it = std_map.begin();
+  for (auto it = my_map.begin(); it != my_map.end(); ++it, ++std_it) {
+    ASSERT_EQ(it->first, std_it->first);
+    ASSERT_EQ(it->second, std_it->second);
+  }
+}
+
+TEST(flatMapModifiers, matches_std_binary_search) {
+  check_against_std<false>();
+}
+
+TEST(flatMapModifiers, matches_std_eytzinger) { check_against_std<true>(); }
+
+TEST(flatMapLookup, eytzinger_finds_every_key) {
+  // Sizes around powers of two, where the implicit tree is full or has a
+  // single node on its last level.
+  for (int n : {1, 2, 3, 7, 8, 9, 15, 16, 17, 100}) {
+    eytzinger_flat_map<int, int> my_map;
+    for (int i = 0; i < n; i++) {
+      my_map.insert(2 * i, i);
+    }
+    for (int i = -1; i <= 2 * n; i++) {
+      auto it = my_map.find(i);
+      if (i >= 0 && i % 2 == 0 && i < 2 * n) {
+        ASSERT_EQ(it->second, i / 2);
+      } else {
+        ASSERT_TRUE(it == my_map.end());
+      }
+    }
+  }
+}
+
+TEST(flatMapModifiers, insert_or_assign) {
+  flat_map<int, int> my_map{{1, 1}};
+  ASSERT_FALSE(my_map.insert_or_assign(1, 7).second);
+  ASSERT_TRUE(my_map.insert_or_assign(2, 8).second);
+  ASSERT_EQ(my_map.at(1), 7);
+  ASSERT_FALSE(my_map.try_emplace(2, 9).second);
+  ASSERT_EQ(my_map.at(2), 8);
+}
+
+TEST(flatMapModifiers, merge_and_insert_many) {
+  flat_map<int, char> a{{1, 'a'}, {2, 'b'}};
+  flat_map<int, char> b{{2, 'x'}, {3, 'c'}};
+  a.merge(b);
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_EQ(a.at(2), 'b');
+  ASSERT_EQ(b.size(), 1);
+  ASSERT_EQ(b.at(2), 'x');
+
+  auto result = a.insert_many(std::pair<int, char>{5, 'e'},
+                              std::pair<int, char>{3, 'z'},
+                              std::pair<int, char>{4, 'd'},
+                              std::pair<int, char>{5, 'y'});
+  ASSERT_TRUE(result[0].second);
+  ASSERT_FALSE(result[1].second);
+  ASSERT_EQ(result[1].first->second, 'c');
+  ASSERT_TRUE(result[2].second);
+  ASSERT_FALSE(result[3].second);
+  ASSERT_EQ(result[3].first->second, 'e');
+  ASSERT_EQ(a.size(), 5);
+  int expected = 1;
+  for (auto it = a.begin(); it != a.end(); ++it) {
+    ASSERT_EQ(it->first, expected++);
+  }
+  a.erase(a.find(4));
+  ASSERT_FALSE(a.contains(4));
+}
+
+// Existing elements are moved, not copied, when new ones are merged in.
+TEST(flatMapModifiers, merges_move_existing_elements) {
+  flat_map<int, std::unique_ptr<int>> a;
+  flat_map<int, std::unique_ptr<int>> b;
+  a.try_emplace(1, std::make_unique<int>(1));
+  b.try_emplace(2, std::make_unique<int>(2));
+  b.try_emplace(1, std::make_unique<int>(3));
+  a.merge(b);
+  ASSERT_EQ(*a.at(2), 2);
+  ASSERT_EQ(*b.at(1), 3);
+
+  flat_map<int, std::string> my_map{{1, std::string(100, 'x')}};
+  const char *buffer = my_map.at(1).data();
+  my_map.insert_many(std::pair<int, std::string>{0, "a"},
+                     std::pair<int, std::string>{2, "b"});
+  ASSERT_EQ(my_map.at(1).data(), buffer);
+}
+
+TEST(flatMapIterators, work_with_standard_algorithms) {
+  using traits = std::iterator_traits<flat_map<int, std::string>::iterator>;
+  static_assert(std::is_same_v<traits::iterator_category,
+                               std::bidirectional_iterator_tag>);
+  static_assert(std::is_same_v<traits::value_type,
+                               std::pair<const int, std::string>>);
+  flat_map<int, std::string> my_map{{1, "a"}, {2, "b"}, {3, "c"}};
+  ASSERT_EQ(std::distance(my_map.begin(), my_map.end()), 3);
+  auto it = std::find_if(my_map.begin(), my_map.end(),
+                         [](const auto &kv) { return kv.second == "b"; });
+  ASSERT_EQ(it->first, 2);
+  ASSERT_EQ(std::prev(my_map.cend())->first, 3);
+  ASSERT_EQ(std::count_if(my_map.cbegin(), my_map.cend(),
+                          [](const auto &kv) { return kv.first > 1; }),
+            2);
+}
+
+TEST(flatMapAllocator, pmr_flat_map_takes_storage_from_arena) {
+  alignas(std::max_align_t) char buffer[65536];
+  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                            std::pmr::null_memory_resource());
+  pmr::flat_map<int, int> my_map(&arena);
+  for (int i = 0; i < 100; i++) {
+    my_map.insert(i, i * 2);
+  }
+  pmr::flat_map<int, int> other({{100, 200}, {50, 0}}, &arena);
+  my_map.merge(other);
+  ASSERT_EQ(my_map.get_allocator().resource(), &arena);
+  auto *key = reinterpret_cast<const char *>(my_map.keys().data());
+  auto *value = reinterpret_cast<const char *>(&my_map.at(50));
+  ASSERT_TRUE(key >= buffer && key < buffer + sizeof(buffer));
+  ASSERT_TRUE(value >= buffer && value < buffer + sizeof(buffer));
+  ASSERT_EQ(my_map.at(100), 200);
+  ASSERT_EQ(my_map.size(), 101);
+  ASSERT_EQ(other.size(), 1);
+}
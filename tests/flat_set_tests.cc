@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include <cstddef>
+#include <memory_resource>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../src/ps_flat_set.h"
+
+using namespace ps;
+
+TEST(flatSetConstructors, constructors) {
+  flat_set<int> empty_set;
+  ASSERT_TRUE(empty_set.empty());
+  ASSERT_TRUE(empty_set.begin() == empty_set.end());
+
+  flat_set<int> my_set{3, 1, 2, 1};
+  ASSERT_EQ(my_set.size(), 3);
+  ASSERT_EQ(*my_set.begin(), 1);
+  flat_set<int> copy_set(my_set);
+  copy_set.erase(1);
+  ASSERT_TRUE(my_set.contains(1));
+  flat_set<int> moved_set(std::move(copy_set));
+  ASSERT_EQ(moved_set.size(), 2);
+}
+
+TEST(flatSetModifiers, matches_std_under_churn) {
+  srand(5);
+  eytzinger_flat_set<std::string> my_set;
+  std::set<std::string> std_set;
+  for (int i = 0; i < 5000; i++) {
+    std::string key = std::to_string(rand() % 700);
+    if (rand() % 3 == 0) {
+      ASSERT_EQ(my_set.erase(key), std_set.erase(key));
+    } else {
+      ASSERT_EQ(my_set.insert(key).second, std_set.insert(key).second);
+    }
+    ASSERT_EQ(my_set.contains(key), std_set.count(key) == 1);
+  }
+  ASSERT_EQ(my_set.size(), std_set.size());
+  auto std_it = std_set.begin();
+  for (auto it = my_set.begin(); it != my_set.end(); ++it, ++std_it) {
+    ASSERT_EQ(*it, *std_it);
+  }
+}
+
+TEST(flatSetModifiers, merge_and_insert_many) {
+  flat_set<int> a{1, 2};
+  flat_set<int> b{2, 3};
+  a.merge(b);
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_EQ(b.size(), 1);
+  ASSERT_TRUE(b.contains(2));
+
+  auto result = a.insert_many(3, 5, 4, 5);
+  ASSERT_FALSE(result[0].second);
+  ASSERT_TRUE(result[1].second);
+  ASSERT_EQ(*result[2].first, 4);
+  ASSERT_FALSE(result[3].second);
+  ASSERT_EQ(a.size(), 5);
+  a.erase(a.find(4));
+  ASSERT_FALSE(a.contains(4));
+}
+
+TEST(flatSetModifiers, range_insert) {
+  std::vector<int> items{9, 3, 7, 3, 1};
+  flat_set<int> my_set{7, 8};
+  my_set.insert(items.begin(), items.end());
+  int expected[] = {1, 3, 7, 8, 9};
+  ASSERT_EQ(my_set.size(), 5);
+  for (size_t i = 0; i < my_set.size(); i++) {
+    ASSERT_EQ(my_set.keys()[i], expected[i]);
+  }
+}
+
+TEST(flatSetAllocator, pmr_eytzinger_flat_set_takes_storage_from_arena) {
+  alignas(std::max_align_t) char buffer[65536];
+  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                            std::pmr::null_memory_resource());
+  eytzinger_flat_set<int, std::less<>, std::pmr::polymorphic_allocator<int>>
+      my_set(&arena);
+  for (int i = 0; i < 100; i++) {
+    my_set.insert(i);
+  }
+  auto *key = reinterpret_cast<const char *>(my_set.keys().data());
+  ASSERT_TRUE(key >= buffer && key < buffer + sizeof(buffer));
+  ASSERT_EQ(my_set.get_allocator().resource(), &arena);
+  ASSERT_TRUE(my_set.contains(99));
+  ASSERT_EQ(my_set.size(), 100);
+
+  pmr::flat_set<std::pmr::string> strings(&arena);
+  strings.insert(std::pmr::string(100, 'x'));
+  auto *chars = strings.begin()->data();
+  ASSERT_TRUE(chars >= buffer && chars < buffer + sizeof(buffer));
+}
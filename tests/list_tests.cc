@@ -1,8 +1,11 @@
 #include <gtest/gtest.h>
 
 #include <list>
+#include <memory_resource>
+#include <string>
 
 #include "../src/ps_list.h"
+#include "../src/ps_pool_allocator.h"
 
 // Constructor tests
 
@@ -598,4 +601,235 @@ TEST(InsertManyFrontFunctionList, Test_1) {
     ++iter;
     ++i;
   }
-}
\ No newline at end of file
+}
+// Moving between lists on different resources copies the values over, as
+// neither can free the other's nodes.
+TEST(AllocatorList, Test_1) {
+  std::pmr::monotonic_buffer_resource first;
+  std::pmr::monotonic_buffer_resource second;
+  ps::pmr::list<int> lst1(&first);
+  ps::pmr::list<int> lst2(&second);
+  lst1.push_back(1);
+  lst1.push_back(2);
+  lst2 = std::move(lst1);
+  ASSERT_EQ(lst2.get_allocator().resource(), &second);
+  ASSERT_EQ(lst2.size(), 2);
+  ASSERT_EQ(lst2.back(), 2);
+  ASSERT_TRUE(lst1.empty());
+  ps::pmr::list<int> lst3(std::move(lst2));
+  ASSERT_EQ(lst3.get_allocator().resource(), &second);
+  ASSERT_EQ(lst3.front(), 1);
+}
+
+// Nodes come from the list's own arena, and a freed node is the next one
+// handed out. Moves and swaps take the arena along with the nodes.
+TEST(AllocatorList, Test_pool) {
+  ps::list<int, ps::pool_allocator<int>> lst1 = {1, 2, 3};
+  const int* freed = &lst1.back();
+  lst1.pop_back();
+  lst1.push_front(0);
+  ASSERT_EQ(&lst1.front(), freed);
+
+  ps::list<int, ps::pool_allocator<int>> lst2;
+  lst2.push_back(4);
+  ASSERT_FALSE(lst1.get_allocator() == lst2.get_allocator());
+  auto arena = lst1.get_allocator().arena();
+  lst2 = std::move(lst1);
+  ASSERT_EQ(lst2.get_allocator().arena(), arena);
+  ASSERT_EQ(lst2.size(), 3);
+  ASSERT_EQ(&lst2.front(), freed);
+
+  ps::list<int, ps::pool_allocator<int>> lst3(lst2.get_allocator());
+  lst3.push_back(5);
+  lst3.swap(lst1);
+  ASSERT_EQ(lst1.get_allocator().arena(), arena);
+  lst2.splice(lst2.cend(), lst1);
+  ASSERT_EQ(lst2.size(), 4);
+  ASSERT_EQ(lst2.back(), 5);
+  lst2.sort(std::greater<>());
+  ASSERT_EQ(lst2.front(), 5);
+  ASSERT_EQ(lst2.back(), 0);
+}
+
+// Lists on different arenas cannot free each other's nodes, so splicing and
+// merging between them move the values and leave the nodes where they are.
+TEST(AllocatorList, Test_pool_different_arenas) {
+  ps::list<std::string, ps::pool_allocator<std::string>> lst1 = {"b", "d"};
+  {
+    ps::list<std::string, ps::pool_allocator<std::string>> lst2 = {"a", "c"};
+    ASSERT_FALSE(lst1.get_allocator() == lst2.get_allocator());
+    lst1.splice(lst1.cbegin(), lst2);
+    ASSERT_TRUE(lst2.empty());
+  }
+  ASSERT_EQ(lst1.size(), 4);
+  ASSERT_EQ(lst1.front(), "a");
+  ASSERT_EQ(*++lst1.begin(), "c");
+  lst1.sort();
+  {
+    ps::list<std::string, ps::pool_allocator<std::string>> lst3 = {"bb", "e"};
+    lst1.merge(lst3);
+    ASSERT_TRUE(lst3.empty());
+  }
+  std::string expected[] = {"a", "b", "bb", "c", "d", "e"};
+  ASSERT_EQ(lst1.size(), 6);
+  size_t i = 0;
+  for (const auto& value : lst1) {
+    ASSERT_EQ(value, expected[i++]);
+  }
+}
+
+namespace {
+
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  size_t allocations = 0;
+
+ private:
+  void* do_allocate(size_t bytes, size_t align) override {
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, align);
+  }
+  void do_deallocate(void* p, size_t bytes, size_t align) override {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+  }
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+}  // namespace
+
+// The sentinel lives in the list: an empty list allocates nothing, and
+// end() stays valid and reachable through moves and swaps.
+TEST(SentinelList, Test_empty) {
+  ps::pmr::list<int> empty(std::pmr::null_memory_resource());
+  ASSERT_TRUE(empty.begin() == empty.end());
+  empty.unique();
+  empty.reverse();
+  empty.sort();
+  ps::pmr::list<int> moved(std::move(empty));
+  ASSERT_TRUE(moved.begin() == moved.end());
+  moved.clear();
+
+  CountingResource counter;
+  ps::pmr::list<int> lst(&counter);
+  for (int i = 0; i < 100; ++i) {
+    lst.push_back(i);
+    lst.pop_front();
+  }
+  ASSERT_EQ(counter.allocations, 100);
+
+  ps::list<int> lst1 = {1, 2, 3};
+  ps::list<int> lst2;
+  lst1.swap(lst2);
+  ASSERT_TRUE(lst1.begin() == lst1.end());
+  ASSERT_EQ(*--lst2.end(), 3);
+  ASSERT_EQ(*++lst2.end(), 1);
+  lst1 = std::move(lst2);
+  ASSERT_EQ(*--lst1.end(), 3);
+  ASSERT_TRUE(lst2.begin() == lst2.end());
+  lst2.push_back(4);
+  ASSERT_EQ(lst2.front(), 4);
+}
+
+// Positional insert and erase use the node the iterator holds, and return
+// iterators to the new element and to the one after the erased one.
+TEST(InsertFunctionList, Test_positional) {
+  ps::list<int> ps_lst = {1, 5};
+  auto pos = ++ps_lst.cbegin();
+  for (int i = 2; i < 5; ++i) {
+    auto it = ps_lst.insert(pos, i);
+    ASSERT_EQ(*it, i);
+  }
+  auto last = ps_lst.insert(ps_lst.cend(), 6);
+  ASSERT_EQ(*last, 6);
+  auto next = ps_lst.erase(++ps_lst.cbegin());
+  ASSERT_EQ(*next, 3);
+  std::list<int> std_lst = {1, 3, 4, 5, 6};
+  ASSERT_EQ(ps_lst.size(), std_lst.size());
+  auto std_it = std_lst.begin();
+  for (auto it = ps_lst.begin(); it != ps_lst.end(); ++it, ++std_it) {
+    ASSERT_EQ(*it, *std_it);
+  }
+  while (!ps_lst.empty()) {
+    ps_lst.pop_back();
+  }
+  ps_lst.push_front(7);
+  ps_lst.push_back(8);
+  ASSERT_EQ(ps_lst.front(), 7);
+  ASSERT_EQ(ps_lst.back(), 8);
+  ASSERT_EQ(ps_lst.size(), 2);
+}
+
+// splice and merge move the nodes themselves, so the elements keep their
+// addresses.
+TEST(SpliceFunctionList, Test_relinks) {
+  ps::list<int> ps_lst = {1, 4};
+  ps::list<int> ps_lst_other = {2, 3};
+  const int* two = &ps_lst_other.front();
+  ps_lst.splice(++ps_lst.cbegin(), ps_lst_other);
+  ASSERT_TRUE(ps_lst_other.empty());
+  ASSERT_EQ(&*++ps_lst.begin(), two);
+  ASSERT_EQ(ps_lst.size(), 4);
+
+  ps::list<int> odd = {1, 3, 5, 7};
+  ps::list<int> even = {0, 2, 4, 6, 8, 10};
+  const int* ten = &even.back();
+  odd.merge(even);
+  ASSERT_TRUE(even.empty());
+  ASSERT_EQ(odd.size(), 10);
+  ASSERT_EQ(&odd.back(), ten);
+  int expected = 0;
+  for (auto it = odd.begin(); it != odd.end(); ++it) {
+    ASSERT_EQ(*it, expected == 9 ? 10 : expected);
+    ++expected;
+  }
+  even.push_back(1);
+  ASSERT_EQ(even.front(), 1);
+}
+
+// sort relinks nodes: equal keys keep their order and every element keeps
+// its address.
+TEST(SortFunctionList, Test_stable) {
+  ps::list<std::pair<int, int>> ps_lst;
+  std::list<std::pair<int, int>> std_lst;
+  for (int i = 0; i < 1000; ++i) {
+    ps_lst.push_back({(i * 7919) % 10, i});
+    std_lst.push_back({(i * 7919) % 10, i});
+  }
+  const std::pair<int, int>* first = &ps_lst.front();
+  auto by_key = [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+    return a.first < b.first;
+  };
+  ps_lst.sort(by_key);
+  std_lst.sort(by_key);
+  ASSERT_EQ(ps_lst.size(), std_lst.size());
+  auto std_it = std_lst.begin();
+  bool found_first = false;
+  for (auto it = ps_lst.begin(); it != ps_lst.end(); ++it, ++std_it) {
+    ASSERT_EQ(*it, *std_it);
+    found_first = found_first || &*it == first;
+  }
+  ASSERT_TRUE(found_first);
+  ASSERT_EQ(ps_lst.back(), std_lst.back());
+}
+
+TEST(SortFunctionList, Test_sorted_input) {
+  ps::list<int> ps_lst;
+  for (int i = 0; i < 100000; ++i) {
+    ps_lst.push_back(i / 3);
+  }
+  ps_lst.sort(std::greater<>());
+  ASSERT_EQ(ps_lst.front(), 33333);
+  ASSERT_EQ(ps_lst.back(), 0);
+  ps_lst.reverse();
+  int previous = -1;
+  for (auto it = ps_lst.begin(); it != ps_lst.end(); ++it) {
+    ASSERT_LE(previous, *it);
+    previous = *it;
+  }
+  ASSERT_EQ(ps_lst.front(), 0);
+  ASSERT_EQ(ps_lst.back(), 33333);
+  ASSERT_EQ(*--ps_lst.end(), 33333);
+}
@@ -2,7 +2,13 @@
 #include <stdlib.h>
 #include <time.h>
 
+#include <memory_resource>
+#include <set>
+#include <string>
+#include <thread>
+
 #include "../src/ps_map.h"
+#include "../src/ps_pool_allocator.h"
 
 using namespace ps;
 
@@ -211,6 +217,141 @@ TEST(mapIterators, end_iterator) {
   ASSERT_EQ(*iterator, pair(4, 3));
 }
 
+TEST(mapIterators, empty_map_begin_equals_end) {
+  map<int, int> foo;
+  ASSERT_TRUE(foo.begin() == foo.end());
+  foo.insert(1, 1);
+  foo.erase(1);
+  ASSERT_TRUE(foo.begin() == foo.end());
+}
+
+TEST(mapConstructors, from_sorted) {
+  std::vector<std::pair<int, std::string>> items;
+  for (int i = 0; i < 50; i++) {
+    items.emplace_back(i, std::to_string(i));
+  }
+  auto my_map = map<int, std::string>::from_sorted(items.begin(), items.end());
+  ASSERT_EQ(my_map.size(), 50);
+  int expected = 0;
+  for (auto it = my_map.begin(); it != my_map.end(); ++it) {
+    ASSERT_EQ(it->first, expected);
+    ASSERT_EQ(it->second, std::to_string(expected));
+    expected++;
+  }
+  my_map.insert(100, "100");
+  my_map.erase(10);
+  ASSERT_EQ(my_map.size(), 50);
+  ASSERT_EQ(my_map.at(100), "100");
+  ASSERT_FALSE(my_map.contains(10));
+}
+
+TEST(mapModifiers, assign_sorted_keeps_first_duplicate) {
+  using pair = std::pair<int, int>;
+  map<int, int> my_map({pair(100, 1)});
+  std::vector<pair> items = {pair(1, 1), pair(2, 2), pair(2, 3), pair(5, 5)};
+  my_map.assign_sorted(items.begin(), items.end());
+  ASSERT_EQ(my_map.size(), 3);
+  ASSERT_EQ(my_map.at(2), 2);
+  ASSERT_FALSE(my_map.contains(100));
+
+  my_map.assign_sorted(items.end(), items.end());
+  ASSERT_TRUE(my_map.empty());
+  ASSERT_TRUE(my_map.begin() == my_map.end());
+}
+
+namespace {
+
+struct CountedKey {
+  static int copies;
+  int value = 0;
+
+  CountedKey() = default;
+  explicit CountedKey(int v) : value(v) {}
+  CountedKey(const CountedKey &other) : value(other.value) { copies++; }
+  CountedKey &operator=(const CountedKey &other) = default;
+};
+int CountedKey::copies = 0;
+
+bool operator<(const CountedKey &lhs, const CountedKey &rhs) {
+  return lhs.value < rhs.value;
+}
+bool operator<(const CountedKey &lhs, int rhs) { return lhs.value < rhs; }
+bool operator<(int lhs, const CountedKey &rhs) { return lhs < rhs.value; }
+
+}  // namespace
+
+TEST(mapLookup, heterogeneous_string_lookup) {
+  map<std::string, int> my_map;
+  my_map.insert("apple", 1);
+  my_map.insert("banana", 2);
+  my_map.insert("cherry", 3);
+
+  std::string_view key = "banana";
+  ASSERT_TRUE(my_map.contains(key));
+  ASSERT_TRUE(my_map.contains("cherry"));
+  ASSERT_FALSE(my_map.contains("durian"));
+  ASSERT_EQ(my_map.at(key), 2);
+  ASSERT_EQ(my_map.find("apple")->second, 1);
+  ASSERT_TRUE(my_map.find("durian") == my_map.end());
+  ASSERT_ANY_THROW(my_map.at(std::string_view("durian")));
+
+  my_map.erase(key);
+  ASSERT_FALSE(my_map.contains("banana"));
+  ASSERT_EQ(my_map.size(), 2);
+}
+
+TEST(mapLookup, custom_compare_orders_keys) {
+  map<std::string, int, std::greater<>> my_map;
+  my_map.insert("apple", 1);
+  my_map.insert("cherry", 3);
+  my_map.insert("banana", 2);
+  ASSERT_FALSE(my_map.insert("banana", 5).second);
+
+  std::vector<std::string> keys;
+  for (auto it = my_map.begin(); it != my_map.end(); ++it) {
+    keys.push_back((*it).first);
+  }
+  ASSERT_EQ(keys, (std::vector<std::string>{"cherry", "banana", "apple"}));
+  ASSERT_EQ(my_map.at(std::string_view("banana")), 2);
+
+  map<std::string, int, std::greater<>> copy(my_map);
+  ASSERT_EQ((*copy.begin()).first, "cherry");
+}
+
+TEST(mapLookup, lookup_does_not_copy_key) {
+  map<CountedKey, int> my_map;
+  for (int i = 0; i < 10; i++) {
+    my_map.insert(CountedKey(i), i);
+  }
+  CountedKey::copies = 0;
+  CountedKey probe(5);
+  ASSERT_TRUE(my_map.contains(probe));
+  ASSERT_EQ(my_map.at(probe), 5);
+  ASSERT_TRUE(my_map.contains(7));
+  ASSERT_EQ(my_map.find(3)->second, 3);
+  my_map.erase(4);
+  ASSERT_EQ(CountedKey::copies, 0);
+  ASSERT_EQ(my_map.size(), 9);
+}
+
+TEST(mapLookup, nth_and_rank) {
+  ranked_map<int, char> my_map;
+  for (int i = 0; i < 100; i++) {
+    my_map.insert((i * 37) % 100 * 2, static_cast<char>('a' + i % 26));
+  }
+  my_map.erase(10);
+  ASSERT_EQ(my_map.nth(0)->first, 0);
+  ASSERT_EQ(my_map.nth(5)->first, 12);
+  ASSERT_EQ(my_map.nth(98)->first, 198);
+  ASSERT_TRUE(my_map.nth(99) == my_map.end());
+  ASSERT_EQ(my_map.rank(12), 5);
+  ASSERT_EQ(my_map.rank(13), 6);
+  ASSERT_EQ(my_map.rank(1000), 99);
+
+  const ranked_map<int, char> &const_map = my_map;
+  ASSERT_EQ(const_map.nth(my_map.rank(50))->first, 50);
+}
+
 TEST(mapRandomTest, random_test) {
   map<int, int> foo;
   std::map<int, int> bar;
@@ -444,4 +585,279 @@ TEST(mapGroup, test_4) {
   my_map.clear();
   std_map.clear();
   ASSERT_EQ(my_map.size(), std_map.size());
-}
\ No newline at end of file
+}
+
+namespace {
+
+struct CountedValue {
+  static int copies;
+  static int moves;
+  std::vector<int> payload;
+
+  CountedValue() = default;
+  explicit CountedValue(int size) : payload(static_cast<size_t>(size)) {}
+  CountedValue(const CountedValue &other) : payload(other.payload) {
+    copies++;
+  }
+  CountedValue(CountedValue &&other) noexcept
+      : payload(std::move(other.payload)) {
+    moves++;
+  }
+  CountedValue &operator=(const CountedValue &other) = default;
+  CountedValue &operator=(CountedValue &&other) noexcept = default;
+
+  static void reset() { copies = moves = 0; }
+};
+int CountedValue::copies = 0;
+int CountedValue::moves = 0;
+
+}  // namespace
+
+TEST(mapModifiers, emplace_constructs_value_in_place) {
+  map<int, CountedValue> my_map;
+  CountedValue::reset();
+  ASSERT_TRUE(my_map.try_emplace(1, 100).second);
+  ASSERT_TRUE(my_map.emplace(2, 50).second);
+  ASSERT_TRUE(my_map
+                  .emplace(std::piecewise_construct, std::forward_as_tuple(3),
+                           std::forward_as_tuple(10))
+                  .second);
+  ASSERT_EQ(CountedValue::copies, 0);
+  ASSERT_EQ(CountedValue::moves, 0);
+  ASSERT_EQ(my_map.at(1).payload.size(), 100);
+  ASSERT_EQ(my_map.at(3).payload.size(), 10);
+
+  ASSERT_FALSE(my_map.emplace(2, 7).second);
+  ASSERT_EQ(my_map.at(2).payload.size(), 50);
+  ASSERT_EQ(my_map.size(), 3);
+}
+
+TEST(mapModifiers, insert_rvalue_moves_value) {
+  map<int, CountedValue> my_map;
+  CountedValue::reset();
+  auto result =
+      my_map.insert(std::pair<const int, CountedValue>(1, CountedValue(8)));
+  ASSERT_TRUE(result.second);
+  ASSERT_EQ(CountedValue::copies, 0);
+  ASSERT_EQ((*result.first).second.payload.size(), 8);
+
+  CountedValue::reset();
+  my_map.insert_or_assign(1, CountedValue(4));
+  ASSERT_EQ(CountedValue::copies, 0);
+  ASSERT_EQ(my_map.at(1).payload.size(), 4);
+  ASSERT_EQ(my_map.size(), 1);
+
+  CountedValue::reset();
+  my_map.insert_or_assign(2, CountedValue(3));
+  ASSERT_EQ(CountedValue::copies, 0);
+  ASSERT_EQ(CountedValue::moves, 1);
+  ASSERT_EQ(my_map.at(2).payload.size(), 3);
+}
+
+TEST(mapModifiers, insert_or_assign_moves_key_and_value) {
+  map<std::string, std::string> my_map;
+  std::string key(32, 'k');
+  std::string value(32, 'v');
+  ASSERT_TRUE(my_map.insert_or_assign(std::move(key), std::move(value)).second);
+  ASSERT_TRUE(key.empty());
+  ASSERT_TRUE(value.empty());
+  std::string other(32, 'w');
+  ASSERT_FALSE(
+      my_map.insert_or_assign(std::string(32, 'k'), std::move(other)).second);
+  ASSERT_TRUE(other.empty());
+  ASSERT_EQ(my_map.at(std::string(32, 'k')), std::string(32, 'w'));
+}
+
+TEST(mapModifiers, try_emplace_leaves_arguments_on_duplicate) {
+  map<std::string, std::string> my_map;
+  my_map.try_emplace("key", "first");
+  std::string value = "second";
+  auto result = my_map.try_emplace("key", std::move(value));
+  ASSERT_FALSE(result.second);
+  ASSERT_EQ(value, "second");
+  ASSERT_EQ((*result.first).second, "first");
+}
+
+TEST(mapModifiers, operator_brackets_inserts_once) {
+  map<int, CountedValue> my_map;
+  CountedValue::reset();
+  my_map[5].payload.push_back(1);
+  my_map[5].payload.push_back(2);
+  ASSERT_EQ(my_map.size(), 1);
+  ASSERT_EQ(my_map.at(5).payload.size(), 2);
+  ASSERT_EQ(CountedValue::copies, 0);
+  ASSERT_EQ(CountedValue::moves, 0);
+}
+
+TEST(mapModifiers, move_only_values) {
+  map<std::string, std::unique_ptr<int>> my_map;
+  my_map.emplace("a", std::make_unique<int>(1));
+  my_map.try_emplace("b", new int(2));
+  my_map["c"] = std::make_unique<int>(3);
+  std::string key = "d";
+  my_map[std::move(key)] = std::make_unique<int>(4);
+  ASSERT_EQ(my_map.size(), 4);
+  ASSERT_EQ(*my_map.at("a"), 1);
+  ASSERT_EQ(*my_map.at("b"), 2);
+  ASSERT_EQ(*my_map.at("c"), 3);
+  ASSERT_EQ(*my_map.at("d"), 4);
+}
+
+TEST(mapModifiers, insert_with_hint) {
+  map<int, std::string> my_map;
+  auto hint = my_map.end();
+  for (int i = 0; i < 100; i += 2) {
+    hint = my_map.insert(hint, {i, std::to_string(i)});
+  }
+  // A wrong hint still inserts in the right place.
+  auto it = my_map.insert(my_map.begin(), {51, "51"});
+  ASSERT_EQ((*it).first, 51);
+  ASSERT_EQ((*++it).first, 52);
+
+  auto duplicate = my_map.emplace_hint(my_map.end(), 10, "ten");
+  ASSERT_EQ((*duplicate).second, "10");
+  auto front = my_map.emplace_hint(my_map.begin(), -1, "minus one");
+  ASSERT_TRUE(front == my_map.begin());
+  ASSERT_EQ(my_map.size(), 52);
+
+  int previous = -2;
+  for (auto i = my_map.begin(); i != my_map.end(); ++i) {
+    ASSERT_LT(previous, (*i).first);
+    previous = (*i).first;
+  }
+}
+
+TEST(mapModifiers, insert_many_sorted_batch) {
+  map<int, int> my_map;
+  my_map.insert(3, 0);
+  auto res = my_map.insert_many(std::pair<const int, int>{1, 1},
+                                std::pair<const int, int>{2, 2},
+                                std::pair<const int, int>{3, 3},
+                                std::pair<const int, int>{4, 4});
+  ASSERT_EQ(res.size(), 4);
+  ASSERT_TRUE(res[0].second);
+  ASSERT_FALSE(res[2].second);
+  ASSERT_EQ((*res[2].first).second, 0);
+  ASSERT_EQ((*res[3].first).first, 4);
+  ASSERT_EQ(my_map.size(), 4);
+}
+
+TEST(mapModifiers, merge_relinks_values) {
+  map<int, CountedValue> target;
+  map<int, CountedValue> source;
+  for (int i = 0; i < 20; i++) {
+    target.try_emplace(i * 2, 1);
+    source.try_emplace(i * 3, 2);
+  }
+  CountedValue::reset();
+  target.merge(source);
+  ASSERT_EQ(CountedValue::copies, 0);
+  ASSERT_EQ(CountedValue::moves, 0);
+  ASSERT_EQ(target.size(), 33);
+  ASSERT_EQ(source.size(), 7);
+  ASSERT_EQ(target.at(3).payload.size(), 2);
+  ASSERT_EQ(target.at(6).payload.size(), 1);
+  ASSERT_EQ(source.at(6).payload.size(), 2);
+}
+
+TEST(mapModifiers, extract_and_insert_node) {
+  map<std::string, int> first{{"a", 1}, {"b", 2}, {"c", 3}};
+  map<std::string, int> second{{"b", 20}};
+
+  auto node = first.extract("b");
+  ASSERT_FALSE(node.empty());
+  ASSERT_EQ(node.key(), "b");
+  node.mapped() = 200;
+  ASSERT_EQ(first.size(), 2);
+  ASSERT_FALSE(first.extract("z"));
+
+  auto result = second.insert(std::move(node));
+  ASSERT_FALSE(result.inserted);
+  ASSERT_EQ((*result.position).second, 20);
+  ASSERT_EQ(result.node.mapped(), 200);
+
+  result = first.insert(std::move(result.node));
+  ASSERT_TRUE(result.inserted);
+  ASSERT_TRUE(result.node.empty());
+  ASSERT_EQ(first.at("b"), 200);
+
+  second.insert(first.extract(first.begin()));
+  ASSERT_TRUE(second.contains("a"));
+  ASSERT_FALSE(first.contains("a"));
+}
+
+TEST(mapModifiers, clear_async) {
+  map<int, std::string> my_map;
+  for (int i = 0; i < 1000; i++) {
+    my_map.insert(i, std::to_string(i));
+  }
+  my_map.clear_async();
+  ASSERT_TRUE(my_map.empty());
+  ASSERT_TRUE(my_map.begin() == my_map.end());
+  my_map.insert(5, "five");
+  ASSERT_EQ(my_map.at(5), "five");
+  ASSERT_EQ(my_map.size(), 1);
+}
+
+TEST(mapAllocator, pmr_map_takes_nodes_from_arena) {
+  alignas(std::max_align_t) char buffer[65536];
+  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                            std::pmr::null_memory_resource());
+  pmr::map<int, int> my_map(&arena);
+  for (int i = 0; i < 100; i++) {
+    my_map.insert({i, i * 2});
+  }
+  auto *value = reinterpret_cast<const char *>(&my_map.at(50));
+  ASSERT_TRUE(value >= buffer && value < buffer + sizeof(buffer));
+  ASSERT_EQ(my_map.at(99), 198);
+  ASSERT_EQ(my_map.size(), 100);
+}
+
+namespace {
+
+// Records which threads return memory to it.
+class ThreadRecordingResource : public std::pmr::memory_resource {
+ public:
+  std::set<std::thread::id> deallocating_threads;
+
+ private:
+  void *do_allocate(size_t bytes, size_t align) override {
+    return std::pmr::new_delete_resource()->allocate(bytes, align);
+  }
+  void do_deallocate(void *ptr, size_t bytes, size_t align) override {
+    deallocating_threads.insert(std::this_thread::get_id());
+    std::pmr::new_delete_resource()->deallocate(ptr, bytes, align);
+  }
+  bool do_is_equal(const memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+}  // namespace
+
+TEST(mapAllocator, pmr_clear_async_frees_on_calling_thread) {
+  ThreadRecordingResource resource;
+  pmr::map<int, std::string> my_map(&resource);
+  for (int i = 0; i < 1000; i++) {
+    my_map.insert({i, std::to_string(i)});
+  }
+  my_map.clear_async();
+  reclaimer::instance().wait_idle();
+  ASSERT_TRUE(my_map.empty());
+  ASSERT_EQ(resource.deallocating_threads,
+            std::set<std::thread::id>{std::this_thread::get_id()});
+}
+
+TEST(mapAllocator, pool_allocator_map) {
+  map<int, int, std::less<>, pool_allocator<std::pair<const int, int>>>
+      my_map;
+  for (int i = 0; i < 1000; i++) {
+    my_map.insert({i, i * 2});
+  }
+  for (int i = 0; i < 1000; i += 2) {
+    my_map.erase(i);
+  }
+  ASSERT_EQ(my_map.size(), 500);
+  ASSERT_EQ(my_map.at(999), 1998);
+  ASSERT_FALSE(my_map.contains(998));
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "../src/ps_mapped_vector.h"
+
+namespace {
+
+struct Record {
+  long id;
+  double score;
+};
+
+struct Block {
+  char bytes[1000];
+};
+
+size_t openDescriptors() {
+  auto fds = std::filesystem::directory_iterator("/proc/self/fd");
+  return size_t(std::distance(fds, std::filesystem::directory_iterator()));
+}
+
+// A file in the temp directory that is gone again after the test.
+class TempPath {
+ public:
+  explicit TempPath(const char* name)
+      : path_((std::filesystem::temp_directory_path() /
+               (std::string(name) + "." + std::to_string(getpid())))
+                  .string()) {
+    std::filesystem::remove(path_);
+  }
+  ~TempPath() { std::filesystem::remove(path_); }
+  const std::string& str() const { return path_; }
+
+ private:
+  std::string path_;
+};
+
+}  // namespace
+
+TEST(MappedVector, Test_push_back) {
+  TempPath path("mapped_vector_push_back");
+  ps::mapped_vector<int> vect(path.str());
+  ASSERT_TRUE(vect.is_open());
+  ASSERT_TRUE(vect.empty());
+  for (int i = 0; i < 100000; ++i) {
+    vect.push_back(i);
+  }
+  ASSERT_EQ(vect.size(), 100000);
+  ASSERT_GE(vect.capacity(), vect.size());
+  ASSERT_EQ(vect.back(), 99999);
+  long long sum = 0;
+  for (int value : vect) {
+    sum += value;
+  }
+  ASSERT_EQ(sum, 4999950000LL);
+  ASSERT_EQ(vect.end() - vect.begin(), 100000);
+  ASSERT_THROW(vect.at(100000), std::out_of_range);
+}
+
+// Everything written before close() is there, unchanged, after open().
+TEST(MappedVector, Test_reopen) {
+  TempPath path("mapped_vector_reopen");
+  {
+    ps::mapped_vector<Record> vect(path.str());
+    for (long i = 0; i < 5000; ++i) {
+      vect.emplace_back(Record{i, double(i) / 2});
+    }
+    vect.sync();
+  }
+  ps::mapped_vector<Record> vect;
+  ASSERT_FALSE(vect.is_open());
+  vect.open(path.str());
+  ASSERT_EQ(vect.size(), 5000);
+  for (long i = 0; i < 5000; ++i) {
+    ASSERT_EQ(vect[size_t(i)].id, i);
+    ASSERT_EQ(vect[size_t(i)].score, double(i) / 2);
+  }
+  vect.push_back(Record{5000, 1.0});
+  vect.shrink_to_fit();
+  ASSERT_EQ(vect.capacity(), 5001);
+  vect.close();
+  ASSERT_EQ(std::filesystem::file_size(path.str()),
+            64 + 5001 * sizeof(Record));
+
+  ps::mapped_vector<Record> again(path.str());
+  ASSERT_EQ(again.size(), 5001);
+  ASSERT_EQ(again.back().id, 5000);
+}
+
+TEST(MappedVector, Test_modifiers) {
+  TempPath path("mapped_vector_modifiers");
+  ps::mapped_vector<int> vect(path.str());
+  for (int i = 0; i < 10; ++i) {
+    vect.push_back(i);
+  }
+  vect.insert(vect.begin(), vect[9]);
+  vect.erase(vect.begin() + 1, vect.begin() + 4);
+  vect.erase(vect.end() - 1);
+  vect.pop_back();
+  std::vector<int> expected{9, 3, 4, 5, 6, 7};
+  ASSERT_EQ(std::vector<int>(vect.begin(), vect.end()), expected);
+
+  ps::mapped_vector<int> moved(std::move(vect));
+  ASSERT_FALSE(vect.is_open());
+  ASSERT_EQ(moved.front(), 9);
+  moved.clear();
+  ASSERT_TRUE(moved.empty());
+}
+
+TEST(MappedVector, Test_wrong_file) {
+  TempPath path("mapped_vector_wrong_file");
+  {
+    ps::mapped_vector<int> ints(path.str());
+    ints.push_back(1);
+  }
+  ps::mapped_vector<Record> records;
+  ASSERT_THROW(records.open(path.str()), std::runtime_error);
+  ASSERT_FALSE(records.is_open());
+  ASSERT_THROW(records.open("/nonexistent-dir/vector"), std::system_error);
+}
+
+// A file that cannot be mapped leaves no descriptor open behind.
+TEST(MappedVector, Test_failed_open_closes_file) {
+  if (!std::filesystem::exists("/proc/self/fd")) {
+    GTEST_SKIP();
+  }
+  size_t before = openDescriptors();
+  ps::mapped_vector<int> vect;
+  ASSERT_THROW(vect.open("/dev/null"), std::system_error);
+  ASSERT_FALSE(vect.is_open());
+  ASSERT_EQ(openDescriptors(), before);
+}
+
+// A file that ends in a partial element is mapped, and unmapped, whole.
+TEST(MappedVector, Test_partial_element_is_unmapped) {
+  TempPath path("mapped_vector_partial_element");
+  size_t page = size_t(sysconf(_SC_PAGESIZE));
+  {
+    ps::mapped_vector<Block> blocks(path.str());
+    blocks.push_back(Block());
+  }
+  std::filesystem::resize_file(path.str(), 2 * page + 100);
+  ps::mapped_vector<Block> blocks(path.str());
+  ASSERT_EQ(blocks.size(), 1);
+  // The 64-byte header comes first; the last page holds no whole block.
+  ASSERT_LT(64 + blocks.capacity() * sizeof(Block), 2 * page);
+  char* tail = reinterpret_cast<char*>(blocks.data()) - 64 + 2 * page;
+  ASSERT_EQ(msync(tail, page, MS_ASYNC), 0);
+  blocks.close();
+  ASSERT_NE(msync(tail, page, MS_ASYNC), 0);
+}
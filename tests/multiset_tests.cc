@@ -1,7 +1,15 @@
 #include <gtest/gtest.h>
 #include <time.h>
 
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <vector>
+
 #include "../src/ps_multiset.h"
+#include "../src/ps_pool_allocator.h"
+#include "../src/ps_set_algebra.h"
+#include "set_test_helpers.h"
 
 using namespace ps;
 
@@ -58,6 +66,22 @@ TEST(multisetConstructors, initializer_list_constructor) {
   ASSERT_EQ(my_multiset.contains(6), true);
 }
 
+TEST(multisetConstructors, from_sorted) {
+  std::vector<int> items = {1, 3, 3, 5, 7, 7, 7, 9};
+  auto my_multiset = multiset<int>::from_sorted(items.begin(), items.end());
+  ASSERT_EQ(my_multiset.size(), items.size());
+  ASSERT_EQ(my_multiset.count(7), 3);
+  ASSERT_EQ(my_multiset.count(3), 2);
+  auto item = items.begin();
+  for (auto it = my_multiset.begin(); it != my_multiset.end(); ++it) {
+    ASSERT_EQ(*it, *item);
+    ++item;
+  }
+  my_multiset.erase(7);
+  ASSERT_EQ(my_multiset.count(7), 2);
+  ASSERT_EQ(my_multiset.size(), items.size() - 1);
+}
+
 TEST(multisetModifiers, clear_multiset) {
   multiset<int> my_multiset;
   my_multiset.insert(5);
@@ -151,6 +175,37 @@ TEST(multisetModifiers, merge_multiset) {
   ASSERT_EQ(u.contains(10), true);
 }
 
+TEST(multisetModifiers, merge_keeps_counts) {
+  multiset<int> target{1, 1, 3};
+  multiset<int> source{1, 2, 2, 4};
+  target.merge(source);
+  ASSERT_EQ(target.size(), 6);
+  ASSERT_EQ(target.count(2), 2);
+  ASSERT_EQ(target.count(1), 2);
+  ASSERT_EQ(source.size(), 1);
+  ASSERT_EQ(source.count(1), 1);
+}
+
+TEST(multisetModifiers, extract_and_insert_node) {
+  multiset<int> first{5, 5, 5, 7};
+  multiset<int> second{5};
+
+  auto node = first.extract(5);
+  ASSERT_EQ(node.value(), 5);
+  ASSERT_EQ(first.count(5), 2);
+  ASSERT_EQ(first.size(), 3);
+
+  auto it = second.insert(std::move(node));
+  ASSERT_EQ(*it, 5);
+  ASSERT_EQ(second.count(5), 2);
+  ASSERT_EQ(second.size(), 2);
+
+  second.insert(first.extract(first.find(7)));
+  ASSERT_FALSE(first.contains(7));
+  ASSERT_EQ(second.count(7), 1);
+  ASSERT_EQ(second.size(), 3);
+}
+
 TEST(multisetIterators, begin_iterator) {
   multiset<int> foo;
 
@@ -314,6 +369,62 @@ TEST(multisetLookups, lower_upper_bound_start_of_map) {
   ASSERT_EQ(*iterator_upper_bound, 1);
 }
 
+TEST(multisetLookups, heterogeneous_string_lookup) {
+  multiset<std::string> my_multiset({"a", "b", "b", "c"});
+  std::string_view key = "b";
+  ASSERT_EQ(my_multiset.count(key), 2);
+  ASSERT_TRUE(my_multiset.contains("c"));
+  ASSERT_EQ(*my_multiset.lower_bound(key), "b");
+  ASSERT_EQ(*my_multiset.upper_bound(key), "c");
+  ASSERT_EQ(*my_multiset.equal_range(key).second, "b");
+  ASSERT_TRUE(my_multiset.find("z") == my_multiset.end());
+  my_multiset.erase(key);
+  ASSERT_EQ(my_multiset.count("b"), 1);
+  ASSERT_EQ(my_multiset.size(), 3);
+}
+
+TEST(multisetLookups, equal_range_missing_key) {
+  multiset<int> my_multiset({5, 7, 2});
+  auto range = my_multiset.equal_range(6);
+  ASSERT_TRUE(range.first == my_multiset.end());
+  ASSERT_TRUE(range.second == my_multiset.end());
+}
+
+TEST(multisetLookups, custom_compare_orders_keys) {
+  multiset<int, std::greater<>> my_multiset({2, 7, 2, 5});
+  std::vector<int> keys;
+  for (auto it = my_multiset.begin(); it != my_multiset.end(); ++it) {
+    keys.push_back(*it);
+  }
+  ASSERT_EQ(keys, (std::vector<int>{7, 5, 2, 2}));
+  ASSERT_EQ(*my_multiset.lower_bound(6), 5);
+  ASSERT_EQ(*my_multiset.upper_bound(5), 2);
+  ASSERT_EQ(my_multiset.count(2), 2);
+}
+
+TEST(multisetLookups, nth_and_rank_count_copies) {
+  ranked_multiset<int> my_multiset({5, 1, 5, 3, 5, 3});
+  ASSERT_EQ(my_multiset.rank(3), 1);
+  ASSERT_EQ(my_multiset.rank(5), 3);
+  ASSERT_EQ(my_multiset.rank(6), 6);
+  ASSERT_EQ(*my_multiset.nth(2), 3);
+  ASSERT_EQ(*my_multiset.nth(3), 5);
+  auto it = my_multiset.nth(4);
+  ++it;
+  ASSERT_EQ(*it, 5);
+  ++it;
+  ASSERT_TRUE(it == my_multiset.end());
+
+  my_multiset.erase(5);
+  auto node = my_multiset.extract(3);
+  ASSERT_EQ(my_multiset.rank(5), 2);
+  ASSERT_EQ(*my_multiset.nth(2), 5);
+  my_multiset.insert(std::move(node));
+  my_multiset.insert(0);
+  ASSERT_EQ(my_multiset.rank(5), 4);
+  ASSERT_TRUE(my_multiset.nth(6) == my_multiset.end());
+}
+
 TEST(multisetGroup, iterators_test_1) {
   const multiset<int> my_multiset{3, 5, 1, 9};
   const std::multiset<int> std_multiset{3, 5, 1, 9};
@@ -349,3 +460,73 @@ TEST(multisetGroup, iterators_test_2) {
   EXPECT_TRUE(iter2 == iter1);
   EXPECT_FALSE(iter2 != iter1);
 }
+
+TEST(multisetAlgebra, operations_count_copies) {
+  srand(12);
+  for (int round = 0; round < 20; round++) {
+    multiset<int> a;
+    multiset<int> b;
+    std::multiset<int> std_a;
+    std::multiset<int> std_b;
+    for (int i = 0; i < 400; i++) {
+      int x = rand() % 100;
+      a.insert(x);
+      std_a.insert(x);
+    }
+    int b_count = round % 2 == 0 ? 400 : 8;
+    for (int i = 0; i < b_count; i++) {
+      int x = rand() % 100;
+      b.insert(x);
+      std_b.insert(x);
+    }
+    std::vector<int> expected;
+    std::set_union(std_a.begin(), std_a.end(), std_b.begin(), std_b.end(),
+                   std::back_inserter(expected));
+    multiset<int> result = set_union(a, b);
+    ASSERT_EQ(result.size(), expected.size());
+    ASSERT_EQ(keys_of(result), expected);
+
+    expected.clear();
+    std::set_intersection(std_a.begin(), std_a.end(), std_b.begin(),
+                          std_b.end(), std::back_inserter(expected));
+    result = set_intersection(a, b);
+    ASSERT_EQ(result.size(), expected.size());
+    ASSERT_EQ(keys_of(result), expected);
+    result = set_intersection_galloping(b, a);
+    ASSERT_EQ(result.size(), expected.size());
+    ASSERT_EQ(keys_of(result), expected);
+
+    expected.clear();
+    std::set_difference(std_b.begin(), std_b.end(), std_a.begin(),
+                        std_a.end(), std::back_inserter(expected));
+    result = set_difference(b, a);
+    ASSERT_EQ(result.size(), expected.size());
+    ASSERT_EQ(keys_of(result), expected);
+    ASSERT_EQ(includes(a, b), std::includes(std_a.begin(), std_a.end(),
+                                            std_b.begin(), std_b.end()));
+  }
+}
+
+TEST(multisetAlgebra, result_stays_usable) {
+  ranked_multiset<int> a{1, 1, 1, 2};
+  ranked_multiset<int> b{1, 2, 2, 3};
+  auto result = set_difference(a, b);
+  ASSERT_EQ(result.size(), 2);
+  ASSERT_EQ(result.count(1), 2);
+  ASSERT_EQ(result.rank(2), 2);
+  ASSERT_TRUE(includes(a, result));
+  result.insert(2);
+  ASSERT_EQ(*result.nth(2), 2);
+  ASSERT_FALSE(includes(a, set_union(a, b)));
+}
+
+TEST(multisetAllocator, pool_allocator_multiset) {
+  multiset<int, std::less<>, pool_allocator<int>> my_set;
+  for (int i = 0; i < 1000; i++) {
+    my_set.insert(i % 10);
+  }
+  my_set.erase(my_set.find(3));
+  ASSERT_EQ(my_set.size(), 999);
+  ASSERT_EQ(my_set.count(3), 99);
+  ASSERT_EQ(my_set.count(4), 100);
+}
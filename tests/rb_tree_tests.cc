@@ -1,4 +1,7 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
 
 #include "../src/ps_rb_tree.h"
 
@@ -103,3 +106,554 @@ TEST(RBTreeFind, findNextElement) {
 
   ASSERT_EQ(tree.nextNode(min_node)->value.first, 10);
 }
+
+TEST(RBTreeFind, nextAndPrevWalkWholeTree) {
+  auto tree = RBTree<int, int>{};
+  for (int i : {50, 20, 80, 10, 30, 70, 90, 25, 35, 5}) {
+    std::pair<const int, int> p = {i, i};
+    tree.insert(p);
+  }
+  tree.del(20);
+  tree.del(90);
+
+  int expected[] = {5, 10, 25, 30, 35, 50, 70, 80};
+  auto node = tree.beginNode();
+  for (int value : expected) {
+    ASSERT_EQ(node->value.first, value);
+    node = tree.nextNode(node);
+  }
+  ASSERT_EQ(node, tree.endNode());
+
+  for (int i = 7; i >= 0; i--) {
+    node = tree.prevNode(node);
+    ASSERT_EQ(node->value.first, expected[i]);
+  }
+}
+
+TEST(RBTreeFind, cachedMinMaxFollowDeletes) {
+  auto tree = RBTree<int, int>{};
+  for (int i = 0; i < 16; i++) {
+    std::pair<const int, int> p = {i, i};
+    tree.insert(p);
+  }
+  tree.del(0);
+  tree.del(15);
+  ASSERT_EQ(tree.minNode()->value.first, 1);
+  ASSERT_EQ(tree.maxNode()->value.first, 14);
+
+  for (int i = 1; i < 15; i++) {
+    tree.del(i);
+  }
+  ASSERT_EQ(tree.size(), 0);
+  ASSERT_EQ(tree.beginNode(), tree.endNode());
+}
+
+namespace {
+
+size_t live_slab_allocations = 0;
+
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;
+
+  CountingAllocator() = default;
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U> &) {}
+
+  T *allocate(size_t n) {
+    live_slab_allocations++;
+    return std::allocator<T>{}.allocate(n);
+  }
+  void deallocate(T *p, size_t n) {
+    live_slab_allocations--;
+    std::allocator<T>{}.deallocate(p, n);
+  }
+};
+
+}  // namespace
+
+TEST(RBTreeAllocator, nodesComeFromSlabs) {
+  {
+    RBTree<int, int, std::less<>,
+           CountingAllocator<std::pair<const int, int>>>
+        tree;
+    for (int i = 0; i < 16; i++) {
+      std::pair<const int, int> p = {i, i};
+      tree.insert(p);
+    }
+    ASSERT_EQ(live_slab_allocations, 2);
+
+    for (int i = 0; i < 8; i++) {
+      tree.del(i);
+    }
+    for (int i = 100; i < 108; i++) {
+      std::pair<const int, int> p = {i, i};
+      tree.insert(p);
+    }
+    ASSERT_EQ(live_slab_allocations, 2);
+    ASSERT_EQ(tree.size(), 16);
+
+    tree.clear();
+    ASSERT_EQ(live_slab_allocations, 0);
+    ASSERT_EQ(tree.beginNode(), tree.endNode());
+  }
+  ASSERT_EQ(live_slab_allocations, 0);
+}
+
+TEST(RBTreeAllocator, clearDestroysValues) {
+  auto tree = RBTree<int, std::string>{};
+  for (int i = 0; i < 100; i++) {
+    std::pair<const int, std::string> p = {i, std::string(64, 'x')};
+    tree.insert(p);
+  }
+  tree.clear();
+  std::pair<const int, std::string> p = {1, "one"};
+  tree.insert(p);
+  ASSERT_EQ(tree.find(1).second, "one");
+  ASSERT_EQ(tree.size(), 1);
+}
+
+namespace {
+
+// The shared nil node is the only node that links to itself.
+bool isNil(const rbnode<int, int> *x) { return x->left == x; }
+
+// Returns the black height of the subtree or -1 if an invariant is broken.
+int blackHeight(const rbnode<int, int> *x) {
+  if (isNil(x)) {
+    return 1;
+  }
+  if (x->color == RED &&
+      ((!isNil(x->left) && x->left->color == RED) ||
+       (!isNil(x->right) && x->right->color == RED))) {
+    return -1;
+  }
+  if ((!isNil(x->left) && x->left->parent != x) ||
+      (!isNil(x->right) && x->right->parent != x)) {
+    return -1;
+  }
+  int left = blackHeight(x->left);
+  int right = blackHeight(x->right);
+  if (left == -1 || left != right) {
+    return -1;
+  }
+  return left + (x->color == BLACK ? 1 : 0);
+}
+
+template <typename Compare, typename Allocator, typename Weigh>
+bool isRedBlackTree(RBTree<int, int, Compare, Allocator, Weigh> &tree) {
+  if (tree.size() == 0) {
+    return true;
+  }
+  const rbnode<int, int> *root = tree.beginNode();
+  while (!isNil(root->parent)) {
+    root = root->parent;
+  }
+  return root->color == BLACK && blackHeight(root) != -1;
+}
+
+}  // namespace
+
+TEST(RBTreeAssignSorted, buildsValidTreeOfAnySize) {
+  for (int count = 0; count <= 130; count++) {
+    auto tree = RBTree<int, int>{};
+    int key = 0;
+    tree.assignSorted(static_cast<size_t>(count), [&key]() {
+      key += 2;
+      return std::pair<const int, int>(key, -key);
+    });
+    ASSERT_EQ(tree.size(), static_cast<size_t>(count));
+    ASSERT_TRUE(isRedBlackTree(tree));
+
+    int expected = 2;
+    for (auto node = tree.beginNode(); node != tree.endNode();
+         node = tree.nextNode(node)) {
+      ASSERT_EQ(node->value.first, expected);
+      ASSERT_EQ(node->value.second, -expected);
+      expected += 2;
+    }
+    ASSERT_EQ(expected, 2 * count + 2);
+  }
+}
+
+TEST(RBTreeAssignSorted, treeStaysValidAfterUpdates) {
+  auto tree = RBTree<int, int>{};
+  int key = 0;
+  tree.assignSorted(100, [&key]() {
+    key += 2;
+    return std::pair<const int, int>(key, key);
+  });
+  for (int i = 1; i < 100; i += 4) {
+    std::pair<const int, int> p = {i, i};
+    tree.insert(p);
+    tree.del(i + 1);
+    ASSERT_TRUE(isRedBlackTree(tree));
+  }
+  ASSERT_EQ(tree.size(), 100);
+}
+
+namespace {
+
+// Three-way comparator that counts how often the tree consults it.
+struct CountingThreeWay {
+  int *calls;
+  bool operator()(int a, int b) const {
+    ++*calls;
+    return a < b;
+  }
+  int compare(int a, int b) const {
+    ++*calls;
+    return a < b ? -1 : (b < a ? 1 : 0);
+  }
+};
+
+}  // namespace
+
+TEST(RBTreeCompare, reverseOrder) {
+  auto tree = RBTree<int, int, std::greater<>>{};
+  for (int i = 0; i < 50; i++) {
+    std::pair<const int, int> p = {(i * 7) % 50, i};
+    tree.insert(p);
+  }
+  std::pair<const int, int> duplicate = {3, 0};
+  ASSERT_EQ(tree.insert(duplicate), nullptr);
+  ASSERT_TRUE(isRedBlackTree(tree));
+
+  int expected = 49;
+  for (auto node = tree.beginNode(); node != tree.endNode();
+       node = tree.nextNode(node)) {
+    ASSERT_EQ(node->value.first, expected--);
+  }
+  ASSERT_EQ(expected, -1);
+  ASSERT_EQ(tree.findLowerBoundNode(20)->value.first, 20);
+  ASSERT_EQ(tree.findUpperBoundNode(20)->value.first, 19);
+  ASSERT_TRUE(tree.contains(0));
+  ASSERT_FALSE(tree.contains(50));
+}
+
+TEST(RBTreeCompare, threeWayCompareOncePerLevel) {
+  int calls = 0;
+  auto tree = RBTree<int, int, CountingThreeWay>{CountingThreeWay{&calls}};
+  for (int i = 0; i < 1000; i++) {
+    std::pair<const int, int> p = {i, i};
+    tree.insert(p);
+  }
+  ASSERT_TRUE(isRedBlackTree(tree));
+
+  // A red-black tree of 1000 nodes is at most 2 * log2(1001) < 20 deep.
+  for (int i = 0; i < 1000; i++) {
+    calls = 0;
+    ASSERT_NE(tree.findNode(i), nullptr);
+    ASSERT_LE(calls, 20);
+    calls = 0;
+    std::pair<const int, int> p = {i, 0};
+    ASSERT_EQ(tree.insert(p), nullptr);
+    ASSERT_LE(calls, 20);
+  }
+  ASSERT_EQ(tree.findNode(1000), nullptr);
+}
+
+TEST(RBTreeHint, anyHintKeepsTreeValid) {
+  auto tree = RBTree<int, int>{};
+  std::mt19937 gen(3);
+  std::uniform_int_distribution<int> dist(0, 300);
+  const rbnode<int, int> *hint = tree.endNode();
+  for (int i = 0; i < 500; i++) {
+    int key = dist(gen);
+    bool expected = !tree.contains(key);
+    auto result = tree.insertHint(hint, std::pair<const int, int>(key, i));
+    ASSERT_EQ(result.second, expected);
+    ASSERT_EQ(result.first->value.first, key);
+    ASSERT_TRUE(isRedBlackTree(tree));
+    // Alternate between the new node, its neighbours and the ends.
+    switch (i % 4) {
+      case 0:
+        hint = result.first;
+        break;
+      case 1:
+        hint = tree.nextNode(result.first);
+        break;
+      case 2:
+        hint = tree.prevNode(result.first);
+        break;
+      default:
+        hint = tree.beginNode();
+        break;
+    }
+  }
+  int previous = -1;
+  for (auto node = tree.beginNode(); node != tree.endNode();
+       node = tree.nextNode(node)) {
+    ASSERT_LT(previous, node->value.first);
+    previous = node->value.first;
+  }
+}
+
+TEST(RBTreeHint, orderedInsertWithHintIsConstantTime) {
+  int calls = 0;
+  auto tree = RBTree<int, int, CountingThreeWay>{CountingThreeWay{&calls}};
+  const rbnode<int, int> *hint = tree.endNode();
+  for (int i = 0; i < 10000; i++) {
+    hint = tree.tryEmplaceHint(hint, i, i).first;
+  }
+  ASSERT_LE(calls, 2 * 10000);
+
+  calls = 0;
+  hint = tree.beginNode();
+  for (int i = -1; i >= -10000; i--) {
+    hint = tree.emplaceHint(hint, i, i).first;
+  }
+  ASSERT_LE(calls, 3 * 10000);
+  ASSERT_EQ(tree.size(), 20000);
+  ASSERT_TRUE(isRedBlackTree(tree));
+  ASSERT_EQ(tree.minNode()->value.first, -10000);
+  ASSERT_EQ(tree.maxNode()->value.first, 9999);
+}
+
+TEST(RBTreeNodeHandle, handleOutlivesSourceTree) {
+  RBTree<int, std::string>::node_type handle;
+  {
+    auto source = RBTree<int, std::string>{};
+    for (int i = 0; i < 40; i++) {
+      source.tryEmplace(i, std::to_string(i));
+    }
+    handle = source.extract(source.findNode(7));
+    ASSERT_EQ(source.size(), 39);
+    ASSERT_FALSE(source.contains(7));
+  }
+  ASSERT_EQ(handle.key(), 7);
+  ASSERT_EQ(handle.mapped(), "7");
+
+  auto target = RBTree<int, std::string>{};
+  target.tryEmplace(7, "other");
+  auto result = target.insertNode(std::move(handle));
+  ASSERT_FALSE(result.second);
+  ASSERT_FALSE(handle.empty());
+
+  target.clear();
+  result = target.insertNode(std::move(handle));
+  ASSERT_TRUE(result.second);
+  ASSERT_TRUE(handle.empty());
+  ASSERT_EQ(result.first->value.second, "7");
+}
+
+TEST(RBTreeNodeHandle, mergeRelinksWithoutAllocating) {
+  using Tree = RBTree<int, int, std::less<>,
+                      CountingAllocator<std::pair<const int, int>>>;
+  {
+    Tree first;
+    auto *second = new Tree;
+    for (int i = 0; i < 100; i++) {
+      first.tryEmplace(i * 2, i);
+      second->tryEmplace(i * 3, i);
+    }
+    size_t slabs = live_slab_allocations;
+    first.mergeNodes(*second, [](rbnode<int, int> *, rbnode<int, int> *) {
+      return false;
+    });
+    ASSERT_EQ(live_slab_allocations, slabs);
+    ASSERT_EQ(first.size(), 166);
+    ASSERT_EQ(second->size(), 34);
+    ASSERT_TRUE(isRedBlackTree(first));
+    ASSERT_TRUE(isRedBlackTree(*second));
+
+    // Nodes moved out of second stay valid after it is gone, and merging
+    // back and forth does not tie the trees' lifetimes in a cycle.
+    second->mergeNodes(first, [](rbnode<int, int> *, rbnode<int, int> *) {
+      return false;
+    });
+    first.mergeNodes(*second, [](rbnode<int, int> *, rbnode<int, int> *) {
+      return false;
+    });
+    delete second;
+    for (int i = 0; i < 300; i++) {
+      ASSERT_EQ(first.contains(i), (i % 2 == 0 && i < 200) || i % 3 == 0);
+      first.del(i);
+    }
+    ASSERT_EQ(first.size(), 0);
+  }
+  ASSERT_EQ(live_slab_allocations, 0);
+}
+
+TEST(RBTreeNodeHandle, mergedPoolsAreReleasedOnceEmpty) {
+  using Tree = RBTree<int, int, std::less<>,
+                      CountingAllocator<std::pair<const int, int>>>;
+  {
+    Tree tree;
+    int next = 0;
+    for (; next < 1000; next++) {
+      tree.tryEmplace(next, next);
+    }
+    // Every round merges in a fresh tree and drops as many old keys, so the
+    // tree keeps its size while the nodes come from ever new pools.
+    size_t slabs_after_warmup = 0;
+    for (int round = 0; round < 50; round++) {
+      {
+        Tree fresh;
+        for (int i = 0; i < 1000; i++) {
+          fresh.tryEmplace(next + i, i);
+        }
+        tree.mergeNodes(fresh, [](rbnode<int, int> *, rbnode<int, int> *) {
+          return false;
+        });
+      }
+      for (int i = 0; i < 1000; i++) {
+        tree.del(next - 1000 + i);
+      }
+      next += 1000;
+      if (round == 9) {
+        slabs_after_warmup = live_slab_allocations;
+      }
+    }
+    ASSERT_EQ(tree.size(), 1000);
+    ASSERT_TRUE(isRedBlackTree(tree));
+    ASSERT_LE(live_slab_allocations, 2 * slabs_after_warmup);
+  }
+  ASSERT_EQ(live_slab_allocations, 0);
+}
+
+TEST(RBTreeClear, asyncClearReclaimsInBackground) {
+  auto shared = std::make_shared<int>(42);
+  {
+    RBTree<int, std::shared_ptr<int>, std::less<>,
+           CountingAllocator<std::pair<const int, std::shared_ptr<int>>>>
+        tree;
+    for (int i = 0; i < 1000; i++) {
+      tree.tryEmplace(i, shared);
+    }
+    tree.clearAsync();
+    ASSERT_EQ(tree.size(), 0);
+    ASSERT_EQ(tree.beginNode(), tree.endNode());
+
+    // The tree is usable right away, with storage of its own.
+    tree.tryEmplace(1, shared);
+    ASSERT_EQ(tree.find(1).second, shared);
+    ASSERT_TRUE(tree.contains(1));
+    ASSERT_FALSE(tree.contains(2));
+
+    reclaimer::instance().wait_idle();
+    ASSERT_EQ(shared.use_count(), 2);
+    ASSERT_EQ(live_slab_allocations, 1);
+  }
+  ASSERT_EQ(shared.use_count(), 1);
+  ASSERT_EQ(live_slab_allocations, 0);
+}
+
+TEST(RBTreeClear, clearWithSharedPoolsFreesEveryNode) {
+  auto first = RBTree<int, std::string>{};
+  auto second = RBTree<int, std::string>{};
+  for (int i = 0; i < 500; i++) {
+    first.tryEmplace(i * 2, std::to_string(i));
+    second.tryEmplace(i * 2 + 1, std::to_string(i));
+  }
+  first.mergeNodes(second, [](auto *, auto *) { return false; });
+  ASSERT_EQ(first.size(), 1000);
+  std::vector<const void *> nodes;
+  for (auto *node = first.beginNode(); node != first.endNode();
+       node = first.nextNode(node)) {
+    nodes.push_back(node);
+  }
+  std::sort(nodes.begin(), nodes.end(), std::less<>());
+
+  // Pools are shared now, so clearing has to hand nodes back one by one and
+  // the freed slots are reused.
+  first.clear();
+  for (int i = 0; i < 1000; i++) {
+    first.tryEmplace(i, std::to_string(i));
+    const void *node = first.findNode(i);
+    ASSERT_TRUE(std::binary_search(nodes.begin(), nodes.end(), node,
+                                   std::less<>()));
+  }
+  for (int i = 0; i < 1000; i++) {
+    second.tryEmplace(i, std::to_string(i));
+  }
+  ASSERT_EQ(first.find(999).second, "999");
+  ASSERT_EQ(second.size(), 1000);
+  ASSERT_EQ(second.find(999).second, "999");
+}
+
+namespace {
+
+using RankedTree = RBTree<int, int, std::less<>,
+                          std::allocator<std::pair<const int, int>>,
+                          unit_weight>;
+
+}  // namespace
+
+TEST(RBTreeOrderStatistics, selectAndRankFollowUpdates) {
+  RankedTree tree;
+  std::vector<bool> present(512, false);
+  std::mt19937 random(7);
+  for (int step = 0; step < 4000; step++) {
+    int key = static_cast<int>(random() % present.size());
+    if (present[static_cast<size_t>(key)]) {
+      tree.del(key);
+    } else {
+      tree.tryEmplace(key, key);
+    }
+    present[static_cast<size_t>(key)] = !present[static_cast<size_t>(key)];
+    if (step % 500 != 0) {
+      continue;
+    }
+    ASSERT_TRUE(isRedBlackTree(tree));
+    ASSERT_EQ(tree.totalWeight(), tree.size());
+    size_t rank = 0;
+    for (size_t i = 0; i < present.size(); i++) {
+      ASSERT_EQ(tree.rankOf(static_cast<int>(i)), rank);
+      if (present[i]) {
+        size_t offset;
+        ASSERT_EQ(tree.selectNode(rank, offset)->value.first,
+                  static_cast<int>(i));
+        ASSERT_EQ(offset, 0);
+        rank++;
+      }
+    }
+    size_t offset;
+    ASSERT_EQ(tree.selectNode(rank, offset), tree.endNode());
+  }
+}
+
+TEST(RBTreeOrderStatistics, weightsSurviveSortedBuildAndMerge) {
+  RankedTree first;
+  RankedTree second;
+  int key = 0;
+  first.assignSorted(100, [&key]() {
+    key += 2;
+    return std::pair<const int, int>(key, key);
+  });
+  for (int i = 1; i < 200; i += 2) {
+    second.tryEmplace(i, i);
+  }
+  first.mergeNodes(second, [](auto *, auto *) { return false; });
+  ASSERT_EQ(second.totalWeight(), 0);
+  ASSERT_EQ(first.totalWeight(), 200);
+  for (size_t k = 0; k < 200; k++) {
+    size_t offset;
+    ASSERT_EQ(first.selectNode(k, offset)->value.first,
+              static_cast<int>(k) + 1);
+  }
+}
+
+TEST(RBTreeOrderStatistics, mappedWeightCountsEveryCopy) {
+  RBTree<int, size_t, std::less<>,
+         std::allocator<std::pair<const int, size_t>>, mapped_weight>
+      tree;
+  tree.tryEmplace(10, size_t{3});
+  tree.tryEmplace(20, size_t{1});
+  tree.tryEmplace(30, size_t{2});
+  ASSERT_EQ(tree.totalWeight(), 6);
+  ASSERT_EQ(tree.rankOf(20), 3);
+  ASSERT_EQ(tree.rankOf(30), 4);
+
+  size_t offset;
+  ASSERT_EQ(tree.selectNode(2, offset)->value.first, 10);
+  ASSERT_EQ(offset, 2);
+  ASSERT_EQ(tree.selectNode(5, offset)->value.first, 30);
+  ASSERT_EQ(offset, 1);
+
+  auto *node = tree.findNode(10);
+  node->value.second = 1;
+  tree.reweigh(node);
+  ASSERT_EQ(tree.rankOf(30), 2);
+  ASSERT_EQ(tree.selectNode(1, offset)->value.first, 20);
+}
@@ -0,0 +1,16 @@
+#ifndef CONTAINERS_TESTS_SET_TEST_HELPERS_H_
+#define CONTAINERS_TESTS_SET_TEST_HELPERS_H_
+
+#include <vector>
+
+/** The keys of a set or multiset of ints, in iteration order. */
+template <typename Container>
+std::vector<int> keys_of(const Container &container) {
+  std::vector<int> keys;
+  for (auto it = container.begin(); it != container.end(); ++it) {
+    keys.push_back(*it);
+  }
+  return keys;
+}
+
+#endif  // CONTAINERS_TESTS_SET_TEST_HELPERS_H_
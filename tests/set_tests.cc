@@ -2,7 +2,16 @@
 #include <stdlib.h>
 #include <time.h>
 
+#include <algorithm>
+#include <iterator>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
 #include "../src/ps_set.h"
+#include "../src/ps_pool_allocator.h"
+#include "../src/ps_set_algebra.h"
+#include "set_test_helpers.h"
 
 using namespace ps;
 
@@ -60,6 +69,136 @@ TEST(setConstructors, initializer_list_constructor) {
   ASSERT_EQ(my_set.contains(6), true);
 }
 
+TEST(setConstructors, from_sorted) {
+  std::vector<int> items = {1, 3, 3, 5, 7, 7, 7, 9};
+  auto my_set = set<int>::from_sorted(items.begin(), items.end());
+  std::set<int> std_set(items.begin(), items.end());
+  ASSERT_EQ(my_set.size(), std_set.size());
+  auto std_iter = std_set.begin();
+  for (auto my_iter = my_set.begin(); my_iter != my_set.end(); ++my_iter) {
+    ASSERT_EQ(*my_iter, *std_iter);
+    ++std_iter;
+  }
+  my_set.assign_sorted(items.begin(), items.begin() + 2);
+  ASSERT_EQ(my_set.size(), 2);
+  ASSERT_TRUE(my_set.contains(3));
+  ASSERT_FALSE(my_set.contains(5));
+}
+
+TEST(setLookup, heterogeneous_string_lookup) {
+  set<std::string> my_set({"one", "two", "three"});
+  std::string_view key = "two";
+  ASSERT_TRUE(my_set.contains(key));
+  ASSERT_EQ(*my_set.find("three"), "three");
+  ASSERT_TRUE(my_set.find("four") == my_set.end());
+  my_set.erase(key);
+  ASSERT_FALSE(my_set.contains("two"));
+  ASSERT_EQ(my_set.size(), 2);
+}
+
+TEST(setLookup, custom_compare_orders_keys) {
+  set<int, std::greater<>> my_set({3, 1, 4, 1, 5, 9, 2, 6});
+  std::vector<int> keys;
+  for (auto it = my_set.begin(); it != my_set.end(); ++it) {
+    keys.push_back(*it);
+  }
+  ASSERT_EQ(keys, (std::vector<int>{9, 6, 5, 4, 3, 2, 1}));
+
+  std::vector<int> sorted = {8, 7, 7, 3};
+  auto from_sorted = set<int, std::greater<>>::from_sorted(sorted.begin(),
+                                                           sorted.end());
+  ASSERT_EQ(from_sorted.size(), 3);
+  ASSERT_EQ(*from_sorted.begin(), 8);
+}
+
+TEST(setLookup, nth_and_rank) {
+  ranked_set<int, std::greater<>> my_set({3, 1, 4, 1, 5, 9, 2, 6});
+  ASSERT_EQ(*my_set.nth(0), 9);
+  ASSERT_EQ(*my_set.nth(3), 4);
+  ASSERT_TRUE(my_set.nth(7) == my_set.end());
+  ASSERT_EQ(my_set.rank(9), 0);
+  ASSERT_EQ(my_set.rank(4), 3);
+  ASSERT_EQ(my_set.rank(0), 7);
+  my_set.erase(6);
+  ASSERT_EQ(*my_set.nth(1), 5);
+}
+
+TEST(setModifiers, insert_with_hint) {
+  set<int> my_set;
+  auto hint = my_set.end();
+  for (int i = 0; i < 50; i++) {
+    hint = my_set.insert(hint, i * 2);
+  }
+  ASSERT_EQ(*my_set.insert(my_set.begin(), 33), 33);
+  ASSERT_EQ(*my_set.emplace_hint(my_set.end(), 98), 98);
+  ASSERT_EQ(my_set.size(), 51);
+
+  int expected = 0;
+  for (auto i = my_set.begin(); i != my_set.end(); ++i) {
+    if (expected == 34) {
+      ASSERT_EQ(*i, 33);
+      ++i;
+    }
+    ASSERT_EQ(*i, expected);
+    expected += 2;
+  }
+}
+
+namespace {
+
+struct CountedKey {
+  static int copies;
+  int key;
+  explicit CountedKey(int k = 0) : key(k) {}
+  CountedKey(const CountedKey &other) : key(other.key) { copies++; }
+  bool operator<(const CountedKey &other) const { return key < other.key; }
+};
+
+int CountedKey::copies = 0;
+
+}  // namespace
+
+TEST(setModifiers, insert_stores_key_once) {
+  static_assert(sizeof(rbnode<std::string, void>) + sizeof(std::string) ==
+                sizeof(rbnode<std::string, std::string>));
+  set<CountedKey> my_set;
+  CountedKey::copies = 0;
+  for (int i = 0; i < 10; i++) {
+    my_set.insert(CountedKey(i));
+  }
+  ASSERT_EQ(CountedKey::copies, 10);
+  my_set.insert(CountedKey(3));
+  ASSERT_EQ(CountedKey::copies, 10);
+
+  std::vector<CountedKey> sorted;
+  for (int i = 0; i < 10; i++) {
+    sorted.emplace_back(i);
+  }
+  CountedKey::copies = 0;
+  my_set.assign_sorted(sorted.begin(), sorted.end());
+  ASSERT_EQ(CountedKey::copies, 10);
+  ASSERT_EQ(my_set.size(), 10);
+}
+
+TEST(setModifiers, extract_and_insert_node) {
+  set<int> first{1, 2, 3};
+  set<int> second{2};
+  auto node = first.extract(2);
+  ASSERT_EQ(node.value(), 2);
+  ASSERT_EQ(first.size(), 2);
+
+  auto result = second.insert(std::move(node));
+  ASSERT_FALSE(result.inserted);
+  ASSERT_FALSE(result.node.empty());
+  result = first.insert(std::move(result.node));
+  ASSERT_TRUE(result.inserted);
+  ASSERT_EQ(*result.position, 2);
+
+  second.insert(first.extract(first.begin()));
+  ASSERT_TRUE(second.contains(1));
+  ASSERT_EQ(first.size(), 2);
+}
+
 TEST(setModifiers, clear_set) {
   set<int> my_set;
   my_set.insert(5);
@@ -342,4 +481,95 @@ TEST(setGroup, test_4) {
   my_set.clear();
   std_set.clear();
   ASSERT_EQ(my_set.size(), std_set.size());
-}
\ No newline at end of file
+}
+
+TEST(setAlgebra, operations_match_std_algorithms) {
+  srand(21);
+  for (int round = 0; round < 20; round++) {
+    set<int> a;
+    set<int> b;
+    std::set<int> std_a;
+    std::set<int> std_b;
+    for (int i = 0; i < 300; i++) {
+      int x = rand() % 500;
+      a.insert(x);
+      std_a.insert(x);
+    }
+    // Every other round b is tiny, which takes the galloping path.
+    int b_count = round % 2 == 0 ? 300 : 5;
+    for (int i = 0; i < b_count; i++) {
+      int x = rand() % 500;
+      b.insert(x);
+      std_b.insert(x);
+    }
+    std::vector<int> expected;
+    std::set_union(std_a.begin(), std_a.end(), std_b.begin(), std_b.end(),
+                   std::back_inserter(expected));
+    set<int> result = set_union(a, b);
+    ASSERT_EQ(keys_of(result), expected);
+
+    expected.clear();
+    std::set_intersection(std_a.begin(), std_a.end(), std_b.begin(),
+                          std_b.end(), std::back_inserter(expected));
+    result = set_intersection(b, a);
+    ASSERT_EQ(keys_of(result), expected);
+    result = set_intersection_galloping(a, b);
+    ASSERT_EQ(keys_of(result), expected);
+
+    expected.clear();
+    std::set_difference(std_a.begin(), std_a.end(), std_b.begin(),
+                        std_b.end(), std::back_inserter(expected));
+    result = set_difference(a, b);
+    ASSERT_EQ(keys_of(result), expected);
+    ASSERT_EQ(includes(a, b), std::includes(std_a.begin(), std_a.end(),
+                                            std_b.begin(), std_b.end()));
+    ASSERT_TRUE(includes(a, result));
+  }
+}
+
+TEST(setAlgebra, empty_operands_and_custom_compare) {
+  set<int, std::greater<>> a{1, 2, 3};
+  set<int, std::greater<>> empty;
+  ASSERT_EQ(set_union(empty, a).size(), 3);
+  ASSERT_TRUE(set_intersection(a, empty).empty());
+  ASSERT_TRUE(set_intersection_galloping(empty, a).empty());
+  ASSERT_EQ(set_difference(a, empty).size(), 3);
+  ASSERT_TRUE(includes(a, empty));
+  ASSERT_FALSE(includes(empty, a));
+
+  set<int, std::greater<>> b{3, 0};
+  auto result = set_union(a, b);
+  ASSERT_EQ(keys_of(result), (std::vector<int>{3, 2, 1, 0}));
+  result.insert(-1);
+  ASSERT_EQ(*result.begin(), 3);
+}
+
+TEST(setAllocator, pool_allocator_set) {
+  set<int, std::less<>, pool_allocator<int>> my_set;
+  for (int i = 0; i < 1000; i++) {
+    my_set.insert(i);
+  }
+  for (int i = 0; i < 1000; i += 2) {
+    my_set.erase(my_set.find(i));
+  }
+  set<int, std::less<>, pool_allocator<int>> moved(std::move(my_set));
+  ASSERT_EQ(moved.size(), 500);
+  ASSERT_TRUE(moved.contains(999));
+  ASSERT_FALSE(moved.contains(998));
+}
+
+TEST(setAllocator, pmr_set_algebra_stays_in_arena) {
+  std::pmr::monotonic_buffer_resource arena;
+  pmr::set<int> a(&arena);
+  pmr::set<int> b(&arena);
+  for (int i = 0; i < 10; i++) {
+    a.insert(i);
+    b.insert(i + 5);
+  }
+  ASSERT_EQ(a.get_allocator().resource(), &arena);
+  ASSERT_EQ(set_union(a, b).get_allocator().resource(), &arena);
+  ASSERT_EQ(set_intersection(a, b).get_allocator().resource(), &arena);
+  ASSERT_EQ(set_difference(a, b).get_allocator().resource(), &arena);
+  ASSERT_EQ(keys_of(set_intersection(a, b)),
+            (std::vector<int>{5, 6, 7, 8, 9}));
+}
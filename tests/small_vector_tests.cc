@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../src/ps_set.h"
+#include "../src/ps_small_vector.h"
+
+TEST(ConstructorSmallVector, Test_1) {
+  ps::small_vector<int, 4> vect{1, 2, 3};
+  ASSERT_EQ(vect.size(), 3);
+  ASSERT_EQ(vect.capacity(), 4);
+  ASSERT_TRUE(vect.is_inline());
+  auto* bytes = reinterpret_cast<const char*>(vect.data());
+  auto* self = reinterpret_cast<const char*>(&vect);
+  ASSERT_TRUE(bytes >= self && bytes < self + sizeof(vect));
+
+  ps::small_vector<int, 4> sized(6);
+  ASSERT_FALSE(sized.is_inline());
+  ASSERT_EQ(sized.size(), 6);
+  ASSERT_EQ(sized[5], 0);
+}
+
+TEST(PushBackSmallVector, Test_1) {
+  ps::small_vector<std::string, 2> vect;
+  std::vector<std::string> expected;
+  for (int i = 0; i < 10; ++i) {
+    vect.push_back(std::string(20, char('a' + i)));
+    expected.push_back(std::string(20, char('a' + i)));
+    ASSERT_EQ(vect.is_inline(), i < 2);
+  }
+  vect.insert(vect.begin() + 1, vect.back());
+  expected.insert(expected.begin() + 1, expected.back());
+  vect.erase(vect.begin());
+  expected.erase(expected.begin());
+  ASSERT_EQ(vect.size(), expected.size());
+  for (size_t i = 0; i < vect.size(); ++i) {
+    ASSERT_EQ(vect[i], expected[i]);
+  }
+  while (vect.size() > 2) {
+    vect.pop_back();
+  }
+  vect.shrink_to_fit();
+  ASSERT_TRUE(vect.is_inline());
+  ASSERT_EQ(vect.back(), expected[1]);
+}
+
+TEST(CopyAndMoveSmallVector, Test_1) {
+  ps::small_vector<std::unique_ptr<int>, 3> small;
+  small.emplace_back(new int(1));
+  ps::small_vector<std::unique_ptr<int>, 3> big;
+  for (int i = 0; i < 5; ++i) {
+    big.emplace_back(new int(i));
+  }
+  int* heap = big.data()->get();
+  small.swap(big);
+  ASSERT_EQ(small.size(), 5);
+  ASSERT_EQ(big.size(), 1);
+  ASSERT_TRUE(big.is_inline());
+  ASSERT_EQ(small[0].get(), heap);
+  ASSERT_EQ(*big[0], 1);
+
+  ps::small_vector<std::unique_ptr<int>, 3> moved(std::move(big));
+  ASSERT_TRUE(big.empty());
+  ASSERT_EQ(*moved[0], 1);
+
+  ps::small_vector<std::string, 3> strings{"a", "b"};
+  ps::small_vector<std::string, 3> copy(strings);
+  copy.insert_many_back("c", "d");
+  ASSERT_EQ(strings.size(), 2);
+  ASSERT_EQ(copy.size(), 4);
+  ASSERT_EQ(copy[3], "d");
+  strings = copy;
+  ASSERT_EQ(strings[2], "c");
+}
+
+TEST(InsertManySmallVector, Test_1) {
+  ps::set<int> set;
+  auto result = set.insert_many(3, 1, 3);
+  ASSERT_TRUE(result.is_inline());
+  ASSERT_EQ(result.size(), 3);
+  ASSERT_TRUE(result[0].second);
+  ASSERT_FALSE(result[2].second);
+  ASSERT_EQ(*result[1].first, 1);
+}
+
+TEST(InsertManySmallVector, Test_shift_once) {
+  ps::small_vector<int, 4> vect{1, 2};
+  auto it = vect.insert_many(vect.begin() + 1, 7, 8, 9);
+  ASSERT_EQ(it, vect.begin() + 1);
+  ASSERT_FALSE(vect.is_inline());
+  std::vector<int> expected{1, 9, 8, 7, 2};
+  ASSERT_TRUE(std::equal(vect.begin(), vect.end(), expected.begin(),
+                         expected.end()));
+
+  ps::small_vector<std::unique_ptr<int>, 2> pointers;
+  pointers.insert_many_back(std::make_unique<int>(1), std::make_unique<int>(2),
+                            std::make_unique<int>(3));
+  pointers.insert_many(pointers.begin(), std::make_unique<int>(0));
+  ASSERT_EQ(pointers.size(), 4);
+  ASSERT_EQ(*pointers[0], 0);
+  ASSERT_EQ(*pointers[3], 3);
+}
+
+TEST(RangeSmallVector, Test_insert_erase) {
+  ps::small_vector<std::string, 4> vect{"a", "e"};
+  std::vector<std::string> middle{"b", "c", "d"};
+  auto it = vect.insert(vect.begin() + 1, middle.begin(), middle.end());
+  ASSERT_EQ(*it, "b");
+  ASSERT_EQ(vect.size(), 5);
+  ASSERT_EQ(vect[4], "e");
+
+  std::vector<std::string> front{"x", "y"};
+  vect.insert(vect.begin(), front.begin(), front.end());
+  ASSERT_EQ(vect.size(), 7);
+  ASSERT_EQ(vect[0], "x");
+  ASSERT_EQ(vect[2], "a");
+
+  it = vect.erase(vect.begin(), vect.begin() + 3);
+  ASSERT_EQ(*it, "b");
+  std::vector<std::string> expected{"b", "c", "d", "e"};
+  ASSERT_TRUE(std::equal(vect.begin(), vect.end(), expected.begin(),
+                         expected.end()));
+  vect.shrink_to_fit();
+  ASSERT_TRUE(vect.is_inline());
+
+  ps::small_vector<int, 8> ints{1, 2, 3, 4, 5};
+  int more[] = {6, 7};
+  ints.insert(ints.begin() + 2, std::begin(more), std::end(more));
+  ASSERT_TRUE(ints.is_inline());
+  ints.erase(ints.begin(), ints.begin() + 2);
+  std::vector<int> ints_expected{6, 7, 3, 4, 5};
+  ASSERT_TRUE(std::equal(ints.begin(), ints.end(), ints_expected.begin(),
+                         ints_expected.end()));
+}
+
+namespace {
+
+struct ThrowsOnConstruct {
+  explicit ThrowsOnConstruct(bool fail) {
+    if (fail) {
+      throw std::runtime_error("construct");
+    }
+  }
+};
+
+// Counts the live objects; the copy after copies_left more throws. With
+// no move constructor, relocating and moving copy.
+struct ThrowsOnCopy {
+  static inline int live = 0;
+  static inline int copies_left = -1;
+  int value;
+
+  explicit ThrowsOnCopy(int v) : value(v) { ++live; }
+  ThrowsOnCopy(const ThrowsOnCopy& other) : value(other.value) {
+    if (copies_left-- == 0) {
+      throw std::runtime_error("copy");
+    }
+    ++live;
+  }
+  ~ThrowsOnCopy() { --live; }
+};
+
+}  // namespace
+
+// A failed element constructor leaves the vector as it was and frees the
+// buffer it was going to grow into.
+TEST(PushBackSmallVector, Test_throwing_constructor) {
+  ps::small_vector<ThrowsOnConstruct, 2> vect;
+  vect.emplace_back(false);
+  vect.emplace_back(false);
+  ASSERT_THROW(vect.emplace_back(true), std::runtime_error);
+  ASSERT_EQ(vect.size(), 2);
+  ASSERT_TRUE(vect.is_inline());
+}
+
+// A copy that throws while the elements change buffers leaves them where
+// they were, and nothing is leaked or destroyed twice.
+TEST(PushBackSmallVector, Test_throwing_copy_while_relocating) {
+  static_assert(std::is_nothrow_move_constructible_v<ps::small_vector<int, 2>>);
+  static_assert(
+      !std::is_nothrow_move_constructible_v<ps::small_vector<ThrowsOnCopy, 2>>);
+  {
+    ps::small_vector<ThrowsOnCopy, 2> vect;
+    vect.emplace_back(0);
+    vect.emplace_back(1);
+    ThrowsOnCopy::copies_left = 1;
+    ASSERT_THROW(vect.emplace_back(2), std::runtime_error);
+    ASSERT_TRUE(vect.is_inline());
+    ThrowsOnCopy::copies_left = 1;
+    using vector_type = ps::small_vector<ThrowsOnCopy, 2>;
+    ASSERT_THROW(vector_type(std::move(vect)), std::runtime_error);
+    ASSERT_EQ(vect.size(), 2);
+
+    ThrowsOnCopy::copies_left = -1;
+    vect.emplace_back(2);
+    ThrowsOnCopy::copies_left = 2;
+    ASSERT_THROW(vect.reserve(10), std::runtime_error);
+    vect.pop_back();
+    ThrowsOnCopy::copies_left = 1;
+    ASSERT_THROW(vect.shrink_to_fit(), std::runtime_error);
+    ASSERT_FALSE(vect.is_inline());
+    ThrowsOnCopy::copies_left = -1;
+    ASSERT_EQ(vect.size(), 2);
+    ASSERT_EQ(ThrowsOnCopy::live, 2);
+    ASSERT_EQ(vect[0].value, 0);
+    ASSERT_EQ(vect[1].value, 1);
+  }
+  ASSERT_EQ(ThrowsOnCopy::live, 0);
+}
+
+namespace {
+
+bool inBuffer(const void* p, const char* buffer, size_t size) {
+  auto* c = static_cast<const char*>(p);
+  return c >= buffer && c < buffer + size;
+}
+
+}  // namespace
+
+// The heap buffer and the elements' own memory come from the vector's
+// resource; moving to another resource moves the elements.
+TEST(AllocatorSmallVector, Test_1) {
+  char buffer[16384];
+  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                            std::pmr::null_memory_resource());
+  ps::pmr::small_vector<std::pmr::string, 4> vect(&arena);
+  for (int i = 0; i < 20; ++i) {
+    vect.emplace_back(100, 'x');
+  }
+  ASSERT_EQ(vect.get_allocator().resource(), &arena);
+  ASSERT_FALSE(vect.is_inline());
+  ASSERT_TRUE(inBuffer(vect.data(), buffer, sizeof(buffer)));
+  ASSERT_TRUE(inBuffer(vect[19].data(), buffer, sizeof(buffer)));
+
+  ps::pmr::small_vector<std::pmr::string, 4> other(
+      std::pmr::new_delete_resource());
+  other = std::move(vect);
+  ASSERT_TRUE(vect.empty());
+  ASSERT_EQ(other.size(), 20);
+  ASSERT_EQ(other[19], std::pmr::string(100, 'x'));
+  ASSERT_FALSE(inBuffer(other.data(), buffer, sizeof(buffer)));
+  ASSERT_FALSE(inBuffer(other[19].data(), buffer, sizeof(buffer)));
+}
@@ -0,0 +1,252 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+
+#include "../src/ps_unordered_map.h"
+
+using namespace ps;
+
+TEST(unorderedMapConstructors, constructor_creates_map) {
+  unordered_map<int, int> my_map;
+  ASSERT_EQ(my_map.contains(5), false);
+  ASSERT_EQ(my_map.empty(), true);
+  ASSERT_TRUE(my_map.begin() == my_map.end());
+}
+
+TEST(unorderedMapConstructors, copy_and_move) {
+  unordered_map<int, int> my_map{{4, 8}, {5, 9}};
+  unordered_map<int, int> copy_map(my_map);
+  copy_map[5] = 7;
+  ASSERT_EQ(my_map[5], 9);
+  ASSERT_EQ(copy_map[4], 8);
+
+  unordered_map<int, int> moved_map = std::move(copy_map);
+  ASSERT_EQ(moved_map.size(), 2);
+  ASSERT_EQ(moved_map[5], 7);
+  my_map = moved_map;
+  ASSERT_EQ(my_map[5], 7);
+  my_map = unordered_map<int, int>{{1, 1}};
+  ASSERT_EQ(my_map.size(), 1);
+}
+
+TEST(unorderedMapModifiers, insert_and_assign) {
+  unordered_map<int, std::string> my_map;
+  ASSERT_TRUE(my_map.insert(1, "one").second);
+  ASSERT_FALSE(my_map.insert(std::pair<const int, std::string>(1, "uno"))
+                   .second);
+  ASSERT_EQ(my_map.at(1), "one");
+  auto result = my_map.insert_or_assign(1, "uno");
+  ASSERT_FALSE(result.second);
+  ASSERT_EQ(result.first->second, "uno");
+  ASSERT_TRUE(my_map.try_emplace(2, 3, 'x').second);
+  ASSERT_EQ(my_map[2], "xxx");
+  ASSERT_TRUE(my_map.emplace(3, "three").second);
+  ASSERT_EQ(my_map.size(), 3);
+  ASSERT_THROW(my_map.at(4), std::out_of_range);
+}
+
+TEST(unorderedMapModifiers, matches_std_under_churn) {
+  srand(13);
+  unordered_map<int, int> my_map;
+  std::unordered_map<int, int> std_map;
+  for (int i = 0; i < 20000; i++) {
+    int key = rand() % 2000;
+    if (rand() % 3 == 0) {
+      ASSERT_EQ(my_map.erase(key), std_map.erase(key));
+    } else {
+      my_map[key] += i;
+      std_map[key] += i;
+    }
+  }
+  ASSERT_EQ(my_map.size(), std_map.size());
+  size_t visited = 0;
+  for (auto it = my_map.begin(); it != my_map.end(); ++it) {
+    ASSERT_EQ(it->second, std_map.at(it->first));
+    visited++;
+  }
+  ASSERT_EQ(visited, std_map.size());
+  ASSERT_LE(my_map.load_factor(), 0.875f);
+}
+
+TEST(unorderedMapModifiers, erase_iterator_and_clear) {
+  unordered_map<std::string, int> my_map;
+  for (int i = 0; i < 100; i++) {
+    my_map[std::to_string(i)] = i;
+  }
+  my_map.erase(my_map.find("42"));
+  ASSERT_FALSE(my_map.contains("42"));
+  ASSERT_EQ(my_map.size(), 99);
+  size_t buckets = my_map.bucket_count();
+  my_map.clear();
+  ASSERT_TRUE(my_map.empty());
+  ASSERT_EQ(my_map.bucket_count(), buckets);
+  my_map["a"] = 1;
+  ASSERT_EQ(my_map.count("a"), 1);
+}
+
+TEST(unorderedMapModifiers, merge_moves_missing_keys) {
+  unordered_map<int, std::string> a{{1, "a"}, {2, "b"}};
+  unordered_map<int, std::string> b{{2, "x"}, {3, "c"}};
+  a.merge(b);
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_EQ(a[2], "b");
+  ASSERT_EQ(a[3], "c");
+  ASSERT_EQ(b.size(), 1);
+  ASSERT_EQ(b[2], "x");
+}
+
+namespace {
+
+// Counts the copies made of any key.
+struct CopyCountingKey {
+  static inline int copies = 0;
+  int value;
+
+  explicit CopyCountingKey(int v) : value(v) {}
+  CopyCountingKey(const CopyCountingKey &other) : value(other.value) {
+    ++copies;
+  }
+  CopyCountingKey(CopyCountingKey &&other) noexcept = default;
+  bool operator==(const CopyCountingKey &other) const {
+    return value == other.value;
+  }
+};
+
+struct CopyCountingKeyHash {
+  size_t operator()(const CopyCountingKey &key) const {
+    return std::hash<int>()(key.value);
+  }
+};
+
+}  // namespace
+
+TEST(unorderedMapModifiers, growth_and_merge_move_keys) {
+  unordered_map<CopyCountingKey, std::string, CopyCountingKeyHash> a;
+  unordered_map<CopyCountingKey, std::string, CopyCountingKeyHash> b;
+  for (int i = 0; i < 1000; i++) {
+    a.try_emplace(CopyCountingKey(i), "a");
+    b.emplace(CopyCountingKey(i + 500), "b");
+  }
+  a.merge(b);
+  ASSERT_EQ(a.size(), 1500);
+  ASSERT_EQ(b.size(), 500);
+  ASSERT_EQ(a.at(CopyCountingKey(1499)), "b");
+  ASSERT_EQ(CopyCountingKey::copies, 0);
+}
+
+TEST(unorderedMapModifiers, move_only_keys) {
+  unordered_map<std::unique_ptr<int>, int> a;
+  unordered_map<std::unique_ptr<int>, int> b;
+  for (int i = 0; i < 100; i++) {
+    a.try_emplace(std::make_unique<int>(i), i);
+    b.emplace(std::make_unique<int>(i), i);
+  }
+  a[std::make_unique<int>(100)] = 100;
+  a.merge(b);
+  ASSERT_EQ(a.size(), 201);
+  ASSERT_TRUE(b.empty());
+  for (auto &item : a) {
+    ASSERT_EQ(*item.first, item.second);
+  }
+}
+
+TEST(unorderedMapModifiers, insert_many) {
+  unordered_map<int, int> my_map{{1, 1}};
+  auto result = my_map.insert_many(std::pair<const int, int>(1, 5),
+                                   std::pair<const int, int>(2, 2),
+                                   std::pair<const int, int>(3, 3));
+  ASSERT_EQ(result.size(), 3);
+  ASSERT_FALSE(result[0].second);
+  ASSERT_EQ(result[0].first->second, 1);
+  ASSERT_TRUE(result[2].second);
+  ASSERT_EQ(result[2].first->first, 3);
+  ASSERT_EQ(my_map.size(), 3);
+}
+
+TEST(unorderedMapModifiers, insert_many_after_erase_keeps_iterators) {
+  unordered_map<int, int> my_map;
+  for (int i = 0; i < 54; i++) {
+    my_map.insert(i, i);
+  }
+  for (int i = 0; i < 3; i++) {
+    my_map.erase(i);
+  }
+  auto result = my_map.insert_many(std::pair<const int, int>(61, 61),
+                                   std::pair<const int, int>(62, 62),
+                                   std::pair<const int, int>(63, 63),
+                                   std::pair<const int, int>(64, 64),
+                                   std::pair<const int, int>(65, 65));
+  ASSERT_EQ(result.size(), 5);
+  for (int i = 0; i < 5; i++) {
+    ASSERT_TRUE(result[i].second);
+    ASSERT_EQ(result[i].first->first, 61 + i);
+    ASSERT_EQ(result[i].first, my_map.find(61 + i));
+  }
+  ASSERT_EQ(my_map.size(), 56);
+}
+
+TEST(unorderedMapModifiers, reserve_keeps_iterators) {
+  unordered_map<int, int> my_map;
+  my_map.reserve(1000);
+  size_t buckets = my_map.bucket_count();
+  auto first = my_map.insert(0, 0).first;
+  for (int i = 1; i < 1000; i++) {
+    my_map[i] = i;
+  }
+  ASSERT_EQ(my_map.bucket_count(), buckets);
+  ASSERT_EQ(first->first, 0);
+}
+
+TEST(unorderedMapAllocator, pmr_map_takes_slots_from_arena) {
+  alignas(std::max_align_t) char buffer[65536];
+  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                            std::pmr::null_memory_resource());
+  ps::pmr::unordered_map<int, int> map(&arena);
+  for (int i = 0; i < 100; i++) {
+    map.insert(i, i * 2);
+  }
+  auto *value = reinterpret_cast<const char *>(&map.at(50));
+  ASSERT_TRUE(value >= buffer && value < buffer + sizeof(buffer));
+  ASSERT_EQ(map.at(99), 198);
+}
+
+TEST(unorderedMapAllocator, pmr_map_assigns_and_swaps_in_own_arena) {
+  alignas(std::max_align_t) char first_buffer[65536];
+  alignas(std::max_align_t) char second_buffer[65536];
+  std::pmr::monotonic_buffer_resource first_arena(
+      first_buffer, sizeof(first_buffer), std::pmr::null_memory_resource());
+  std::pmr::monotonic_buffer_resource second_arena(
+      second_buffer, sizeof(second_buffer), std::pmr::null_memory_resource());
+  auto in_first = [&](const int &value) {
+    auto *address = reinterpret_cast<const char *>(&value);
+    return address >= first_buffer &&
+           address < first_buffer + sizeof(first_buffer);
+  };
+  ps::pmr::unordered_map<int, int> map(&first_arena);
+  ps::pmr::unordered_map<int, int> other(&second_arena);
+  for (int i = 0; i < 100; i++) {
+    other.insert(i, i * 2);
+  }
+  map = other;
+  ASSERT_EQ(map.size(), 100);
+  ASSERT_EQ(other.size(), 100);
+  ASSERT_TRUE(in_first(map.at(50)));
+
+  other[100] = 200;
+  map = std::move(other);
+  ASSERT_EQ(map.size(), 101);
+  ASSERT_TRUE(other.empty());
+  ASSERT_TRUE(in_first(map.at(100)));
+
+  ps::pmr::unordered_map<int, int> swapped(&first_arena);
+  swapped[-1] = -2;
+  map.swap(swapped);
+  ASSERT_EQ(map.size(), 1);
+  ASSERT_EQ(swapped.size(), 101);
+  ASSERT_TRUE(in_first(map.at(-1)));
+  ASSERT_TRUE(in_first(swapped.at(99)));
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include <memory_resource>
+#include <string>
+#include <unordered_set>
+
+#include "../src/ps_unordered_set.h"
+
+using namespace ps;
+
+TEST(unorderedSetConstructors, constructors) {
+  unordered_set<int> empty_set;
+  ASSERT_TRUE(empty_set.empty());
+  ASSERT_TRUE(empty_set.begin() == empty_set.end());
+
+  unordered_set<int> my_set{1, 2, 3, 2};
+  ASSERT_EQ(my_set.size(), 3);
+  unordered_set<int> copy_set(my_set);
+  copy_set.erase(1);
+  ASSERT_TRUE(my_set.contains(1));
+  unordered_set<int> moved_set(std::move(copy_set));
+  ASSERT_EQ(moved_set.size(), 2);
+}
+
+TEST(unorderedSetModifiers, matches_std_under_churn) {
+  srand(7);
+  unordered_set<std::string> my_set;
+  std::unordered_set<std::string> std_set;
+  for (int i = 0; i < 20000; i++) {
+    std::string key = std::to_string(rand() % 3000);
+    if (rand() % 2 == 0) {
+      ASSERT_EQ(my_set.erase(key), std_set.erase(key));
+    } else {
+      ASSERT_EQ(my_set.insert(key).second, std_set.insert(key).second);
+    }
+  }
+  ASSERT_EQ(my_set.size(), std_set.size());
+  size_t visited = 0;
+  for (auto it = my_set.begin(); it != my_set.end(); it++) {
+    ASSERT_EQ(std_set.count(*it), 1);
+    visited++;
+  }
+  ASSERT_EQ(visited, std_set.size());
+}
+
+TEST(unorderedSetModifiers, merge_and_insert_many) {
+  unordered_set<int> a{1, 2};
+  unordered_set<int> b{2, 3};
+  a.merge(b);
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_EQ(b.size(), 1);
+  ASSERT_TRUE(b.contains(2));
+
+  auto result = a.insert_many(3, 4, 5);
+  ASSERT_FALSE(result[0].second);
+  ASSERT_TRUE(result[1].second);
+  ASSERT_EQ(*result[2].first, 5);
+  ASSERT_EQ(a.size(), 5);
+  a.erase(a.find(4));
+  ASSERT_FALSE(a.contains(4));
+}
+
+TEST(unorderedSetModifiers, insert_many_after_erase_keeps_iterators) {
+  unordered_set<int> a;
+  for (int i = 0; i < 54; i++) {
+    a.insert(i);
+  }
+  for (int i = 0; i < 3; i++) {
+    a.erase(i);
+  }
+  auto result = a.insert_many(61, 62, 63, 64, 65);
+  ASSERT_EQ(result.size(), 5);
+  for (int i = 0; i < 5; i++) {
+    ASSERT_TRUE(result[i].second);
+    ASSERT_EQ(*result[i].first, 61 + i);
+    ASSERT_EQ(result[i].first, a.find(61 + i));
+  }
+  ASSERT_EQ(a.size(), 56);
+}
+
+TEST(unorderedSetAllocator, pmr_set_assigns_and_swaps) {
+  std::pmr::monotonic_buffer_resource first_arena;
+  std::pmr::monotonic_buffer_resource second_arena;
+  ps::pmr::unordered_set<int> a(&first_arena);
+  ps::pmr::unordered_set<int> b(&second_arena);
+  b.insert(1);
+  b.insert(2);
+  a = b;
+  ASSERT_EQ(a.size(), 2);
+  b.insert(3);
+  a = std::move(b);
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_TRUE(b.empty());
+  ps::pmr::unordered_set<int> c(&first_arena);
+  a.swap(c);
+  ASSERT_TRUE(a.empty());
+  ASSERT_TRUE(c.contains(3));
+}
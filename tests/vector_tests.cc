@@ -1,7 +1,14 @@
 #include <gtest/gtest.h>
 
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "../src/ps_huge_page_allocator.h"
 #include "../src/ps_vector.h"
 
 // Constructor tests
@@ -405,6 +412,75 @@ TEST(InsertFunctionTestVector, Test_4) {
   }
 }
 
+// Range insert with and without room, for a tail longer and shorter than
+// the range, on trivially copyable and on other elements.
+TEST(InsertFunctionTestVector, Test_range) {
+  const int source[] = {10, 11, 12};
+  const std::vector<std::string> extra = {std::string(20, 'x'),
+                                          std::string(20, 'y')};
+  for (size_t index = 0; index <= 5; ++index) {
+    ps::vector<int> ps_ints{1, 2, 3, 4, 5};
+    std::vector<int> std_ints{1, 2, 3, 4, 5};
+    ps::vector<std::string> ps_strings;
+    std::vector<std::string> std_strings;
+    for (int i = 0; i < 5; ++i) {
+      ps_strings.push_back(std::string(20, char('a' + i)));
+      std_strings.push_back(std::string(20, char('a' + i)));
+    }
+    for (size_t cap : {size_t{5}, size_t{16}}) {
+      ps_ints.reserve(cap);
+      ps_strings.reserve(cap);
+      auto it = ps_ints.insert(ps_ints.begin() + index, source, source + 3);
+      ASSERT_EQ(*it, 10);
+      std_ints.insert(std_ints.begin() + long(index), source, source + 3);
+      ps_strings.insert(ps_strings.begin() + index, extra.begin(),
+                        extra.end());
+      std_strings.insert(std_strings.begin() + long(index), extra.begin(),
+                         extra.end());
+    }
+    ASSERT_EQ(std::vector<int>(ps_ints.begin(), ps_ints.end()), std_ints);
+    ASSERT_EQ(
+        std::vector<std::string>(ps_strings.begin(), ps_strings.end()),
+        std_strings);
+  }
+}
+
+TEST(InsertFunctionTestVector, Test_input_iterator) {
+  std::istringstream in("3 4 5");
+  ps::vector<int> vect{1, 2, 6};
+  vect.insert(vect.begin() + 2, std::istream_iterator<int>(in),
+              std::istream_iterator<int>());
+  ASSERT_EQ(vect.size(), 6);
+  for (size_t i = 0; i < vect.size(); ++i) {
+    ASSERT_EQ(vect[i], i + 1);
+  }
+  EXPECT_THROW(vect.insert(vect.end() + 1, vect.begin(), vect.end()),
+               std::out_of_range);
+}
+
+TEST(EraseFunctionTestVector, Test_range) {
+  ps::vector<std::string> ps_vect;
+  std::vector<std::string> std_vect;
+  for (int i = 0; i < 10; ++i) {
+    ps_vect.push_back(std::string(20, char('a' + i)));
+    std_vect.push_back(std::string(20, char('a' + i)));
+  }
+  auto it = ps_vect.erase(ps_vect.begin() + 2, ps_vect.begin() + 5);
+  std_vect.erase(std_vect.begin() + 2, std_vect.begin() + 5);
+  ASSERT_EQ(*it, std_vect[2]);
+  ASSERT_EQ(std::vector<std::string>(ps_vect.begin(), ps_vect.end()),
+            std_vect);
+  ps_vect.erase(ps_vect.begin(), ps_vect.begin());
+  ps_vect.erase(ps_vect.begin() + 3, ps_vect.end());
+  ASSERT_EQ(ps_vect.size(), 3);
+  ASSERT_EQ(ps_vect.back(), std_vect[2]);
+
+  ps::vector<int> ints{1, 2, 3, 4, 5};
+  ints.erase(ints.begin() + 1, ints.begin() + 3);
+  ASSERT_EQ(ints.size(), 3);
+  ASSERT_EQ(ints[1], 4);
+}
+
 TEST(InsertManyBackFunctionVector, Test_1) {
   ps::vector<int> ps_vect{1, 2, 3, 4};
   ps_vect.insert_many_back(5, 6, 7);
@@ -427,4 +503,242 @@ TEST(InsertManyFunctionVector, Test_1) {
     ++iter_1;
     ++i;
   }
-}
\ No newline at end of file
+}
+
+TEST(InsertManyFunctionVector, Test_2) {
+  ps::vector<std::string> ps_vect{"e", "f"};
+  auto it = ps_vect.insert_many(ps_vect.begin() + 1, "d", std::string("c"));
+  ASSERT_EQ(*it, "c");
+  ps_vect.insert_many(ps_vect.begin(), ps_vect[0], "x");
+  const char* expected[] = {"x", "e", "e", "c", "d", "f"};
+  ASSERT_EQ(ps_vect.size(), 6);
+  for (size_t i = 0; i < ps_vect.size(); ++i) {
+    ASSERT_EQ(ps_vect[i], expected[i]);
+  }
+}
+
+TEST(EmplaceBackFunctionVector, Test_1) {
+  ps::vector<std::unique_ptr<int>> vect;
+  for (int i = 0; i < 100; ++i) {
+    vect.emplace_back(new int(i));
+  }
+  vect.push_back(std::make_unique<int>(100));
+  vect.emplace(vect.begin(), std::make_unique<int>(-1));
+  ASSERT_EQ(vect.size(), 102);
+  for (size_t i = 0; i < vect.size(); ++i) {
+    ASSERT_EQ(*vect[i], static_cast<int>(i) - 1);
+  }
+  vect.erase(vect.begin());
+  ASSERT_EQ(*vect.front(), 0);
+}
+
+// Growing moves strings instead of copying them, also when the new element
+// is one of the old ones.
+TEST(EmplaceBackFunctionVector, Test_2) {
+  ps::vector<std::string> vect;
+  vect.push_back(std::string(100, 'x'));
+  const char* buffer = vect[0].data();
+  for (int i = 0; i < 10; ++i) {
+    vect.push_back(vect[0]);
+    vect.insert(vect.begin(), vect.back());
+  }
+  ASSERT_EQ(vect.size(), 21);
+  ASSERT_EQ(vect[0], std::string(100, 'x'));
+  ASSERT_EQ(vect[20], std::string(100, 'x'));
+  size_t moved = 0;
+  for (size_t i = 0; i < vect.size(); ++i) {
+    moved += vect[i].data() == buffer ? 1 : 0;
+  }
+  ASSERT_EQ(moved, 1);
+}
+
+// Allocator tests
+
+static bool inBuffer(const void* p, const char* buffer, size_t size) {
+  auto* c = static_cast<const char*>(p);
+  return c >= buffer && c < buffer + size;
+}
+
+namespace {
+
+// Counts the bytes handed out and not yet given back.
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  size_t in_use = 0;
+
+ private:
+  void* do_allocate(size_t bytes, size_t align) override {
+    in_use += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, align);
+  }
+  void do_deallocate(void* p, size_t bytes, size_t align) override {
+    in_use -= bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+  }
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+struct ThrowsOnConstruct {
+  explicit ThrowsOnConstruct(bool fail) {
+    if (fail) {
+      throw std::runtime_error("construct");
+    }
+  }
+};
+
+// Counts the live objects; the copy after copies_left more throws. With
+// no move constructor, relocating copies.
+struct ThrowsOnCopy {
+  static inline int live = 0;
+  static inline int copies_left = -1;
+  int value;
+
+  explicit ThrowsOnCopy(int v) : value(v) { ++live; }
+  ThrowsOnCopy(const ThrowsOnCopy& other) : value(other.value) {
+    if (copies_left-- == 0) {
+      throw std::runtime_error("copy");
+    }
+    ++live;
+  }
+  ~ThrowsOnCopy() { --live; }
+};
+
+}  // namespace
+
+TEST(AllocatorVector, Test_1) {
+  char buffer[4096];
+  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                            std::pmr::null_memory_resource());
+  ps::pmr::vector<int> vect(&arena);
+  for (int i = 0; i < 200; ++i) {
+    vect.push_back(i);
+  }
+  ASSERT_EQ(vect.get_allocator().resource(), &arena);
+  ASSERT_TRUE(inBuffer(vect.data(), buffer, sizeof(buffer)));
+  ASSERT_EQ(vect[199], 199);
+  ps::pmr::vector<int> copy(vect, &arena);
+  ASSERT_TRUE(inBuffer(copy.data(), buffer, sizeof(buffer)));
+  ASSERT_EQ(copy.size(), 200);
+}
+
+// Elements that take an allocator get the vector's, and moving between
+// resources moves the elements instead of the buffer.
+TEST(AllocatorVector, Test_2) {
+  CountingResource first;
+  CountingResource second;
+  {
+    ps::pmr::vector<std::pmr::string> vect(&first);
+    for (int i = 0; i < 50; ++i) {
+      vect.emplace_back(100, 'x');
+    }
+    ASSERT_EQ(vect[0].get_allocator().resource(), &first);
+    size_t in_first = first.in_use;
+    ASSERT_GT(in_first, 50 * 100);
+
+    ps::pmr::vector<std::pmr::string> other(&second);
+    other = std::move(vect);
+    ASSERT_TRUE(vect.empty());
+    ASSERT_EQ(other.get_allocator().resource(), &second);
+    ASSERT_EQ(other.size(), 50);
+    ASSERT_EQ(other[49], std::pmr::string(100, 'x'));
+    ASSERT_EQ(other[49].get_allocator().resource(), &second);
+    ASSERT_GT(second.in_use, 50 * 100);
+
+    ps::pmr::vector<std::pmr::string> copy(other);
+    ASSERT_EQ(copy.get_allocator().resource(),
+              std::pmr::get_default_resource());
+  }
+  ASSERT_EQ(first.in_use, 0);
+  ASSERT_EQ(second.in_use, 0);
+}
+
+// A failed element constructor leaves the vector as it was and gives back
+// the buffer it was going to grow into.
+TEST(AllocatorVector, Test_throwing_constructor) {
+  CountingResource resource;
+  ps::pmr::vector<ThrowsOnConstruct> vect(&resource);
+  vect.emplace_back(false);
+  size_t in_use = resource.in_use;
+  ASSERT_THROW(vect.emplace_back(true), std::runtime_error);
+  ASSERT_EQ(vect.size(), 1);
+  ASSERT_EQ(resource.in_use, in_use);
+}
+
+// A copy that throws while growing frees the new buffer and its elements
+// and leaves the old ones in place.
+TEST(AllocatorVector, Test_throwing_copy_while_growing) {
+  CountingResource resource;
+  {
+    ps::pmr::vector<ThrowsOnCopy> vect(&resource);
+    for (int i = 0; i < 4; ++i) {
+      vect.emplace_back(i);
+    }
+    size_t in_use = resource.in_use;
+    ThrowsOnCopy::copies_left = 2;
+    ASSERT_THROW(vect.push_back(ThrowsOnCopy(4)), std::runtime_error);
+    ThrowsOnCopy::copies_left = 1;
+    ASSERT_THROW(vect.reserve(100), std::runtime_error);
+    ThrowsOnCopy::copies_left = -1;
+    ASSERT_EQ(resource.in_use, in_use);
+    ASSERT_EQ(vect.size(), 4);
+    ASSERT_EQ(ThrowsOnCopy::live, 4);
+    for (int i = 0; i < 4; ++i) {
+      ASSERT_EQ(vect[i].value, i);
+    }
+  }
+  ASSERT_EQ(ThrowsOnCopy::live, 0);
+  ASSERT_EQ(resource.in_use, 0);
+}
+
+TEST(GrowthVector, Test_policies) {
+  ps::vector<int, std::allocator<int>, ps::one_and_half_growth> half;
+  ps::vector<int, std::allocator<int>, ps::fixed_growth<100>> fixed;
+  std::vector<size_t> half_caps;
+  std::vector<size_t> fixed_caps;
+  for (int i = 0; i < 250; ++i) {
+    half.push_back(i);
+    fixed.push_back(i);
+    if (half_caps.empty() || half_caps.back() != half.capacity()) {
+      half_caps.push_back(half.capacity());
+    }
+    if (fixed_caps.empty() || fixed_caps.back() != fixed.capacity()) {
+      fixed_caps.push_back(fixed.capacity());
+    }
+  }
+  ASSERT_EQ(half_caps, (std::vector<size_t>{1, 2, 4, 7, 11, 17, 26, 40, 61,
+                                            92, 139, 209, 314}));
+  ASSERT_EQ(fixed_caps, (std::vector<size_t>{100, 200, 300}));
+  for (size_t i = 0; i < 250; ++i) {
+    ASSERT_EQ(half[i], i);
+    ASSERT_EQ(fixed[i], i);
+  }
+}
+
+// Past the threshold the buffer is mapped and grows through mremap; the
+// elements survive every change of storage.
+TEST(HugePageVector, Test_1) {
+  using alloc = ps::huge_page_allocator<int>;
+  const size_t n = 4 * alloc::kMapThreshold / sizeof(int);
+  ps::vector<int, alloc> vect;
+  for (size_t i = 0; i < n; ++i) {
+    vect.push_back(int(i));
+  }
+  vect.insert_many(vect.begin() + 1, -1, -2);
+  ASSERT_EQ(vect.size(), n + 2);
+  ASSERT_EQ(vect[1], -2);
+  ASSERT_EQ(vect[2], -1);
+  vect.erase(vect.begin() + 1, vect.begin() + 3);
+  vect.reserve(2 * vect.capacity());
+  for (size_t i = 0; i < n; i += 4097) {
+    ASSERT_EQ(vect[i], int(i));
+  }
+  ps::vector<int, alloc> copy(vect);
+  ASSERT_EQ(copy[n - 1], int(n - 1));
+  vect.erase(vect.begin() + 10, vect.end());
+  vect.shrink_to_fit();
+  ASSERT_EQ(vect.capacity(), 10);
+  ASSERT_EQ(vect[9], 9);
+}